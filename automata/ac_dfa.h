@@ -0,0 +1,277 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Compiled Aho-Corasick automaton: dense move table over symbol classes.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <boost/type_traits/make_unsigned.hpp>
+
+#include "fsm_defs.h"
+#include "aho_corasick.h"
+
+namespace strutext { namespace automata {
+
+/**
+ * \brief Compiled Aho-Corasick automaton.
+ *
+ * All the fail move chains of Aho-Corasick trie are resolved in the deterministic automaton,
+ * which has a move from every state by every symbol. Symbols, which move the automaton
+ * identically from all the states, form a class, so the move table has a column per class.
+ * All the symbols absent in the trie make the class 0, and each trie symbol makes its own class
+ * (two symbols of the trie lead to different states from some state). So the dictionaries of
+ * natural language words have a few dozen classes instead of the whole alphabet. The table is
+ * dense, moves of state i are placed in [i * C, (i + 1) * C) range, where C is the number of
+ * classes. Thus a move costs a symbol class lookup and a table load.
+ * The table takes 4 * C bytes per state, so the compilation is for hot dictionaries, the
+ * usual trie is more compact.
+ *
+ * State attributes are the chain identifiers of the state and of its fail move chain.
+ */
+template <typename Char, typename Attribute>
+class AcDfa {
+public:
+  /// Symbol type.
+  typedef Char CharType;
+
+  /// Chain identifier type.
+  typedef Attribute ChainId;
+
+  /// Unsigned symbol type, used as index.
+  typedef typename boost::make_unsigned<CharType>::type SymbolCode;
+
+  /// State attributes: range in the attribute array.
+  typedef AttributeRange<Attribute> AttributeList;
+
+  /// Maximal number of symbols, whose classes are kept in direct lookup table.
+  static const size_t kMaxDirectSymbols = 0x10000;
+
+  /// Default initialization: invalid and start states without chains.
+  AcDfa()
+    : num_of_classes_(1)
+    , direct_classes_(GetDirectTableSize(0), 0)
+    , delta_(2, kStartState)
+    , accepted_(2, 0)
+    , attr_offsets_(3, 0) {}
+
+  /**
+   * \brief Build the automaton by Aho-Corasick trie.
+   *
+   * Fail moves are calculated here, so FailMoveGenerator call for the trie is not required.
+   *
+   * \param trie The trie, any implementation of move table.
+   */
+  template <class TrieImpl>
+  void Compile(const TrieImpl& trie);
+
+  /// Return number of states of the automaton.
+  size_t GetNumOfStates() const { return accepted_.size(); }
+
+  /// Return number of symbol classes.
+  size_t GetNumOfClasses() const { return num_of_classes_; }
+
+  /// Get class of the symbol.
+  uint32_t GetSymbolClass(const CharType& symbol) const {
+    const SymbolCode code = static_cast<SymbolCode>(symbol);
+    if (code < direct_classes_.size()) {
+      return direct_classes_[code];
+    }
+    typename SymbolClassList::const_iterator it = std::lower_bound(
+        sparse_classes_.begin(), sparse_classes_.end(), std::make_pair(code, uint32_t(0)));
+    if (it != sparse_classes_.end() and it->first == code) {
+      return it->second;
+    }
+    return 0;
+  }
+
+  /**
+   * \brief Move by the symbol.
+   *
+   * \param  from   State to move from.
+   * \param  symbol Symbol to move by.
+   * \return        State to move to, the start state at least.
+   */
+  StateId Move(const StateId& from, const CharType& symbol) const {
+    return delta_[from * num_of_classes_ + GetSymbolClass(symbol)];
+  }
+
+  /**
+   * \brief Move by the symbol class.
+   *
+   * \param  from  State to move from.
+   * \param  cls   Symbol class.
+   * \return       State to move to, the start state at least.
+   */
+  StateId MoveByClass(const StateId& from, uint32_t cls) const {
+    return delta_[from * num_of_classes_ + cls];
+  }
+
+  /// Is the state the end of some chain in the trie?
+  bool IsAcceptable(const StateId& state) const { return accepted_[state] != 0; }
+
+  /// Get chain identifiers found in the state.
+  AttributeList GetStateAttributes(const StateId& state) const {
+    const Attribute* attrs = attrs_.empty() ? NULL : &attrs_[0];
+    return AttributeList(attrs + attr_offsets_[state], attrs + attr_offsets_[state + 1]);
+  }
+
+private:
+  /// Type of symbol to class list.
+  typedef std::vector<std::pair<SymbolCode, uint32_t> > SymbolClassList;
+
+  /// Size of direct class lookup table for the symbols.
+  static size_t GetDirectTableSize(SymbolCode max_code) {
+    if (sizeof(SymbolCode) == 1) {
+      return 256;
+    }
+    return std::min(static_cast<size_t>(max_code) + 1, kMaxDirectSymbols);
+  }
+
+  size_t                 num_of_classes_; ///< Number of symbol classes.
+  std::vector<uint32_t>  direct_classes_; ///< Classes of the first symbols.
+  SymbolClassList        sparse_classes_; ///< Sorted classes of other symbols.
+  std::vector<StateId>   delta_;          ///< Move table.
+  std::vector<uint8_t>   accepted_;       ///< Acceptable state marks.
+  std::vector<uint32_t>  attr_offsets_;   ///< Begin of the attributes of each state, plus the end of the last one.
+  std::vector<Attribute> attrs_;          ///< Attributes.
+};
+
+template <typename Char, typename Attribute>
+template <class TrieImpl>
+void AcDfa<Char, Attribute>::Compile(const TrieImpl& trie) {
+  typedef typename TrieImpl::Transitions::TransTable TransTableImpl;
+  typedef std::map<SymbolCode, uint32_t> SymbolIdMap;
+
+  // Collect the trie symbols, the class 0 is for absent symbols.
+  const size_t num_of_states = trie.GetNumOfStates();
+  SymbolIdMap symbol_ids;
+  for (StateId state = 0; state < num_of_states; ++state) {
+    const TransTableImpl& moves = trie.GetMoveTable(state);
+    for (typename TransTableImpl::const_iterator move_it = moves.begin(); move_it != moves.end(); ++move_it) {
+      symbol_ids.insert(std::make_pair(static_cast<SymbolCode>(move_it->first), 0));
+    }
+  }
+  num_of_classes_ = 1;
+  for (typename SymbolIdMap::iterator it = symbol_ids.begin(); it != symbol_ids.end(); ++it) {
+    it->second = num_of_classes_++;
+  }
+
+  // Fill the table in breadth first order, so the fail state row is ready before the state row.
+  // The row of state is the row of its fail state, overwritten by the state moves.
+  delta_.assign(num_of_states * num_of_classes_, kStartState);
+  std::vector<StateId> fail_moves(num_of_states, kStartState);
+  std::vector<std::vector<Attribute> > states_attr(num_of_states);
+  std::list<StateId> work_states;
+  work_states.push_back(kStartState);
+  while (not work_states.empty()) {
+    const StateId state = work_states.front();
+    work_states.pop_front();
+    StateId* row = &delta_[state * num_of_classes_];
+    if (state != kStartState) {
+      const StateId* fail_row = &delta_[fail_moves[state] * num_of_classes_];
+      std::copy(fail_row, fail_row + num_of_classes_, row);
+    }
+
+    // Own chains and the chains of the fail state.
+    const typename TrieImpl::AttributeList own_attrs = trie.GetStateAttributes(state);
+    states_attr[state].assign(own_attrs.begin(), own_attrs.end());
+    if (state != kStartState) {
+      const std::vector<Attribute>& fail_attrs = states_attr[fail_moves[state]];
+      for (size_t i = 0; i < fail_attrs.size(); ++i) {
+        if (std::find(states_attr[state].begin(), states_attr[state].end(), fail_attrs[i]) == states_attr[state].end()) {
+          states_attr[state].push_back(fail_attrs[i]);
+        }
+      }
+    }
+
+    const TransTableImpl& moves = trie.GetMoveTable(state);
+    for (typename TransTableImpl::const_iterator move_it = moves.begin(); move_it != moves.end(); ++move_it) {
+      const uint32_t cls = symbol_ids[static_cast<SymbolCode>(move_it->first)];
+      // Fail move of the child is the move of this state fail state, the row keeps it yet.
+      fail_moves[move_it->second] = state == kStartState ? kStartState : row[cls];
+      row[cls] = move_it->second;
+      work_states.push_back(move_it->second);
+    }
+  }
+
+  // Symbol classes.
+  const SymbolCode max_code = symbol_ids.empty() ? 0 : symbol_ids.rbegin()->first;
+  direct_classes_.assign(GetDirectTableSize(max_code), 0);
+  sparse_classes_.clear();
+  for (typename SymbolIdMap::const_iterator it = symbol_ids.begin(); it != symbol_ids.end(); ++it) {
+    if (it->first < direct_classes_.size()) {
+      direct_classes_[it->first] = it->second;
+    } else {
+      sparse_classes_.push_back(*it);
+    }
+  }
+
+  // Acceptable states and attributes.
+  accepted_.resize(num_of_states);
+  attr_offsets_.assign(1, 0);
+  attr_offsets_.reserve(num_of_states + 1);
+  attrs_.clear();
+  for (StateId state = 0; state < num_of_states; ++state) {
+    accepted_[state] = trie.IsAcceptable(state) ? 1 : 0;
+    attrs_.insert(attrs_.end(), states_attr[state].begin(), states_attr[state].end());
+    attr_offsets_.push_back(attrs_.size());
+  }
+}
+
+/**
+ * \brief Compile Aho-Corasick trie.
+ *
+ * \param      trie The trie.
+ * \param[out] dfa  The compiled automaton.
+ */
+template <class TransImpl, typename Char, typename Attribute>
+void Compile(const AhoCorasickTrie<TransImpl, Attribute>& trie, AcDfa<Char, Attribute>& dfa) {
+  dfa.Compile(trie);
+}
+
+/**
+ * \brief Aho-Corasick mover for the compiled automaton: a move is a table load.
+ */
+template <typename Char, typename Attribute>
+class AcProcessor<AcDfa<Char, Attribute> > {
+public:
+  /// Initialization by the automaton.
+  explicit AcProcessor(const AcDfa<Char, Attribute>& dfa) : dfa_(dfa) {}
+
+  /**
+   * \brief Move implementation.
+   *
+   * \param  from State to move from.
+   * \param  sym  Symbol to move.
+   * \return      State to move to.
+   */
+  StateId Move(const StateId& from, const Char& sym) const {
+    return dfa_.Move(from, sym);
+  }
+
+private:
+  const AcDfa<Char, Attribute>& dfa_; ///< Reference to the automaton.
+};
+
+}} // namespace strutext, automata.
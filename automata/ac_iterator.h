@@ -34,7 +34,7 @@ class AcSymbolIterator : public boost::iterator_facade<
   AcSymbolIterator<AcTrie, SymbolIterator>,
   StateId,
   boost::forward_traversal_tag,
-  const typename AcTrie::AttributeList&> {
+  typename AcTrie::AttributeList> {
 private:
   /// Declaration for iterator_facade.
   friend class boost::iterator_core_access;
@@ -101,7 +101,7 @@ private:
   /**
    * \brief The attributes' set related to the current state.
    */
-  const AttributeList& dereference() const {
+  AttributeList dereference() const {
     return ac_trie_.GetStateAttributes(state_);
   }
 
@@ -227,4 +227,159 @@ private:
   const AcTrie&  ac_trie_; ///< Aho-Corasick trie reference.
 };
 
+/// Semantics of non-overlapping chain search.
+enum AcMatchKind {
+  kLeftmostLongest, ///< The leftmost chain, the longest of the chains starting there.
+  kLeftmostFirst    ///< The leftmost chain, the one with the least identifier of the chains starting there.
+};
+
+/**
+ * \brief Chain found by AcMatchIterator.
+ */
+template <typename ChainId>
+struct AcMatch {
+  /// Default initialization.
+  AcMatch()
+    : begin_(0)
+    , end_(0)
+    , id_() {}
+
+  size_t  begin_; ///< Position of the first chain symbol.
+  size_t  end_;   ///< Position after the last chain symbol.
+  ChainId id_;    ///< Chain identifier.
+};
+
+/**
+ * \brief Iterator by non-overlapping chains, found by Aho-Corasick automaton.
+ *
+ * Unlike AcChainIterator, which reports all the chains ending at each position, the iterator
+ * reports the leftmost chain, then searches the next one after its end. Of the chains starting
+ * at the same position, the longest one or the one with the least identifier is chosen. The
+ * search goes on while the automaton state, the longest suffix of the text which is a trie
+ * prefix, starts not after the candidate, so no chain is post-filtered and no memory is allocated.
+ * If several identifiers are set for the same chain, the least one is reported: it is the first
+ * of the match state attributes, as FailMoveGenerator sorts the own chains of each state.
+ *
+ * The trie fail moves and match states must be generated by FailMoveGenerator.
+ */
+template <class AcTrie, typename SymbolIterator>
+class AcMatchIterator : public boost::iterator_facade<
+  AcMatchIterator<AcTrie, SymbolIterator>,
+  AcMatch<typename AcTrie::ChainId>,
+  boost::forward_traversal_tag,
+  const AcMatch<typename AcTrie::ChainId>&> {
+private:
+  // Declaration for iterator_facade.
+  friend class boost::iterator_core_access;
+
+  /// Aho-Corasick trie processor type.
+  typedef AcProcessor<AcTrie> AcProcessorImpl;
+
+  /// Type of chain identifier.
+  typedef typename AcTrie::ChainId ChainId;
+
+  /// Type of found chain.
+  typedef AcMatch<ChainId> Match;
+
+public:
+  /**
+   * \brief Default initialization, the end iterator.
+   */
+  AcMatchIterator()
+    : kind_(kLeftmostLongest)
+    , found_(false)
+    , pos_(0)
+    , ac_trie_(NULL) {}
+
+  /**
+   * \brief Initialization by input stream.
+   *
+   * \param begin   Iterator of the stream's begin.
+   * \param end     Iterator of the stream's end.
+   * \param ac_trie The trie.
+   * \param kind    Which of the chains starting at the same position is reported.
+   */
+  AcMatchIterator(const SymbolIterator& begin, const SymbolIterator& end, const AcTrie& ac_trie,
+                  AcMatchKind kind = kLeftmostLongest)
+    : kind_(kind)
+    , found_(false)
+    , pos_(0)
+    , it_(begin)
+    , end_(end)
+    , ac_trie_(&ac_trie) {
+    increment();
+  }
+
+private:
+  /**
+   * \brief Search of the next chain.
+   */
+  void increment() {
+    found_ = false;
+    if (ac_trie_ == NULL) {
+      return;
+    }
+    AcProcessorImpl ac_processor(*ac_trie_);
+    StateId state = kStartState;
+    SymbolIterator match_end;
+    while (it_ != end_) {
+      state = ac_processor.Move(state, *it_);
+      ++it_;
+      ++pos_;
+
+      // No chain, which starts not after the candidate, may be continued.
+      if (found_ and pos_ - ac_trie_->depths_[state] > match_.begin_) {
+        break;
+      }
+
+      const StateId match_state = ac_trie_->match_states_[state];
+      if (match_state != kInvalidState) {
+        const size_t begin = pos_ - ac_trie_->depths_[match_state];
+        const ChainId& id = ac_trie_->GetStateAttributes(match_state)[0];
+        if (not found_ or begin < match_.begin_
+            or (begin == match_.begin_ and (kind_ == kLeftmostLongest or id < match_.id_))) {
+          match_.begin_ = begin;
+          match_.end_ = pos_;
+          match_.id_ = id;
+          match_end = it_;
+          found_ = true;
+        }
+      }
+    }
+
+    // Continue after the chain found.
+    if (found_) {
+      it_ = match_end;
+      pos_ = match_.end_;
+    }
+  }
+
+  /**
+   * \brief Compare iterators.
+   * \param  other The iterator object to compare.
+   */
+  bool equal(const AcMatchIterator& other) const {
+    if (not found_ or not other.found_) {
+      return found_ == other.found_;
+    }
+    return match_.end_ == other.match_.end_;
+  }
+
+  /**
+   * \brief Return current chain.
+   */
+  const Match& dereference() const {
+    return match_;
+  }
+
+private:
+  AcMatchKind    kind_;    ///< Search semantics.
+  bool           found_;   ///< Is the chain found?
+  Match          match_;   ///< The chain found.
+  size_t         pos_;     ///< The current symbol position.
+  SymbolIterator it_;      ///< The current iterator.
+  SymbolIterator end_;     ///< End of stream iterator.
+  const AcTrie*  ac_trie_; ///< Aho-Corasick trie.
+};
+
 }} // namespace strutext, automata.
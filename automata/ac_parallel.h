@@ -0,0 +1,173 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Multi-threaded Aho-Corasick search in large texts.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/ref.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "aho_corasick.h"
+
+namespace strutext { namespace automata {
+
+/// Default size of text chunk scanned by a thread at once.
+const size_t kDefaultAcChunkSize = 1 << 22;
+
+/**
+ * \brief Length of the longest chain of the trie.
+ *
+ * \param  trie The trie.
+ * \return      Maximal depth of the trie states.
+ */
+template <class TrieImpl>
+size_t GetMaxChainLength(const TrieImpl& trie) {
+  typedef typename TrieImpl::Transitions::TransTable TransTableImpl;
+  size_t max_len = 0;
+  std::vector<std::pair<StateId, size_t> > work_states(1, std::make_pair(kStartState, 0));
+  while (not work_states.empty()) {
+    const std::pair<StateId, size_t> state = work_states.back();
+    work_states.pop_back();
+    max_len = std::max(max_len, state.second);
+    const TransTableImpl& moves = trie.GetMoveTable(state.first);
+    for (typename TransTableImpl::const_iterator move_it = moves.begin(); move_it != moves.end(); ++move_it) {
+      work_states.push_back(std::make_pair(move_it->second, state.second + 1));
+    }
+  }
+  return max_len;
+}
+
+/**
+ * \brief Chain search in a chunk of the text.
+ *
+ * The scan starts max_len - 1 symbols before the chunk, so the automaton state is the same as
+ * in the whole text scan at the chunk begin: the state depth is not greater than max_len.
+ * Only chains ending in the chunk are reported.
+ */
+template <class AcTrie>
+struct AcChunkScan {
+  /// Chain identifier type.
+  typedef typename AcTrie::ChainId ChainId;
+
+  /// Type of found chain: end position in the text and the chain identifier.
+  typedef std::pair<size_t, ChainId> Match;
+
+  /// Initialization.
+  AcChunkScan(const AcTrie& trie, const char* data, size_t begin, size_t end, size_t max_len)
+    : trie_(&trie)
+    , data_(data)
+    , begin_(begin)
+    , end_(end)
+    , max_len_(max_len) {}
+
+  /// Do the scan, the errors are remembered to be passed to the caller thread.
+  void operator()() {
+    try {
+      matches_.clear();
+      AcProcessor<AcTrie> processor(*trie_);
+      StateId state = kStartState;
+      const size_t warm_up = std::min(begin_, max_len_ > 0 ? max_len_ - 1 : 0);
+      for (size_t pos = begin_ - warm_up; pos < end_; ++pos) {
+        state = processor.Move(state, data_[pos]);
+        if (pos >= begin_) {
+          const typename AcTrie::AttributeList& attrs = trie_->GetStateAttributes(state);
+          for (size_t i = 0; i < attrs.size(); ++i) {
+            matches_.push_back(Match(pos + 1, attrs[i]));
+          }
+        }
+      }
+    } catch (const std::exception& err) {
+      error_ = err.what();
+      if (error_.empty()) {
+        error_ = "chunk scan failed";
+      }
+    } catch (...) {
+      error_ = "chunk scan failed";
+    }
+  }
+
+  const AcTrie*      trie_;    ///< The trie.
+  const char*        data_;    ///< The text.
+  size_t             begin_;   ///< Begin of the chunk.
+  size_t             end_;     ///< End of the chunk.
+  size_t             max_len_; ///< Length of the longest chain.
+  std::vector<Match> matches_; ///< Found chains.
+  std::string        error_;   ///< Scan error.
+};
+
+/**
+ * \brief Search chains of Aho-Corasick trie in the text by several threads.
+ *
+ * The text is split in chunks, which are scanned by the threads in parallel; each chunk scan starts
+ * with overlap of the longest chain length. The trie is shared, so the fail moves must be generated
+ * before the call. The text is processed by rounds of num_of_threads chunks, so the memory for found
+ * chains is bounded by the round size. The callback is called in the caller thread, in order of chain
+ * ends, exactly as AcChainIterator finds them: callback(end, chain_id), where end is the position
+ * after the last chain symbol.
+ *
+ * \param trie           Aho-Corasick trie with char symbols.
+ * \param data           The text.
+ * \param size           Size of the text.
+ * \param num_of_threads Number of threads, the caller thread is one of them.
+ * \param callback       Functor to receive the chains found.
+ * \param chunk_size     Size of text chunk scanned by a thread at once.
+ */
+template <class AcTrie, class Callback>
+void ParallelAcScan(const AcTrie& trie, const char* data, size_t size, size_t num_of_threads, Callback callback,
+                    size_t chunk_size = kDefaultAcChunkSize) {
+  typedef AcChunkScan<AcTrie> ChunkScan;
+  num_of_threads = std::max<size_t>(1, num_of_threads);
+  chunk_size = std::max<size_t>(1, chunk_size);
+  const size_t max_len = GetMaxChainLength(trie);
+  for (size_t round_begin = 0; round_begin < size; round_begin += num_of_threads * chunk_size) {
+    std::vector<ChunkScan> chunks;
+    for (size_t begin = round_begin; begin < size and chunks.size() < num_of_threads; begin += chunk_size) {
+      chunks.push_back(ChunkScan(trie, data, begin, std::min(size, begin + chunk_size), max_len));
+    }
+    // The started threads refer to the chunks, they are joined even if a thread cannot be created.
+    boost::thread_group threads;
+    try {
+      for (size_t i = 1; i < chunks.size(); ++i) {
+        threads.create_thread(boost::ref(chunks[i]));
+      }
+      chunks[0]();
+    } catch (...) {
+      threads.join_all();
+      throw;
+    }
+    threads.join_all();
+
+    for (size_t i = 0; i < chunks.size(); ++i) {
+      if (not chunks[i].error_.empty()) {
+        throw std::runtime_error(chunks[i].error_);
+      }
+      for (size_t j = 0; j < chunks[i].matches_.size(); ++j) {
+        callback(chunks[i].matches_[j].first, chunks[i].matches_[j].second);
+      }
+    }
+  }
+}
+
+}} // namespace strutext, automata.
@@ -18,6 +18,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #include <list>
 #include <vector>
 #include <algorithm>
@@ -40,7 +42,12 @@ struct AhoCorasickTrie : public Trie<TransImpl, Attribute> {
   /// Fail transitions set type.
   typedef std::vector<StateId> FailMoveList;
 
-  FailMoveList fail_moves_; ///< Fail transitions set.
+  /// State depths type.
+  typedef std::vector<uint32_t> DepthList;
+
+  FailMoveList fail_moves_;   ///< Fail transitions set.
+  DepthList    depths_;       ///< Depth of each state, the length of chains ending in acceptable state.
+  FailMoveList match_states_; ///< The state or its nearest fail state, which is acceptable, or kInvalidState.
 };
 
 /**
@@ -52,6 +59,9 @@ public:
   /**
    * \brief Fail transitions generation.
    *
+   * The chains of fail states are added to the state attributes, the attributes are pooled. The
+   * list of each state begins with its own chain identifiers in ascending order.
+   *
    * \param[out] ac_trie Trie to fill by fail transitions.
    */
   static void Generate(AcTrie& ac_trie) {
@@ -112,25 +122,93 @@ public:
       }
     }
 
-    // Process including chains.
-    for (StateId i = kStartState; i < ac_trie.GetNumOfStates(); ++i) {
-      StateId state = i;
-      StateId fstate = ac_trie.fail_moves_[state];
-      while (fstate != kStartState) {
-        // Add the chain index to the attribute list if the state is acceptable.
-        if (ac_trie.IsAcceptable(fstate)) {
-          const typename AcTrie::AttributeList& chain_ids = ac_trie.GetStateAttributes(fstate);
-          // Go through identifiers.
-          for (typename AcTrie::AttributeList::const_iterator chain_it = chain_ids.begin(); chain_it != chain_ids.end(); ++chain_it) {
-            // Search the identifier in the attribute list and add if the identifier hasn't been found.
-            const typename AcTrie::AttributeList& ids = ac_trie.GetStateAttributes(state);
-            if (std::find(ids.begin(), ids.end(), *chain_it) == ids.end()) {
-              ac_trie.AddAttribute(state, *chain_it);
-            }
+    // Process including chains. In breadth first order the fail state has got the chains of its
+    // fail states before the state, so the state gets its own chains and the chains of its fail
+    // state. The lists are built in one pool and then are placed in the state order.
+    std::vector<StateId> order;
+    GetBreadthFirstOrder(ac_trie, order);
+    const size_t num_of_states = ac_trie.GetNumOfStates();
+    typename AcTrie::AttrPool pool;
+    std::vector<uint32_t> begins(num_of_states, 0), sizes(num_of_states, 0);
+    for (size_t i = 0; i < order.size(); ++i) {
+      const StateId state = order[i];
+      const typename AcTrie::AttributeList own = ac_trie.GetStateAttributes(state);
+      begins[state] = pool.size();
+      pool.insert(pool.end(), own.begin(), own.end());
+      std::sort(pool.begin() + begins[state], pool.end());
+      if (state != kStartState) {
+        const StateId fstate = ac_trie.fail_moves_[state];
+        for (uint32_t j = begins[fstate]; j < begins[fstate] + sizes[fstate]; ++j) {
+          const typename AcTrie::Attribute chain_id = pool[j];
+          if (std::find(own.begin(), own.end(), chain_id) == own.end()) {
+            pool.push_back(chain_id);
           }
         }
-        // Go the next fail transition.
-        fstate = ac_trie.fail_moves_[fstate];
+      }
+      sizes[state] = pool.size() - begins[state];
+    }
+    typename AcTrie::AttrOffsetList offsets(1, 0);
+    offsets.reserve(num_of_states + 1);
+    typename AcTrie::AttrPool attrs;
+    attrs.reserve(pool.size());
+    for (StateId state = 0; state < num_of_states; ++state) {
+      attrs.insert(attrs.end(), pool.begin() + begins[state], pool.begin() + begins[state] + sizes[state]);
+      offsets.push_back(attrs.size());
+    }
+    ac_trie.SetPooledAttributes(offsets, attrs);
+
+    GenerateMatchStates(ac_trie);
+  }
+
+  /**
+   * \brief State depths and match states generation, the fail moves should be generated.
+   *
+   * The longest chain found in a state ends in its match state, its length is the match state depth.
+   *
+   * \param[out] ac_trie Trie to fill.
+   */
+  static void GenerateMatchStates(AcTrie& ac_trie) {
+    typedef typename AcTrie::Transitions::TransTable TransTableImpl;
+
+    const size_t num_of_states = ac_trie.GetNumOfStates();
+    ac_trie.depths_.assign(num_of_states, 0);
+    ac_trie.match_states_.assign(num_of_states, kInvalidState);
+    if (num_of_states <= kStartState or ac_trie.fail_moves_.size() != num_of_states) {
+      return;
+    }
+
+    // Breadth first order, so the fail state is processed before the state.
+    std::vector<StateId> order;
+    GetBreadthFirstOrder(ac_trie, order);
+    for (size_t i = 0; i < order.size(); ++i) {
+      const StateId state = order[i];
+      if (ac_trie.IsAcceptable(state)) {
+        ac_trie.match_states_[state] = state;
+      } else if (state != kStartState) {
+        ac_trie.match_states_[state] = ac_trie.match_states_[ac_trie.fail_moves_[state]];
+      }
+      const TransTableImpl& st_moves = ac_trie.GetMoveTable(state);
+      for (typename TransTableImpl::const_iterator move_it = st_moves.begin(); move_it != st_moves.end(); ++move_it) {
+        ac_trie.depths_[move_it->second] = ac_trie.depths_[state] + 1;
+      }
+    }
+  }
+
+private:
+  /**
+   * \brief List the trie states in breadth first order.
+   *
+   * \param      ac_trie The trie.
+   * \param[out] order   The states, starting from the start state.
+   */
+  static void GetBreadthFirstOrder(const AcTrie& ac_trie, std::vector<StateId>& order) {
+    typedef typename AcTrie::Transitions::TransTable TransTableImpl;
+    order.assign(1, kStartState);
+    order.reserve(ac_trie.GetNumOfStates());
+    for (size_t i = 0; i < order.size(); ++i) {
+      const TransTableImpl& st_moves = ac_trie.GetMoveTable(order[i]);
+      for (typename TransTableImpl::const_iterator move_it = st_moves.begin(); move_it != st_moves.end(); ++move_it) {
+        order.push_back(move_it->second);
       }
     }
   }
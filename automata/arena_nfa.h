@@ -0,0 +1,607 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  NFA with states and moves kept in arrays, moves by symbol ranges.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/type_traits/make_unsigned.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "fsm_defs.h"
+#include "nfa.h"
+#include "dfa_minimizer.h"
+
+namespace strutext { namespace automata {
+
+/**
+ * \brief NFA with states and moves kept in arrays.
+ *
+ * States are numbered from 0, all the moves are kept in one array and the moves of a state are
+ * linked in a list by the move indexes, the same is for the state attributes. So a state costs
+ * three numbers and a move is a record in the array, nothing is allocated per state or per move.
+ * Move label is the range of symbols, thus a symbol class is one move instead of a move per symbol.
+ * Symbols are compared as unsigned codes.
+ *
+ * Automata are built by Thompson construction: each operator takes fragments with one entry and
+ * one exit state and returns the new fragment, states and moves are appended in place and nothing
+ * is copied. The states of fragments are never merged, so the fragments are combined in any way,
+ * but a fragment is used once: to use it twice, build it twice.
+ */
+template <typename SymbolCode, typename Attribute>
+class ArenaNfa {
+public:
+  /// Unsigned symbol type, range bounds are compared in it.
+  typedef typename boost::make_unsigned<SymbolCode>::type UnsignedCode;
+
+  /// End of move or attribute list.
+  static const uint32_t kNoLink = 0xFFFFFFFF;
+
+  /// Move of the automaton.
+  struct Move {
+    UnsignedCode first_;   ///< First symbol of the range.
+    UnsignedCode last_;    ///< Last symbol of the range, included.
+    StateId      to_;      ///< State to move to.
+    uint32_t     next_;    ///< Next move of the same state.
+    bool         epsilon_; ///< Is it epsilon move?
+  };
+
+  /// State attribute.
+  struct AttrLink {
+    Attribute attr_; ///< The attribute.
+    uint32_t  next_; ///< Next attribute of the same state.
+  };
+
+  /// Part of the automaton with one entry and one exit state.
+  struct Fragment {
+    /// Initialization.
+    Fragment(StateId start = 0, StateId end = 0)
+      : start_(start)
+      , end_(end) {}
+
+    StateId start_; ///< Entry state.
+    StateId end_;   ///< Exit state.
+  };
+
+  /// Default initialization: empty automaton.
+  ArenaNfa()
+    : start_(0) {}
+
+  /// Reserve memory for the passed number of states and moves.
+  void Reserve(size_t num_of_states, size_t num_of_moves) {
+    first_moves_.reserve(num_of_states);
+    first_attrs_.reserve(num_of_states);
+    accepted_.reserve(num_of_states);
+    moves_.reserve(num_of_moves);
+  }
+
+  /// Add new state, return its number.
+  StateId AddState() {
+    first_moves_.push_back(kNoLink);
+    first_attrs_.push_back(kNoLink);
+    accepted_.push_back(0);
+    return first_moves_.size() - 1;
+  }
+
+  /**
+   * \brief Add move by the symbol range.
+   *
+   * \param from  State to move from.
+   * \param to    State to move to.
+   * \param first First symbol of the range.
+   * \param last  Last symbol of the range, included.
+   */
+  void AddMove(StateId from, StateId to, const SymbolCode& first, const SymbolCode& last) {
+    if (static_cast<UnsignedCode>(last) < static_cast<UnsignedCode>(first)) {
+      throw std::invalid_argument("Invalid symbol range in NFA move");
+    }
+    AddMove(from, to, static_cast<UnsignedCode>(first), static_cast<UnsignedCode>(last), false);
+  }
+
+  /// Add epsilon move.
+  void AddEpsilonMove(StateId from, StateId to) {
+    AddMove(from, to, UnsignedCode(), UnsignedCode(), true);
+  }
+
+  /// Add attribute to the state.
+  void AddAttribute(StateId state, const Attribute& attr) {
+    AttrLink link;
+    link.attr_ = attr;
+    link.next_ = first_attrs_[state];
+    first_attrs_[state] = attrs_.size();
+    attrs_.push_back(link);
+  }
+
+  /// Make the state acceptable.
+  void AddToAcceptedSet(StateId state) { accepted_[state] = 1; }
+
+  /// Make the exit state of the fragment acceptable with the attribute.
+  void Accept(const Fragment& fragment, const Attribute& attr) {
+    AddToAcceptedSet(fragment.end_);
+    AddAttribute(fragment.end_, attr);
+  }
+
+  /// Set the start state.
+  void SetStartState(StateId state) { start_ = state; }
+
+  /// Fragment accepting the symbol range.
+  Fragment Range(const SymbolCode& first, const SymbolCode& last) {
+    const Fragment result = NewFragment();
+    AddMove(result.start_, result.end_, first, last);
+    return result;
+  }
+
+  /// Fragment accepting the symbol.
+  Fragment Symbol(const SymbolCode& symbol) {
+    return Range(symbol, symbol);
+  }
+
+  /// Fragment accepting the empty string.
+  Fragment Empty() {
+    const Fragment result = NewFragment();
+    AddEpsilonMove(result.start_, result.end_);
+    return result;
+  }
+
+  /// Fragment accepting the left string followed by the right one.
+  Fragment Concat(const Fragment& left, const Fragment& right) {
+    AddEpsilonMove(left.end_, right.start_);
+    return Fragment(left.start_, right.end_);
+  }
+
+  /// Fragment accepting the left string or the right one.
+  Fragment Union(const Fragment& left, const Fragment& right) {
+    const Fragment result = NewFragment();
+    AddBranch(result, left);
+    AddBranch(result, right);
+    return result;
+  }
+
+  /// Fragment accepting any of the passed fragments strings, the list must not be empty.
+  Fragment Union(const std::vector<Fragment>& fragments) {
+    const Fragment result = NewFragment();
+    for (size_t i = 0; i < fragments.size(); ++i) {
+      AddBranch(result, fragments[i]);
+    }
+    return result;
+  }
+
+  /// Fragment accepting the fragment string repeated zero or more times.
+  Fragment Iteration(const Fragment& operand) {
+    const Fragment result = Optional(operand);
+    AddEpsilonMove(operand.end_, operand.start_);
+    return result;
+  }
+
+  /// Fragment accepting the fragment string repeated one or more times.
+  Fragment PositiveIteration(const Fragment& operand) {
+    const Fragment result = NewFragment();
+    AddBranch(result, operand);
+    AddEpsilonMove(operand.end_, operand.start_);
+    return result;
+  }
+
+  /// Fragment accepting the fragment string or the empty string.
+  Fragment Optional(const Fragment& operand) {
+    const Fragment result = NewFragment();
+    AddBranch(result, operand);
+    AddEpsilonMove(result.start_, result.end_);
+    return result;
+  }
+
+  /// Return number of states.
+  size_t GetNumOfStates() const { return first_moves_.size(); }
+
+  /// Return number of moves.
+  size_t GetNumOfMoves() const { return moves_.size(); }
+
+  /// Get the start state.
+  StateId GetStartState() const { return start_; }
+
+  /// Is the state acceptable?
+  bool IsAcceptable(StateId state) const { return accepted_[state] != 0; }
+
+  /// Get index of the first move of the state, or kNoLink.
+  uint32_t GetFirstMove(StateId state) const { return first_moves_[state]; }
+
+  /// Get the move by its index.
+  const Move& GetMove(uint32_t index) const { return moves_[index]; }
+
+  /// Get index of the first attribute of the state, or kNoLink.
+  uint32_t GetFirstAttribute(StateId state) const { return first_attrs_[state]; }
+
+  /// Get the attribute by its index.
+  const AttrLink& GetAttribute(uint32_t index) const { return attrs_[index]; }
+
+  /// Return number of bytes used by the automaton.
+  size_t GetMemorySize() const {
+    return sizeof(*this) + first_moves_.capacity() * sizeof(uint32_t) + first_attrs_.capacity() * sizeof(uint32_t)
+           + accepted_.capacity() + moves_.capacity() * sizeof(Move) + attrs_.capacity() * sizeof(AttrLink);
+  }
+
+  /**
+   * \brief Partition the symbols to classes.
+   *
+   * The symbols of a class are not distinguished by any move: each move range is a union of
+   * classes. The class i is [starts[i], starts[i + 1]) range, the last one is up to the maximal
+   * symbol. Class 0 starts at 0.
+   *
+   * \param[out] starts First symbols of the classes, sorted.
+   */
+  void GetSymbolClasses(std::vector<UnsignedCode>& starts) const {
+    const UnsignedCode max_code = ~UnsignedCode();
+    starts.assign(1, UnsignedCode());
+    for (size_t i = 0; i < moves_.size(); ++i) {
+      if (not moves_[i].epsilon_) {
+        starts.push_back(moves_[i].first_);
+        if (moves_[i].last_ != max_code) {
+          starts.push_back(moves_[i].last_ + 1);
+        }
+      }
+    }
+    std::sort(starts.begin(), starts.end());
+    starts.erase(std::unique(starts.begin(), starts.end()), starts.end());
+  }
+
+private:
+  /// Add move implementation.
+  void AddMove(StateId from, StateId to, UnsignedCode first, UnsignedCode last, bool epsilon) {
+    Move move;
+    move.first_ = first;
+    move.last_ = last;
+    move.to_ = to;
+    move.next_ = first_moves_[from];
+    move.epsilon_ = epsilon;
+    first_moves_[from] = moves_.size();
+    moves_.push_back(move);
+  }
+
+  /// New fragment of two states without moves.
+  Fragment NewFragment() {
+    const StateId start = AddState();
+    return Fragment(start, AddState());
+  }
+
+  /// Put the fragment between entry and exit states of the other one.
+  void AddBranch(const Fragment& fragment, const Fragment& branch) {
+    AddEpsilonMove(fragment.start_, branch.start_);
+    AddEpsilonMove(branch.end_, fragment.end_);
+  }
+
+  StateId               start_;       ///< Start state.
+  std::vector<uint32_t> first_moves_; ///< First move of each state.
+  std::vector<uint32_t> first_attrs_; ///< First attribute of each state.
+  std::vector<uint8_t>  accepted_;    ///< Acceptable state marks.
+  std::vector<Move>     moves_;       ///< All the moves.
+  std::vector<AttrLink> attrs_;       ///< All the attributes.
+};
+
+template <typename SymbolCode, typename Attribute>
+const uint32_t ArenaNfa<SymbolCode, Attribute>::kNoLink;
+
+/**
+ * \brief Symbol classes of the automaton.
+ *
+ * Maps the symbol to its class number by binary search in the class starts.
+ */
+template <typename SymbolCode>
+class SymbolClasses {
+public:
+  /// Unsigned symbol type.
+  typedef typename boost::make_unsigned<SymbolCode>::type UnsignedCode;
+
+  /// Default initialization: all the symbols are in class 0.
+  SymbolClasses()
+    : starts_(1, UnsignedCode()) {}
+
+  /// Build the classes of the automaton.
+  template <typename Attribute>
+  explicit SymbolClasses(const ArenaNfa<SymbolCode, Attribute>& nfa) {
+    nfa.GetSymbolClasses(starts_);
+  }
+
+  /// Return number of classes.
+  size_t GetNumOfClasses() const { return starts_.size(); }
+
+  /// Get first symbol of the class.
+  UnsignedCode GetFirstSymbol(uint32_t cls) const { return starts_[cls]; }
+
+  /// Get class of the symbol.
+  uint32_t GetClass(const SymbolCode& symbol) const {
+    return std::upper_bound(starts_.begin(), starts_.end(), static_cast<UnsignedCode>(symbol)) - starts_.begin() - 1;
+  }
+
+  /// Get the first class of the range, which is the union of classes.
+  uint32_t GetFirstClass(UnsignedCode first) const {
+    return std::lower_bound(starts_.begin(), starts_.end(), first) - starts_.begin();
+  }
+
+  /// Get the last class of the range, which is the union of classes.
+  uint32_t GetLastClass(UnsignedCode last) const {
+    if (last == static_cast<UnsignedCode>(~UnsignedCode())) {
+      return starts_.size() - 1;
+    }
+    return std::lower_bound(starts_.begin(), starts_.end(), static_cast<UnsignedCode>(last + 1)) - starts_.begin() - 1;
+  }
+
+private:
+  std::vector<UnsignedCode> starts_; ///< First symbols of the classes.
+};
+
+/**
+ * \brief Copy the NFA to the array one.
+ *
+ * \param      nfa    The NFA.
+ * \param[out] result The array NFA.
+ */
+template <typename SymbolCode, typename Attribute>
+void BuildArenaNfa(const Nfa<SymbolCode, Attribute>& nfa, ArenaNfa<SymbolCode, Attribute>& result) {
+  typedef Nfa<SymbolCode, Attribute> NfaImpl;
+
+  result = ArenaNfa<SymbolCode, Attribute>();
+  boost::unordered_map<typename NfaImpl::State*, StateId> numbers;
+  for (typename NfaImpl::StateStorage::const_iterator st_it = nfa.GetStates().begin();
+        st_it != nfa.GetStates().end(); ++st_it) {
+    numbers[st_it->get()] = result.AddState();
+  }
+  for (typename NfaImpl::StateStorage::const_iterator st_it = nfa.GetStates().begin();
+        st_it != nfa.GetStates().end(); ++st_it) {
+    const StateId state = numbers[st_it->get()];
+    const typename NfaImpl::State::TransTable& moves = (*st_it)->trans_table_;
+    for (typename NfaImpl::State::TransTable::const_iterator tr_it = moves.begin(); tr_it != moves.end(); ++tr_it) {
+      if (tr_it->first.type_ == NfaImpl::Symbol::SYMBOL_MT) {
+        result.AddMove(state, numbers[tr_it->second], tr_it->first.symbol_, tr_it->first.symbol_);
+      } else {
+        result.AddEpsilonMove(state, numbers[tr_it->second]);
+      }
+    }
+    for (typename NfaImpl::State::AttrList::const_iterator it = (*st_it)->attr_list_.begin();
+          it != (*st_it)->attr_list_.end(); ++it) {
+      result.AddAttribute(state, *it);
+    }
+    if (nfa.GetAcceptedStates().count(st_it->get())) {
+      result.AddToAcceptedSet(state);
+    }
+  }
+  if (nfa.GetStartState() != NULL) {
+    result.SetStartState(numbers[nfa.GetStartState()]);
+  }
+}
+
+namespace details {
+
+/**
+ * \brief Add the states reachable by epsilon moves.
+ *
+ * \param         nfa    The NFA.
+ * \param[in,out] states The states, unique; the closure on return, sorted.
+ * \param[in,out] stamps Visit stamps of the NFA states, zero filled.
+ * \param[in,out] stamp  The last used stamp.
+ */
+template <typename SymbolCode, typename Attribute>
+void CloseStates(const ArenaNfa<SymbolCode, Attribute>& nfa, std::vector<StateId>& states,
+                 std::vector<uint32_t>& stamps, uint32_t& stamp) {
+  typedef ArenaNfa<SymbolCode, Attribute> NfaImpl;
+
+  if (++stamp == 0) {
+    stamps.assign(stamps.size(), 0);
+    stamp = 1;
+  }
+  for (size_t i = 0; i < states.size(); ++i) {
+    stamps[states[i]] = stamp;
+  }
+  for (size_t i = 0; i < states.size(); ++i) {
+    for (uint32_t j = nfa.GetFirstMove(states[i]); j != NfaImpl::kNoLink; j = nfa.GetMove(j).next_) {
+      const typename NfaImpl::Move& move = nfa.GetMove(j);
+      if (move.epsilon_ and stamps[move.to_] != stamp) {
+        stamps[move.to_] = stamp;
+        states.push_back(move.to_);
+      }
+    }
+  }
+  std::sort(states.begin(), states.end());
+}
+
+/**
+ * \brief Collect the acceptance, the attributes and the move targets of the NFA states.
+ *
+ * \param         nfa         The NFA.
+ * \param         classes     Symbol classes of the NFA.
+ * \param         states      The NFA states.
+ * \param[in,out] is_accepted Is some state acceptable?
+ * \param[in,out] attrs       The attributes of the states are added.
+ * \param[in,out] targets     The targets of the moves by each class are added.
+ * \param[in,out] touched     The classes, whose targets were empty, are added.
+ */
+template <typename SymbolCode, typename Attribute>
+void CollectMoves(const ArenaNfa<SymbolCode, Attribute>& nfa, const SymbolClasses<SymbolCode>& classes,
+                  const std::vector<StateId>& states, bool& is_accepted, std::vector<Attribute>& attrs,
+                  std::vector<std::vector<StateId> >& targets, std::vector<uint32_t>& touched) {
+  typedef ArenaNfa<SymbolCode, Attribute> NfaImpl;
+
+  for (size_t i = 0; i < states.size(); ++i) {
+    is_accepted = is_accepted or nfa.IsAcceptable(states[i]);
+    for (uint32_t j = nfa.GetFirstAttribute(states[i]); j != NfaImpl::kNoLink; j = nfa.GetAttribute(j).next_) {
+      attrs.push_back(nfa.GetAttribute(j).attr_);
+    }
+    for (uint32_t j = nfa.GetFirstMove(states[i]); j != NfaImpl::kNoLink; j = nfa.GetMove(j).next_) {
+      const typename NfaImpl::Move& move = nfa.GetMove(j);
+      if (move.epsilon_) {
+        continue;
+      }
+      const uint32_t last = classes.GetLastClass(move.last_);
+      for (uint32_t cls = classes.GetFirstClass(move.first_); cls <= last; ++cls) {
+        if (targets[cls].empty()) {
+          touched.push_back(cls);
+        }
+        targets[cls].push_back(move.to_);
+      }
+    }
+  }
+}
+
+/**
+ * \brief Make the move targets the deterministic state: sort, close and drop the excluded states.
+ *
+ * \param         nfa      The NFA.
+ * \param[in,out] states   The move targets.
+ * \param         excluded Flags of the excluded states, or empty.
+ * \param[in,out] stamps   Visit stamps of the NFA states.
+ * \param[in,out] stamp    The last used stamp.
+ */
+template <typename SymbolCode, typename Attribute>
+void MakeStateList(const ArenaNfa<SymbolCode, Attribute>& nfa, std::vector<StateId>& states,
+                   const std::vector<bool>& excluded, std::vector<uint32_t>& stamps, uint32_t& stamp) {
+  std::sort(states.begin(), states.end());
+  states.erase(std::unique(states.begin(), states.end()), states.end());
+  CloseStates(nfa, states, stamps, stamp);
+  if (not excluded.empty()) {
+    size_t size = 0;
+    for (size_t i = 0; i < states.size(); ++i) {
+      if (not excluded[states[i]]) {
+        states[size++] = states[i];
+      }
+    }
+    states.resize(size);
+  }
+}
+
+} // namespace details.
+
+/**
+ * \brief Subset construction of deterministic automaton over symbol classes.
+ *
+ * A move by a range is a move by each class of the range, so the result has a move per class and
+ * its symbols are the class numbers. A state of the result is the sorted list of NFA states, closed
+ * by epsilon moves, the lists are compared in full. The attributes of a state are the attributes of
+ * all its NFA states.
+ *
+ * The unanchored automaton accepts the texts ending by the NFA language, so it searches the language
+ * from each text position. The closure of the start state is then the part of each state, it is not
+ * kept in the lists, and its attributes and move targets are collected once. Else the starts of all
+ * the rules would be closed and compared in each state.
+ *
+ * \param      nfa        The NFA.
+ * \param      classes    Symbol classes of the NFA.
+ * \param[out] dfa        The deterministic automaton, the start state is 0.
+ * \param      unanchored Is the automaton unanchored?
+ */
+template <typename SymbolCode, typename Attribute>
+void SubsetConstruction(const ArenaNfa<SymbolCode, Attribute>& nfa, const SymbolClasses<SymbolCode>& classes,
+                        DfaGraph<uint32_t, Attribute>& dfa, bool unanchored = false) {
+  typedef DfaGraph<uint32_t, Attribute>                                      Graph;
+  typedef std::vector<StateId>                                               StateList;
+  typedef boost::unordered_map<StateList, StateId, boost::hash<StateList> > StateListMap;
+
+  dfa = Graph();
+  if (nfa.GetNumOfStates() == 0) {
+    return;
+  }
+  const size_t num_of_classes = classes.GetNumOfClasses();
+  std::vector<uint32_t> stamps(nfa.GetNumOfStates(), 0);
+  uint32_t stamp = 0;
+  StateList start_list(1, nfa.GetStartState());
+  details::CloseStates(nfa, start_list, stamps, stamp);
+
+  // The start closure part of each state of the unanchored automaton.
+  std::vector<StateList> targets(num_of_classes);
+  std::vector<uint32_t> touched;
+  std::vector<bool> in_start;
+  std::vector<StateList> start_targets;
+  std::vector<Attribute> start_attrs;
+  bool start_accepted = false;
+  std::vector<StateId> start_moves;
+  if (unanchored) {
+    in_start.resize(nfa.GetNumOfStates(), false);
+    for (size_t i = 0; i < start_list.size(); ++i) {
+      in_start[start_list[i]] = true;
+    }
+    details::CollectMoves(nfa, classes, start_list, start_accepted, start_attrs, targets, touched);
+    for (size_t i = 0; i < touched.size(); ++i) {
+      details::MakeStateList(nfa, targets[touched[i]], in_start, stamps, stamp);
+    }
+    touched.clear();
+    start_targets.swap(targets);
+    targets.resize(num_of_classes);
+    start_moves.resize(num_of_classes, kInvalidState);
+  }
+
+  // The map keys are not moved by rehashing, so the list of keys is the list of states.
+  StateListMap dfa_states;
+  std::vector<const StateList*> state_lists;
+  state_lists.push_back(&dfa_states.insert(std::make_pair(unanchored ? StateList() : start_list, StateId(0))).first->first);
+
+  std::vector<Attribute> attrs;
+  StateList merged;
+  for (StateId state = 0; state < state_lists.size(); ++state) {
+    // Acceptance, attributes and targets of the moves by each class.
+    bool is_accepted = start_accepted;
+    attrs.assign(start_attrs.begin(), start_attrs.end());
+    details::CollectMoves(nfa, classes, *state_lists[state], is_accepted, attrs, targets, touched);
+    std::sort(attrs.begin(), attrs.end());
+    attrs.erase(std::unique(attrs.begin(), attrs.end()), attrs.end());
+    dfa.AddState(is_accepted, attrs.begin(), attrs.end());
+
+    // The unanchored automaton moves by each class, at least to the start closure.
+    if (unanchored) {
+      touched.resize(num_of_classes);
+      for (uint32_t cls = 0; cls < num_of_classes; ++cls) {
+        touched[cls] = cls;
+      }
+    } else {
+      std::sort(touched.begin(), touched.end());
+    }
+
+    // Moves by each class lead to the closure of their targets.
+    for (size_t i = 0; i < touched.size(); ++i) {
+      const uint32_t cls = touched[i];
+      StateList& class_targets = targets[cls];
+      const bool from_start = unanchored and class_targets.empty();
+      if (from_start and start_moves[cls] != kInvalidState) {
+        dfa.moves_.push_back(typename Graph::Move(state, cls, start_moves[cls]));
+        continue;
+      }
+      details::MakeStateList(nfa, class_targets, in_start, stamps, stamp);
+      if (unanchored) {
+        merged.clear();
+        std::set_union(class_targets.begin(), class_targets.end(), start_targets[cls].begin(),
+                       start_targets[cls].end(), std::back_inserter(merged));
+        class_targets.swap(merged);
+      }
+      typename StateListMap::iterator it = dfa_states.find(class_targets);
+      if (it == dfa_states.end()) {
+        it = dfa_states.insert(std::make_pair(class_targets, static_cast<StateId>(state_lists.size()))).first;
+        state_lists.push_back(&it->first);
+      }
+      if (from_start) {
+        start_moves[cls] = it->second;
+      }
+      dfa.moves_.push_back(typename Graph::Move(state, cls, it->second));
+      class_targets.clear();
+    }
+    touched.clear();
+  }
+}
+
+}} // namespace strutext, automata.
@@ -20,6 +20,7 @@
 
 #include <stdint.h>
 
+#include <cstddef>
 #include <vector>
 
 #include "fsm.h"
@@ -29,10 +30,60 @@ namespace strutext { namespace automata {
 /// Serializer forward declaration.
 template <class> struct AttrFsmSerializer;
 
+/**
+ * \brief Attribute list of a state: range in the attribute storage.
+ */
+template <typename Attribute>
+class AttributeRange {
+public:
+  /// Iterator type.
+  typedef const Attribute* const_iterator;
+
+  /// Empty list initialization.
+  AttributeRange()
+    : begin_(NULL)
+    , end_(NULL) {}
+
+  /// Initialization by range.
+  AttributeRange(const Attribute* begin, const Attribute* end)
+    : begin_(begin)
+    , end_(end) {}
+
+  /// Number of attributes.
+  size_t size() const { return end_ - begin_; }
+
+  /// Are attributes absent?
+  bool empty() const { return begin_ == end_; }
+
+  /// Get attribute.
+  const Attribute& operator[](size_t i) const { return begin_[i]; }
+
+  /// Get the first attribute.
+  const Attribute& front() const { return *begin_; }
+
+  /// Get the last attribute.
+  const Attribute& back() const { return *(end_ - 1); }
+
+  /// Begin of the attributes.
+  const_iterator begin() const { return begin_; }
+
+  /// End of the attributes.
+  const_iterator end() const { return end_; }
+
+private:
+  const Attribute* begin_; ///< Begin of the attributes.
+  const Attribute* end_;   ///< End of the attributes.
+};
+
 /**
  * \brief FSM with attributes definition.
  *
  * State attribute is some template type. An each state contains a list of such attributes.
+ * While the automaton is built, each state keeps its own attribute vector. Most states have
+ * no attributes, so the built automaton pools them by FreezeAttributes() call: all the
+ * attributes are placed in one array, the attributes of state i are in
+ * [attr_offsets_[i], attr_offsets_[i + 1]) range. Adding of attribute to the pooled automaton
+ * returns it to the vector per state form.
  */
 template <class T1, typename T2>
 struct AttributeFsm : public FiniteStateMachine<T1> {
@@ -46,10 +97,16 @@ struct AttributeFsm : public FiniteStateMachine<T1> {
   typedef FiniteStateMachine<Transition> FsmImpl;
 
   /// Attribute list type.
-  typedef std::vector<Attribute> AttributeList;
+  typedef AttributeRange<Attribute> AttributeList;
 
   /// State attribute list type.
-  typedef std::vector<AttributeList> StateAttributeList;
+  typedef std::vector<std::vector<Attribute> > StateAttributeList;
+
+  /// Type of pooled attribute offsets.
+  typedef std::vector<uint32_t> AttrOffsetList;
+
+  /// Type of attribute pool.
+  typedef std::vector<Attribute> AttrPool;
 
   // Make serializer to be friend.
   friend struct AttrFsmSerializer<AttributeFsm<Transition, Attribute> >;
@@ -63,7 +120,17 @@ struct AttributeFsm : public FiniteStateMachine<T1> {
   virtual ~AttributeFsm() {}
 
   /// Get state's attribute.
-  const AttributeList& GetStateAttributes(const StateId& state) const { return states_attr_[state]; }
+  AttributeList GetStateAttributes(const StateId& state) const {
+    if (not attr_offsets_.empty()) {
+      const Attribute* pool = attrs_.empty() ? NULL : &attrs_[0];
+      return AttributeList(pool + attr_offsets_[state], pool + attr_offsets_[state + 1]);
+    }
+    const std::vector<Attribute>& attrs = states_attr_[state];
+    return attrs.empty() ? AttributeList() : AttributeList(&attrs[0], &attrs[0] + attrs.size());
+  }
+
+  /// Are the attributes pooled?
+  bool IsAttributesPooled() const { return not attr_offsets_.empty(); }
 
   /**
    * \brief New state adding.
@@ -73,14 +140,77 @@ struct AttributeFsm : public FiniteStateMachine<T1> {
    */
   StateId AddState(bool is_accepted = false) {
     StateId state = FsmImpl::AddState(is_accepted);
-    states_attr_.push_back(AttributeList());
+    if (attr_offsets_.empty()) {
+      states_attr_.push_back(std::vector<Attribute>());
+    } else {
+      attr_offsets_.push_back(attr_offsets_.back());
+    }
     return state;
   }
 
   /// Adding attribute to the state.
-  void AddAttribute(const StateId& state, const Attribute& attr) { states_attr_[state].push_back(attr); }
+  void AddAttribute(const StateId& state, const Attribute& attr) {
+    ThawAttributes();
+    states_attr_[state].push_back(attr);
+  }
+
+  /// Place the attributes of all the states in one array.
+  void FreezeAttributes() {
+    if (not attr_offsets_.empty()) {
+      return;
+    }
+    size_t num_of_attrs = 0;
+    for (size_t i = 0; i < states_attr_.size(); ++i) {
+      num_of_attrs += states_attr_[i].size();
+    }
+    AttrOffsetList offsets;
+    offsets.reserve(states_attr_.size() + 1);
+    offsets.push_back(0);
+    AttrPool attrs;
+    attrs.reserve(num_of_attrs);
+    for (size_t i = 0; i < states_attr_.size(); ++i) {
+      attrs.insert(attrs.end(), states_attr_[i].begin(), states_attr_[i].end());
+      offsets.push_back(attrs.size());
+    }
+    SetPooledAttributes(offsets, attrs);
+  }
+
+  /// Return the attributes to the vector per state form.
+  void ThawAttributes() {
+    if (attr_offsets_.empty()) {
+      return;
+    }
+    StateAttributeList states_attr(attr_offsets_.size() - 1);
+    for (size_t i = 0; i < states_attr.size(); ++i) {
+      states_attr[i].assign(attrs_.begin() + attr_offsets_[i], attrs_.begin() + attr_offsets_[i + 1]);
+    }
+    states_attr_.swap(states_attr);
+    AttrOffsetList().swap(attr_offsets_);
+    AttrPool().swap(attrs_);
+  }
+
+  /**
+   * \brief Set pooled attributes, the lists are swapped with passed ones.
+   *
+   * \param offsets The begin of attributes of each state, plus the end of the last state attributes.
+   * \param attrs   The attributes.
+   */
+  void SetPooledAttributes(AttrOffsetList& offsets, AttrPool& attrs) {
+    attr_offsets_.swap(offsets);
+    attrs_.swap(attrs);
+    StateAttributeList().swap(states_attr_);
+  }
+
+  /// Drop all the attributes and release their memory, the automaton gets two states without attributes.
+  void ClearAttributes() {
+    StateAttributeList(2).swap(states_attr_);
+    AttrOffsetList().swap(attr_offsets_);
+    AttrPool().swap(attrs_);
+  }
 
-  StateAttributeList states_attr_; /// Attributes defined for an each state.
+  StateAttributeList states_attr_;  ///< Attributes defined for an each state, if not pooled.
+  AttrOffsetList     attr_offsets_; ///< Begin of pooled attributes of each state, plus the end of the last one.
+  AttrPool           attrs_;        ///< Pooled attributes.
 };
 
 }} // namespace strutext, automata.
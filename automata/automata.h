@@ -21,7 +21,9 @@
 #include "fsm_defs.h"
 #include "fsm.h"
 #include "flex_transitions.h"
+#include "frozen_transitions.h"
 #include "attr_fsm.h"
 #include "trie.h"
 #include "aho_corasick.h"
+#include "ac_dfa.h"
 #include "serializer.h"
@@ -222,7 +222,8 @@ private:
 
     // We need to inherit attributes of acceptable state.
     if (state->is_acceptable_) {
-      attrs = typename StateInfo::AttributeList(trie.states_attr_[state_id].begin(), trie.states_attr_[state_id].end());
+      const typename TrieImpl::AttributeList state_attrs = trie.GetStateAttributes(state_id);
+      attrs = typename StateInfo::AttributeList(state_attrs.begin(), state_attrs.end());
     }
 
     return MinimizationResult(state.get(), attrs);
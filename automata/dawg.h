@@ -0,0 +1,569 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Minimal acyclic automaton (DAWG) with word numbering on transitions.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_set.hpp>
+
+#include "fsm_defs.h"
+#include "attr_fsm.h"
+
+namespace strutext { namespace automata {
+
+/**
+ * \brief Minimal deterministic acyclic automaton of words with attributes.
+ *
+ * The automaton is minimal, so the words share both prefixes and suffixes. The attributes can't
+ * be kept in the states, as a state is shared by different words. So each move has an output,
+ * the number of words, which are less than any word going through the move. The sum of the
+ * outputs along the path of a word is the word number in the sorted word list, which is the
+ * index of the word attributes. Words, which are prefixes of the passed text, are found by
+ * a single pass: each acceptable state passed gives the number of the prefix.
+ *
+ * Moves are kept in the compressed sparse row layout like the frozen automaton has: moves
+ * of state i are placed in [offsets_[i], offsets_[i + 1]) range of the sorted symbols, targets
+ * and outputs. The automaton is built by DawgBuilder and can't be modified.
+ */
+template <typename Char, typename Attribute>
+struct Dawg {
+  /// Symbol type.
+  typedef Char CharType;
+
+  /// Word identifier type.
+  typedef Attribute ChainId;
+
+  /// Attribute list of a word.
+  typedef AttributeRange<Attribute> AttributeList;
+
+  /// Number of state moves, which are looked through linearly.
+  static const uint32_t kLinearSearchSize = 8u;
+
+  /// Type of offset list.
+  typedef std::vector<uint32_t> OffsetList;
+
+  /// Type of move symbol list.
+  typedef std::vector<CharType> SymbolList;
+
+  /// Type of move target list.
+  typedef std::vector<StateId> TargetList;
+
+  /// Type of move output list.
+  typedef std::vector<uint32_t> OutputList;
+
+  /// Type of acceptable state marks.
+  typedef std::vector<uint8_t> AcceptList;
+
+  /// Type of attribute list.
+  typedef std::vector<Attribute> AttrPool;
+
+  /// Empty automaton: invalid and start states, no words.
+  Dawg()
+    : offsets_(3, 0)
+    , accepted_(2, 0)
+    , attr_offsets_(1, 0) {}
+
+  /// Return number of states.
+  size_t GetNumOfStates() const { return accepted_.size(); }
+
+  /// Return number of moves.
+  size_t GetNumOfMoves() const { return targets_.size(); }
+
+  /// Return number of words.
+  size_t GetNumOfWords() const { return attr_offsets_.size() - 1; }
+
+  /**
+   * \brief Move by the symbol.
+   *
+   * \param         state  The state to move from.
+   * \param         symbol The move symbol.
+   * \param[in,out] number Word number, the move output is added to it.
+   * \return               Move state or kInvalidState if the move is absent.
+   */
+  StateId Go(const StateId& state, const CharType& symbol, uint32_t& number) const {
+    uint32_t begin = offsets_[state];
+    uint32_t end = offsets_[state + 1];
+    if (end - begin <= kLinearSearchSize) {
+      for (; begin != end; ++begin) {
+        if (symbols_[begin] == symbol) {
+          number += outputs_[begin];
+          return targets_[begin];
+        }
+      }
+      return kInvalidState;
+    }
+    const CharType* first = &symbols_[0] + begin;
+    const CharType* last = &symbols_[0] + end;
+    const CharType* pos = std::lower_bound(first, last, symbol);
+    if (pos != last and *pos == symbol) {
+      number += outputs_[pos - &symbols_[0]];
+      return targets_[pos - &symbols_[0]];
+    }
+    return kInvalidState;
+  }
+
+  /// Is the state the end of some word?
+  bool IsAcceptable(const StateId& state) const { return accepted_[state] != 0; }
+
+  /**
+   * \brief Get attributes of the word.
+   *
+   * \param  number Word number, got in the acceptable state.
+   * \return        The word attributes.
+   */
+  AttributeList GetWordAttributes(uint32_t number) const {
+    const Attribute* attrs = attrs_.empty() ? NULL : &attrs_[0];
+    return AttributeList(attrs + attr_offsets_[number], attrs + attr_offsets_[number + 1]);
+  }
+
+  /**
+   * \brief Search of the passed word.
+   *
+   * \param begin Iterator of the word begin.
+   * \param end   Iterator of the word end.
+   * \result      The attributes of the word, empty if the word is absent.
+   */
+  template <typename SymbolIterator>
+  AttributeList Search(SymbolIterator begin, SymbolIterator end) const {
+    StateId state = kStartState;
+    uint32_t number = 0;
+    for (SymbolIterator it = begin; state != kInvalidState and it != end; ++it) {
+      state = Go(state, *it, number);
+    }
+    if (state == kInvalidState or not IsAcceptable(state)) {
+      return AttributeList();
+    }
+    return GetWordAttributes(number);
+  }
+
+  OffsetList offsets_;      ///< Begin of the moves of each state, plus the end of the last state moves.
+  SymbolList symbols_;      ///< Move symbols, sorted for each state.
+  TargetList targets_;      ///< Move target states.
+  OutputList outputs_;      ///< Move outputs.
+  AcceptList accepted_;     ///< Acceptable state marks.
+  OffsetList attr_offsets_; ///< Begin of the attributes of each word, plus the end of the last one.
+  AttrPool   attrs_;        ///< Word attributes.
+};
+
+/**
+ * \brief Check the automaton arrays read from stream or memory image.
+ *
+ * The offsets must not decrease, the moves must go to the following states and the outputs must
+ * give word numbers less than the number of words, so Go and GetWordAttributes never leave the
+ * arrays. The moves go to the following states, so the word numbers are checked from the last
+ * state to the start: ends[state] is the greatest number of the words reached from the state
+ * plus one, or zero if none is. The invalid state must not be acceptable. The array sizes are
+ * checked by the caller, there are two states at least.
+ *
+ * \param offsets      Move offsets of each state, num_of_states + 1 elements.
+ * \param targets      Move targets.
+ * \param outputs      Move outputs.
+ * \param accepted     Acceptable state marks, num_of_states elements.
+ * \param attr_offsets Attribute offsets of each word, num_of_words + 1 elements.
+ * \param num_of_states Number of states.
+ * \param num_of_words  Number of words.
+ * \return              True if the arrays are consistent.
+ */
+template <typename OffsetArray, typename TargetArray, typename OutputArray, typename AcceptArray>
+bool CheckDawgArrays(const OffsetArray& offsets, const TargetArray& targets, const OutputArray& outputs,
+                     const AcceptArray& accepted, const OffsetArray& attr_offsets, size_t num_of_states,
+                     size_t num_of_words) {
+  if (accepted[kInvalidState]) {
+    return false;
+  }
+  for (size_t i = 0; i < num_of_words; ++i) {
+    if (attr_offsets[i] > attr_offsets[i + 1]) {
+      return false;
+    }
+  }
+  std::vector<uint64_t> ends(num_of_states, 0);
+  for (size_t state = num_of_states; state-- > 0;) {
+    if (offsets[state] > offsets[state + 1]) {
+      return false;
+    }
+    uint64_t end = accepted[state] ? 1 : 0;
+    for (uint32_t i = offsets[state]; i < offsets[state + 1]; ++i) {
+      const StateId target = targets[i];
+      if (target <= state or target >= num_of_states) {
+        return false;
+      }
+      if (ends[target] != 0) {
+        end = std::max(end, outputs[i] + ends[target]);
+      }
+    }
+    if (end > num_of_words) {
+      return false;
+    }
+    ends[state] = end;
+  }
+  return true;
+}
+
+/**
+ * \brief Incremental builder of minimal acyclic automaton from sorted words.
+ *
+ * The algorithm of J. Daciuk et al. (Incremental Construction of Minimal Acyclic Finite-State
+ * Automata, 2000) for sorted input. The states of the last added word path are not finished.
+ * When the next word is added, the path states after the common prefix are finished: from the
+ * last one, each state is replaced by the equal registered state or is registered itself. So
+ * the automaton is minimal all the time, and the memory is proportional to the minimal
+ * automaton size, not to the trie size.
+ */
+template <typename Char, typename Attribute>
+class DawgBuilder : private boost::noncopyable {
+public:
+  /// Automaton type.
+  typedef Dawg<Char, Attribute> DawgImpl;
+
+  /// Default initialization.
+  DawgBuilder()
+    : states_(1)
+    , register_(0, StateHash(states_), StateEqual(states_))
+    , path_(1, 0)
+    , attr_offsets_(1, 0) {}
+
+  /**
+   * \brief Add word with attributes.
+   *
+   * The words must be added in sorted order, the same word may be added several times in a row,
+   * its attributes are joined.
+   *
+   * \param begin      Iterator of the word begin.
+   * \param end        Iterator of the word end.
+   * \param attr_begin Iterator of the attributes begin.
+   * \param attr_end   Iterator of the attributes end.
+   */
+  template <typename SymbolIterator, typename AttrIterator>
+  void Add(SymbolIterator begin, SymbolIterator end, AttrIterator attr_begin, AttrIterator attr_end);
+
+  /// Add word with single attribute.
+  template <typename SymbolIterator>
+  void Add(SymbolIterator begin, SymbolIterator end, const Attribute& attr) {
+    Add(begin, end, &attr, &attr + 1);
+  }
+
+  /// Return number of words added.
+  size_t GetNumOfWords() const { return attr_offsets_.size() - 1; }
+
+  /**
+   * \brief Finish the automaton, the builder is ready for the next one.
+   *
+   * \param[out] dawg The automaton to fill.
+   */
+  void Build(DawgImpl& dawg);
+
+private:
+  /// Number of building state.
+  typedef uint32_t StateNum;
+
+  /// State being built.
+  struct State {
+    /// Default initialization.
+    State() : final_(false) {}
+
+    std::vector<std::pair<Char, StateNum> > moves_; ///< Moves, sorted by symbol.
+    bool                                    final_; ///< Is the state the end of a word?
+  };
+
+  /// Type of state list.
+  typedef std::vector<State> StateList;
+
+  /// Hash of the state by its moves, the targets are registered already.
+  struct StateHash {
+    explicit StateHash(const StateList& states) : states_(&states) {}
+
+    size_t operator()(StateNum num) const {
+      const State& state = (*states_)[num];
+      size_t seed = state.final_ ? 1 : 0;
+      for (size_t i = 0; i < state.moves_.size(); ++i) {
+        boost::hash_combine(seed, state.moves_[i].first);
+        boost::hash_combine(seed, state.moves_[i].second);
+      }
+      return seed;
+    }
+
+    const StateList* states_; ///< States of the builder.
+  };
+
+  /// Equality of the states.
+  struct StateEqual {
+    explicit StateEqual(const StateList& states) : states_(&states) {}
+
+    bool operator()(StateNum left, StateNum right) const {
+      const State& left_state = (*states_)[left];
+      const State& right_state = (*states_)[right];
+      return left_state.final_ == right_state.final_ and left_state.moves_ == right_state.moves_;
+    }
+
+    const StateList* states_; ///< States of the builder.
+  };
+
+  /// Type of state register.
+  typedef boost::unordered_set<StateNum, StateHash, StateEqual> Register;
+
+  /// Replace or register the path states deeper than the passed length.
+  void FinishPath(size_t len);
+
+  /// Get new state.
+  StateNum NewState();
+
+  StateList              states_;       ///< States, the first one is the start.
+  Register               register_;     ///< Finished states.
+  std::vector<StateNum>  free_;         ///< Numbers of states replaced by equal ones.
+  std::vector<StateNum>  path_;         ///< States of the last word path.
+  std::vector<Char>      last_word_;    ///< The last word.
+  std::vector<uint32_t>  attr_offsets_; ///< Begin of the attributes of each word.
+  std::vector<Attribute> attrs_;        ///< Word attributes.
+};
+
+template <typename Char, typename Attribute>
+template <typename SymbolIterator, typename AttrIterator>
+void DawgBuilder<Char, Attribute>::Add(SymbolIterator begin, SymbolIterator end, AttrIterator attr_begin,
+                                       AttrIterator attr_end) {
+  std::vector<Char> word(begin, end);
+  size_t prefix = 0;
+  while (prefix < word.size() and prefix < last_word_.size() and word[prefix] == last_word_[prefix]) {
+    ++prefix;
+  }
+  const bool same = GetNumOfWords() > 0 and prefix == word.size() and prefix == last_word_.size();
+  if (GetNumOfWords() > 0 and not same) {
+    // The word must be greater than the last one.
+    if (prefix == word.size() or (prefix < last_word_.size() and not (last_word_[prefix] < word[prefix]))) {
+      throw std::invalid_argument("DawgBuilder: words are not sorted");
+    }
+  }
+
+  if (not same) {
+    FinishPath(prefix);
+    for (size_t i = prefix; i < word.size(); ++i) {
+      const StateNum state = NewState();
+      states_[path_.back()].moves_.push_back(std::make_pair(word[i], state));
+      path_.push_back(state);
+    }
+    states_[path_.back()].final_ = true;
+    last_word_.swap(word);
+    attr_offsets_.push_back(attr_offsets_.back());
+  }
+  for (AttrIterator it = attr_begin; it != attr_end; ++it) {
+    attrs_.push_back(*it);
+  }
+  attr_offsets_.back() = attrs_.size();
+}
+
+template <typename Char, typename Attribute>
+void DawgBuilder<Char, Attribute>::FinishPath(size_t len) {
+  for (size_t i = path_.size() - 1; i > len; --i) {
+    const StateNum state = path_[i];
+    typename Register::const_iterator it = register_.find(state);
+    if (it != register_.end()) {
+      // The equal state is found, the parent last move goes there.
+      states_[path_[i - 1]].moves_.back().second = *it;
+      states_[state] = State();
+      free_.push_back(state);
+    } else {
+      register_.insert(state);
+    }
+  }
+  path_.resize(len + 1);
+}
+
+template <typename Char, typename Attribute>
+typename DawgBuilder<Char, Attribute>::StateNum DawgBuilder<Char, Attribute>::NewState() {
+  if (not free_.empty()) {
+    const StateNum state = free_.back();
+    free_.pop_back();
+    return state;
+  }
+  states_.push_back(State());
+  return states_.size() - 1;
+}
+
+template <typename Char, typename Attribute>
+void DawgBuilder<Char, Attribute>::Build(DawgImpl& dawg) {
+  FinishPath(0);
+
+  // Post order of the states, so the targets are before the state.
+  const StateNum kNoState = static_cast<StateNum>(-1);
+  std::vector<StateNum> order;
+  std::vector<uint8_t> visited(states_.size(), 0);
+  std::vector<std::pair<StateNum, size_t> > stack(1, std::make_pair(StateNum(0), size_t(0)));
+  visited[0] = 1;
+  while (not stack.empty()) {
+    std::pair<StateNum, size_t>& top = stack.back();
+    const State& state = states_[top.first];
+    if (top.second < state.moves_.size()) {
+      const StateNum target = state.moves_[top.second++].second;
+      if (not visited[target]) {
+        visited[target] = 1;
+        stack.push_back(std::make_pair(target, size_t(0)));
+      }
+    } else {
+      order.push_back(top.first);
+      stack.pop_back();
+    }
+  }
+
+  // Number of words of each state and new state numbers: the start state gets kStartState,
+  // the others go in the reverse post order.
+  std::vector<uint32_t> counts(states_.size(), 0);
+  std::vector<StateId> ids(states_.size(), kNoState);
+  for (size_t i = 0; i < order.size(); ++i) {
+    const State& state = states_[order[i]];
+    uint32_t count = state.final_ ? 1 : 0;
+    for (size_t j = 0; j < state.moves_.size(); ++j) {
+      count += counts[state.moves_[j].second];
+    }
+    counts[order[i]] = count;
+    ids[order[i]] = kStartState + (order.size() - 1 - i);
+  }
+
+  const size_t num_of_states = order.size() + kStartState;
+  dawg.offsets_.assign(1, 0);
+  dawg.offsets_.reserve(num_of_states + 1);
+  dawg.offsets_.push_back(0);
+  dawg.accepted_.assign(num_of_states, 0);
+  dawg.symbols_.clear();
+  dawg.targets_.clear();
+  dawg.outputs_.clear();
+  for (size_t i = order.size(); i-- > 0;) {
+    const State& state = states_[order[i]];
+    uint32_t output = state.final_ ? 1 : 0;
+    for (size_t j = 0; j < state.moves_.size(); ++j) {
+      dawg.symbols_.push_back(state.moves_[j].first);
+      dawg.targets_.push_back(ids[state.moves_[j].second]);
+      dawg.outputs_.push_back(output);
+      output += counts[state.moves_[j].second];
+    }
+    dawg.offsets_.push_back(dawg.symbols_.size());
+    dawg.accepted_[ids[order[i]]] = state.final_ ? 1 : 0;
+  }
+  dawg.attr_offsets_.swap(attr_offsets_);
+  dawg.attrs_.swap(attrs_);
+
+  // Ready for the next automaton.
+  states_.assign(1, State());
+  register_.clear();
+  free_.clear();
+  path_.assign(1, 0);
+  last_word_.clear();
+  attr_offsets_.assign(1, 0);
+  attrs_.clear();
+}
+
+namespace details {
+
+/// Pass the trie words to the builder in sorted order.
+template <class TrieImpl, typename Char, typename Attribute>
+void AddTrieWords(const TrieImpl& trie, StateId state, std::vector<Char>& word, DawgBuilder<Char, Attribute>& builder) {
+  typedef typename TrieImpl::Transitions::TransTable TransTableImpl;
+  if (trie.IsAcceptable(state)) {
+    const typename TrieImpl::AttributeList attrs = trie.GetStateAttributes(state);
+    builder.Add(word.begin(), word.end(), attrs.begin(), attrs.end());
+  }
+  const TransTableImpl moves = trie.GetMoveTable(state);
+  for (typename TransTableImpl::const_iterator move_it = moves.begin(); move_it != moves.end(); ++move_it) {
+    word.push_back(move_it->first);
+    AddTrieWords(trie, move_it->second, word, builder);
+    word.pop_back();
+  }
+}
+
+/// Pass the automaton words to the visitor in sorted order.
+template <typename Char, typename Attribute, class Visitor>
+void VisitDawgWords(const Dawg<Char, Attribute>& dawg, StateId state, uint32_t number, std::vector<Char>& word,
+                    Visitor& visitor) {
+  if (dawg.IsAcceptable(state)) {
+    visitor(word, dawg.GetWordAttributes(number));
+  }
+  for (uint32_t i = dawg.offsets_[state]; i < dawg.offsets_[state + 1]; ++i) {
+    word.push_back(dawg.symbols_[i]);
+    VisitDawgWords(dawg, dawg.targets_[i], number + dawg.outputs_[i], word, visitor);
+    word.pop_back();
+  }
+}
+
+/// Visitor, which adds the words to the trie.
+template <class TrieImpl>
+struct TrieFiller {
+  explicit TrieFiller(TrieImpl& trie) : trie_(&trie) {}
+
+  template <typename Char, class AttributeList>
+  void operator()(const std::vector<Char>& word, const AttributeList& attrs) {
+    const StateId last = trie_->AddChain(word.begin(), word.end());
+    for (size_t i = 0; i < attrs.size(); ++i) {
+      trie_->AddAttribute(last, attrs[i]);
+    }
+  }
+
+  TrieImpl* trie_; ///< The trie to fill.
+};
+
+}  // namespace details.
+
+/**
+ * \brief Build minimal acyclic automaton by trie.
+ *
+ * The trie words are enumerated in sorted order and are passed to DawgBuilder.
+ *
+ * \param      trie The trie, any implementation with move tables sorted by symbol.
+ * \param[out] dawg The automaton to fill.
+ */
+template <class TrieImpl, typename Char, typename Attribute>
+void BuildDawg(const TrieImpl& trie, Dawg<Char, Attribute>& dawg) {
+  DawgBuilder<Char, Attribute> builder;
+  std::vector<Char> word;
+  details::AddTrieWords(trie, kStartState, word, builder);
+  builder.Build(dawg);
+}
+
+/**
+ * \brief Enumerate the automaton words in sorted order.
+ *
+ * The visitor is called as visitor(word, attrs), where word is std::vector<Char> and attrs is
+ * the word attribute list.
+ *
+ * \param dawg    The automaton.
+ * \param visitor Functor to receive the words.
+ */
+template <typename Char, typename Attribute, class Visitor>
+void VisitWords(const Dawg<Char, Attribute>& dawg, Visitor& visitor) {
+  std::vector<Char> word;
+  details::VisitDawgWords(dawg, kStartState, 0, word, visitor);
+}
+
+/**
+ * \brief Add the automaton words to the trie.
+ *
+ * \param      dawg The automaton.
+ * \param[out] trie The trie to fill.
+ */
+template <typename Char, typename Attribute, class TrieImpl>
+void Thaw(const Dawg<Char, Attribute>& dawg, TrieImpl& trie) {
+  details::TrieFiller<TrieImpl> filler(trie);
+  VisitWords(dawg, filler);
+}
+
+}} // namespace strutext, automata.
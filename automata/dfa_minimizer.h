@@ -0,0 +1,406 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Minimization of deterministic automata.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "fsm_defs.h"
+#include "attr_fsm.h"
+#include "frozen_transitions.h"
+
+namespace strutext { namespace automata {
+
+/**
+ * \brief Deterministic automaton as the list of moves.
+ *
+ * The form is produced by the subset construction and is consumed by the minimization. States are
+ * numbered from 0, there is no invalid state. Attributes of state i are placed in
+ * [attr_offsets_[i], attr_offsets_[i + 1]) range of the attribute array, sorted.
+ */
+template <typename Char, typename Attribute>
+struct DfaGraph {
+  /// Move of the automaton.
+  struct Move {
+    /// Initialization.
+    Move(StateId from, const Char& symbol, StateId to)
+      : from_(from)
+      , symbol_(symbol)
+      , to_(to) {}
+
+    StateId from_;   ///< State to move from.
+    Char    symbol_; ///< Move symbol.
+    StateId to_;     ///< State to move to.
+  };
+
+  /// Empty automaton.
+  DfaGraph()
+    : start_(0)
+    , attr_offsets_(1, 0) {}
+
+  /// Return number of states.
+  size_t GetNumOfStates() const { return accepted_.size(); }
+
+  /**
+   * \brief Add state.
+   *
+   * \param  is_accepted Is the state acceptable?
+   * \param  begin       Begin of the sorted state attributes.
+   * \param  end         End of the attributes.
+   * \return             The state number.
+   */
+  template <typename AttrIterator>
+  StateId AddState(bool is_accepted, AttrIterator begin, AttrIterator end) {
+    accepted_.push_back(is_accepted ? 1 : 0);
+    attrs_.insert(attrs_.end(), begin, end);
+    attr_offsets_.push_back(attrs_.size());
+    return accepted_.size() - 1;
+  }
+
+  StateId                start_;        ///< Start state.
+  std::vector<uint8_t>   accepted_;     ///< Acceptable state marks.
+  std::vector<uint32_t>  attr_offsets_; ///< Begin of the attributes of each state, plus the end of the last one.
+  std::vector<Attribute> attrs_;        ///< Attributes.
+  std::vector<Move>      moves_;        ///< Moves, at most one per state and symbol.
+};
+
+namespace details {
+
+/**
+ * \brief Refinable partition of [0, n) elements.
+ *
+ * Elements of each set are contiguous in the element array, the marked ones go first. Splitting
+ * moves the marked or the unmarked part, the smaller one, to a new set.
+ */
+class Partition {
+public:
+  /// Initialization: all the elements are in one set.
+  explicit Partition(size_t size)
+    : num_of_sets_(size > 0 ? 1 : 0)
+    , elems_(size)
+    , locs_(size)
+    , sets_(size, 0)
+    , first_(size + 1, 0)
+    , past_(size + 1, 0)
+    , marked_(size + 1, 0) {
+    for (size_t i = 0; i < size; ++i) {
+      elems_[i] = locs_[i] = i;
+    }
+    past_[0] = size;
+  }
+
+  /// Return number of sets.
+  uint32_t GetNumOfSets() const { return num_of_sets_; }
+
+  /// Get set of the element.
+  uint32_t GetSet(uint32_t elem) const { return sets_[elem]; }
+
+  /// Get begin of the set elements.
+  const uint32_t* Begin(uint32_t set) const { return &elems_[0] + first_[set]; }
+
+  /// Get end of the set elements.
+  const uint32_t* End(uint32_t set) const { return &elems_[0] + past_[set]; }
+
+  /// Mark the element.
+  void Mark(uint32_t elem) {
+    const uint32_t set = sets_[elem];
+    const uint32_t loc = locs_[elem];
+    const uint32_t border = first_[set] + marked_[set];
+    if (loc < border) {
+      return;
+    }
+    elems_[loc] = elems_[border];
+    locs_[elems_[loc]] = loc;
+    elems_[border] = elem;
+    locs_[elem] = border;
+    if (marked_[set]++ == 0) {
+      touched_.push_back(set);
+    }
+  }
+
+  /// Split the sets having marked elements, the marks are dropped.
+  void Split() {
+    while (not touched_.empty()) {
+      const uint32_t set = touched_.back();
+      touched_.pop_back();
+      const uint32_t border = first_[set] + marked_[set];
+      if (border == past_[set]) {
+        marked_[set] = 0;
+        continue;
+      }
+      const uint32_t new_set = num_of_sets_++;
+      if (marked_[set] <= past_[set] - border) {
+        first_[new_set] = first_[set];
+        past_[new_set] = first_[set] = border;
+      } else {
+        past_[new_set] = past_[set];
+        first_[new_set] = past_[set] = border;
+      }
+      for (uint32_t i = first_[new_set]; i < past_[new_set]; ++i) {
+        sets_[elems_[i]] = new_set;
+      }
+      marked_[set] = marked_[new_set] = 0;
+    }
+  }
+
+private:
+  uint32_t              num_of_sets_; ///< Number of sets.
+  std::vector<uint32_t> elems_;       ///< Elements grouped by sets.
+  std::vector<uint32_t> locs_;        ///< Location of each element in the element array.
+  std::vector<uint32_t> sets_;        ///< Set of each element.
+  std::vector<uint32_t> first_;       ///< Begin of each set in the element array.
+  std::vector<uint32_t> past_;        ///< End of each set in the element array.
+  std::vector<uint32_t> marked_;      ///< Number of marked elements of each set.
+  std::vector<uint32_t> touched_;     ///< Sets having marked elements.
+};
+
+/// Order of the moves by symbol.
+template <class Move>
+struct MoveSymbolLess {
+  bool operator()(const Move& left, const Move& right) const {
+    return left.symbol_ < right.symbol_;
+  }
+};
+
+/**
+ * \brief Find the states reachable by the moves.
+ *
+ * \param      adjacent_offsets Begin of the adjacent moves of each state, plus the end.
+ * \param      adjacent         Adjacent states.
+ * \param[out] marks            Reachable state marks, the initial states are marked already.
+ */
+inline void MarkReachable(const std::vector<uint32_t>& adjacent_offsets, const std::vector<uint32_t>& adjacent,
+                          std::vector<uint8_t>& marks) {
+  std::vector<uint32_t> work_states;
+  for (size_t state = 0; state < marks.size(); ++state) {
+    if (marks[state]) {
+      work_states.push_back(state);
+    }
+  }
+  while (not work_states.empty()) {
+    const uint32_t state = work_states.back();
+    work_states.pop_back();
+    for (uint32_t i = adjacent_offsets[state]; i < adjacent_offsets[state + 1]; ++i) {
+      if (not marks[adjacent[i]]) {
+        marks[adjacent[i]] = 1;
+        work_states.push_back(adjacent[i]);
+      }
+    }
+  }
+}
+
+/**
+ * \brief Group the adjacent states of each state.
+ *
+ * \param      num_of_states Number of states.
+ * \param      moves         The moves, the source and target are taken by the passed members.
+ * \param      from          Member of the move, whose adjacent states are grouped.
+ * \param      to            Member of the adjacent state.
+ * \param[out] offsets       Begin of the adjacent states of each state, plus the end.
+ * \param[out] adjacent      Adjacent states, or move numbers if to is NULL.
+ */
+template <class Move>
+void GroupMoves(size_t num_of_states, const std::vector<Move>& moves, StateId Move::* from, StateId Move::* to,
+                std::vector<uint32_t>& offsets, std::vector<uint32_t>& adjacent) {
+  offsets.assign(num_of_states + 1, 0);
+  for (size_t i = 0; i < moves.size(); ++i) {
+    ++offsets[moves[i].*from + 1];
+  }
+  for (size_t state = 0; state < num_of_states; ++state) {
+    offsets[state + 1] += offsets[state];
+  }
+  adjacent.resize(moves.size());
+  std::vector<uint32_t> pos(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < moves.size(); ++i) {
+    adjacent[pos[moves[i].*from]++] = to != NULL ? moves[i].*to : i;
+  }
+}
+
+} // namespace details.
+
+/**
+ * \brief Minimize deterministic automaton.
+ *
+ * Valmari-Lehtinen variant of Hopcroft algorithm is used, it works on partial move tables in
+ * O(m log n) time, where m is the number of moves. The states, which are not reachable from the
+ * start state or from which no acceptable state is reachable, are dropped first. The states are
+ * equivalent if they are both acceptable or not, have the same attributes and equivalent moves.
+ * The result is the frozen automaton, its states are numbered in breadth first order from the
+ * start one, the attributes are pooled.
+ *
+ * \param      graph The automaton.
+ * \param[out] dfa   The minimal automaton.
+ */
+template <typename Char, typename Attribute>
+void MinimizeDfa(const DfaGraph<Char, Attribute>& graph, AttributeFsm<FrozenTransitions<Char>, Attribute>& dfa) {
+  typedef DfaGraph<Char, Attribute>                         Graph;
+  typedef typename Graph::Move                              Move;
+  typedef AttributeFsm<FrozenTransitions<Char>, Attribute>  FrozenFsm;
+
+  dfa = FrozenFsm();
+  const size_t num_of_states = graph.GetNumOfStates();
+  if (num_of_states == 0) {
+    return;
+  }
+
+  // Useful states are reachable from the start and reach some acceptable state.
+  std::vector<uint32_t> offsets, adjacent;
+  details::GroupMoves(num_of_states, graph.moves_, &Move::from_, &Move::to_, offsets, adjacent);
+  std::vector<uint8_t> reachable(num_of_states, 0);
+  reachable[graph.start_] = 1;
+  details::MarkReachable(offsets, adjacent, reachable);
+  details::GroupMoves(num_of_states, graph.moves_, &Move::to_, &Move::from_, offsets, adjacent);
+  std::vector<uint8_t> useful(graph.accepted_.begin(), graph.accepted_.end());
+  for (size_t state = 0; state < num_of_states; ++state) {
+    useful[state] = useful[state] and reachable[state];
+  }
+  details::MarkReachable(offsets, adjacent, useful);
+  if (not useful[graph.start_] or not reachable[graph.start_]) {
+    return;
+  }
+
+  // Renumber the useful states and drop the moves of others.
+  std::vector<uint32_t> numbers(num_of_states, 0);
+  std::vector<uint32_t> states;
+  for (size_t state = 0; state < num_of_states; ++state) {
+    if (useful[state] and reachable[state]) {
+      numbers[state] = states.size();
+      states.push_back(state);
+    }
+  }
+  std::vector<Move> moves;
+  for (size_t i = 0; i < graph.moves_.size(); ++i) {
+    const Move& move = graph.moves_[i];
+    if (useful[move.from_] and reachable[move.from_] and useful[move.to_] and reachable[move.to_]) {
+      moves.push_back(Move(numbers[move.from_], move.symbol_, numbers[move.to_]));
+    }
+  }
+  std::stable_sort(moves.begin(), moves.end(), details::MoveSymbolLess<Move>());
+
+  // Initial blocks: the states of the same acceptance and attributes.
+  typedef std::pair<uint8_t, std::vector<Attribute> > StateClass;
+  std::map<StateClass, std::vector<uint32_t> > classes;
+  for (size_t i = 0; i < states.size(); ++i) {
+    const StateId state = states[i];
+    const StateClass key(graph.accepted_[state], std::vector<Attribute>(
+        graph.attrs_.begin() + graph.attr_offsets_[state], graph.attrs_.begin() + graph.attr_offsets_[state + 1]));
+    classes[key].push_back(i);
+  }
+  details::Partition blocks(states.size());
+  typename std::map<StateClass, std::vector<uint32_t> >::const_iterator class_it = classes.begin();
+  for (++class_it; class_it != classes.end(); ++class_it) {
+    for (size_t i = 0; i < class_it->second.size(); ++i) {
+      blocks.Mark(class_it->second[i]);
+    }
+    blocks.Split();
+  }
+
+  // Initial cords: the moves by the same symbol, the moves are sorted by symbol.
+  details::Partition cords(moves.size());
+  for (size_t i = 1; i < moves.size(); ++i) {
+    if (moves[i - 1].symbol_ < moves[i].symbol_) {
+      for (size_t j = i; j < moves.size() and not (moves[i].symbol_ < moves[j].symbol_); ++j) {
+        cords.Mark(j);
+      }
+      cords.Split();
+    }
+  }
+
+  // Split the blocks by the cords and the cords by the blocks.
+  details::GroupMoves(states.size(), moves, &Move::to_, static_cast<StateId Move::*>(NULL), offsets, adjacent);
+  uint32_t block = 1;
+  for (uint32_t cord = 0; cord < cords.GetNumOfSets(); ++cord) {
+    for (const uint32_t* it = cords.Begin(cord); it != cords.End(cord); ++it) {
+      blocks.Mark(moves[*it].from_);
+    }
+    blocks.Split();
+    for (; block < blocks.GetNumOfSets(); ++block) {
+      for (const uint32_t* it = blocks.Begin(block); it != blocks.End(block); ++it) {
+        for (uint32_t i = offsets[*it]; i < offsets[*it + 1]; ++i) {
+          cords.Mark(adjacent[i]);
+        }
+      }
+      cords.Split();
+    }
+  }
+
+  // Number the blocks in breadth first order, the moves of the block are the moves of any its state.
+  details::GroupMoves(states.size(), moves, &Move::from_, static_cast<StateId Move::*>(NULL), offsets, adjacent);
+  std::vector<StateId> block_states(blocks.GetNumOfSets(), kInvalidState);
+  std::vector<uint32_t> order(1, blocks.GetSet(numbers[graph.start_]));
+  block_states[order[0]] = kStartState;
+  typename FrozenFsm::OffsetList& move_offsets = dfa.offsets_;
+  move_offsets.assign(2, 0);
+  dfa.accepted_.assign(1, 0);
+  typename FrozenFsm::AttrOffsetList attr_offsets(2, 0);
+  typename FrozenFsm::AttrPool attrs;
+  for (size_t i = 0; i < order.size(); ++i) {
+    const uint32_t state = *blocks.Begin(order[i]);
+    for (uint32_t j = offsets[state]; j < offsets[state + 1]; ++j) {
+      const Move& move = moves[adjacent[j]];
+      const uint32_t target = blocks.GetSet(move.to_);
+      if (block_states[target] == kInvalidState) {
+        block_states[target] = order.size() + 1;
+        order.push_back(target);
+      }
+      dfa.symbols_.push_back(move.symbol_);
+      dfa.targets_.push_back(block_states[target]);
+    }
+    move_offsets.push_back(dfa.symbols_.size());
+    const StateId source = states[state];
+    dfa.accepted_.push_back(graph.accepted_[source]);
+    attrs.insert(attrs.end(), graph.attrs_.begin() + graph.attr_offsets_[source],
+                 graph.attrs_.begin() + graph.attr_offsets_[source + 1]);
+    attr_offsets.push_back(attrs.size());
+  }
+  dfa.SetPooledAttributes(attr_offsets, attrs);
+}
+
+/**
+ * \brief Minimize FSM with attributes, for example trie.
+ *
+ * \param      fsm The automaton, any implementation of move table.
+ * \param[out] dfa The minimal automaton.
+ */
+template <class TransImpl, typename Char, typename Attribute>
+void MinimizeDfa(const AttributeFsm<TransImpl, Attribute>& fsm, AttributeFsm<FrozenTransitions<Char>, Attribute>& dfa) {
+  typedef typename TransImpl::TransTable TransTableImpl;
+  typedef DfaGraph<Char, Attribute>      Graph;
+
+  Graph graph;
+  graph.start_ = kStartState;
+  for (StateId state = 0; state < fsm.GetNumOfStates(); ++state) {
+    const typename AttributeFsm<TransImpl, Attribute>::AttributeList state_attrs = fsm.GetStateAttributes(state);
+    std::vector<Attribute> attrs(state_attrs.begin(), state_attrs.end());
+    std::sort(attrs.begin(), attrs.end());
+    attrs.erase(std::unique(attrs.begin(), attrs.end()), attrs.end());
+    graph.AddState(fsm.IsAcceptable(state), attrs.begin(), attrs.end());
+    const TransTableImpl moves = fsm.GetMoveTable(state);
+    for (typename TransTableImpl::const_iterator move_it = moves.begin(); move_it != moves.end(); ++move_it) {
+      graph.moves_.push_back(typename Graph::Move(state, move_it->first, move_it->second));
+    }
+  }
+  MinimizeDfa(graph, dfa);
+}
+
+}} // namespace strutext, automata.
@@ -50,6 +50,9 @@ struct FlatTransitions {
   /// Move table type.
   typedef std::map<CharType, StateId> TransTable;
 
+  // Move table as returned by GetMoveTable, it is built on each call.
+  typedef TransTable TransTableRef;
+
   // Make serializer to be friend.
   friend class TransSerializer<FlatTransitions<Char, Size> >;
 
@@ -81,8 +84,8 @@ struct FlatTransitions {
     trans_table_[symbol] = to;
   }
 
-  /// Return reference to move table.
-  TransTable GetMoveTable() const {
+  /// Build the move table.
+  TransTableRef GetMoveTable() const {
     TransTable result;
     for (size_t i = 0; i < Size; ++i) {
       if (trans_table_[i] > 0) {
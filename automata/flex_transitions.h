@@ -40,6 +40,9 @@ struct FlexTransitions {
   // Move table type.
   typedef std::map<CharType, StateId> TransTable;
 
+  // Move table as returned by GetMoveTable, no copy is made.
+  typedef const TransTable& TransTableRef;
+
   // Make serializer to be friend.
   friend class TransSerializer<FlexTransitions<Char> >;
 
@@ -68,7 +71,7 @@ struct FlexTransitions {
   }
 
   /// Return reference to the move table.
-  TransTable GetMoveTable() const {
+  TransTableRef GetMoveTable() const {
     return trans_table_;
   }
 
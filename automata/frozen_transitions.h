@@ -0,0 +1,270 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Frozen (immutable) move table implementation.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+#include <algorithm>
+#include <map>
+
+#include "fsm_defs.h"
+#include "fsm.h"
+#include "attr_fsm.h"
+#include "aho_corasick.h"
+
+namespace strutext { namespace automata {
+
+/**
+ * \brief "Frozen" move table.
+ *
+ * The type is a tag for FiniteStateMachine. The automaton specialized by it keeps moves of all
+ * the states in the compressed sparse row layout: moves of state i are placed in
+ * [offsets_[i], offsets_[i + 1]) range of two contiguous arrays, sorted symbols and target states.
+ * Such automaton cannot be modified, it is built from any other automaton by freezing.
+ */
+template <typename Char>
+struct FrozenTransitions {
+  /// Symbol type.
+  typedef Char CharType;
+
+  /// Move table type.
+  typedef std::map<CharType, StateId> TransTable;
+};
+
+/**
+ * \brief Finite State Machine with frozen move table.
+ *
+ * The interface is the same as the general FSM has, except modification methods.
+ */
+template <typename Char>
+struct FiniteStateMachine<FrozenTransitions<Char> > {
+  /// Type of transition table.
+  typedef FrozenTransitions<Char>        Transitions;
+
+  /// Symbol type.
+  typedef typename Transitions::CharType CharType;
+
+  /// Number of reserved states by default, unused here.
+  static const size_t kReservedStateTableSize = 10000u;
+
+  /// Number of state moves, which are looked through linearly.
+  static const uint32_t kLinearSearchSize = 8u;
+
+  /// Type of move offset list.
+  typedef std::vector<uint32_t> OffsetList;
+
+  /// Type of move symbol list.
+  typedef std::vector<CharType> SymbolList;
+
+  /// Type of move target list.
+  typedef std::vector<StateId>  TargetList;
+
+  /// Type of acceptable state marks.
+  typedef std::vector<uint8_t>  AcceptList;
+
+  // Make serializer class as friend.
+  friend struct FsmSerializer<Transitions>;
+
+  /**
+   * \brief Default initialization.
+   *
+   * Like any automaton, the empty frozen automaton has invalid and start states.
+   */
+  explicit FiniteStateMachine(size_t = kReservedStateTableSize)
+    : offsets_(3, 0)
+    , accepted_(2, 0) {}
+
+  /// The class may be inherited.
+  virtual ~FiniteStateMachine() {}
+
+  /// Return number of states of the automata.
+  size_t GetNumOfStates() const { return accepted_.size(); }
+
+  /**
+   * \brief Transiotion by symbol implementation.
+   *
+   * \param  state  The state to move from.
+   * \param  symbol The move symbol.
+   * \return        Move state number or kInvalidState if move is absent.
+   */
+  StateId Go(const StateId& state, const CharType& symbol) const {
+    uint32_t begin = offsets_[state];
+    uint32_t end = offsets_[state + 1];
+    if (end - begin <= kLinearSearchSize) {
+      for (; begin != end; ++begin) {
+        if (symbols_[begin] == symbol) {
+          return targets_[begin];
+        }
+      }
+      return kInvalidState;
+    }
+    const CharType* first = &symbols_[0] + begin;
+    const CharType* last = &symbols_[0] + end;
+    const CharType* pos = std::lower_bound(first, last, symbol);
+    if (pos != last and *pos == symbol) {
+      return targets_[pos - &symbols_[0]];
+    }
+    return kInvalidState;
+  }
+
+  /**
+   * \brief Making the state to be acceptable.
+   *
+   * \param state The state number.
+   */
+  void MakeAcceptable(const StateId& state) {
+    accepted_[state] = 1;
+  }
+
+  /**
+   * \brief Is the state acceptable?
+   *
+   * \param  state  The state number.
+   * \return        true if the state is acceptable and false otherwise.
+   */
+  bool IsAcceptable(const StateId& state) const {
+    return accepted_[state] != 0;
+  }
+
+  /// Return the move table.
+  typename Transitions::TransTable GetMoveTable(const StateId& state) const {
+    typename Transitions::TransTable result;
+    for (uint32_t i = offsets_[state]; i < offsets_[state + 1]; ++i) {
+      result.insert(result.end(), std::make_pair(symbols_[i], targets_[i]));
+    }
+    return result;
+  }
+
+  /**
+   * \brief Build the frozen automaton from the passed one.
+   *
+   * \param fsm The automaton to freeze.
+   */
+  template <class TransImpl>
+  void Freeze(const FiniteStateMachine<TransImpl>& fsm) {
+    typedef typename TransImpl::TransTable TransTableImpl;
+
+    const size_t num_of_states = fsm.GetNumOfStates();
+    offsets_.assign(1, 0);
+    offsets_.reserve(num_of_states + 1);
+    accepted_.resize(num_of_states);
+    symbols_.clear();
+    targets_.clear();
+    for (StateId state = 0; state < num_of_states; ++state) {
+      const TransTableImpl moves = fsm.GetMoveTable(state);
+      for (typename TransTableImpl::const_iterator move_it = moves.begin(); move_it != moves.end(); ++move_it) {
+        symbols_.push_back(move_it->first);
+        targets_.push_back(move_it->second);
+      }
+      offsets_.push_back(symbols_.size());
+      accepted_[state] = fsm.IsAcceptable(state) ? 1 : 0;
+    }
+
+    // Release unused memory.
+    SymbolList(symbols_).swap(symbols_);
+    TargetList(targets_).swap(targets_);
+  }
+
+  OffsetList offsets_;  ///< Begin of the moves of each state, plus the end of the last state moves.
+  SymbolList symbols_;  ///< Move symbols, sorted for each state.
+  TargetList targets_;  ///< Move target states.
+  AcceptList accepted_; ///< Acceptable state marks.
+};
+
+/**
+ * \brief Freeze FSM.
+ *
+ * \param      fsm    The automaton to freeze.
+ * \param[out] frozen The frozen automaton.
+ */
+template <class TransImpl, typename Char>
+void Freeze(const FiniteStateMachine<TransImpl>& fsm, FiniteStateMachine<FrozenTransitions<Char> >& frozen) {
+  frozen.Freeze(fsm);
+}
+
+/**
+ * \brief Freeze FSM with attributes, for example trie.
+ *
+ * \param      fsm    The automaton to freeze.
+ * \param[out] frozen The frozen automaton.
+ */
+template <class TransImpl, typename Char, typename Attribute>
+void Freeze(const AttributeFsm<TransImpl, Attribute>& fsm, AttributeFsm<FrozenTransitions<Char>, Attribute>& frozen) {
+  typedef AttributeFsm<FrozenTransitions<Char>, Attribute> FrozenFsm;
+  frozen.Freeze(fsm);
+
+  // The frozen automaton keeps the attributes pooled.
+  typename FrozenFsm::AttrOffsetList offsets(1, 0);
+  offsets.reserve(fsm.GetNumOfStates() + 1);
+  typename FrozenFsm::AttrPool attrs;
+  for (StateId state = 0; state < fsm.GetNumOfStates(); ++state) {
+    const typename AttributeFsm<TransImpl, Attribute>::AttributeList state_attrs = fsm.GetStateAttributes(state);
+    attrs.insert(attrs.end(), state_attrs.begin(), state_attrs.end());
+    offsets.push_back(attrs.size());
+  }
+  typename FrozenFsm::AttrPool(attrs).swap(attrs);
+  frozen.SetPooledAttributes(offsets, attrs);
+}
+
+/**
+ * \brief Freeze Aho-Corasick trie.
+ *
+ * \param      trie   The trie to freeze, fail moves should be generated.
+ * \param[out] frozen The frozen trie.
+ */
+template <class TransImpl, typename Char, typename Attribute>
+void Freeze(const AhoCorasickTrie<TransImpl, Attribute>& trie,
+            AhoCorasickTrie<FrozenTransitions<Char>, Attribute>& frozen) {
+  typedef AttributeFsm<TransImpl, Attribute> AttributeFsmImpl;
+  typedef AttributeFsm<FrozenTransitions<Char>, Attribute> FrozenAttributeFsm;
+  Freeze(static_cast<const AttributeFsmImpl&>(trie), static_cast<FrozenAttributeFsm&>(frozen));
+  frozen.fail_moves_ = trie.fail_moves_;
+  frozen.depths_ = trie.depths_;
+  frozen.match_states_ = trie.match_states_;
+}
+
+/**
+ * \brief Build modifiable FSM with attributes from the frozen one.
+ *
+ * \param      frozen The frozen automaton.
+ * \param[out] fsm    The automaton to fill, its previous content is dropped.
+ */
+template <typename Char, class TransImpl, typename Attribute>
+void Thaw(const AttributeFsm<FrozenTransitions<Char>, Attribute>& frozen, AttributeFsm<TransImpl, Attribute>& fsm) {
+  typedef typename AttributeFsm<TransImpl, Attribute>::FsmImpl FsmImpl;
+
+  fsm.states_.assign(2, typename FsmImpl::State());
+  fsm.ClearAttributes();
+  for (size_t i = 2; i < frozen.GetNumOfStates(); ++i) {
+    fsm.AddState();
+  }
+  for (StateId state = 0; state < frozen.GetNumOfStates(); ++state) {
+    for (uint32_t i = frozen.offsets_[state]; i < frozen.offsets_[state + 1]; ++i) {
+      fsm.AddTransition(state, frozen.targets_[i], frozen.symbols_[i]);
+    }
+    if (frozen.IsAcceptable(state)) {
+      fsm.MakeAcceptable(state);
+    }
+    const typename AttributeFsm<FrozenTransitions<Char>, Attribute>::AttributeList attrs = frozen.GetStateAttributes(state);
+    fsm.states_attr_[state].assign(attrs.begin(), attrs.end());
+  }
+}
+
+}} // namespace strutext, automata.
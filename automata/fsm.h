@@ -137,7 +137,7 @@ struct FiniteStateMachine {
   }
 
   /// Return reference to the move table.
-  typename Transitions::TransTable GetMoveTable(const StateId& state) const {
+  typename Transitions::TransTableRef GetMoveTable(const StateId& state) const {
       return states_[state].trans_.GetMoveTable();
   }
 
@@ -0,0 +1,121 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Shift-And step implementations.
+ * \author Vladimir Lapshin.
+ */
+
+#include "glushkov_matcher.h"
+
+#ifdef STRUTEXT_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace strutext { namespace automata {
+
+namespace {
+
+/// Plain implementation, starting from the word.
+uint64_t StepScalar(size_t begin, size_t num_of_words, const uint64_t* shift, const uint64_t* first,
+                    const uint64_t* masks, const uint64_t* last, uint64_t* follow, uint64_t* state) {
+  uint64_t found = 0;
+  for (size_t i = begin; i < num_of_words; ++i) {
+    state[i] = (((state[i] << 1) & shift[i]) | first[i] | follow[i]) & masks[i];
+    follow[i] = 0;
+    found |= state[i] & last[i];
+  }
+  return found;
+}
+
+/// Plain implementation.
+uint64_t Step(size_t num_of_words, const uint64_t* shift, const uint64_t* first,
+              const uint64_t* masks, const uint64_t* last, uint64_t* follow, uint64_t* state) {
+  return StepScalar(0, num_of_words, shift, first, masks, last, follow, state);
+}
+
+#ifdef STRUTEXT_X86_SIMD
+
+/// SSE2 implementation, two words at once.
+uint64_t StepSse2(size_t num_of_words, const uint64_t* shift, const uint64_t* first,
+                  const uint64_t* masks, const uint64_t* last, uint64_t* follow, uint64_t* state) {
+  const __m128i zero = _mm_setzero_si128();
+  __m128i found = zero;
+  size_t i = 0;
+  for (; i + 2 <= num_of_words; i += 2) {
+    __m128i* follow_words = reinterpret_cast<__m128i*>(follow + i);
+    __m128i* state_words = reinterpret_cast<__m128i*>(state + i);
+    const __m128i words = _mm_and_si128(
+        _mm_or_si128(
+            _mm_or_si128(
+                _mm_and_si128(_mm_slli_epi64(_mm_loadu_si128(state_words), 1),
+                              _mm_loadu_si128(reinterpret_cast<const __m128i*>(shift + i))),
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(first + i))),
+            _mm_loadu_si128(follow_words)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks + i)));
+    _mm_storeu_si128(state_words, words);
+    _mm_storeu_si128(follow_words, zero);
+    found = _mm_or_si128(found, _mm_and_si128(words, _mm_loadu_si128(reinterpret_cast<const __m128i*>(last + i))));
+  }
+  uint64_t lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), found);
+  return lanes[0] | lanes[1] | StepScalar(i, num_of_words, shift, first, masks, last, follow, state);
+}
+
+/// AVX2 implementation, four words at once.
+__attribute__((target("avx2")))
+uint64_t StepAvx2(size_t num_of_words, const uint64_t* shift, const uint64_t* first,
+                  const uint64_t* masks, const uint64_t* last, uint64_t* follow, uint64_t* state) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i found = zero;
+  size_t i = 0;
+  for (; i + 4 <= num_of_words; i += 4) {
+    __m256i* follow_words = reinterpret_cast<__m256i*>(follow + i);
+    __m256i* state_words = reinterpret_cast<__m256i*>(state + i);
+    const __m256i words = _mm256_and_si256(
+        _mm256_or_si256(
+            _mm256_or_si256(
+                _mm256_and_si256(_mm256_slli_epi64(_mm256_loadu_si256(state_words), 1),
+                                 _mm256_loadu_si256(reinterpret_cast<const __m256i*>(shift + i))),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first + i))),
+            _mm256_loadu_si256(follow_words)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(masks + i)));
+    _mm256_storeu_si256(state_words, words);
+    _mm256_storeu_si256(follow_words, zero);
+    found = _mm256_or_si256(
+        found, _mm256_and_si256(words, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(last + i))));
+  }
+  uint64_t lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), found);
+  return lanes[0] | lanes[1] | lanes[2] | lanes[3]
+      | StepScalar(i, num_of_words, shift, first, masks, last, follow, state);
+}
+
+#endif  // STRUTEXT_X86_SIMD
+
+}  // namespace.
+
+details::ShiftAndStepFunction details::GetShiftAndStep(encode::SimdLevel level) {
+  switch (level) {
+#ifdef STRUTEXT_X86_SIMD
+    case encode::AVX2_SIMD_LEVEL:
+      return StepAvx2;
+    case encode::SSE2_SIMD_LEVEL:
+      return StepSse2;
+#endif
+    default:
+      return Step;
+  }
+}
+
+}} // namespace strutext, automata.
@@ -0,0 +1,482 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Bit-parallel search of short rules: Glushkov automata run as Shift-And.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <boost/type_traits/make_unsigned.hpp>
+
+#include "cpu_features.h"
+#include "nfa.h"
+#include "nfa_operations.h"
+
+namespace strutext { namespace automata {
+
+namespace details {
+
+/**
+ * \brief Shift-And step over the state words.
+ *
+ * Each word is replaced by ((word << 1) & shift | first | follow) & masks, the follow words are
+ * zeroed for the next step.
+ *
+ * \param         num_of_words Number of the state words.
+ * \param         shift        Positions followed by the next ones.
+ * \param         first        First positions of the rules.
+ * \param         masks        Positions of the current symbol.
+ * \param         last         Last positions of the rules.
+ * \param[in,out] follow       Follow positions, which are not reached by shift.
+ * \param[in,out] state        The state words.
+ * \return                     Union of the state words and the last positions.
+ */
+typedef uint64_t (*ShiftAndStepFunction)(size_t num_of_words, const uint64_t* shift, const uint64_t* first,
+                                         const uint64_t* masks, const uint64_t* last, uint64_t* follow,
+                                         uint64_t* state);
+
+/// Get Shift-And step implementation by the instruction set.
+ShiftAndStepFunction GetShiftAndStep(encode::SimdLevel level);
+
+} // namespace details.
+
+/**
+ * \brief Bit-parallel search of short rules.
+ *
+ * Each rule is the NFA, which is converted to Glushkov form: the positions are the symbol moves of
+ * the same source and target, a position is followed by the positions leaving the epsilon closure
+ * of its target. A rule may have at most kMaxPositions positions, epsilon cycles are allowed. The
+ * positions are numbered in depth first order, so a chain of moves gets consecutive numbers.
+ *
+ * The rules are packed to 64-bit words in turn, a rule does not cross the word border. The text is
+ * scanned by Shift-And: a position is active if its symbol is read and some preceding position was
+ * active or it is the first one. The moves to the next positions are one shift of the word, other
+ * moves are looked up in tables by 8 bits of the word. Each symbol of the rules has the mask of its
+ * positions in each word; the symbols of equal masks make one class, and the masks are kept by
+ * classes. The class 0 is for absent symbols. The words are updated by SSE2 or AVX2 instructions, if
+ * the CPU supports them.
+ *
+ * The rules are searched from each text position, the matches are reported by their ends, as
+ * RegexScanner does. The scan takes a class lookup and a pass over the words per symbol, whatever the
+ * size of deterministic automaton of the rules is.
+ */
+template <typename SymbolCode, typename RuleId>
+class GlushkovMatcher {
+public:
+  /// Unsigned symbol type, used as index.
+  typedef typename boost::make_unsigned<SymbolCode>::type UnsignedCode;
+
+  /// Rule match found in the text.
+  struct Match {
+    /// Initialization.
+    Match(size_t end, RuleId id)
+      : end_(end)
+      , id_(id) {}
+
+    size_t end_; ///< Offset of the symbol after the match.
+    RuleId id_;  ///< Rule identifier.
+  };
+
+  /// Type of match list.
+  typedef std::vector<Match> MatchList;
+
+  /// The maximal number of positions of a rule.
+  static const size_t kMaxPositions = 64;
+
+  /// Maximal number of symbols, whose classes are kept in direct lookup table.
+  static const size_t kMaxDirectSymbols = 0x10000;
+
+  /// Default initialization: no rules, the best instruction set.
+  GlushkovMatcher()
+    : num_of_words_(0)
+    , num_of_classes_(1)
+    , step_(details::GetShiftAndStep(encode::GetSimdLevel()))
+    , compiled_(false) {}
+
+  /**
+   * \brief Add the rule.
+   *
+   * \param nfa The rule automaton, the attributes are not used.
+   * \param id  The rule identifier.
+   */
+  template <typename Attribute>
+  void AddRule(const Nfa<SymbolCode, Attribute>& nfa, RuleId id);
+
+  /// Pack the rules and build the masks, it must be called after the rules are added.
+  void Compile();
+
+  /// Is the matcher compiled?
+  bool IsCompiled() const { return compiled_; }
+
+  /// Use the instruction set, if the CPU supports it.
+  void SetSimdLevel(encode::SimdLevel level) {
+    step_ = details::GetShiftAndStep(encode::IsSimdLevelSupported(level) ? level : encode::SCALAR_SIMD_LEVEL);
+  }
+
+  /// Return number of rules.
+  size_t GetNumOfRules() const { return rules_.size(); }
+
+  /// Return number of state words.
+  size_t GetNumOfWords() const { return num_of_words_; }
+
+  /// Return number of symbol classes.
+  size_t GetNumOfClasses() const { return num_of_classes_; }
+
+  /// Get class of the symbol.
+  uint32_t GetSymbolClass(SymbolCode symbol) const {
+    const UnsignedCode code = static_cast<UnsignedCode>(symbol);
+    if (code < direct_classes_.size()) {
+      return direct_classes_[code];
+    }
+    typename SymbolClassList::const_iterator it = std::lower_bound(
+        sparse_classes_.begin(), sparse_classes_.end(), std::make_pair(code, uint32_t(0)));
+    if (it != sparse_classes_.end() and it->first == code) {
+      return it->second;
+    }
+    return 0;
+  }
+
+  /**
+   * \brief Search the rules in the text.
+   *
+   * \param      begin   Begin of the text symbols.
+   * \param      end     End of the text.
+   * \param[out] matches Found rules, in order of their ends, the offsets are in symbols.
+   * \return             Number of found rules.
+   */
+  template <typename Iterator>
+  size_t Scan(Iterator begin, Iterator end, MatchList& matches) const;
+
+private:
+  /// Rule in Glushkov form, the positions are numbered from 0.
+  struct Rule {
+    /// Type of symbol positions.
+    typedef std::map<UnsignedCode, uint64_t> LabelMap;
+
+    RuleId                id_;               ///< Rule identifier.
+    size_t                num_of_positions_; ///< Number of positions.
+    uint64_t              first_;            ///< First positions.
+    uint64_t              last_;             ///< Last positions.
+    bool                  empty_;            ///< Does the rule match the empty text?
+    std::vector<uint64_t> follow_;           ///< Follow positions of each position.
+    LabelMap              labels_;           ///< Positions of each symbol.
+  };
+
+  /// Lookup table of follow positions by 8 bits of the state word.
+  struct FollowTable {
+    /// Initialization.
+    FollowTable(uint32_t word, uint32_t shift, uint32_t offset)
+      : word_(word)
+      , shift_(shift)
+      , offset_(offset) {}
+
+    uint32_t word_;   ///< The state word.
+    uint32_t shift_;  ///< The first bit of the 8 bits.
+    uint32_t offset_; ///< Offset of the table in the table pool.
+  };
+
+  /// Type of symbol to class list.
+  typedef std::vector<std::pair<UnsignedCode, uint32_t> > SymbolClassList;
+
+  /// Check the matcher is compiled and prepare the match list.
+  void StartScan(MatchList& matches) const {
+    if (not compiled_) {
+      throw std::runtime_error("GlushkovMatcher: the matcher is not compiled");
+    }
+    matches.clear();
+  }
+
+  /// Add matches of the rules, which match the empty text.
+  void AddEmptyMatches(size_t end, MatchList& matches) const {
+    for (size_t i = 0; i < empty_rules_.size(); ++i) {
+      matches.push_back(Match(end, empty_rules_[i]));
+    }
+  }
+
+  std::vector<Rule>                   rules_;          ///< The rules.
+  size_t                              num_of_words_;   ///< Number of state words.
+  size_t                              num_of_classes_; ///< Number of symbol classes.
+  std::vector<uint32_t>               direct_classes_; ///< Classes of the first symbols.
+  SymbolClassList                     sparse_classes_; ///< Sorted classes of other symbols.
+  std::vector<uint64_t>               masks_;          ///< Positions of each class in each word.
+  std::vector<uint64_t>               shift_;          ///< Positions followed by the next ones.
+  std::vector<uint64_t>               first_;          ///< First positions of the rules.
+  std::vector<uint64_t>               last_;           ///< Last positions of the rules.
+  std::vector<FollowTable>            tables_;         ///< Follow tables.
+  std::vector<uint64_t>               table_pool_;     ///< Follow positions of the tables.
+  std::vector<uint32_t>               bit_rules_;      ///< Rule number of each bit of each word.
+  std::vector<RuleId>                 empty_rules_;    ///< Rules matching the empty text.
+  details::ShiftAndStepFunction       step_;           ///< Shift-And step implementation.
+  bool                                compiled_;       ///< Is the matcher compiled?
+};
+
+template <typename SymbolCode, typename RuleId>
+const size_t GlushkovMatcher<SymbolCode, RuleId>::kMaxPositions;
+
+template <typename SymbolCode, typename RuleId>
+const size_t GlushkovMatcher<SymbolCode, RuleId>::kMaxDirectSymbols;
+
+template <typename SymbolCode, typename RuleId>
+template <typename Attribute>
+void GlushkovMatcher<SymbolCode, RuleId>::AddRule(const Nfa<SymbolCode, Attribute>& nfa, RuleId id) {
+  typedef operations::utils::NumberedNfa<SymbolCode, Attribute> NumberedNfaImpl;
+  typedef typename NumberedNfaImpl::StateList                   StateList;
+  typedef typename NumberedNfaImpl::SymbolMove                  SymbolMove;
+  typedef std::pair<uint32_t, uint32_t>                         MoveKey;
+
+  if (nfa.GetStartState() == NULL) {
+    throw std::invalid_argument("GlushkovMatcher: the rule has no start state");
+  }
+  NumberedNfaImpl numbered(nfa);
+
+  // Candidate positions: the symbol moves of the same source and target.
+  std::map<MoveKey, uint32_t> move_numbers;
+  std::vector<uint32_t> targets;
+  std::vector<std::vector<UnsignedCode> > symbols;
+  std::vector<std::vector<uint32_t> > leaving(numbered.GetNumOfStates());
+  for (uint32_t state = 0; state < numbered.GetNumOfStates(); ++state) {
+    const std::vector<SymbolMove>& moves = numbered.GetSymbolMoves(state);
+    for (size_t i = 0; i < moves.size(); ++i) {
+      const MoveKey key(state, moves[i].second);
+      typename std::map<MoveKey, uint32_t>::iterator it = move_numbers.find(key);
+      if (it == move_numbers.end()) {
+        it = move_numbers.insert(std::make_pair(key, static_cast<uint32_t>(targets.size()))).first;
+        targets.push_back(moves[i].second);
+        symbols.push_back(std::vector<UnsignedCode>());
+        leaving[state].push_back(it->second);
+      }
+      symbols[it->second].push_back(static_cast<UnsignedCode>(moves[i].first));
+    }
+  }
+
+  // Depth first numbering of the positions reachable from the start, the first follow position
+  // is numbered next.
+  const uint32_t kNoPosition = 0xFFFFFFFF;
+  std::vector<uint32_t> numbers(targets.size(), kNoPosition);
+  std::vector<uint32_t> order;
+  std::vector<uint32_t> work_moves;
+  const StateList start_closure = numbered.GetClosure(numbered.GetStartState());
+  for (size_t i = start_closure.size(); i > 0; --i) {
+    work_moves.insert(work_moves.end(), leaving[start_closure[i - 1]].rbegin(), leaving[start_closure[i - 1]].rend());
+  }
+  while (not work_moves.empty()) {
+    const uint32_t move = work_moves.back();
+    work_moves.pop_back();
+    if (numbers[move] != kNoPosition) {
+      continue;
+    }
+    if (order.size() == kMaxPositions) {
+      throw std::invalid_argument("GlushkovMatcher: the rule has more positions than the maximal number");
+    }
+    numbers[move] = order.size();
+    order.push_back(move);
+    const StateList& closure = numbered.GetClosure(targets[move]);
+    for (size_t i = closure.size(); i > 0; --i) {
+      for (size_t j = leaving[closure[i - 1]].size(); j > 0; --j) {
+        if (numbers[leaving[closure[i - 1]][j - 1]] == kNoPosition) {
+          work_moves.push_back(leaving[closure[i - 1]][j - 1]);
+        }
+      }
+    }
+  }
+
+  // First, last and follow positions, and the positions of each symbol.
+  Rule rule;
+  rule.id_ = id;
+  rule.num_of_positions_ = order.size();
+  rule.first_ = 0;
+  rule.last_ = 0;
+  rule.empty_ = false;
+  rule.follow_.assign(order.size(), 0);
+  for (size_t i = 0; i < start_closure.size(); ++i) {
+    rule.empty_ = rule.empty_ or numbered.IsAcceptable(start_closure[i]);
+    for (size_t j = 0; j < leaving[start_closure[i]].size(); ++j) {
+      rule.first_ |= uint64_t(1) << numbers[leaving[start_closure[i]][j]];
+    }
+  }
+  for (size_t pos = 0; pos < order.size(); ++pos) {
+    const StateList& closure = numbered.GetClosure(targets[order[pos]]);
+    for (size_t i = 0; i < closure.size(); ++i) {
+      if (numbered.IsAcceptable(closure[i])) {
+        rule.last_ |= uint64_t(1) << pos;
+      }
+      for (size_t j = 0; j < leaving[closure[i]].size(); ++j) {
+        rule.follow_[pos] |= uint64_t(1) << numbers[leaving[closure[i]][j]];
+      }
+    }
+    const std::vector<UnsignedCode>& pos_symbols = symbols[order[pos]];
+    for (size_t i = 0; i < pos_symbols.size(); ++i) {
+      rule.labels_[pos_symbols[i]] |= uint64_t(1) << pos;
+    }
+  }
+  rules_.push_back(rule);
+  compiled_ = false;
+}
+
+template <typename SymbolCode, typename RuleId>
+void GlushkovMatcher<SymbolCode, RuleId>::Compile() {
+  // The rules are put to the words in turn, the next word is started if the rule does not fit.
+  std::vector<std::pair<uint32_t, uint32_t> > places(rules_.size());
+  num_of_words_ = 0;
+  size_t used_bits = kMaxPositions;
+  for (size_t i = 0; i < rules_.size(); ++i) {
+    if (rules_[i].num_of_positions_ == 0) {
+      continue;
+    }
+    if (used_bits + rules_[i].num_of_positions_ > kMaxPositions) {
+      ++num_of_words_;
+      used_bits = 0;
+    }
+    places[i] = std::make_pair(num_of_words_ - 1, used_bits);
+    used_bits += rules_[i].num_of_positions_;
+  }
+
+  // First, last and shifted positions; follow tables of other moves.
+  shift_.assign(num_of_words_, 0);
+  first_.assign(num_of_words_, 0);
+  last_.assign(num_of_words_, 0);
+  bit_rules_.assign(num_of_words_ * kMaxPositions, 0);
+  std::vector<uint64_t> follow(num_of_words_ * kMaxPositions, 0);
+  empty_rules_.clear();
+  for (size_t i = 0; i < rules_.size(); ++i) {
+    const Rule& rule = rules_[i];
+    if (rule.empty_) {
+      empty_rules_.push_back(rule.id_);
+    }
+    if (rule.num_of_positions_ == 0) {
+      continue;
+    }
+    const uint32_t word = places[i].first;
+    const uint32_t offset = places[i].second;
+    first_[word] |= rule.first_ << offset;
+    if (not rule.empty_) {
+      // The rules matching the empty text are reported at each offset anyway.
+      last_[word] |= rule.last_ << offset;
+    }
+    for (size_t pos = 0; pos < rule.num_of_positions_; ++pos) {
+      bit_rules_[word * kMaxPositions + offset + pos] = i;
+      uint64_t pos_follow = rule.follow_[pos];
+      const uint64_t next = uint64_t(1) << (pos + 1);
+      if (pos + 1 < rule.num_of_positions_ and (pos_follow & next) != 0) {
+        shift_[word] |= next << offset;
+        pos_follow &= ~next;
+      }
+      follow[word * kMaxPositions + offset + pos] = pos_follow << offset;
+    }
+  }
+  tables_.clear();
+  table_pool_.clear();
+  for (uint32_t word = 0; word < num_of_words_; ++word) {
+    for (uint32_t shift = 0; shift < kMaxPositions; shift += 8) {
+      const uint64_t* bits_follow = &follow[word * kMaxPositions + shift];
+      if (std::count(bits_follow, bits_follow + 8, uint64_t(0)) == 8) {
+        continue;
+      }
+      tables_.push_back(FollowTable(word, shift, table_pool_.size()));
+      table_pool_.resize(table_pool_.size() + 256, 0);
+      uint64_t* table = &table_pool_[tables_.back().offset_];
+      for (uint32_t bits = 1; bits < 256; ++bits) {
+        // The table entry is the entry of the bits without the lowest one plus the lowest one follow.
+        const uint32_t lowest = bits & (~bits + 1);
+        table[bits] = table[bits ^ lowest] | bits_follow[__builtin_ctz(lowest)];
+      }
+    }
+  }
+
+  // Symbol classes by the masks over all the words, the class 0 has no positions.
+  std::map<UnsignedCode, std::vector<uint64_t> > symbol_masks;
+  for (size_t i = 0; i < rules_.size(); ++i) {
+    for (typename Rule::LabelMap::const_iterator it = rules_[i].labels_.begin(); it != rules_[i].labels_.end(); ++it) {
+      std::vector<uint64_t>& masks = symbol_masks[it->first];
+      masks.resize(num_of_words_, 0);
+      masks[places[i].first] |= it->second << places[i].second;
+    }
+  }
+  std::map<std::vector<uint64_t>, uint32_t> class_numbers;
+  class_numbers[std::vector<uint64_t>(num_of_words_, 0)] = 0;
+  masks_.assign(num_of_words_, 0);
+  std::map<UnsignedCode, uint32_t> symbol_classes;
+  size_t max_code = 0;
+  for (typename std::map<UnsignedCode, std::vector<uint64_t> >::const_iterator it = symbol_masks.begin();
+        it != symbol_masks.end(); ++it) {
+    std::map<std::vector<uint64_t>, uint32_t>::iterator cls_it = class_numbers.find(it->second);
+    if (cls_it == class_numbers.end()) {
+      cls_it = class_numbers.insert(std::make_pair(it->second, static_cast<uint32_t>(class_numbers.size()))).first;
+      masks_.insert(masks_.end(), it->second.begin(), it->second.end());
+    }
+    symbol_classes[it->first] = cls_it->second;
+    max_code = it->first;
+  }
+  num_of_classes_ = class_numbers.size();
+  direct_classes_.assign(sizeof(UnsignedCode) == 1 ? 256 : std::min(max_code + 1, kMaxDirectSymbols), 0);
+  sparse_classes_.clear();
+  for (typename std::map<UnsignedCode, uint32_t>::const_iterator it = symbol_classes.begin();
+        it != symbol_classes.end(); ++it) {
+    if (it->first < direct_classes_.size()) {
+      direct_classes_[it->first] = it->second;
+    } else {
+      sparse_classes_.push_back(*it);
+    }
+  }
+  compiled_ = true;
+}
+
+template <typename SymbolCode, typename RuleId>
+template <typename Iterator>
+size_t GlushkovMatcher<SymbolCode, RuleId>::Scan(Iterator begin, Iterator end, MatchList& matches) const {
+  StartScan(matches);
+  std::vector<uint64_t> state(num_of_words_ + 1, 0);
+  std::vector<uint64_t> follow(num_of_words_ + 1, 0);
+  size_t pos = 0;
+  AddEmptyMatches(pos, matches);
+  for (; begin != end; ++begin) {
+    ++pos;
+    for (size_t i = 0; i < tables_.size(); ++i) {
+      const FollowTable& table = tables_[i];
+      follow[table.word_] |= table_pool_[table.offset_ + ((state[table.word_] >> table.shift_) & 0xFF)];
+    }
+    if (num_of_words_ == 0) {
+      AddEmptyMatches(pos, matches);
+      continue;
+    }
+    const uint64_t* masks = &masks_[GetSymbolClass(*begin) * num_of_words_];
+    if (step_(num_of_words_, &shift_[0], &first_[0], masks, &last_[0], &follow[0], &state[0]) != 0) {
+      // Each rule is reported once, though several its last positions are reached.
+      for (size_t word = 0; word < num_of_words_; ++word) {
+        uint32_t prev_rule = rules_.size();
+        for (uint64_t found = state[word] & last_[word]; found != 0; found &= found - 1) {
+          const uint32_t rule = bit_rules_[word * kMaxPositions + __builtin_ctzll(found)];
+          if (rule != prev_rule) {
+            matches.push_back(Match(pos, rules_[rule].id_));
+            prev_rule = rule;
+          }
+        }
+      }
+    }
+    AddEmptyMatches(pos, matches);
+  }
+  return matches.size();
+}
+
+}} // namespace strutext, automata.
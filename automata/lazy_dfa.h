@@ -0,0 +1,324 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Lazy deterministic automaton: the states are built on first visit and kept in bounded cache.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <boost/functional/hash.hpp>
+#include <boost/type_traits/make_unsigned.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "fsm_defs.h"
+#include "nfa.h"
+#include "nfa_operations.h"
+
+namespace strutext { namespace automata {
+
+/**
+ * \brief Deterministic automaton of NFA, built during the matching.
+ *
+ * A state is the sorted list of NFA states closed by epsilon moves, the same as in the subset
+ * construction, but it is built when the matching comes to it first. The move table is dense over
+ * symbol classes: each NFA symbol makes its own class and all other symbols share the class 0.
+ * The unknown moves are calculated by NFA moves and remembered, so the text symbol costs a class
+ * lookup and a table load when the state and the move are known.
+ *
+ * The number of cached states is bounded. When the cache is full, all the states are evicted, except
+ * the start and the current ones, and the building goes on. The moves refer to the states by numbers,
+ * so evicting some states would require to find all the moves to them. If the cache gets full before
+ * kMinSymbolsPerState symbols per cached state are scanned since the last flush, the cache thrashes,
+ * and the rest of the text is matched by NFA simulation: the same moves, not remembered.
+ *
+ * The NFA must live while the automaton is used.
+ */
+template <typename SymbolCode, typename Attribute>
+class LazyDfa {
+public:
+  /// NFA type.
+  typedef Nfa<SymbolCode, Attribute> NfaImpl;
+
+  /// Type of attribute list.
+  typedef std::vector<Attribute> AttributeList;
+
+  /// Unsigned symbol type, used as index.
+  typedef typename boost::make_unsigned<SymbolCode>::type UnsignedCode;
+
+  /// Maximal number of symbols, whose classes are kept in direct lookup table.
+  static const size_t kMaxDirectSymbols = 0x10000;
+
+  /// Default number of cached states.
+  static const size_t kDefaultMaxStates = 0x10000;
+
+  /// The least number of cached states: the start, the current and the next ones.
+  static const size_t kMinStates = 3;
+
+  /// Scanned symbols per built state, if less then the cache thrashes.
+  static const size_t kMinSymbolsPerState = 10;
+
+  /**
+   * \brief Initialization by NFA.
+   *
+   * \param nfa        The NFA.
+   * \param max_states The maximal number of cached states, at least kMinStates.
+   */
+  explicit LazyDfa(const NfaImpl& nfa, size_t max_states = kDefaultMaxStates);
+
+  /**
+   * \brief Match the text by the automaton.
+   *
+   * \param      begin Begin of the text symbols.
+   * \param      end   End of the text.
+   * \param[out] attrs Attributes of the state at the text end, sorted.
+   * \return           Is the text in the language of the NFA?
+   */
+  template <typename Iterator>
+  bool Match(Iterator begin, Iterator end, AttributeList& attrs);
+
+  /// Return number of cached states.
+  size_t GetNumOfStates() const { return lists_.size(); }
+
+  /// Return the maximal number of cached states.
+  size_t GetMaxNumOfStates() const { return max_states_; }
+
+  /// Return number of symbol classes.
+  size_t GetNumOfClasses() const { return num_of_classes_; }
+
+  /// Return number of cache flushes.
+  size_t GetNumOfFlushes() const { return num_of_flushes_; }
+
+  /// Return number of texts, matched by NFA simulation because of cache thrashing.
+  size_t GetNumOfFallbacks() const { return num_of_fallbacks_; }
+
+  /// Get class of the symbol.
+  uint32_t GetSymbolClass(SymbolCode symbol) const {
+    const UnsignedCode code = static_cast<UnsignedCode>(symbol);
+    if (code < direct_classes_.size()) {
+      return direct_classes_[code];
+    }
+    typename SymbolClassList::const_iterator it = std::lower_bound(
+        sparse_classes_.begin(), sparse_classes_.end(), std::make_pair(code, uint32_t(0)));
+    if (it != sparse_classes_.end() and it->first == code) {
+      return it->second;
+    }
+    return 0;
+  }
+
+private:
+  /// Numbered NFA type.
+  typedef operations::utils::NumberedNfa<SymbolCode, Attribute> NumberedNfaImpl;
+
+  /// Type of NFA state list.
+  typedef typename NumberedNfaImpl::StateList StateList;
+
+  /// Type of state list to state map.
+  typedef boost::unordered_map<StateList, StateId, boost::hash<StateList> > StateListMap;
+
+  /// Type of symbol to class list.
+  typedef std::vector<std::pair<UnsignedCode, uint32_t> > SymbolClassList;
+
+  /// Unknown move mark.
+  static const StateId kUnknownState = 0xFFFFFFFF;
+
+  /// Get the state of the list, add it if absent.
+  StateId AddState(const StateList& list);
+
+  /// Evict all the states, return the number of the kept state.
+  StateId Flush(StateId keep);
+
+  /// Collect the acceptance and the attributes of NFA states.
+  bool GetAttributes(const StateList& list, AttributeList& attrs) const;
+
+  NumberedNfaImpl                  nfa_;              ///< The NFA with numbered states.
+  size_t                           max_states_;       ///< The maximal number of cached states.
+  size_t                           num_of_classes_;   ///< Number of symbol classes.
+  std::vector<uint32_t>            direct_classes_;   ///< Classes of the first symbols.
+  SymbolClassList                  sparse_classes_;   ///< Sorted classes of other symbols.
+  StateListMap                     states_;           ///< Cached states by NFA state lists.
+  std::vector<const StateList*>    lists_;            ///< NFA state lists of cached states.
+  std::vector<StateId>             delta_;            ///< Move table, kUnknownState for unknown moves.
+  std::vector<uint8_t>             accepted_;         ///< Acceptable state marks.
+  std::vector<uint32_t>            attr_offsets_;     ///< Begin of the attributes of each state, plus the end.
+  AttributeList                    attrs_;            ///< Attributes of cached states.
+  StateId                          dead_;             ///< The state of no NFA states, if cached.
+  StateList                        start_list_;       ///< NFA states of the start state.
+  StateList                        target_list_;      ///< Target of the move being built.
+  AttributeList                    state_attrs_;      ///< Attributes of the state being added.
+  size_t                           num_of_symbols_;   ///< Symbols scanned since the last flush.
+  size_t                           num_of_flushes_;   ///< Number of cache flushes.
+  size_t                           num_of_fallbacks_; ///< Number of NFA simulations.
+};
+
+template <typename SymbolCode, typename Attribute>
+const size_t LazyDfa<SymbolCode, Attribute>::kMaxDirectSymbols;
+
+template <typename SymbolCode, typename Attribute>
+const size_t LazyDfa<SymbolCode, Attribute>::kDefaultMaxStates;
+
+template <typename SymbolCode, typename Attribute>
+const size_t LazyDfa<SymbolCode, Attribute>::kMinStates;
+
+template <typename SymbolCode, typename Attribute>
+const size_t LazyDfa<SymbolCode, Attribute>::kMinSymbolsPerState;
+
+template <typename SymbolCode, typename Attribute>
+const StateId LazyDfa<SymbolCode, Attribute>::kUnknownState;
+
+template <typename SymbolCode, typename Attribute>
+LazyDfa<SymbolCode, Attribute>::LazyDfa(const NfaImpl& nfa, size_t max_states)
+  : nfa_(nfa)
+  , max_states_(max_states)
+  , num_of_classes_(1)
+  , attr_offsets_(1, 0)
+  , dead_(kUnknownState)
+  , num_of_symbols_(0)
+  , num_of_flushes_(0)
+  , num_of_fallbacks_(0) {
+  if (max_states_ < kMinStates) {
+    throw std::invalid_argument("LazyDfa: the number of cached states is less than the least one");
+  }
+
+  // Collect the NFA symbols, the class 0 is for absent symbols.
+  std::map<UnsignedCode, uint32_t> symbol_ids;
+  for (uint32_t state = 0; state < nfa_.GetNumOfStates(); ++state) {
+    const std::vector<typename NumberedNfaImpl::SymbolMove>& moves = nfa_.GetSymbolMoves(state);
+    for (size_t i = 0; i < moves.size(); ++i) {
+      symbol_ids[static_cast<UnsignedCode>(moves[i].first)] = 0;
+    }
+  }
+  size_t max_code = 0;
+  for (typename std::map<UnsignedCode, uint32_t>::iterator it = symbol_ids.begin(); it != symbol_ids.end(); ++it) {
+    it->second = num_of_classes_++;
+    max_code = it->first;
+  }
+  direct_classes_.assign(sizeof(UnsignedCode) == 1 ? 256 : std::min(max_code + 1, kMaxDirectSymbols), 0);
+  for (typename std::map<UnsignedCode, uint32_t>::const_iterator it = symbol_ids.begin(); it != symbol_ids.end(); ++it) {
+    if (it->first < direct_classes_.size()) {
+      direct_classes_[it->first] = it->second;
+    } else {
+      sparse_classes_.push_back(*it);
+    }
+  }
+
+  // The start state is always the state 0.
+  if (nfa.GetStartState() != NULL) {
+    start_list_ = nfa_.GetClosure(nfa_.GetStartState());
+  }
+  AddState(start_list_);
+}
+
+template <typename SymbolCode, typename Attribute>
+template <typename Iterator>
+bool LazyDfa<SymbolCode, Attribute>::Match(Iterator begin, Iterator end, AttributeList& attrs) {
+  StateId state = 0;
+  size_t pos = 0;
+  for (; begin != end and state != dead_; ++begin, ++pos) {
+    const uint32_t cls = GetSymbolClass(*begin);
+    if (delta_[state * num_of_classes_ + cls] != kUnknownState) {
+      state = delta_[state * num_of_classes_ + cls];
+      continue;
+    }
+
+    // Unknown move is calculated by NFA, the new state may require to flush the cache.
+    nfa_.Move(*lists_[state], *begin, target_list_);
+    StateId next = kUnknownState;
+    typename StateListMap::const_iterator it = states_.find(target_list_);
+    if (it != states_.end()) {
+      next = it->second;
+    } else {
+      if (lists_.size() == max_states_) {
+        if (num_of_symbols_ + pos < kMinSymbolsPerState * max_states_) {
+          // The cache thrashes, the rest of the text is matched by NFA.
+          ++num_of_fallbacks_;
+          StateList current;
+          current.swap(target_list_);
+          for (++begin, ++pos; begin != end and not current.empty(); ++begin, ++pos) {
+            nfa_.Move(current, *begin, target_list_);
+            current.swap(target_list_);
+          }
+          num_of_symbols_ += pos;
+          return GetAttributes(current, attrs);
+        }
+        num_of_symbols_ = 0;
+        pos = 0;
+        state = Flush(state);
+      }
+      next = AddState(target_list_);
+    }
+    delta_[state * num_of_classes_ + cls] = next;
+    state = next;
+  }
+  num_of_symbols_ += pos;
+  attrs.assign(attrs_.begin() + attr_offsets_[state], attrs_.begin() + attr_offsets_[state + 1]);
+  return accepted_[state] != 0;
+}
+
+template <typename SymbolCode, typename Attribute>
+StateId LazyDfa<SymbolCode, Attribute>::AddState(const StateList& list) {
+  typename StateListMap::iterator it = states_.find(list);
+  if (it == states_.end()) {
+    // The map keys are not moved by rehashing, so the list of keys is the list of states.
+    const StateId state = lists_.size();
+    it = states_.insert(std::make_pair(list, state)).first;
+    lists_.push_back(&it->first);
+    delta_.resize(delta_.size() + num_of_classes_, kUnknownState);
+    accepted_.push_back(GetAttributes(list, state_attrs_) ? 1 : 0);
+    attrs_.insert(attrs_.end(), state_attrs_.begin(), state_attrs_.end());
+    attr_offsets_.push_back(attrs_.size());
+    if (list.empty()) {
+      dead_ = state;
+    }
+  }
+  return it->second;
+}
+
+template <typename SymbolCode, typename Attribute>
+StateId LazyDfa<SymbolCode, Attribute>::Flush(StateId keep) {
+  ++num_of_flushes_;
+  StateList keep_list(*lists_[keep]);
+  states_.clear();
+  lists_.clear();
+  delta_.clear();
+  accepted_.clear();
+  attr_offsets_.assign(1, 0);
+  attrs_.clear();
+  dead_ = kUnknownState;
+  AddState(start_list_);
+  return AddState(keep_list);
+}
+
+template <typename SymbolCode, typename Attribute>
+bool LazyDfa<SymbolCode, Attribute>::GetAttributes(const StateList& list, AttributeList& attrs) const {
+  bool is_accepted = false;
+  std::set<Attribute> attr_set;
+  for (size_t i = 0; i < list.size(); ++i) {
+    is_accepted = is_accepted or nfa_.IsAcceptable(list[i]);
+    attr_set.insert(nfa_.GetAttributes(list[i]).begin(), nfa_.GetAttributes(list[i]).end());
+  }
+  attrs.assign(attr_set.begin(), attr_set.end());
+  return is_accepted;
+}
+
+}} // namespace strutext, automata.
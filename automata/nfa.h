@@ -116,7 +116,7 @@ struct Nfa : private boost::noncopyable {
   void AddTransition(State* from, State* to, SymbolCode symbol) {
     assert(from and "state must be not NULL");
     assert(to and "state must be not NULL");
-    from->trans_table_.insert(State::TransTable::value_type(Symbol(symbol), to));
+    from->trans_table_.insert(typename State::TransTable::value_type(Symbol(symbol), to));
   }
 
   /**
@@ -129,7 +129,7 @@ struct Nfa : private boost::noncopyable {
   void AddTransition(State* from, State* to, Symbol symbol) {
     assert(from and "state must be not NULL");
     assert(to and "state must be not NULL");
-    from->trans_table_.insert(State::TransTable::value_type(symbol, to));
+    from->trans_table_.insert(typename State::TransTable::value_type(symbol, to));
   }
 
   /**
@@ -141,7 +141,7 @@ struct Nfa : private boost::noncopyable {
   void AddEpsilonTransition(State* from, State* to) {
     assert(from and "state must be not NULL");
     assert(to and "state must be not NULL");
-    from->trans_table_.insert(State::TransTable::value_type(Symbol(), to));
+    from->trans_table_.insert(typename State::TransTable::value_type(Symbol(), to));
   }
 
   /**
@@ -18,15 +18,25 @@
 
 #pragma once
 
+#include <stdint.h>
+
+#include <algorithm>
 #include <list>
 #include <vector>
 #include <set>
 #include <map>
+#include <utility>
 
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_map.hpp>
 
 #include "nfa.h"
+#include "fsm_defs.h"
+#include "attr_fsm.h"
+#include "frozen_transitions.h"
+#include "dfa_minimizer.h"
 
 namespace strutext { namespace automata { namespace operations {
 
@@ -98,77 +108,76 @@ UnionResult<SymbolCode, Attribute> CreateUnion(
   return result;
 }
 
-/// Epsilon closure implementation for one state.
+/**
+ * \brief Epsilon closure implementation for one state.
+ *
+ * The helpers work on state pointers, so they need no numbering of the whole NFA. They have the
+ * same semantics as NumberedNfa::GetClosure and NumberedNfa::Move, which are used in the subset
+ * construction.
+ */
 template <typename SymbolCode, typename Attribute>
 void EpsilonClosure(typename Nfa<SymbolCode, Attribute>::State* state,
-                      std::set<typename Nfa<SymbolCode, Attribute>::State*>& res) {
-  typedef Nfa<SymbolCode, Attribute> NfaImpl;
+                    std::set<typename Nfa<SymbolCode, Attribute>::State*>& res) {
+  typedef Nfa<SymbolCode, Attribute>          NfaImpl;
+  typedef typename NfaImpl::State::TransTable TransTable;
 
   res.clear();
   res.insert(state);
-  std::set<typename NfaImpl::State*> step_res = res;
-  for (;;) {
-    std::set<typename NfaImpl::State*> local_res;
-    for (typename std::set<typename NfaImpl::State*>::iterator st_it = step_res.begin(); st_it != step_res.end(); ++st_it) {
-      typename std::pair<typename NfaImpl::TransTable::iterator, typename NfaImpl::TransTable::iterator> ret =
-                                                                (*st_it)->trans_table_.equal_range(NfaImpl::Symbol());
-      for (typename NfaImpl::TransTable::iterator it = ret.first; it != ret.second; ++it) {
-        if (res.find(it->second) == res.end()) {
-          res.insert(it->second);
-          local_res.insert(it->second);
-        }
+  std::vector<typename NfaImpl::State*> work_states(1, state);
+  while (not work_states.empty()) {
+    const typename NfaImpl::State* current = work_states.back();
+    work_states.pop_back();
+    std::pair<typename TransTable::const_iterator, typename TransTable::const_iterator> range =
+        current->trans_table_.equal_range(typename NfaImpl::Symbol());
+    for (typename TransTable::const_iterator it = range.first; it != range.second; ++it) {
+      if (res.insert(it->second).second) {
+        work_states.push_back(it->second);
       }
     }
-    if (local_res.empty()) {
-      break;
-    } else {
-      local_res.swap(step_res);
-    }
   }
 }
 
 /// Epsilon closure implementation for set of states.
 template <typename SymbolCode, typename Attribute>
 void EpsilonClosure(const std::set<typename Nfa<SymbolCode, Attribute>::State*>& input,
-                      std::set<typename Nfa<SymbolCode, Attribute>::State*>& res) {
+                    std::set<typename Nfa<SymbolCode, Attribute>::State*>& res) {
   typedef Nfa<SymbolCode, Attribute> NfaImpl;
 
-  for (typename std::set<typename Nfa<SymbolCode, Attribute>::State*>::const_iterator st_it = input.begin();
-        st_it != input.end(); ++st_it) {
+  for (typename std::set<typename NfaImpl::State*>::const_iterator st_it = input.begin(); st_it != input.end(); ++st_it) {
     std::set<typename NfaImpl::State*> state_res;
-    EpsilonClosure(*st_it, state_res);
+    EpsilonClosure<SymbolCode, Attribute>(*st_it, state_res);
     res.insert(state_res.begin(), state_res.end());
   }
 }
 
-/// Move on set of states.
+/// Move on set of states, the result is closed by epsilon moves.
 template <typename SymbolCode, typename Attribute>
 void Move(const std::set<typename Nfa<SymbolCode, Attribute>::State*>& input,
-            const typename Nfa<SymbolCode, Attribute>::Symbol& symbol,
-            std::set<typename Nfa<SymbolCode, Attribute>::State*>& res) {
-  typedef Nfa<SymbolCode, Attribute> NfaImpl;
+          const typename Nfa<SymbolCode, Attribute>::Symbol& symbol,
+          std::set<typename Nfa<SymbolCode, Attribute>::State*>& res) {
+  typedef Nfa<SymbolCode, Attribute>          NfaImpl;
+  typedef typename NfaImpl::State::TransTable TransTable;
 
-  for (typename std::set<typename Nfa<SymbolCode, Attribute>::State*>::const_iterator st_it = input.begin();
-        st_it != input.end(); ++st_it) {
-     typename std::pair<typename NfaImpl::TransTable::iterator, typename NfaImpl::TransTable::iterator> ret =
-                                                                      (*st_it)->trans_table_.equal_range(symbol);
-    std::set<typename NfaImpl::State*> state_res, closure_res;
-    for (typename NfaImpl::TransTable::iterator it = ret.first; it != ret.second; ++it) {
-      state_res.insert(it->second);
+  std::set<typename NfaImpl::State*> targets;
+  for (typename std::set<typename NfaImpl::State*>::const_iterator st_it = input.begin(); st_it != input.end(); ++st_it) {
+    std::pair<typename TransTable::const_iterator, typename TransTable::const_iterator> range =
+        (*st_it)->trans_table_.equal_range(symbol);
+    for (typename TransTable::const_iterator it = range.first; it != range.second; ++it) {
+      targets.insert(it->second);
     }
-    EpsilonClosure(state_res, closure_res);
-    res.insert(closure_res.begin(), closure_res.end());
   }
+  EpsilonClosure<SymbolCode, Attribute>(targets, res);
 }
 
 /// Find move symbols for set of states.
 template <typename SymbolCode, typename Attribute>
 void FindSymbols(const std::set<typename Nfa<SymbolCode, Attribute>::State*>& input,
-                  std::set<typename Nfa<SymbolCode, Attribute>::Symbol>& symbols) {
-  typedef Nfa<SymbolCode, Attribute> NfaImpl;
+                 std::set<typename Nfa<SymbolCode, Attribute>::Symbol>& symbols) {
+  typedef Nfa<SymbolCode, Attribute>          NfaImpl;
+  typedef typename NfaImpl::State::TransTable TransTable;
 
   for (typename std::set<typename NfaImpl::State*>::const_iterator st_it = input.begin(); st_it != input.end(); ++st_it) {
-    for (typename NfaImpl::TransTable::iterator it = (*st_it)->trans_table_.begin(); it != (*st_it)->trans_table_.end(); ++it) {
+    for (typename TransTable::const_iterator it = (*st_it)->trans_table_.begin(); it != (*st_it)->trans_table_.end(); ++it) {
       if (it->first.type_ == NfaImpl::Symbol::SYMBOL_MT) {
         symbols.insert(it->first);
       }
@@ -179,10 +188,10 @@ void FindSymbols(const std::set<typename Nfa<SymbolCode, Attribute>::State*>& in
 /// Check does passed set of states contain accepted state.
 template <typename SymbolCode, typename Attribute>
 bool FindInAccepts(const std::set<typename Nfa<SymbolCode, Attribute>::State*>& input,
-                    typename Nfa<SymbolCode, Attribute>::Ptr nfa) {
+                   typename Nfa<SymbolCode, Attribute>::Ptr nfa) {
   typedef Nfa<SymbolCode, Attribute> NfaImpl;
 
-  const std::set<typename NfaImpl::State*>& accepts = nfa->GetAcceptedStates();
+  const typename NfaImpl::StateSet& accepts = nfa->GetAcceptedStates();
   for (typename std::set<typename NfaImpl::State*>::const_iterator st_it = input.begin(); st_it != input.end(); ++st_it) {
     if (accepts.find(*st_it) != accepts.end()) {
       return true;
@@ -194,14 +203,232 @@ bool FindInAccepts(const std::set<typename Nfa<SymbolCode, Attribute>::State*>&
 /// Copy state attributes to new state.
 template <typename SymbolCode, typename Attribute>
 void CopyAttrs(const std::set<typename Nfa<SymbolCode, Attribute>::State*>& input,
-                typename Nfa<SymbolCode, Attribute>::State* new_state) {
+               typename Nfa<SymbolCode, Attribute>::State* new_state) {
   typedef Nfa<SymbolCode, Attribute> NfaImpl;
 
-  for (std::set<typename NfaImpl::State*> st_it = input.begin(); st_it != input.end(); ++st_it) {
+  for (typename std::set<typename NfaImpl::State*>::const_iterator st_it = input.begin(); st_it != input.end(); ++st_it) {
     new_state->attr_list_.insert((*st_it)->attr_list_.begin(), (*st_it)->attr_list_.end());
   }
 }
 
+/**
+ * \brief NFA with numbered states, used in the subset construction.
+ *
+ * Epsilon closures of the states are calculated once, when they are requested first.
+ */
+template <typename SymbolCode, typename Attribute>
+class NumberedNfa {
+public:
+  /// NFA type.
+  typedef Nfa<SymbolCode, Attribute> NfaImpl;
+
+  /// Type of state number list.
+  typedef std::vector<uint32_t> StateList;
+
+  /// Symbol move: the symbol and the state number.
+  typedef std::pair<SymbolCode, uint32_t> SymbolMove;
+
+  /// Initialization by the NFA.
+  explicit NumberedNfa(const NfaImpl& nfa)
+    : start_(0)
+    , stamp_(0) {
+    boost::unordered_map<typename NfaImpl::State*, uint32_t> numbers;
+    for (typename NfaImpl::StateStorage::const_iterator st_it = nfa.GetStates().begin();
+          st_it != nfa.GetStates().end(); ++st_it) {
+      const uint32_t number = states_.size();
+      numbers[st_it->get()] = number;
+      states_.push_back(st_it->get());
+    }
+    if (nfa.GetStartState() != NULL) {
+      start_ = numbers[nfa.GetStartState()];
+    }
+    const size_t num_of_states = states_.size();
+    symbol_moves_.resize(num_of_states);
+    epsilon_moves_.resize(num_of_states);
+    accepted_.assign(num_of_states, 0);
+    for (size_t i = 0; i < num_of_states; ++i) {
+      const typename NfaImpl::State::TransTable& moves = states_[i]->trans_table_;
+      for (typename NfaImpl::State::TransTable::const_iterator tr_it = moves.begin(); tr_it != moves.end(); ++tr_it) {
+        if (tr_it->first.type_ == NfaImpl::Symbol::SYMBOL_MT) {
+          symbol_moves_[i].push_back(SymbolMove(tr_it->first.symbol_, numbers[tr_it->second]));
+        } else {
+          epsilon_moves_[i].push_back(numbers[tr_it->second]);
+        }
+      }
+      accepted_[i] = nfa.GetAcceptedStates().count(states_[i]) ? 1 : 0;
+    }
+    closures_.resize(num_of_states);
+    closed_.assign(num_of_states, 0);
+    stamps_.assign(num_of_states, 0);
+  }
+
+  /// Return number of states.
+  size_t GetNumOfStates() const { return states_.size(); }
+
+  /// Get the start state number.
+  uint32_t GetStartState() const { return start_; }
+
+  /// Is the state acceptable?
+  bool IsAcceptable(uint32_t state) const { return accepted_[state] != 0; }
+
+  /// Get the state attributes.
+  const typename NfaImpl::State::AttrList& GetAttributes(uint32_t state) const { return states_[state]->attr_list_; }
+
+  /// Get the symbol moves of the state.
+  const std::vector<SymbolMove>& GetSymbolMoves(uint32_t state) const { return symbol_moves_[state]; }
+
+  /// Get the epsilon closure of the state, sorted.
+  const StateList& GetClosure(uint32_t state) {
+    if (not closed_[state]) {
+      StateList& closure = closures_[state];
+      NewStamp();
+      std::vector<uint32_t> work_states(1, state);
+      stamps_[state] = stamp_;
+      while (not work_states.empty()) {
+        const uint32_t current = work_states.back();
+        work_states.pop_back();
+        closure.push_back(current);
+        for (size_t i = 0; i < epsilon_moves_[current].size(); ++i) {
+          const uint32_t next = epsilon_moves_[current][i];
+          if (stamps_[next] != stamp_) {
+            stamps_[next] = stamp_;
+            work_states.push_back(next);
+          }
+        }
+      }
+      std::sort(closure.begin(), closure.end());
+      closed_[state] = 1;
+    }
+    return closures_[state];
+  }
+
+  /**
+   * \brief Get the union of epsilon closures of the states.
+   *
+   * \param      begin  Begin of the states.
+   * \param      end    End of the states.
+   * \param[out] result The union, sorted.
+   */
+  template <typename Iterator>
+  void GetClosure(Iterator begin, Iterator end, StateList& result) {
+    result.clear();
+    for (; begin != end; ++begin) {
+      const StateList& closure = GetClosure(*begin);
+      result.insert(result.end(), closure.begin(), closure.end());
+    }
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+  }
+
+  /**
+   * \brief Move the states by the symbol.
+   *
+   * \param      states The states, closed by epsilon moves.
+   * \param      symbol The symbol to move by.
+   * \param[out] result The epsilon closure of the move targets, sorted.
+   */
+  void Move(const StateList& states, SymbolCode symbol, StateList& result) {
+    targets_.clear();
+    for (size_t i = 0; i < states.size(); ++i) {
+      // The moves are sorted by symbols, as they are in the transition table.
+      const std::vector<SymbolMove>& moves = symbol_moves_[states[i]];
+      typename std::vector<SymbolMove>::const_iterator it = std::lower_bound(
+          moves.begin(), moves.end(), SymbolMove(symbol, 0));
+      for (; it != moves.end() and it->first == symbol; ++it) {
+        targets_.push_back(it->second);
+      }
+    }
+    GetClosure(targets_.begin(), targets_.end(), result);
+  }
+
+private:
+  /// Start the new visit of the states.
+  void NewStamp() {
+    if (++stamp_ == 0) {
+      stamps_.assign(stamps_.size(), 0);
+      stamp_ = 1;
+    }
+  }
+
+  std::vector<typename NfaImpl::State*>       states_;        ///< The states by number.
+  uint32_t                                    start_;         ///< Number of the start state.
+  std::vector<std::vector<SymbolMove> >       symbol_moves_;  ///< Symbol moves of each state.
+  std::vector<StateList>                      epsilon_moves_; ///< Epsilon moves of each state.
+  std::vector<uint8_t>                        accepted_;      ///< Acceptable state marks.
+  std::vector<StateList>                      closures_;      ///< Epsilon closures of the states.
+  std::vector<uint8_t>                        closed_;        ///< Are the closures calculated?
+  std::vector<uint32_t>                       stamps_;        ///< Visit stamps of the states.
+  uint32_t                                    stamp_;         ///< The current visit stamp.
+  StateList                                   targets_;       ///< Move targets, used in Move.
+};
+
+/**
+ * \brief Subset construction of deterministic automaton.
+ *
+ * A state of the deterministic automaton is the sorted list of NFA state numbers, closed by epsilon
+ * moves. The lists are kept in hash table and compared in full, so different state sets are never
+ * merged. The attributes of a state are the attributes of all its NFA states.
+ *
+ * \param      automaton The NFA.
+ * \param[out] dfa       The deterministic automaton, the start state is 0.
+ */
+template <typename SymbolCode, typename Attribute>
+void SubsetConstruction(const Nfa<SymbolCode, Attribute>& automaton, DfaGraph<SymbolCode, Attribute>& dfa) {
+  typedef NumberedNfa<SymbolCode, Attribute>                         NumberedNfaImpl;
+  typedef typename NumberedNfaImpl::StateList                        StateList;
+  typedef typename NumberedNfaImpl::SymbolMove                       SymbolMove;
+  typedef DfaGraph<SymbolCode, Attribute>                            Graph;
+  typedef boost::unordered_map<StateList, StateId, boost::hash<StateList> > StateListMap;
+
+  dfa = Graph();
+  if (automaton.GetStartState() == NULL) {
+    return;
+  }
+  NumberedNfaImpl nfa(automaton);
+
+  // The map keys are not moved by rehashing, so the list of keys is the list of states.
+  StateListMap dfa_states;
+  std::vector<const StateList*> state_lists;
+  state_lists.push_back(&dfa_states.insert(std::make_pair(nfa.GetClosure(nfa.GetStartState()), 0)).first->first);
+
+  std::vector<SymbolMove> moves;
+  std::vector<uint32_t> targets;
+  StateList target_list;
+  std::set<Attribute> attrs;
+  for (StateId state = 0; state < state_lists.size(); ++state) {
+    const StateList& state_list = *state_lists[state];
+
+    // Acceptance and attributes.
+    bool is_accepted = false;
+    attrs.clear();
+    moves.clear();
+    for (size_t i = 0; i < state_list.size(); ++i) {
+      is_accepted = is_accepted or nfa.IsAcceptable(state_list[i]);
+      attrs.insert(nfa.GetAttributes(state_list[i]).begin(), nfa.GetAttributes(state_list[i]).end());
+      moves.insert(moves.end(), nfa.GetSymbolMoves(state_list[i]).begin(), nfa.GetSymbolMoves(state_list[i]).end());
+    }
+    dfa.AddState(is_accepted, attrs.begin(), attrs.end());
+
+    // Moves by each symbol lead to the closure of their targets.
+    std::sort(moves.begin(), moves.end());
+    for (size_t begin = 0; begin < moves.size();) {
+      size_t end = begin;
+      targets.clear();
+      for (; end < moves.size() and moves[end].first == moves[begin].first; ++end) {
+        targets.push_back(moves[end].second);
+      }
+      nfa.GetClosure(targets.begin(), targets.end(), target_list);
+      typename StateListMap::iterator it = dfa_states.find(target_list);
+      if (it == dfa_states.end()) {
+        it = dfa_states.insert(std::make_pair(target_list, static_cast<StateId>(state_lists.size()))).first;
+        state_lists.push_back(&it->first);
+      }
+      dfa.moves_.push_back(typename Graph::Move(state, moves[begin].first, it->second));
+      begin = end;
+    }
+  }
+}
+
 } // namespace utils.
 
 template <typename SymbolCode, typename Attribute>
@@ -212,7 +439,7 @@ typename Nfa<SymbolCode, Attribute>::Ptr Concat(typename Nfa<SymbolCode, Attribu
   std::vector<typename NfaImpl::Ptr> auto_list;
   auto_list.push_back(left);
   auto_list.push_back(right);
-  utils::UnionResult<SymbolCode, Attribute> result = CreateUnion(auto_list);
+  utils::UnionResult<SymbolCode, Attribute> result = utils::CreateUnion<SymbolCode, Attribute>(auto_list);
 
   // Add transions form accepted states of left NFA to start state of right NFA.
   for (typename NfaImpl::StateSet::const_iterator st_it = result.accepted_states_[0].begin();
@@ -240,7 +467,7 @@ typename Nfa<SymbolCode, Attribute>::Ptr Union(typename Nfa<SymbolCode, Attribut
   std::vector<typename NfaImpl::Ptr> auto_list;
   auto_list.push_back(left);
   auto_list.push_back(right);
-  utils::UnionResult<SymbolCode, Attribute> result = CreateUnion(auto_list);
+  utils::UnionResult<SymbolCode, Attribute> result = utils::CreateUnion<SymbolCode, Attribute>(auto_list);
 
   // Create new start state and add epsilon transitions from it to start states of operands.
   typename NfaImpl::State::Ptr start_state = boost::make_shared<typename NfaImpl::State>();
@@ -322,7 +549,7 @@ typename Nfa<SymbolCode, Attribute>::Ptr Iteration(typename Nfa<SymbolCode, Attr
   // Create copy of the automaton operand.
   std::vector<typename NfaImpl::Ptr> auto_list;
   auto_list.push_back(operand);
-  utils::UnionResult<SymbolCode, Attribute> result = CreateUnion(auto_list);
+  utils::UnionResult<SymbolCode, Attribute> result = utils::CreateUnion<SymbolCode, Attribute>(auto_list);
 
   // Create start state and add move from it to start state of operand automaton.
   typename NfaImpl::State::Ptr start_state = boost::make_shared<typename NfaImpl::State>();
@@ -356,7 +583,7 @@ typename Nfa<SymbolCode, Attribute>::Ptr Copy(typename Nfa<SymbolCode, Attribute
   // Create copy of the automaton operand.
   std::vector<typename NfaImpl::Ptr> auto_list;
   auto_list.push_back(operand);
-  utils::UnionResult<SymbolCode, Attribute> result = CreateUnion(auto_list);
+  utils::UnionResult<SymbolCode, Attribute> result = utils::CreateUnion<SymbolCode, Attribute>(auto_list);
 
   // Set start state.
   result.automaton_->SetStartState(result.start_states_[0]);
@@ -421,86 +648,58 @@ typename Nfa<SymbolCode, Attribute>::Ptr Invert(typename Nfa<SymbolCode, Attribu
   return result;
 }
 
+/**
+ * \brief Transform NFA to deterministic one.
+ *
+ * \param  automaton The NFA.
+ * \return           The deterministic automaton as NFA without epsilon moves.
+ */
 template <typename SymbolCode, typename Attribute>
 typename Nfa<SymbolCode, Attribute>::Ptr TransformToDfa(typename Nfa<SymbolCode, Attribute>::Ptr automaton) {
-  typedef Nfa<SymbolCode, Attribute> NfaImpl;
+  typedef Nfa<SymbolCode, Attribute>      NfaImpl;
+  typedef DfaGraph<SymbolCode, Attribute> Graph;
 
   // Create DFA.
   typename NfaImpl::Ptr dfa = boost::make_shared<NfaImpl>();
-  if (automaton->GetStates().size() == 0) {
+  Graph graph;
+  utils::SubsetConstruction(*automaton, graph);
+  if (graph.GetNumOfStates() == 0) {
     return dfa;
   }
 
-  // Create DFA's start state as the set of states consisting of NFA's start state.
-  typename NfaImpl::State::Ptr start_state = boost::make_shared<typename NfaImpl::State>();
-  dfa->AddState(start_state);
-  dfa->SetStartState(start_state.get());
-
-  // Fill start state's set.
-  std::set<typename NfaImpl::State*> start_state_set;
-  utils::EpsilonClosure(automaton->GetStartState(), start_state_set);
-  if (utils::FindInAccepts(start_state_set, automaton)) {
-    dfa->AddToAcceptedSet(start_state.get());
-  }
-
-  // Releation connects sets of NFA's states and DFA's states.
-  typedef boost::hash<std::set<typename NfaImpl::State*> > Hash;
-  typedef std::map<std::set<typename NfaImpl::State*>, typename NfaImpl::State*> DfaStateSet;
-  typedef std::map<size_t, typename NfaImpl::State*> DfaHashStateSet;
-  DfaHashStateSet dfa_states;
-  Hash start_state_hash;
-  dfa_states[start_state_hash(start_state_set)] = start_state.get();
-
-  // Current step state set.
-  DfaStateSet step_set;
-  step_set[start_state_set] = start_state.get();
-
-  // Iterate while at least one state needed to be handled.
-  for (;;) {
-    // One iteration state set.
-    DfaStateSet local_set;
-    for (typename DfaStateSet::iterator set_it = step_set.begin(); set_it != step_set.end(); ++set_it) {
-      // Find symbols with transitions.
-      std::set<typename NfaImpl::Symbol> symbols;
-      utils::FindSymbols(set_it->first, symbols);
-
-      // Go through symbols and create states if any.
-      for (typename std::set<typename NfaImpl::Symbol>::iterator sym_it = symbols.begin(); sym_it != symbols.end(); ++sym_it) {
-        // Create transition.
-        std::set<typename NfaImpl::State*> move_set;
-        utils::Move(set_it->first, *sym_it, move_set);
-
-        // Create the state if any.
-        typename NfaImpl::State* state = NULL;
-        Hash hash;
-        const size_t move_set_hash = hash(move_set);
-        typename DfaHashStateSet::iterator mv_it = dfa_states.find(move_set_hash);
-        if (mv_it == dfa_states.end()) {
-          typename NfaImpl::State::Ptr new_state = boost::make_shared<typename NfaImpl::State>();
-          dfa->AddState(new_state);
-          state = new_state.get();
-          utils::CopyAttrs(move_set, new_state.get());
-          if (utils::FindInAccepts(move_set, automaton)) {
-            dfa->AddToAcceptedSet(state);
-          }
-          dfa_states[move_set_hash] = state;
-          local_set[move_set] = state;
-        } else {
-          state = mv_it->second;
-        }
-        dfa->AddTransition(set_it->second, state, *sym_it);
-      }
-    }
-
-    // Check at least one state is bult and break the loop if it is not so.
-    if (local_set.empty()) {
-      break;
-    } else {
-      step_set.swap(local_set);
+  std::vector<typename NfaImpl::State*> states;
+  for (size_t i = 0; i < graph.GetNumOfStates(); ++i) {
+    typename NfaImpl::State::Ptr state = boost::make_shared<typename NfaImpl::State>();
+    dfa->AddState(state);
+    states.push_back(state.get());
+    state->attr_list_.insert(graph.attrs_.begin() + graph.attr_offsets_[i], graph.attrs_.begin() + graph.attr_offsets_[i + 1]);
+    if (graph.accepted_[i]) {
+      dfa->AddToAcceptedSet(state.get());
     }
   }
+  dfa->SetStartState(states[graph.start_]);
+  for (size_t i = 0; i < graph.moves_.size(); ++i) {
+    dfa->AddTransition(states[graph.moves_[i].from_], states[graph.moves_[i].to_], graph.moves_[i].symbol_);
+  }
 
   return dfa;
 }
 
+/**
+ * \brief Build minimal deterministic automaton by NFA.
+ *
+ * The subset construction is followed by the minimization, the result is written straight to the
+ * frozen automaton. The states of the same acceptance and attributes are merged only, so the
+ * attributes of different patterns are kept apart.
+ *
+ * \param      automaton The NFA.
+ * \param[out] dfa       The minimal automaton.
+ */
+template <typename SymbolCode, typename Attribute>
+void BuildDfa(typename Nfa<SymbolCode, Attribute>::Ptr automaton, AttributeFsm<FrozenTransitions<SymbolCode>, Attribute>& dfa) {
+  DfaGraph<SymbolCode, Attribute> graph;
+  utils::SubsetConstruction(*automaton, graph);
+  MinimizeDfa(graph, dfa);
+}
+
 }}} // namespace strutext, automata, operations.
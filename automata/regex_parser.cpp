@@ -0,0 +1,528 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Regular expression parser implementation.
+ * \author Vladimir Lapshin.
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include "symbols.h"
+#include "utf8_decoder.h"
+#include "regex_parser.h"
+
+namespace strutext { namespace automata {
+
+namespace {
+
+/// Unicode category name and its classes.
+struct Category {
+  const char* name_; ///< The category name.
+  uint32_t    mask_; ///< Union of symbols::SymbolClass values.
+};
+
+namespace sym = strutext::symbols;
+
+/// Known categories.
+const Category kCategories[] = {
+  {"L", sym::LETTER}, {"Lu", sym::UPPERCASE_LETTER}, {"Ll", sym::LOWERCASE_LETTER},
+  {"Lt", sym::TITLECASE_LETTER}, {"Lm", sym::MODIFIER_LETTER}, {"Lo", sym::OTHER_LETTER},
+  {"M", sym::MARK}, {"Mn", sym::NONSPACING_MARK}, {"Mc", sym::SPACING_MARK}, {"Me", sym::ENCLOSING_MARK},
+  {"N", sym::NUMBER}, {"Nd", sym::DECIMAL_NUMBER}, {"Nl", sym::LETTER_NUMBER}, {"No", sym::OTHER_NUMBER},
+  {"P", sym::PUNCTUATION}, {"Pc", sym::CONNECTOR_PUNCTUATION}, {"Pd", sym::DASH_PUNCTUATION},
+  {"Ps", sym::OPEN_PUNCTUATION}, {"Pe", sym::CLOSE_PUNCTUATION}, {"Pi", sym::INITIAL_PUNCTUATION},
+  {"Pf", sym::FINAL_PUNCTUATION}, {"Po", sym::OTHER_PUNCTUATION},
+  {"S", sym::SYMBOL}, {"Sm", sym::MATH_SYMBOL}, {"Sc", sym::CURRENCY_SYMBOL}, {"Sk", sym::MODIFIER_SYMBOL},
+  {"So", sym::OTHER_SYMBOL},
+  {"Z", sym::SEPARATOR}, {"Zs", sym::SPACE_SEPARATOR}, {"Zl", sym::LINE_SEPARATOR}, {"Zp", sym::PARAGRAPH_SEPARATOR},
+  {"C", sym::OTHER}, {"Cc", sym::CONTROL}, {"Cf", sym::FORMAT}, {"Co", sym::PRIVATE_USE}, {"Cn", sym::UNASSIGNED}
+};
+
+typedef RegexParser::Range     Range;
+typedef RegexParser::RangeList RangeList;
+
+/// Add the range to the list.
+void AddRange(RangeList& ranges, uint32_t first, uint32_t last) {
+  ranges.push_back(Range(first, last));
+}
+
+/// Sort the ranges and merge the overlapping and adjacent ones.
+void Normalize(RangeList& ranges) {
+  std::sort(ranges.begin(), ranges.end());
+  size_t size = 0;
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    if (size > 0 and ranges[i].first <= ranges[size - 1].second + 1) {
+      ranges[size - 1].second = std::max(ranges[size - 1].second, ranges[i].second);
+    } else {
+      ranges[size++] = ranges[i];
+    }
+  }
+  ranges.resize(size);
+}
+
+/// Replace the normalized ranges by their complement to all Unicode symbols.
+void Complement(RangeList& ranges) {
+  RangeList result;
+  uint32_t first = 0;
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    if (first < ranges[i].first) {
+      AddRange(result, first, ranges[i].first - 1);
+    }
+    first = ranges[i].second + 1;
+  }
+  if (first <= RegexParser::kMaxSymbol) {
+    AddRange(result, first, RegexParser::kMaxSymbol);
+  }
+  ranges.swap(result);
+}
+
+/// Is the symbol hexadecimal digit?
+bool IsHexDigit(uint32_t symbol) {
+  return (symbol >= '0' and symbol <= '9') or (symbol >= 'a' and symbol <= 'f') or (symbol >= 'A' and symbol <= 'F');
+}
+
+/// Get the value of hexadecimal digit.
+uint32_t GetHexDigit(uint32_t symbol) {
+  if (symbol >= '0' and symbol <= '9') {
+    return symbol - '0';
+  }
+  return (symbol | 0x20) - 'a' + 10;
+}
+
+}  // namespace.
+
+const uint32_t RegexParser::kMaxSymbol;
+const uint32_t RegexParser::kBeginOfText;
+const uint32_t RegexParser::kEndOfText;
+const uint32_t RegexParser::kMaxRepetition;
+const uint64_t RegexParser::kMaxExpansion;
+const uint32_t RegexParser::kNoLimit;
+
+RegexParser::Fragment RegexParser::Parse(const std::string& pattern, NfaImpl& nfa) {
+  // Decode the pattern.
+  symbols_.clear();
+  const uint8_t* begin = reinterpret_cast<const uint8_t*>(pattern.data());
+  const uint8_t* end = begin + pattern.size();
+  while (begin != end) {
+    uint32_t code = 0;
+    const size_t len = encode::DecodeUtf8Symbol(begin, end, code);
+    if (len == 0 or (code == 0 and *begin != 0)) {
+      pos_ = symbols_.size();
+      Error("invalid UTF-8 sequence");
+    }
+    symbols_.push_back(code);
+    begin += len;
+  }
+
+  // Parse and build the fragment.
+  pos_ = 0;
+  nodes_.clear();
+  const uint32_t root = ParseUnion();
+  if (not AtEnd()) {
+    Error("unmatched ')'");
+  }
+  return Build(root, nfa);
+}
+
+const RegexParser::RangeList& RegexParser::GetCategoryRanges(uint32_t mask) {
+  CategoryMap::iterator it = categories_.find(mask);
+  if (it != categories_.end()) {
+    return it->second;
+  }
+  RangeList& ranges = categories_[mask];
+  for (uint32_t code = 0; code <= kMaxSymbol; ++code) {
+    if (symbols::GetSymbolClass(code) & mask) {
+      if (not ranges.empty() and ranges.back().second + 1 == code) {
+        ranges.back().second = code;
+      } else {
+        AddRange(ranges, code, code);
+      }
+    }
+  }
+  return ranges;
+}
+
+uint32_t RegexParser::ParseUnion() {
+  const uint32_t first = ParseConcat();
+  if (AtEnd() or Peek() != '|') {
+    return first;
+  }
+  const uint32_t node = AddNode(UNION_NT);
+  nodes_[node].children_.push_back(first);
+  while (not AtEnd() and Peek() == '|') {
+    ++pos_;
+    const uint32_t child = ParseConcat();
+    nodes_[node].children_.push_back(child);
+  }
+  SetNodeSize(node);
+  return node;
+}
+
+uint32_t RegexParser::ParseConcat() {
+  std::vector<uint32_t> children;
+  while (not AtEnd() and Peek() != '|' and Peek() != ')') {
+    children.push_back(ParseRepeat());
+  }
+  if (children.size() == 1) {
+    return children[0];
+  }
+  const uint32_t node = AddNode(children.empty() ? EMPTY_NT : CONCAT_NT);
+  nodes_[node].children_.swap(children);
+  SetNodeSize(node);
+  return node;
+}
+
+uint32_t RegexParser::ParseRepeat() {
+  uint32_t node = ParseAtom();
+  while (not AtEnd()) {
+    uint32_t min = 0;
+    uint32_t max = kNoLimit;
+    const uint32_t symbol = Peek();
+    if (symbol == '*') {
+      ++pos_;
+    } else if (symbol == '+') {
+      ++pos_;
+      min = 1;
+    } else if (symbol == '?') {
+      ++pos_;
+      max = 1;
+    } else if (symbol == '{') {
+      ++pos_;
+      min = max = ParseNumber();
+      if (not AtEnd() and Peek() == ',') {
+        ++pos_;
+        max = (not AtEnd() and Peek() == '}') ? kNoLimit : ParseNumber();
+      }
+      Expect('}');
+      if (max < min) {
+        Error("invalid repetition bounds");
+      }
+    } else {
+      break;
+    }
+    const uint32_t repeat = AddNode(REPEAT_NT);
+    nodes_[repeat].children_.push_back(node);
+    nodes_[repeat].min_ = min;
+    nodes_[repeat].max_ = max;
+    SetNodeSize(repeat);
+    node = repeat;
+  }
+  return node;
+}
+
+uint32_t RegexParser::ParseAtom() {
+  const uint32_t symbol = Peek();
+  RangeList ranges;
+  switch (symbol) {
+    case '(': {
+      ++pos_;
+      if (not AtEnd() and Peek() == '?') {
+        ++pos_;
+        if (AtEnd() or Peek() != ':') {
+          Error("unsupported group");
+        }
+        ++pos_;
+      }
+      const uint32_t node = ParseUnion();
+      Expect(')');
+      return node;
+    }
+    case '[':
+      ++pos_;
+      ParseClass(ranges);
+      break;
+    case '.':
+      ++pos_;
+      AddRange(ranges, '\n', '\n');
+      Complement(ranges);
+      break;
+    case '^':
+      ++pos_;
+      AddRange(ranges, kBeginOfText, kBeginOfText);
+      break;
+    case '$':
+      ++pos_;
+      AddRange(ranges, kEndOfText, kEndOfText);
+      break;
+    case '\\':
+      ++pos_;
+      ParseEscape(ranges, false);
+      break;
+    case '*':
+    case '+':
+    case '?':
+    case '{':
+      Error("nothing to repeat");
+      break;
+    default:
+      ++pos_;
+      AddRange(ranges, symbol, symbol);
+  }
+  return AddRangesNode(ranges);
+}
+
+void RegexParser::ParseClass(RangeList& ranges) {
+  bool negative = false;
+  if (not AtEnd() and Peek() == '^') {
+    negative = true;
+    ++pos_;
+  }
+  bool first = true;
+  while (AtEnd() or Peek() != ']' or first) {
+    if (AtEnd()) {
+      Error("missing ']'");
+    }
+    first = false;
+
+    // The class element: symbol, escape or range of symbols.
+    RangeList element;
+    if (Peek() == '\\') {
+      ++pos_;
+      ParseEscape(element, true);
+    } else {
+      AddRange(element, Peek(), Peek());
+      ++pos_;
+    }
+    const bool is_symbol = element.size() == 1 and element[0].first == element[0].second;
+    if (is_symbol and pos_ + 1 < symbols_.size() and Peek() == '-' and symbols_[pos_ + 1] != ']') {
+      ++pos_;
+      RangeList last;
+      if (Peek() == '\\') {
+        ++pos_;
+        ParseEscape(last, true);
+      } else {
+        AddRange(last, Peek(), Peek());
+        ++pos_;
+      }
+      if (last.size() != 1 or last[0].first != last[0].second or last[0].first < element[0].first) {
+        Error("invalid class range");
+      }
+      element[0].second = last[0].first;
+    }
+    ranges.insert(ranges.end(), element.begin(), element.end());
+  }
+  ++pos_;
+  Normalize(ranges);
+  if (negative) {
+    Complement(ranges);
+  }
+}
+
+void RegexParser::ParseEscape(RangeList& ranges, bool in_class) {
+  if (AtEnd()) {
+    Error("escape at the end of the pattern");
+  }
+  const uint32_t symbol = Peek();
+  ++pos_;
+  switch (symbol) {
+    case 't': AddRange(ranges, '\t', '\t'); break;
+    case 'n': AddRange(ranges, '\n', '\n'); break;
+    case 'r': AddRange(ranges, '\r', '\r'); break;
+    case 'f': AddRange(ranges, '\f', '\f'); break;
+    case 'v': AddRange(ranges, '\v', '\v'); break;
+    case '0': AddRange(ranges, 0, 0); break;
+    case 'x': {
+      const uint32_t code = (not AtEnd() and Peek() == '{') ? ParseHexCode(0) : ParseHexCode(2);
+      AddRange(ranges, code, code);
+      break;
+    }
+    case 'u': {
+      const uint32_t code = ParseHexCode(4);
+      AddRange(ranges, code, code);
+      break;
+    }
+    case 'd':
+    case 'D':
+      AddRange(ranges, '0', '9');
+      break;
+    case 'w':
+    case 'W':
+      AddRange(ranges, '0', '9');
+      AddRange(ranges, 'A', 'Z');
+      AddRange(ranges, '_', '_');
+      AddRange(ranges, 'a', 'z');
+      break;
+    case 's':
+    case 'S':
+      AddRange(ranges, '\t', '\r');
+      AddRange(ranges, ' ', ' ');
+      break;
+    case 'p':
+    case 'P': {
+      Expect('{');
+      std::string name;
+      while (not AtEnd() and Peek() != '}' and Peek() < 0x80) {
+        name.push_back(static_cast<char>(Peek()));
+        ++pos_;
+      }
+      Expect('}');
+      const Category* category = NULL;
+      for (size_t i = 0; i < sizeof(kCategories) / sizeof(kCategories[0]); ++i) {
+        if (name == kCategories[i].name_) {
+          category = &kCategories[i];
+        }
+      }
+      if (category == NULL) {
+        Error("unknown category '" + name + "'");
+      }
+      ranges = GetCategoryRanges(category->mask_);
+      break;
+    }
+    default:
+      if ((symbol >= '0' and symbol <= '9') or (symbol >= 'a' and symbol <= 'z') or (symbol >= 'A' and symbol <= 'Z')) {
+        --pos_;
+        Error(in_class ? "unknown escape in class" : "unknown escape");
+      }
+      AddRange(ranges, symbol, symbol);
+  }
+  if (symbol == 'D' or symbol == 'W' or symbol == 'S' or symbol == 'P') {
+    Normalize(ranges);
+    Complement(ranges);
+  }
+}
+
+uint32_t RegexParser::ParseNumber() {
+  if (AtEnd() or Peek() < '0' or Peek() > '9') {
+    Error("number expected");
+  }
+  uint32_t number = 0;
+  while (not AtEnd() and Peek() >= '0' and Peek() <= '9') {
+    number = number * 10 + (Peek() - '0');
+    if (number > kMaxRepetition) {
+      Error("too many repetitions");
+    }
+    ++pos_;
+  }
+  return number;
+}
+
+uint32_t RegexParser::ParseHexCode(size_t num_of_digits) {
+  const bool braces = num_of_digits == 0;
+  if (braces) {
+    Expect('{');
+  }
+  uint32_t code = 0;
+  size_t len = 0;
+  while (not AtEnd() and IsHexDigit(Peek()) and (braces or len < num_of_digits)) {
+    code = (code << 4) | GetHexDigit(Peek());
+    if (code > kMaxSymbol) {
+      Error("symbol code is out of Unicode");
+    }
+    ++pos_;
+    ++len;
+  }
+  if (len == 0 or (not braces and len != num_of_digits)) {
+    Error("hexadecimal digit expected");
+  }
+  if (braces) {
+    Expect('}');
+  }
+  return code;
+}
+
+uint32_t RegexParser::AddNode(NodeType type) {
+  nodes_.push_back(Node(type));
+  return nodes_.size() - 1;
+}
+
+uint32_t RegexParser::AddRangesNode(const RangeList& ranges) {
+  const uint32_t node = AddNode(RANGES_NT);
+  nodes_[node].ranges_ = ranges;
+  return node;
+}
+
+void RegexParser::SetNodeSize(uint32_t node_id) {
+  // The sizes are at most kMaxExpansion, so the products and sums do not overflow.
+  Node& node = nodes_[node_id];
+  if (node.type_ == REPEAT_NT) {
+    // The child is built for each repetition, and once more for no upper limit.
+    const uint64_t copies = node.max_ == kNoLimit ? std::max<uint32_t>(node.min_, 1) : node.max_;
+    node.size_ = std::max<uint64_t>(1, copies * nodes_[node.children_[0]].size_);
+  } else if (not node.children_.empty()) {
+    node.size_ = 0;
+    for (size_t i = 0; i < node.children_.size(); ++i) {
+      node.size_ += nodes_[node.children_[i]].size_;
+    }
+  }
+  if (node.size_ > kMaxExpansion) {
+    Error("too large pattern after expansion of repetitions");
+  }
+}
+
+RegexParser::Fragment RegexParser::Build(uint32_t node_id, NfaImpl& nfa) {
+  const Node& node = nodes_[node_id];
+  switch (node.type_) {
+    case RANGES_NT: {
+      // All the ranges lead from the entry state to the exit one, an empty class has no moves.
+      const Fragment result(nfa.AddState(), nfa.AddState());
+      for (size_t i = 0; i < node.ranges_.size(); ++i) {
+        nfa.AddMove(result.start_, result.end_, node.ranges_[i].first, node.ranges_[i].second);
+      }
+      return result;
+    }
+    case EMPTY_NT:
+      return nfa.Empty();
+    case CONCAT_NT: {
+      Fragment result = Build(node.children_[0], nfa);
+      for (size_t i = 1; i < node.children_.size(); ++i) {
+        result = nfa.Concat(result, Build(node.children_[i], nfa));
+      }
+      return result;
+    }
+    case UNION_NT: {
+      std::vector<Fragment> fragments;
+      for (size_t i = 0; i < node.children_.size(); ++i) {
+        fragments.push_back(Build(node.children_[i], nfa));
+      }
+      return nfa.Union(fragments);
+    }
+    case REPEAT_NT: {
+      // The child fragment is built for each its use: a{2,4} is aa(a)?(a)?, a{2,} is aa+.
+      const uint32_t child = node.children_[0];
+      if (node.max_ == kNoLimit) {
+        Fragment result = node.min_ == 0 ? nfa.Iteration(Build(child, nfa)) : nfa.PositiveIteration(Build(child, nfa));
+        for (uint32_t i = 1; i < node.min_; ++i) {
+          result = nfa.Concat(Build(child, nfa), result);
+        }
+        return result;
+      }
+      Fragment result = nfa.Empty();
+      for (uint32_t i = 0; i < node.max_; ++i) {
+        const Fragment fragment = Build(child, nfa);
+        result = nfa.Concat(result, i < node.min_ ? fragment : nfa.Optional(fragment));
+      }
+      return result;
+    }
+  }
+  return nfa.Empty();
+}
+
+void RegexParser::Expect(uint32_t symbol) {
+  if (AtEnd() or Peek() != symbol) {
+    std::string text;
+    text.push_back(static_cast<char>(symbol));
+    Error("'" + text + "' expected");
+  }
+  ++pos_;
+}
+
+void RegexParser::Error(const std::string& message) const {
+  std::ostringstream os;
+  os << "Regular expression error at position " << pos_ << ": " << message;
+  throw std::invalid_argument(os.str());
+}
+
+}} // namespace strutext, automata.
@@ -0,0 +1,188 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Regular expression parser, builds NFA fragments.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "arena_nfa.h"
+
+namespace strutext { namespace automata {
+
+/**
+ * \brief Regular expression parser.
+ *
+ * The pattern in UTF-8 is parsed to the fragment of the NFA over Unicode symbols. The syntax:
+ *   - literal symbols, escaped by '\' if they are special: \ . | * + ? ( ) [ ] { } ^ $
+ *   - escapes: \t \n \r \f \v \0, \xHH, \x{H...}, \uHHHH;
+ *   - '.' is any symbol except the new line;
+ *   - classes [abc], [a-z], [^a-z], the escapes above and below are allowed in them;
+ *   - \d \w \s and \D \W \S are ASCII digits, word symbols and spaces and their complements;
+ *   - \p{..} and \P{..} are the Unicode categories of symbols::SymbolClass and their complements:
+ *     L Lu Ll Lt Lm Lo M Mn Mc Me N Nd Nl No P Pc Pd Ps Pe Pi Pf Po S Sm Sc Sk So Z Zs Zl Zp C Cc Cf Co Cn;
+ *   - alternation a|b, groups (ab) and (?:ab), they are the same;
+ *   - repetitions a* a+ a? a{m} a{m,} a{m,n}, n is at most kMaxRepetition. The counted repetitions
+ *     are expanded, the expanded pattern has at most kMaxExpansion atoms;
+ *   - anchors: ^ is the text begin and $ is the text end. They are the moves by the special symbols
+ *     kBeginOfText and kEndOfText, so the text scanner must pass them around the text.
+ * Syntax errors are reported by std::invalid_argument with the error position.
+ */
+class RegexParser {
+public:
+  /// NFA type, the symbols are Unicode codes.
+  typedef ArenaNfa<uint32_t, uint32_t> NfaImpl;
+
+  /// Fragment type.
+  typedef NfaImpl::Fragment Fragment;
+
+  /// Symbol range type.
+  typedef std::pair<uint32_t, uint32_t> Range;
+
+  /// Sorted list of disjoint ranges.
+  typedef std::vector<Range> RangeList;
+
+  /// The maximal Unicode symbol.
+  static const uint32_t kMaxSymbol = 0x10FFFF;
+
+  /// Special symbol before the text.
+  static const uint32_t kBeginOfText = 0x110000;
+
+  /// Special symbol after the text.
+  static const uint32_t kEndOfText = 0x110001;
+
+  /// The maximal number of repetitions.
+  static const uint32_t kMaxRepetition = 1000;
+
+  /// The maximal number of atoms of the pattern with the repetitions expanded.
+  static const uint64_t kMaxExpansion = 100000;
+
+  /// Default initialization.
+  RegexParser()
+    : pos_(0) {}
+
+  /**
+   * \brief Parse the pattern and add its fragment to the NFA.
+   *
+   * \param  pattern The pattern in UTF-8.
+   * \param  nfa     The NFA to add the fragment to.
+   * \return         The fragment.
+   */
+  Fragment Parse(const std::string& pattern, NfaImpl& nfa);
+
+  /**
+   * \brief Get ranges of the symbols of the class.
+   *
+   * \param  mask The union of symbols::SymbolClass values.
+   * \return      The sorted ranges, they are calculated once for each mask.
+   */
+  const RangeList& GetCategoryRanges(uint32_t mask);
+
+private:
+  /// Type of syntax tree node.
+  enum NodeType {
+    RANGES_NT      ///< Symbol ranges.
+    , EMPTY_NT     ///< Empty string.
+    , CONCAT_NT    ///< Concatenation of the children.
+    , UNION_NT     ///< Alternation of the children.
+    , REPEAT_NT    ///< Repetition of the child.
+  };
+
+  /// Syntax tree node.
+  struct Node {
+    /// Initialization.
+    explicit Node(NodeType type)
+      : type_(type)
+      , min_(0)
+      , max_(0)
+      , size_(1) {}
+
+    NodeType              type_;     ///< Node type.
+    RangeList             ranges_;   ///< Ranges of symbols.
+    std::vector<uint32_t> children_; ///< Child nodes.
+    uint32_t              min_;      ///< Minimal number of repetitions.
+    uint32_t              max_;      ///< Maximal number of repetitions, kNoLimit for no limit.
+    uint64_t              size_;     ///< Number of atoms the node fragment is built of.
+  };
+
+  /// No upper limit of repetitions.
+  static const uint32_t kNoLimit = 0xFFFFFFFF;
+
+  /// Type of category ranges cache.
+  typedef std::map<uint32_t, RangeList> CategoryMap;
+
+  /// Parse the alternation.
+  uint32_t ParseUnion();
+
+  /// Parse the concatenation.
+  uint32_t ParseConcat();
+
+  /// Parse the repetition of the atom.
+  uint32_t ParseRepeat();
+
+  /// Parse the atom: symbol, class or group.
+  uint32_t ParseAtom();
+
+  /// Parse the class in brackets.
+  void ParseClass(RangeList& ranges);
+
+  /// Parse the escape sequence after '\', in class or not.
+  void ParseEscape(RangeList& ranges, bool in_class);
+
+  /// Parse the number of the repetition bounds.
+  uint32_t ParseNumber();
+
+  /// Parse hexadecimal code of the passed number of digits, or in braces if zero.
+  uint32_t ParseHexCode(size_t num_of_digits);
+
+  /// Add new node.
+  uint32_t AddNode(NodeType type);
+
+  /// Add new node of the ranges.
+  uint32_t AddRangesNode(const RangeList& ranges);
+
+  /// Calculate the node size by its children, throw the error if the pattern is too large.
+  void SetNodeSize(uint32_t node);
+
+  /// Build the fragment of the node.
+  Fragment Build(uint32_t node, NfaImpl& nfa);
+
+  /// Is the end of the pattern reached?
+  bool AtEnd() const { return pos_ == symbols_.size(); }
+
+  /// Get the current symbol.
+  uint32_t Peek() const { return symbols_[pos_]; }
+
+  /// Skip the expected symbol or throw the error.
+  void Expect(uint32_t symbol);
+
+  /// Throw syntax error at the current position.
+  void Error(const std::string& message) const;
+
+  std::vector<uint32_t> symbols_;    ///< The pattern symbols.
+  size_t                pos_;        ///< Current position in the pattern.
+  std::vector<Node>     nodes_;      ///< Syntax tree nodes.
+  CategoryMap           categories_; ///< Cache of category ranges.
+};
+
+}} // namespace strutext, automata.
@@ -0,0 +1,103 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Search of regular expression rules implementation.
+ * \author Vladimir Lapshin.
+ */
+
+#include "utf8_decoder.h"
+#include "dfa_minimizer.h"
+#include "regex_scanner.h"
+
+namespace strutext { namespace automata {
+
+const size_t RegexScanner::kMaxTableSize;
+const uint32_t RegexScanner::kMaxDirectSymbols;
+
+RegexScanner::RegexScanner()
+  : root_(0)
+  , start_(kInvalidState)
+  , compiled_(false) {
+  root_ = nfa_.AddState();
+  nfa_.SetStartState(root_);
+}
+
+void RegexScanner::AddRule(const std::string& pattern, RuleId id) {
+  const RegexParser::Fragment rule = parser_.Parse(pattern, nfa_);
+  nfa_.Accept(rule, id);
+  nfa_.AddEpsilonMove(root_, rule.start_);
+  compiled_ = false;
+}
+
+void RegexScanner::Compile() {
+  // The minimal unanchored automaton over the classes.
+  const SymbolClasses<uint32_t> classes(nfa_);
+  DfaGraph<uint32_t, RuleId> graph;
+  SubsetConstruction(nfa_, classes, graph, true);
+  MinimizeDfa(graph, dfa_);
+
+  // Class lookup tables.
+  const size_t num_of_classes = classes.GetNumOfClasses();
+  class_starts_.resize(num_of_classes);
+  for (size_t cls = 0; cls < num_of_classes; ++cls) {
+    class_starts_[cls] = classes.GetFirstSymbol(cls);
+  }
+  direct_classes_.resize(kMaxDirectSymbols);
+  for (uint32_t symbol = 0; symbol < kMaxDirectSymbols; ++symbol) {
+    direct_classes_[symbol] = classes.GetClass(symbol);
+  }
+
+  // Dense move table.
+  table_.clear();
+  if (dfa_.GetNumOfStates() * num_of_classes <= kMaxTableSize) {
+    table_.resize(dfa_.GetNumOfStates() * num_of_classes, kInvalidState);
+    for (StateId state = 0; state < dfa_.GetNumOfStates(); ++state) {
+      for (uint32_t cls = 0; cls < num_of_classes; ++cls) {
+        table_[state * num_of_classes + cls] = dfa_.Go(state, cls);
+      }
+    }
+  }
+  std::vector<StateId>(table_).swap(table_);
+
+  start_ = Move(kStartState, RegexParser::kBeginOfText);
+  compiled_ = true;
+}
+
+size_t RegexScanner::ScanUtf8(const char* begin, const char* end, MatchList& matches) const {
+  StartScan(matches);
+  const uint8_t* text = reinterpret_cast<const uint8_t*>(begin);
+  const uint8_t* text_end = reinterpret_cast<const uint8_t*>(end);
+  StateId state = start_;
+  AddMatches(state, 0, matches);
+  for (const uint8_t* pos = text; pos != text_end and state != kInvalidState;) {
+    uint32_t code = 0;
+    size_t len = 1;
+    if (*pos < 0x80) {
+      code = *pos;
+    } else {
+      // Truncated sequence at the end is the illegal symbol 0.
+      len = encode::DecodeUtf8Symbol(pos, text_end, code);
+      if (len == 0) {
+        len = text_end - pos;
+      }
+    }
+    pos += len;
+    state = Move(state, code);
+    AddMatches(state, pos - text, matches);
+  }
+  AddEndMatches(state, text_end - text, matches);
+  return matches.size();
+}
+
+}} // namespace strutext, automata.
@@ -0,0 +1,242 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Search of regular expression rules in texts by one deterministic automaton.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fsm_defs.h"
+#include "attr_fsm.h"
+#include "frozen_transitions.h"
+#include "arena_nfa.h"
+#include "regex_parser.h"
+
+namespace strutext { namespace automata {
+
+/**
+ * \brief Search of regular expression rules.
+ *
+ * The rules are parsed by RegexParser and put to one NFA. It is compiled to the minimal unanchored
+ * deterministic automaton over symbol classes, which searches the rules from each text position,
+ * its attributes are the rule identifiers. So the text is scanned once whatever the number of
+ * rules is, a symbol costs a class lookup and a move. The moves are kept in the dense table of
+ * states by classes, if it takes at most kMaxTableSize entries, otherwise the frozen move table is
+ * searched.
+ *
+ * Each rule match is reported by its end and the rule identifier, all the matches of all the rules
+ * are reported, overlapping and nested ones too. The begin of the match is not known to the
+ * deterministic automaton.
+ */
+class RegexScanner {
+public:
+  /// Rule identifier type.
+  typedef uint32_t RuleId;
+
+  /// Rule match found in the text.
+  struct Match {
+    /// Initialization.
+    Match(size_t end, RuleId id)
+      : end_(end)
+      , id_(id) {}
+
+    size_t end_; ///< Offset of the symbol after the match.
+    RuleId id_;  ///< Rule identifier.
+  };
+
+  /// Type of match list.
+  typedef std::vector<Match> MatchList;
+
+  /// Deterministic automaton type, the symbols are the classes.
+  typedef AttributeFsm<FrozenTransitions<uint32_t>, RuleId> Dfa;
+
+  /// Rule identifiers of the state.
+  typedef Dfa::AttributeList AttributeList;
+
+  /// The maximal number of entries of the dense move table.
+  static const size_t kMaxTableSize = 1 << 24;
+
+  /// Number of symbols, whose classes are kept in direct lookup table.
+  static const uint32_t kMaxDirectSymbols = 0x800;
+
+  /// Default initialization: no rules.
+  RegexScanner();
+
+  /**
+   * \brief Add the rule.
+   *
+   * \param pattern The regular expression in UTF-8.
+   * \param id      The rule identifier.
+   */
+  void AddRule(const std::string& pattern, RuleId id);
+
+  /// Build the automaton, it must be called after the rules are added and before the search.
+  void Compile();
+
+  /// Is the automaton compiled?
+  bool IsCompiled() const { return compiled_; }
+
+  /// Return number of states of the automaton.
+  size_t GetNumOfStates() const { return dfa_.GetNumOfStates(); }
+
+  /// Return number of symbol classes.
+  size_t GetNumOfClasses() const { return class_starts_.size(); }
+
+  /// Is the dense move table built?
+  bool HasMoveTable() const { return not table_.empty(); }
+
+  /// Get the automaton.
+  const Dfa& GetDfa() const { return dfa_; }
+
+  /// Get class of the symbol.
+  uint32_t GetSymbolClass(uint32_t symbol) const {
+    if (symbol < kMaxDirectSymbols) {
+      return direct_classes_[symbol];
+    }
+    return std::upper_bound(class_starts_.begin(), class_starts_.end(), symbol) - class_starts_.begin() - 1;
+  }
+
+  /// Get the state at the text begin, it is kInvalidState if there are no rules.
+  StateId GetStartState() const { return start_; }
+
+  /**
+   * \brief Move by the text symbol.
+   *
+   * \param  from   State to move from.
+   * \param  symbol Unicode symbol to move by.
+   * \return        State to move to.
+   */
+  StateId Move(StateId from, uint32_t symbol) const {
+    const uint32_t cls = GetSymbolClass(symbol);
+    if (not table_.empty()) {
+      return table_[from * class_starts_.size() + cls];
+    }
+    return dfa_.Go(from, cls);
+  }
+
+  /// Move by the text end, the state is acceptable for the rules ending by '$'.
+  StateId MoveToEnd(StateId from) const {
+    return Move(from, RegexParser::kEndOfText);
+  }
+
+  /// Is some rule found in the state?
+  bool IsAcceptable(StateId state) const { return dfa_.IsAcceptable(state); }
+
+  /// Get the rules found in the state.
+  AttributeList GetStateAttributes(StateId state) const { return dfa_.GetStateAttributes(state); }
+
+  /**
+   * \brief Search the rules in the text.
+   *
+   * \param      begin   Begin of the text of Unicode symbols.
+   * \param      end     End of the text.
+   * \param[out] matches Found rules, in order of their ends, the offsets are in symbols.
+   * \return             Number of found rules.
+   */
+  template <typename Utf32Iterator>
+  size_t Scan(Utf32Iterator begin, Utf32Iterator end, MatchList& matches) const;
+
+  /**
+   * \brief Search the rules in UTF-8 text.
+   *
+   * \param      begin   Begin of the text in UTF-8.
+   * \param      end     End of the text.
+   * \param[out] matches Found rules, in order of their ends, the offsets are in bytes.
+   * \return             Number of found rules.
+   */
+  size_t ScanUtf8(const char* begin, const char* end, MatchList& matches) const;
+
+  /// Search the rules in UTF-8 text.
+  size_t ScanUtf8(const std::string& text, MatchList& matches) const {
+    return ScanUtf8(text.data(), text.data() + text.size(), matches);
+  }
+
+private:
+  /// Add matches of the state.
+  void AddMatches(StateId state, size_t end, MatchList& matches) const {
+    if (dfa_.IsAcceptable(state)) {
+      const AttributeList rules = dfa_.GetStateAttributes(state);
+      for (AttributeList::const_iterator it = rules.begin(); it != rules.end(); ++it) {
+        matches.push_back(Match(end, *it));
+      }
+    }
+  }
+
+  /**
+   * \brief Add matches of the text end.
+   *
+   * The state matches are already added at the end, so only the rules reached by the move
+   * by the text end are added.
+   *
+   * \param      state   The state after the text.
+   * \param      end     The text end offset.
+   * \param[out] matches Found rules.
+   */
+  void AddEndMatches(StateId state, size_t end, MatchList& matches) const {
+    const StateId end_state = MoveToEnd(state);
+    if (not dfa_.IsAcceptable(end_state)) {
+      return;
+    }
+    const AttributeList found = dfa_.IsAcceptable(state) ? dfa_.GetStateAttributes(state) : AttributeList();
+    const AttributeList rules = dfa_.GetStateAttributes(end_state);
+    for (AttributeList::const_iterator it = rules.begin(); it != rules.end(); ++it) {
+      if (std::find(found.begin(), found.end(), *it) == found.end()) {
+        matches.push_back(Match(end, *it));
+      }
+    }
+  }
+
+  /// Check the automaton is compiled and prepare the match list.
+  void StartScan(MatchList& matches) const {
+    if (not compiled_) {
+      throw std::runtime_error("RegexScanner: the automaton is not compiled");
+    }
+    matches.clear();
+  }
+
+  RegexParser::NfaImpl  nfa_;            ///< NFA of the rules.
+  StateId               root_;           ///< Start state of the NFA, it has epsilon moves to the rules.
+  RegexParser           parser_;         ///< Parser of the rules.
+  Dfa                   dfa_;            ///< The minimal automaton over symbol classes.
+  std::vector<uint32_t> class_starts_;   ///< First symbols of the classes.
+  std::vector<uint32_t> direct_classes_; ///< Classes of the first symbols.
+  std::vector<StateId>  table_;          ///< Dense move table, if built.
+  StateId               start_;          ///< State at the text begin.
+  bool                  compiled_;       ///< Is the automaton compiled?
+};
+
+template <typename Utf32Iterator>
+size_t RegexScanner::Scan(Utf32Iterator begin, Utf32Iterator end, MatchList& matches) const {
+  StartScan(matches);
+  StateId state = start_;
+  size_t pos = 0;
+  AddMatches(state, pos, matches);
+  for (; begin != end and state != kInvalidState; ++begin) {
+    state = Move(state, *begin);
+    AddMatches(state, ++pos, matches);
+  }
+  AddEndMatches(state, pos, matches);
+  return matches.size();
+}
+
+}} // namespace strutext, automata.
@@ -21,14 +21,17 @@
 #include <stdint.h>
 
 #include <iostream>
+#include <limits>
 #include <stdexcept>
 #include <vector>
 
 #include "flat_transitions.h"
 #include "flex_transitions.h"
+#include "frozen_transitions.h"
 #include "fsm.h"
 #include "attr_fsm.h"
 #include "aho_corasick.h"
+#include "dawg.h"
 
 namespace strutext { namespace automata {
 
@@ -241,6 +244,115 @@ struct FsmSerializer {
   }
 };
 
+/**
+ * \brief Frozen Finite State Machine serialization.
+ *
+ * The stream format is the same as for FSM with FlexTransitions of the same symbol type, so
+ * the automaton serialized with ones may be read as frozen one and vice versa.
+ */
+template <typename Char>
+struct FsmSerializer<FrozenTransitions<Char> > {
+  /// Automaton type.
+  typedef FiniteStateMachine<FrozenTransitions<Char> > Automaton;
+
+  /// Symbol type.
+  typedef typename Automaton::CharType CharType;
+
+  /**
+   * \brief Serialization implementation.
+   *
+   * \param fsm FSM to serialize.
+   * \param os  Stream to write to.
+   */
+  static void Serialize(const Automaton& fsm, std::ostream& os) {
+    // Write number of states.
+    uint32_t num_of_states = fsm.GetNumOfStates() - 1;
+    os.write((const char*)&num_of_states, sizeof num_of_states);
+
+    // Write states.
+    for (unsigned i = 1; i <= num_of_states; ++i) {
+      // Write state accept sign.
+      os.write((const char*)&(fsm.accepted_[i]), sizeof(uint8_t));
+
+      // Write number of moves.
+      uint32_t num_of_moves = fsm.offsets_[i + 1] - fsm.offsets_[i];
+      os.write((const char*)&num_of_moves, sizeof num_of_moves);
+      if (os.bad()) {
+        throw std::runtime_error("Cannot write number of moves to stream");
+      }
+
+      // Write moves.
+      for (uint32_t j = fsm.offsets_[i]; j < fsm.offsets_[i + 1]; ++j) {
+        os.write((const char*)&(fsm.symbols_[j]), sizeof(CharType));
+        os.write((const char*)&(fsm.targets_[j]), sizeof(StateId));
+      }
+      if (os.bad()) {
+        throw std::runtime_error("Cannot write moves to stream");
+      }
+    }
+  }
+
+  /**
+   * \brief Deserialization implementation.
+   *
+   * The moves are checked, so the automaton read never leaves its arrays.
+   *
+   * \param[out] fsm FSM to deserialize..
+   * \param      is  Stream to read from.
+   */
+  static void Deserialize(Automaton& fsm, std::istream& is) {
+    // Read number of states.
+    uint32_t num_of_states = 0;
+    is.read(reinterpret_cast<char*>(&num_of_states), sizeof num_of_states);
+
+    // Prepare the arrays (including invalid state with index 0).
+    fsm.accepted_.assign(num_of_states + 1, 0);
+    fsm.offsets_.assign(2, 0);
+    fsm.offsets_.reserve(num_of_states + 2);
+    fsm.symbols_.clear();
+    fsm.targets_.clear();
+
+    // Read states.
+    const size_t move_len = sizeof(CharType) + sizeof(StateId);
+    std::vector<char> buffer;
+    for (unsigned i = 1; i <= num_of_states; ++i) {
+      // Read accept sign.
+      is.read(reinterpret_cast<char*>(&fsm.accepted_[i]), sizeof(uint8_t));
+
+      // Read moves.
+      uint32_t num_of_moves = 0;
+      is.read(reinterpret_cast<char*>(&num_of_moves), sizeof num_of_moves);
+      if (not is) {
+        throw std::runtime_error("Cannot read moves from stream");
+      }
+      // The symbols are different, and the offsets must not overflow, so they do not decrease.
+      if ((sizeof(CharType) < sizeof(uint32_t) and num_of_moves > (1u << (8 * sizeof(CharType))))
+          or num_of_moves > std::numeric_limits<uint32_t>::max() - fsm.symbols_.size()) {
+        throw std::runtime_error("Bad automaton in stream");
+      }
+      buffer.resize(num_of_moves * move_len);
+      if (num_of_moves) {
+        is.read(&buffer[0], buffer.size());
+        if (not is) {
+          throw std::runtime_error("Cannot read moves from stream");
+        }
+      }
+
+      // The symbols of the state are sorted for search, the targets are in range.
+      for (unsigned j = 0; j < num_of_moves; ++j) {
+        const CharType symbol = *reinterpret_cast<CharType*>(&buffer[j * move_len]);
+        const StateId target = *reinterpret_cast<StateId*>(&buffer[j * move_len + sizeof(CharType)]);
+        if ((j > 0 and not (fsm.symbols_.back() < symbol)) or target >= fsm.accepted_.size()) {
+          throw std::runtime_error("Bad automaton in stream");
+        }
+        fsm.symbols_.push_back(symbol);
+        fsm.targets_.push_back(target);
+      }
+      fsm.offsets_.push_back(fsm.symbols_.size());
+    }
+  }
+};
+
 /// FSM with attributes serialization.
 template <class T>
 struct AttrFsmSerializer {
@@ -261,19 +373,20 @@ struct AttrFsmSerializer {
     FsmSerializerImpl::Serialize(automaton, os);
 
     // Write the number of states.
-    uint32_t num_of_states = automaton.states_attr_.size() - 1;
+    uint32_t num_of_states = automaton.GetNumOfStates() - 1;
     os.write(reinterpret_cast<char*>(&num_of_states), sizeof num_of_states);
 
     // Write states.
     for (unsigned i = 1; i <= num_of_states; ++i) {
+      const typename Automaton::AttributeList attrs = automaton.GetStateAttributes(i);
+
       // Write number of state's attributes.
-      uint32_t num_of_attrs = automaton.states_attr_[i].size();
+      uint32_t num_of_attrs = attrs.size();
       os.write(reinterpret_cast<char*>(&num_of_attrs), sizeof num_of_attrs);
 
       // Write attributes.
-      for (unsigned j = 0; j < num_of_attrs; ++j) {
-        typename Automaton::Attribute attr = automaton.states_attr_[i][j];
-        os.write(reinterpret_cast<char*>(&attr), sizeof attr);
+      if (num_of_attrs) {
+        os.write(reinterpret_cast<const char*>(attrs.begin()), sizeof(typename Automaton::Attribute) * num_of_attrs);
       }
     }
   }
@@ -291,10 +404,10 @@ struct AttrFsmSerializer {
     // Read the number of states.
     uint32_t num_of_states = 0;
     is.read(reinterpret_cast<char*>(&num_of_states), sizeof num_of_states);
-    automaton.states_attr_.resize(num_of_states + 1);
-
-    // Prepare buffer to read attributes.
-    std::vector<typename Automaton::Attribute> buffer;
+    // Attributes are read to the pool, the state 0 has no attributes.
+    typename Automaton::AttrOffsetList offsets(2, 0);
+    offsets.reserve(num_of_states + 2);
+    typename Automaton::AttrPool attrs;
 
     // Read attributes.
     for (unsigned i = 1; i <= num_of_states; ++i) {
@@ -303,13 +416,13 @@ struct AttrFsmSerializer {
       is.read(reinterpret_cast<char*>(&num_of_attrs), sizeof num_of_attrs);
 
       // Read attributes of the state.
-      buffer.resize(num_of_attrs);
-      automaton.states_attr_[i].resize(num_of_attrs);
-      is.read(reinterpret_cast<char*>(&buffer[0]), sizeof(typename Automaton::Attribute) * buffer.size());
-      for (unsigned j = 0; j < num_of_attrs; ++j) {
-        automaton.states_attr_[i][j] = buffer[j];
+      attrs.resize(offsets.back() + num_of_attrs);
+      if (num_of_attrs) {
+        is.read(reinterpret_cast<char*>(&attrs[offsets.back()]), sizeof(typename Automaton::Attribute) * num_of_attrs);
       }
+      offsets.push_back(attrs.size());
     }
+    automaton.SetPooledAttributes(offsets, attrs);
   }
 };
 
@@ -360,6 +473,104 @@ public:
       trie.fail_moves_.resize(num_of_states);
       is.read(reinterpret_cast<char*>(&trie.fail_moves_[0]), num_of_states * sizeof(StateId));
     }
+
+    // Depths and match states are not stored, they are restored by the fail moves.
+    FailMoveGenerator<AcTrie>::GenerateMatchStates(trie);
+  }
+};
+
+/**
+ * \brief Write the list size and elements.
+ *
+ * The elements are written as is, so the list is read on the machine of the same byte order.
+ *
+ * \param list The list.
+ * \param os   Stream to write to.
+ */
+template <typename T>
+void WriteList(const std::vector<T>& list, std::ostream& os) {
+  uint32_t size = list.size();
+  os.write(reinterpret_cast<const char*>(&size), sizeof size);
+  if (size) {
+    os.write(reinterpret_cast<const char*>(&list[0]), size * sizeof(T));
+  }
+}
+
+/**
+ * \brief Read the list size and elements, written by WriteList.
+ *
+ * \param[out] list The list.
+ * \param      is   Stream to read from.
+ */
+template <typename T>
+void ReadList(std::vector<T>& list, std::istream& is) {
+  uint32_t size = 0;
+  is.read(reinterpret_cast<char*>(&size), sizeof size);
+  if (not is) {
+    throw std::runtime_error("Cannot read list from stream");
+  }
+  list.resize(size);
+  if (size) {
+    is.read(reinterpret_cast<char*>(&list[0]), size * sizeof(T));
+    if (not is) {
+      throw std::runtime_error("Cannot read list from stream");
+    }
+  }
+}
+
+/**
+ * \brief Serialization of minimal acyclic automaton.
+ *
+ * The arrays of the automaton are written as is, each one after its size.
+ */
+template <class DawgImpl>
+struct DawgSerializer {
+  /**
+   * \brief Serialization implementation.
+   *
+   * \param dawg Automaton to serialize.
+   * \param os   Stream to write to.
+   */
+  static void Serialize(const DawgImpl& dawg, std::ostream& os) {
+    WriteList(dawg.offsets_, os);
+    WriteList(dawg.symbols_, os);
+    WriteList(dawg.targets_, os);
+    WriteList(dawg.outputs_, os);
+    WriteList(dawg.accepted_, os);
+    WriteList(dawg.attr_offsets_, os);
+    WriteList(dawg.attrs_, os);
+    if (os.bad()) {
+      throw std::runtime_error("Cannot write automaton to stream");
+    }
+  }
+
+  /**
+   * \brief Deserialization implementation.
+   *
+   * \param[out] dawg Automaton to deserialize.
+   * \param      is   Stream to read from.
+   */
+  static void Deserialize(DawgImpl& dawg, std::istream& is) {
+    ReadList(dawg.offsets_, is);
+    ReadList(dawg.symbols_, is);
+    ReadList(dawg.targets_, is);
+    ReadList(dawg.outputs_, is);
+    ReadList(dawg.accepted_, is);
+    ReadList(dawg.attr_offsets_, is);
+    ReadList(dawg.attrs_, is);
+
+    // Check the arrays are consistent.
+    const size_t num_of_moves = dawg.targets_.size();
+    if (dawg.accepted_.size() < 2 or dawg.offsets_.size() != dawg.accepted_.size() + 1
+        or dawg.offsets_.back() != num_of_moves or dawg.symbols_.size() != num_of_moves
+        or dawg.outputs_.size() != num_of_moves or dawg.attr_offsets_.empty()
+        or dawg.attr_offsets_.back() != dawg.attrs_.size()) {
+      throw std::runtime_error("Bad automaton in stream");
+    }
+    if (not CheckDawgArrays(dawg.offsets_, dawg.targets_, dawg.outputs_, dawg.accepted_, dawg.attr_offsets_,
+                            dawg.GetNumOfStates(), dawg.GetNumOfWords())) {
+      throw std::runtime_error("Bad automaton in stream");
+    }
   }
 };
 
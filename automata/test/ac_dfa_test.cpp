@@ -0,0 +1,166 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Compiled Aho-Corasick automaton unit test.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "aho_corasick.h"
+#include "ac_iterator.h"
+#include "ac_dfa.h"
+#include "flex_transitions.h"
+#include "frozen_transitions.h"
+#include "test_random.h"
+
+namespace {
+
+namespace sa = strutext::automata;
+
+// Type definitions.
+typedef sa::FlexTransitions<char>                    Trans;
+typedef sa::AhoCorasickTrie<Trans, uint64_t>         AcTrie;
+typedef sa::AcDfa<char, uint64_t>                    Dfa;
+typedef sa::FlexTransitions<uint32_t>                WideTrans;
+typedef sa::AhoCorasickTrie<WideTrans, uint64_t>     WideAcTrie;
+typedef sa::AcDfa<uint32_t, uint64_t>                WideDfa;
+
+/// Generate pseudo random chains over the alphabet.
+template <typename Char>
+std::vector<std::basic_string<Char> > GenerateChains(const std::vector<Char>& alphabet, size_t num) {
+  std::vector<std::basic_string<Char> > chains;
+  strutext::test::Random random;
+  for (size_t i = 0; i < num; ++i) {
+    std::basic_string<Char> chain;
+    const size_t len = 1 + random.Next(6);
+    for (size_t j = 0; j < len; ++j) {
+      chain.push_back(alphabet[random.Next(alphabet.size())]);
+    }
+    chains.push_back(chain);
+  }
+  return chains;
+}
+
+/// Collect matches: position and chain identifier.
+template <class AcImpl, typename Char>
+std::vector<uint64_t> Match(const AcImpl& ac, const std::basic_string<Char>& text) {
+  std::vector<uint64_t> result;
+  sa::AcProcessor<AcImpl> processor(ac);
+  sa::StateId state = sa::kStartState;
+  for (size_t i = 0; i < text.size(); ++i) {
+    state = processor.Move(state, text[i]);
+    const typename AcImpl::AttributeList& attrs = ac.GetStateAttributes(state);
+    for (size_t j = 0; j < attrs.size(); ++j) {
+      result.push_back(i);
+      result.push_back(attrs[j]);
+    }
+  }
+  return result;
+}
+
+/// Build the trie and the text of chains and noise symbols.
+template <class AcTrieImpl, typename Char>
+std::basic_string<Char> Prepare(const std::vector<Char>& alphabet, const std::vector<Char>& noise, AcTrieImpl& trie) {
+  const std::vector<std::basic_string<Char> > chains = GenerateChains(alphabet, 300);
+  for (size_t i = 0; i < chains.size(); ++i) {
+    trie.AddChain(chains[i].begin(), chains[i].end(), i);
+  }
+  std::basic_string<Char> text;
+  for (size_t i = 0; i < chains.size(); i += 2) {
+    text += chains[i];
+    text.push_back(noise[i % noise.size()]);
+    text += chains[(i * 7) % chains.size()].substr(1);
+  }
+  return text;
+}
+
+} // namespace.
+
+BOOST_AUTO_TEST_CASE(Automata_AcDfa_Match) {
+  const std::string letters = "abcdefgh";
+  const std::vector<char> alphabet(letters.begin(), letters.end());
+  const std::string noise_letters = "xyz ";
+  const std::vector<char> noise(noise_letters.begin(), noise_letters.end());
+  AcTrie trie;
+  const std::string text = Prepare(alphabet, noise, trie);
+
+  // Fail moves are not required for compilation.
+  Dfa dfa;
+  sa::Compile(trie, dfa);
+  sa::FailMoveGenerator<AcTrie>::Generate(trie);
+  const std::vector<uint64_t> expected = Match(trie, text);
+  BOOST_CHECK(not expected.empty());
+  BOOST_CHECK(Match(dfa, text) == expected);
+  BOOST_CHECK_EQUAL(dfa.GetNumOfStates(), trie.GetNumOfStates());
+
+  // Compilation of the trie with fail moves gives the same result.
+  Dfa dfa1;
+  sa::Compile(trie, dfa1);
+  BOOST_CHECK(Match(dfa1, text) == expected);
+
+  // Noise symbols are in one class, each trie symbol has its own.
+  BOOST_CHECK_EQUAL(dfa.GetNumOfClasses(), alphabet.size() + 1);
+  BOOST_CHECK_EQUAL(dfa.GetSymbolClass('x'), dfa.GetSymbolClass('\xFF'));
+  for (sa::StateId state = 0; state < dfa.GetNumOfStates(); ++state) {
+    BOOST_CHECK_EQUAL(dfa.IsAcceptable(state), trie.IsAcceptable(state));
+    BOOST_CHECK_EQUAL(dfa.Move(state, 'z'), sa::kStartState);
+  }
+
+  // Chain iterator works over the compiled automaton.
+  typedef sa::AcChainIterator<Dfa, std::string::const_iterator> ChainIterator;
+  std::vector<uint64_t> chains;
+  for (ChainIterator it(text.begin(), text.end(), dfa); it != ChainIterator(); ++it) {
+    chains.push_back(*it);
+  }
+  BOOST_CHECK_EQUAL(chains.size(), expected.size() / 2);
+}
+
+BOOST_AUTO_TEST_CASE(Automata_AcDfa_WideSymbols) {
+  // Symbols out of the direct lookup table are searched in sorted list.
+  std::vector<uint32_t> alphabet;
+  alphabet.push_back(0x41);
+  alphabet.push_back(0x430);
+  alphabet.push_back(0x4E00);
+  alphabet.push_back(0x1F600);
+  alphabet.push_back(0x20000);
+  std::vector<uint32_t> noise;
+  noise.push_back(0x20);
+  noise.push_back(0x1F601);
+  WideAcTrie trie;
+  const std::basic_string<uint32_t> text = Prepare(alphabet, noise, trie);
+  WideDfa dfa;
+  sa::Compile(trie, dfa);
+  sa::FailMoveGenerator<WideAcTrie>::Generate(trie);
+  const std::vector<uint64_t> expected = Match(trie, text);
+  BOOST_CHECK(not expected.empty());
+  BOOST_CHECK(Match(dfa, text) == expected);
+  BOOST_CHECK_EQUAL(dfa.GetSymbolClass(0x1F601), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Automata_AcDfa_Empty) {
+  Dfa dfa;
+  BOOST_CHECK_EQUAL(dfa.Move(sa::kStartState, 'a'), sa::kStartState);
+  BOOST_CHECK(dfa.GetStateAttributes(sa::kStartState).empty());
+
+  AcTrie trie;
+  sa::Compile(trie, dfa);
+  BOOST_CHECK_EQUAL(dfa.GetNumOfClasses(), 1u);
+  BOOST_CHECK_EQUAL(dfa.Move(sa::kStartState, 'a'), sa::kStartState);
+}
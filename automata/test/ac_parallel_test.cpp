@@ -0,0 +1,136 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Multi-threaded Aho-Corasick search unit test.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "aho_corasick.h"
+#include "ac_iterator.h"
+#include "ac_parallel.h"
+#include "flex_transitions.h"
+#include "frozen_transitions.h"
+#include "test_random.h"
+
+namespace {
+
+namespace sa = strutext::automata;
+
+// Type definitions.
+typedef sa::FlexTransitions<char>                                                Trans;
+typedef sa::AhoCorasickTrie<Trans, uint64_t>                                     AcTrie;
+typedef sa::AhoCorasickTrie<sa::FrozenTransitions<char>, uint64_t>              FrozenAcTrie;
+typedef sa::AcChainIterator<AcTrie, std::string::const_iterator>                ChainIterator;
+typedef std::vector<std::pair<size_t, uint64_t> >                                MatchList;
+
+// Collector of found chains.
+struct MatchCollector {
+  explicit MatchCollector(MatchList& matches) : matches_(&matches) {}
+
+  void operator()(size_t end, uint64_t id) {
+    matches_->push_back(std::make_pair(end, id));
+  }
+
+  MatchList* matches_;
+};
+
+// Build the trie of random chains over small alphabet, so the chains overlap a lot.
+void BuildTrie(AcTrie& trie) {
+  strutext::test::Random random;
+  for (uint64_t id = 1; id <= 200; ++id) {
+    const std::string chain = random.GenerateText(1 + random.Next(7), "abcd");
+    trie.AddChain(chain.begin(), chain.end(), id);
+  }
+  sa::FailMoveGenerator<AcTrie>::Generate(trie);
+}
+
+// Trie which fails to give the chains by an exception not derived from std::exception.
+struct FailingAcTrie : public AcTrie {
+  AttributeList GetStateAttributes(const sa::StateId&) const {
+    throw 1;
+  }
+};
+
+// Scan the text by one thread.
+void ScanSequential(const AcTrie& trie, const std::string& text, MatchList& matches) {
+  for (ChainIterator it(text.begin(), text.end(), trie); it != ChainIterator(); ++it) {
+    matches.push_back(std::make_pair(it.GetPos(), *it));
+  }
+}
+
+}  // namespace.
+
+BOOST_AUTO_TEST_CASE(Automata_ParallelAc_MaxChainLength) {
+  AcTrie trie;
+  BOOST_CHECK_EQUAL(sa::GetMaxChainLength(trie), 0u);
+  const std::string chains[] = {"ab", "abcde", "cd"};
+  for (size_t i = 0; i < 3; ++i) {
+    trie.AddChain(chains[i].begin(), chains[i].end(), i + 1);
+  }
+  BOOST_CHECK_EQUAL(sa::GetMaxChainLength(trie), 5u);
+}
+
+BOOST_AUTO_TEST_CASE(Automata_ParallelAc_Scan) {
+  AcTrie trie;
+  BuildTrie(trie);
+  strutext::test::Random random(7);
+  const std::string text = random.GenerateText(20000, "abcde");
+  MatchList expected;
+  ScanSequential(trie, text, expected);
+  BOOST_REQUIRE(expected.size() > 1000);
+
+  // Chunks smaller and greater than the chains, one chunk and many rounds.
+  const size_t chunk_sizes[] = {1, 3, 7, 100, 4096, 100000};
+  const size_t thread_nums[] = {1, 3, 8};
+  for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]); ++i) {
+    for (size_t j = 0; j < sizeof(thread_nums) / sizeof(thread_nums[0]); ++j) {
+      MatchList matches;
+      sa::ParallelAcScan(trie, text.data(), text.size(), thread_nums[j], MatchCollector(matches), chunk_sizes[i]);
+      BOOST_CHECK(matches == expected);
+    }
+  }
+
+  // The same for frozen trie.
+  FrozenAcTrie frozen;
+  sa::Freeze(trie, frozen);
+  MatchList matches;
+  sa::ParallelAcScan(frozen, text.data(), text.size(), 4, MatchCollector(matches), 1000);
+  BOOST_CHECK(matches == expected);
+}
+
+BOOST_AUTO_TEST_CASE(Automata_ParallelAc_Empty) {
+  AcTrie trie;
+  BuildTrie(trie);
+  MatchList matches;
+  sa::ParallelAcScan(trie, "", 0, 4, MatchCollector(matches));
+  BOOST_CHECK(matches.empty());
+}
+
+BOOST_AUTO_TEST_CASE(Automata_ParallelAc_Failure) {
+  FailingAcTrie trie;
+  BuildTrie(trie);
+  const std::string text = "abcdabcd";
+  MatchList matches;
+  BOOST_CHECK_THROW(sa::ParallelAcScan(trie, text.data(), text.size(), 1, MatchCollector(matches)), std::runtime_error);
+  BOOST_CHECK_THROW(sa::ParallelAcScan(trie, text.data(), text.size(), 4, MatchCollector(matches), 2), std::runtime_error);
+}
@@ -18,8 +18,10 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -27,6 +29,7 @@
 #include "ac_iterator.h"
 #include "flex_transitions.h"
 #include "serializer.h"
+#include "test_random.h"
 
 namespace {
 
@@ -38,6 +41,7 @@ typedef strutext::automata::AcProcessor<AcTrie>
 typedef strutext::automata::AcSerializer<AcTrie>                                  AcSerializer;
 typedef strutext::automata::AcSymbolIterator<AcTrie, std::string::const_iterator> AcIterator;
 typedef strutext::automata::AcChainIterator<AcTrie, std::string::const_iterator>  ChainIterator;
+typedef strutext::automata::AcMatchIterator<AcTrie, std::string::const_iterator>  MatchIterator;
 
 // Utilities.
 struct TrieUtils {
@@ -45,6 +49,43 @@ struct TrieUtils {
   static void AddChainToTrie(const std::string& chain, AcTrie::Attribute attr, AcTrie& trie) {
     trie.AddChain(chain.begin(), chain.end(), attr);
   }
+
+  // Search non-overlapping chains by brute force: chain identifier is the index in the list plus one.
+  static std::string SearchMatches(const std::vector<std::string>& chains, const std::string& text,
+                                   strutext::automata::AcMatchKind kind) {
+    std::stringstream result;
+    size_t pos = 0;
+    while (pos < text.size()) {
+      size_t best = chains.size();
+      for (size_t begin = pos; begin < text.size() and best == chains.size(); ++begin) {
+        for (size_t i = 0; i < chains.size(); ++i) {
+          if (text.compare(begin, chains[i].size(), chains[i]) != 0) {
+            continue;
+          }
+          if (best == chains.size() or (kind == strutext::automata::kLeftmostLongest and chains[i].size() > chains[best].size())) {
+            best = i;
+          }
+        }
+        if (best != chains.size()) {
+          result << begin << "-" << begin + chains[best].size() << ":" << best + 1 << " ";
+          pos = begin + chains[best].size();
+        }
+      }
+      if (best == chains.size()) {
+        break;
+      }
+    }
+    return result.str();
+  }
+
+  // Search non-overlapping chains by the iterator.
+  static std::string IterateMatches(const AcTrie& trie, const std::string& text, strutext::automata::AcMatchKind kind) {
+    std::stringstream result;
+    for (MatchIterator it(text.begin(), text.end(), trie, kind); it != MatchIterator(); ++it) {
+      result << it->begin_ << "-" << it->end_ << ":" << it->id_ << " ";
+    }
+    return result.str();
+  }
 };
 
 }  // namespace.
@@ -237,3 +278,61 @@ BOOST_AUTO_TEST_CASE(Automata_ChainIterator_Search) {
   }
   BOOST_CHECK(he_found and she_found and hers_found);
 }
+
+// Leftmost-longest and leftmost-first non-overlapping chains.
+BOOST_AUTO_TEST_CASE(Automata_MatchIterator_Search) {
+  AcTrie trie;
+  TrieUtils::AddChainToTrie("abc", 1, trie);
+  TrieUtils::AddChainToTrie("abcdef", 2, trie);
+  TrieUtils::AddChainToTrie("bcd", 3, trie);
+  TrieUtils::AddChainToTrie("ef", 4, trie);
+  TrieUtils::AddChainToTrie("x", 5, trie);
+  AcTrieGenerator::Generate(trie);
+
+  const std::string text = "abcdefx bcdef abcx";
+  BOOST_CHECK_EQUAL(TrieUtils::IterateMatches(trie, text, strutext::automata::kLeftmostLongest),
+                    "0-6:2 6-7:5 8-11:3 11-13:4 14-17:1 17-18:5 ");
+  BOOST_CHECK_EQUAL(TrieUtils::IterateMatches(trie, text, strutext::automata::kLeftmostFirst),
+                    "0-3:1 4-6:4 6-7:5 8-11:3 11-13:4 14-17:1 17-18:5 ");
+  BOOST_CHECK_EQUAL(TrieUtils::IterateMatches(trie, "", strutext::automata::kLeftmostLongest), "");
+  BOOST_CHECK_EQUAL(TrieUtils::IterateMatches(trie, "zzz", strutext::automata::kLeftmostLongest), "");
+
+  // Two identifiers of the same chain: the least one is reported whatever the insertion order is.
+  AcTrie same_trie;
+  TrieUtils::AddChainToTrie("bc", 8, same_trie);
+  TrieUtils::AddChainToTrie("abc", 9, same_trie);
+  TrieUtils::AddChainToTrie("abc", 7, same_trie);
+  AcTrieGenerator::Generate(same_trie);
+  BOOST_CHECK_EQUAL(TrieUtils::IterateMatches(same_trie, "abc", strutext::automata::kLeftmostFirst), "0-3:7 ");
+  BOOST_CHECK_EQUAL(TrieUtils::IterateMatches(same_trie, "abc", strutext::automata::kLeftmostLongest), "0-3:7 ");
+
+  // The match states are restored on deserialization.
+  std::stringstream ss;
+  AcSerializer::Serialize(trie, ss);
+  AcTrie trie1;
+  AcSerializer::Deserialize(trie1, ss);
+  BOOST_CHECK_EQUAL(TrieUtils::IterateMatches(trie1, text, strutext::automata::kLeftmostLongest),
+                    "0-6:2 6-7:5 8-11:3 11-13:4 14-17:1 17-18:5 ");
+}
+
+// Non-overlapping chains of random tries are the same as brute force search finds.
+BOOST_AUTO_TEST_CASE(Automata_MatchIterator_Random) {
+  strutext::test::Random random;
+  for (size_t round = 0; round < 50; ++round) {
+    std::vector<std::string> chains;
+    AcTrie trie;
+    for (size_t i = 0; i < 10; ++i) {
+      const std::string chain = random.GenerateText(1 + random.Next(5), "abc");
+      if (std::find(chains.begin(), chains.end(), chain) == chains.end()) {
+        chains.push_back(chain);
+        TrieUtils::AddChainToTrie(chain, chains.size(), trie);
+      }
+    }
+    AcTrieGenerator::Generate(trie);
+    const std::string text = random.GenerateText(200, "abcd");
+    BOOST_CHECK_EQUAL(TrieUtils::IterateMatches(trie, text, strutext::automata::kLeftmostLongest),
+                      TrieUtils::SearchMatches(chains, text, strutext::automata::kLeftmostLongest));
+    BOOST_CHECK_EQUAL(TrieUtils::IterateMatches(trie, text, strutext::automata::kLeftmostFirst),
+                      TrieUtils::SearchMatches(chains, text, strutext::automata::kLeftmostFirst));
+  }
+}
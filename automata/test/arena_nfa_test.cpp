@@ -0,0 +1,246 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Array NFA unit test.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/make_shared.hpp>
+
+#include "nfa.h"
+#include "arena_nfa.h"
+
+namespace {
+
+namespace sa = strutext::automata;
+
+// Type definitions.
+typedef sa::ArenaNfa<char, uint32_t>     ArenaNfa;
+typedef ArenaNfa::Fragment               Fragment;
+typedef sa::ArenaNfa<uint32_t, uint32_t> WideNfa;
+typedef sa::Nfa<char, uint32_t>          NfaImpl;
+
+/// Add epsilon closure of the states.
+template <class NfaType>
+void Close(const NfaType& nfa, std::set<sa::StateId>& states) {
+  std::vector<sa::StateId> work_states(states.begin(), states.end());
+  while (not work_states.empty()) {
+    const sa::StateId state = work_states.back();
+    work_states.pop_back();
+    for (uint32_t i = nfa.GetFirstMove(state); i != NfaType::kNoLink; i = nfa.GetMove(i).next_) {
+      if (nfa.GetMove(i).epsilon_ and states.insert(nfa.GetMove(i).to_).second) {
+        work_states.push_back(nfa.GetMove(i).to_);
+      }
+    }
+  }
+}
+
+/// Attributes of the text found by the NFA simulation, empty if the text is not accepted.
+template <class NfaType, typename Symbol>
+std::set<uint32_t> Simulate(const NfaType& nfa, const std::vector<Symbol>& text, bool& accepted) {
+  std::set<sa::StateId> states;
+  states.insert(nfa.GetStartState());
+  Close(nfa, states);
+  for (size_t i = 0; i < text.size(); ++i) {
+    const typename NfaType::UnsignedCode code = static_cast<typename NfaType::UnsignedCode>(text[i]);
+    std::set<sa::StateId> next;
+    for (std::set<sa::StateId>::const_iterator st_it = states.begin(); st_it != states.end(); ++st_it) {
+      for (uint32_t j = nfa.GetFirstMove(*st_it); j != NfaType::kNoLink; j = nfa.GetMove(j).next_) {
+        const typename NfaType::Move& move = nfa.GetMove(j);
+        if (not move.epsilon_ and move.first_ <= code and code <= move.last_) {
+          next.insert(move.to_);
+        }
+      }
+    }
+    Close(nfa, next);
+    states.swap(next);
+  }
+  accepted = false;
+  std::set<uint32_t> attrs;
+  for (std::set<sa::StateId>::const_iterator st_it = states.begin(); st_it != states.end(); ++st_it) {
+    if (nfa.IsAcceptable(*st_it)) {
+      accepted = true;
+      for (uint32_t i = nfa.GetFirstAttribute(*st_it); i != NfaType::kNoLink; i = nfa.GetAttribute(i).next_) {
+        attrs.insert(nfa.GetAttribute(i).attr_);
+      }
+    }
+  }
+  return attrs;
+}
+
+/// Is the text accepted by the NFA?
+bool Accepts(const ArenaNfa& nfa, const std::string& text) {
+  bool accepted = false;
+  Simulate(nfa, std::vector<char>(text.begin(), text.end()), accepted);
+  return accepted;
+}
+
+/// Fragment accepting the word.
+Fragment Word(ArenaNfa& nfa, const std::string& word) {
+  Fragment result = nfa.Symbol(word[0]);
+  for (size_t i = 1; i < word.size(); ++i) {
+    result = nfa.Concat(result, nfa.Symbol(word[i]));
+  }
+  return result;
+}
+
+} // namespace.
+
+// Thompson construction operators.
+BOOST_AUTO_TEST_CASE(Automata_ArenaNfa_Operators) {
+  // (a|b)*abb.
+  ArenaNfa nfa;
+  const Fragment abb = nfa.Concat(nfa.Iteration(nfa.Union(nfa.Symbol('a'), nfa.Symbol('b'))), Word(nfa, "abb"));
+  nfa.SetStartState(abb.start_);
+  nfa.Accept(abb, 1);
+  std::vector<std::string> texts(1, std::string());
+  for (size_t i = 0; i < texts.size(); ++i) {
+    const std::string text = texts[i];
+    const bool expected = text.size() >= 3 and text.compare(text.size() - 3, 3, "abb") == 0
+                          and text.find('c') == std::string::npos;
+    BOOST_CHECK_EQUAL(Accepts(nfa, text), expected);
+    if (text.size() < 7) {
+      texts.push_back(text + 'a');
+      texts.push_back(text + 'b');
+      texts.push_back(text + 'c');
+    }
+  }
+
+  // (ab)+c?, the fragment of the plus has loop to its start.
+  ArenaNfa plus;
+  const Fragment abc = plus.Concat(plus.PositiveIteration(Word(plus, "ab")), plus.Optional(plus.Symbol('c')));
+  plus.SetStartState(abc.start_);
+  plus.AddToAcceptedSet(abc.end_);
+  BOOST_CHECK(not Accepts(plus, ""));
+  BOOST_CHECK(Accepts(plus, "ab"));
+  BOOST_CHECK(Accepts(plus, "ababc"));
+  BOOST_CHECK(not Accepts(plus, "abcab"));
+  BOOST_CHECK(not Accepts(plus, "a"));
+  BOOST_CHECK(not Accepts(plus, "c"));
+
+  // (x+)?y: the optional fragment does not skip the loop.
+  ArenaNfa optional;
+  const Fragment xy = optional.Concat(optional.Optional(optional.PositiveIteration(optional.Symbol('x'))),
+                                      optional.Symbol('y'));
+  optional.SetStartState(xy.start_);
+  optional.AddToAcceptedSet(xy.end_);
+  BOOST_CHECK(Accepts(optional, "y"));
+  BOOST_CHECK(Accepts(optional, "xxy"));
+  BOOST_CHECK(not Accepts(optional, "x"));
+  BOOST_CHECK(not Accepts(optional, ""));
+
+  BOOST_CHECK_THROW(nfa.Range('z', 'a'), std::invalid_argument);
+}
+
+// Symbol ranges and attributes.
+BOOST_AUTO_TEST_CASE(Automata_ArenaNfa_Ranges) {
+  // Cyrillic words [а-я]+ get attribute 1, numbers [0-9]+ get 2, "ая" gets 3 too.
+  WideNfa nfa;
+  std::vector<WideNfa::Fragment> rules;
+  rules.push_back(nfa.PositiveIteration(nfa.Range(0x430, 0x44F)));
+  nfa.Accept(rules.back(), 1);
+  rules.push_back(nfa.PositiveIteration(nfa.Range('0', '9')));
+  nfa.Accept(rules.back(), 2);
+  rules.push_back(nfa.Concat(nfa.Symbol(0x430), nfa.Symbol(0x44F)));
+  nfa.Accept(rules.back(), 3);
+  nfa.SetStartState(nfa.Union(rules).start_);
+  BOOST_CHECK_EQUAL(nfa.GetNumOfMoves(), 17u);
+
+  bool accepted = false;
+  std::vector<uint32_t> text;
+  text.push_back(0x430);
+  text.push_back(0x44F);
+  std::set<uint32_t> attrs = Simulate(nfa, text, accepted);
+  BOOST_CHECK(accepted);
+  BOOST_CHECK_EQUAL(attrs.size(), 2u);
+  BOOST_CHECK(attrs.count(1) and attrs.count(3));
+  text.push_back('1');
+  Simulate(nfa, text, accepted);
+  BOOST_CHECK(not accepted);
+  text.assign(3, '7');
+  attrs = Simulate(nfa, text, accepted);
+  BOOST_CHECK(accepted);
+  BOOST_CHECK_EQUAL(attrs.size(), 1u);
+  BOOST_CHECK(attrs.count(2));
+
+  // Classes: [0, '0'), ['0', '9'], ('9', 0x430), 0x430, (0x430, 0x44F), 0x44F, (0x44F, max].
+  sa::SymbolClasses<uint32_t> classes(nfa);
+  BOOST_CHECK_EQUAL(classes.GetNumOfClasses(), 7u);
+  BOOST_CHECK_EQUAL(classes.GetClass(0), 0u);
+  BOOST_CHECK_EQUAL(classes.GetClass('5'), 1u);
+  BOOST_CHECK_EQUAL(classes.GetClass('a'), 2u);
+  BOOST_CHECK_EQUAL(classes.GetClass(0x430), 3u);
+  BOOST_CHECK_EQUAL(classes.GetClass(0x431), 4u);
+  BOOST_CHECK_EQUAL(classes.GetClass(0x44E), 4u);
+  BOOST_CHECK_EQUAL(classes.GetClass(0x44F), 5u);
+  BOOST_CHECK_EQUAL(classes.GetClass(0xFFFFFFFF), 6u);
+  BOOST_CHECK_EQUAL(classes.GetFirstClass(0x430), 3u);
+  BOOST_CHECK_EQUAL(classes.GetLastClass(0x44F), 5u);
+  BOOST_CHECK_EQUAL(classes.GetLastClass(0xFFFFFFFF), 6u);
+
+  // Bytes above 0x7F are ordered as unsigned.
+  ArenaNfa bytes;
+  const Fragment high = bytes.Range('\x80', '\xFF');
+  bytes.SetStartState(high.start_);
+  bytes.AddToAcceptedSet(high.end_);
+  BOOST_CHECK(Accepts(bytes, "\xD0"));
+  BOOST_CHECK(not Accepts(bytes, "a"));
+  sa::SymbolClasses<char> byte_classes(bytes);
+  BOOST_CHECK_EQUAL(byte_classes.GetNumOfClasses(), 2u);
+  BOOST_CHECK_EQUAL(byte_classes.GetClass('\xFF'), 1u);
+}
+
+// Copy of the pointer based NFA.
+BOOST_AUTO_TEST_CASE(Automata_ArenaNfa_Copy) {
+  NfaImpl nfa;
+  std::vector<NfaImpl::State*> states;
+  for (size_t i = 0; i < 4; ++i) {
+    NfaImpl::State::Ptr state = boost::make_shared<NfaImpl::State>();
+    nfa.AddState(state);
+    states.push_back(state.get());
+  }
+  // a*b | c.
+  nfa.SetStartState(states[0]);
+  nfa.AddEpsilonTransition(states[0], states[1]);
+  nfa.AddTransition(states[1], states[1], 'a');
+  nfa.AddTransition(states[1], states[2], 'b');
+  nfa.AddTransition(states[0], states[3], 'c');
+  nfa.AddToAcceptedSet(states[2]);
+  nfa.AddToAcceptedSet(states[3]);
+  states[2]->attr_list_.insert(1);
+  states[3]->attr_list_.insert(2);
+
+  ArenaNfa arena;
+  sa::BuildArenaNfa(nfa, arena);
+  BOOST_CHECK_EQUAL(arena.GetNumOfStates(), 4u);
+  BOOST_CHECK_EQUAL(arena.GetNumOfMoves(), 4u);
+  const char* texts[] = {"", "b", "aab", "c", "ac", "ab", "bb"};
+  const uint32_t expected[] = {0, 1, 1, 2, 0, 1, 0};
+  for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i) {
+    bool accepted = false;
+    const std::string text(texts[i]);
+    const std::set<uint32_t> attrs = Simulate(arena, std::vector<char>(text.begin(), text.end()), accepted);
+    BOOST_CHECK_EQUAL(accepted, expected[i] != 0);
+    BOOST_CHECK_EQUAL(attrs.size(), expected[i] != 0 ? 1u : 0u);
+    BOOST_CHECK(expected[i] == 0 or attrs.count(expected[i]));
+  }
+}
@@ -0,0 +1,220 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Minimal acyclic automaton unit test.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "trie.h"
+#include "flex_transitions.h"
+#include "dawg.h"
+#include "serializer.h"
+#include "test_random.h"
+
+namespace {
+
+namespace sa = strutext::automata;
+
+// Type definitions.
+typedef sa::FlexTransitions<char>           Trans;
+typedef sa::Trie<Trans, uint64_t>           FlexTrie;
+typedef sa::Dawg<char, uint64_t>            Dawg;
+typedef sa::DawgBuilder<char, uint64_t>     DawgBuilder;
+typedef sa::DawgSerializer<Dawg>            Serializer;
+
+/// Generate pseudo random words with common suffixes.
+std::vector<std::string> GenerateWords() {
+  static const char* kSuffixes[] = {"", "a", "ov", "ami", "ah", "om", "u"};
+  std::vector<std::string> words;
+  strutext::test::Random random;
+  for (size_t i = 0; i < 300; ++i) {
+    const std::string base = random.GenerateText(1 + random.Next(6), "abcdefghijklmnopqrstuvwxyz");
+    for (size_t j = 0; j < sizeof(kSuffixes) / sizeof(kSuffixes[0]); ++j) {
+      words.push_back(base + kSuffixes[j]);
+    }
+  }
+  return words;
+}
+
+/// Search the word in the automaton.
+template <class AutomatonImpl>
+std::vector<uint64_t> Search(const AutomatonImpl& automaton, const std::string& word) {
+  const typename AutomatonImpl::AttributeList attrs = automaton.Search(word.begin(), word.end());
+  std::vector<uint64_t> result(attrs.begin(), attrs.end());
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+/// Build the trie of the words, the word index is the attribute.
+void BuildTrie(const std::vector<std::string>& words, FlexTrie& trie) {
+  for (size_t i = 0; i < words.size(); ++i) {
+    trie.AddAttribute(trie.AddChain(words[i].begin(), words[i].end()), i);
+  }
+}
+
+/// Check the automaton has the same words as the trie.
+void CheckDawg(const FlexTrie& expected, const Dawg& dawg, const std::vector<std::string>& words) {
+  for (size_t i = 0; i < words.size(); ++i) {
+    BOOST_CHECK(Search(dawg, words[i]) == Search(expected, words[i]));
+    const std::string absent = words[i] + "#";
+    BOOST_CHECK(Search(dawg, absent).empty());
+  }
+  BOOST_CHECK(Search(dawg, "").empty());
+}
+
+} // namespace.
+
+// Build from the trie and search the words.
+BOOST_AUTO_TEST_CASE(Automata_Dawg_Search) {
+  const std::vector<std::string> words = GenerateWords();
+  FlexTrie trie;
+  BuildTrie(words, trie);
+  Dawg dawg;
+  sa::BuildDawg(trie, dawg);
+
+  const std::set<std::string> word_set(words.begin(), words.end());
+  BOOST_CHECK_EQUAL(dawg.GetNumOfWords(), word_set.size());
+  BOOST_CHECK_LT(dawg.GetNumOfStates(), trie.GetNumOfStates() / 2);
+  CheckDawg(trie, dawg, words);
+}
+
+// Minimal automaton of a small dictionary.
+BOOST_AUTO_TEST_CASE(Automata_Dawg_Minimal) {
+  // Words "tap", "taps", "top", "tops" share all the states but the second one.
+  static const char* kWords[] = {"tap", "taps", "top", "tops"};
+  DawgBuilder builder;
+  for (size_t i = 0; i < 4; ++i) {
+    const std::string word(kWords[i]);
+    builder.Add(word.begin(), word.end(), uint64_t(i));
+  }
+  Dawg dawg;
+  builder.Build(dawg);
+  // Invalid state, start state and 4 states of the paths.
+  BOOST_CHECK_EQUAL(dawg.GetNumOfStates(), 6u);
+  BOOST_CHECK_EQUAL(dawg.GetNumOfMoves(), 5u);
+  for (size_t i = 0; i < 4; ++i) {
+    const std::vector<uint64_t> attrs = Search(dawg, kWords[i]);
+    BOOST_REQUIRE_EQUAL(attrs.size(), 1u);
+    BOOST_CHECK_EQUAL(attrs[0], i);
+  }
+  BOOST_CHECK(Search(dawg, "ta").empty());
+  BOOST_CHECK(Search(dawg, "tapss").empty());
+}
+
+// Word numbers of the prefixes found by a single pass.
+BOOST_AUTO_TEST_CASE(Automata_Dawg_Prefixes) {
+  static const char* kWords[] = {"a", "ab", "abc", "abd", "b"};
+  DawgBuilder builder;
+  for (size_t i = 0; i < 5; ++i) {
+    const std::string word(kWords[i]);
+    builder.Add(word.begin(), word.end(), uint64_t(i * 10));
+    if (i == 2) {
+      // The same word again: the attributes are joined.
+      builder.Add(word.begin(), word.end(), uint64_t(21));
+    }
+  }
+  BOOST_CHECK_EQUAL(builder.GetNumOfWords(), 5u);
+  Dawg dawg;
+  builder.Build(dawg);
+
+  const std::string text = "abcd";
+  std::vector<uint32_t> numbers;
+  sa::StateId state = sa::kStartState;
+  uint32_t number = 0;
+  for (size_t i = 0; i < text.size() and state != sa::kInvalidState; ++i) {
+    state = dawg.Go(state, text[i], number);
+    if (state != sa::kInvalidState and dawg.IsAcceptable(state)) {
+      numbers.push_back(number);
+    }
+  }
+  BOOST_REQUIRE_EQUAL(numbers.size(), 3u);
+  BOOST_CHECK_EQUAL(numbers[0], 0u);
+  BOOST_CHECK_EQUAL(numbers[1], 1u);
+  BOOST_CHECK_EQUAL(numbers[2], 2u);
+  const Dawg::AttributeList attrs = dawg.GetWordAttributes(2);
+  BOOST_REQUIRE_EQUAL(attrs.size(), 2u);
+  BOOST_CHECK_EQUAL(attrs[0], 20u);
+  BOOST_CHECK_EQUAL(attrs[1], 21u);
+  BOOST_CHECK_EQUAL(Search(dawg, "b")[0], 40u);
+}
+
+// Unsorted words are rejected.
+BOOST_AUTO_TEST_CASE(Automata_Dawg_NotSorted) {
+  DawgBuilder builder;
+  const std::string first = "abc";
+  const std::string second = "ab";
+  builder.Add(first.begin(), first.end(), uint64_t(1));
+  BOOST_CHECK_THROW(builder.Add(second.begin(), second.end(), uint64_t(2)), std::invalid_argument);
+  const std::string third = "abb";
+  BOOST_CHECK_THROW(builder.Add(third.begin(), third.end(), uint64_t(3)), std::invalid_argument);
+}
+
+// Serialization and thawing.
+BOOST_AUTO_TEST_CASE(Automata_Dawg_Serialization) {
+  const std::vector<std::string> words = GenerateWords();
+  FlexTrie trie;
+  BuildTrie(words, trie);
+  Dawg dawg;
+  sa::BuildDawg(trie, dawg);
+
+  std::stringstream ss;
+  Serializer::Serialize(dawg, ss);
+  Dawg restored;
+  Serializer::Deserialize(restored, ss);
+  BOOST_CHECK_EQUAL(restored.GetNumOfStates(), dawg.GetNumOfStates());
+  CheckDawg(trie, restored, words);
+
+  FlexTrie thawed;
+  sa::Thaw(restored, thawed);
+  BOOST_CHECK_EQUAL(thawed.GetNumOfStates(), trie.GetNumOfStates());
+  for (size_t i = 0; i < words.size(); ++i) {
+    BOOST_CHECK(Search(thawed, words[i]) == Search(trie, words[i]));
+  }
+
+  std::stringstream bad("abc");
+  BOOST_CHECK_THROW(Serializer::Deserialize(restored, bad), std::runtime_error);
+
+  // Move targets and word numbers out of range.
+  Dawg broken = dawg;
+  broken.targets_.back() = broken.GetNumOfStates();
+  std::stringstream bad_target;
+  Serializer::Serialize(broken, bad_target);
+  BOOST_CHECK_THROW(Serializer::Deserialize(restored, bad_target), std::runtime_error);
+  broken = dawg;
+  broken.targets_.front() = sa::kStartState;
+  std::stringstream cycle;
+  Serializer::Serialize(broken, cycle);
+  BOOST_CHECK_THROW(Serializer::Deserialize(restored, cycle), std::runtime_error);
+  broken = dawg;
+  broken.outputs_.back() += broken.GetNumOfWords();
+  std::stringstream bad_output;
+  Serializer::Serialize(broken, bad_output);
+  BOOST_CHECK_THROW(Serializer::Deserialize(restored, bad_output), std::runtime_error);
+  broken = dawg;
+  broken.accepted_[sa::kInvalidState] = 1;
+  std::stringstream bad_invalid;
+  Serializer::Serialize(broken, bad_invalid);
+  BOOST_CHECK_THROW(Serializer::Deserialize(restored, bad_invalid), std::runtime_error);
+}
@@ -0,0 +1,214 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Frozen automata unit test.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "trie.h"
+#include "aho_corasick.h"
+#include "flex_transitions.h"
+#include "frozen_transitions.h"
+#include "serializer.h"
+#include "test_random.h"
+
+namespace {
+
+namespace sa = strutext::automata;
+
+// Type definitions.
+typedef sa::FlexTransitions<char>                  Trans;
+typedef sa::FrozenTransitions<char>                FrozenTrans;
+typedef sa::Trie<Trans, uint64_t>                  FlexTrie;
+typedef sa::Trie<FrozenTrans, uint64_t>            FrozenTrie;
+typedef sa::AhoCorasickTrie<Trans, uint64_t>       AcTrie;
+typedef sa::AhoCorasickTrie<FrozenTrans, uint64_t> FrozenAcTrie;
+
+/// Generate pseudo random words, some of them have many continuations.
+std::vector<std::string> GenerateWords() {
+  std::vector<std::string> words;
+  strutext::test::Random random;
+  for (size_t i = 0; i < 500; ++i) {
+    const size_t len = 1 + random.Next(8);
+    words.push_back(random.GenerateText(len, "abcdefghijklmnopqrstuvwxyz"));
+  }
+  return words;
+}
+
+/// Search the chain in the trie.
+template <class TrieImpl>
+std::vector<uint64_t> Search(const TrieImpl& trie, const std::string& chain) {
+  const typename TrieImpl::AttributeList& attrs = trie.Search(chain.begin(), chain.end());
+  return std::vector<uint64_t>(attrs.begin(), attrs.end());
+}
+
+/// Check the tries have the same chains.
+template <class TrieImpl>
+void CheckTrie(const FlexTrie& expected, const TrieImpl& trie, const std::vector<std::string>& words) {
+  BOOST_REQUIRE_EQUAL(trie.GetNumOfStates(), expected.GetNumOfStates());
+  for (size_t i = 0; i < words.size(); ++i) {
+    BOOST_CHECK(Search(trie, words[i]) == Search(expected, words[i]));
+    const std::string absent = words[i] + "#";
+    BOOST_CHECK(Search(trie, absent).empty());
+  }
+  for (sa::StateId state = 0; state < expected.GetNumOfStates(); ++state) {
+    BOOST_CHECK(trie.GetMoveTable(state) == expected.GetMoveTable(state));
+    BOOST_CHECK_EQUAL(trie.IsAcceptable(state), expected.IsAcceptable(state));
+  }
+}
+
+/// Collect AC matches of the text.
+template <class AcTrieImpl>
+std::vector<uint64_t> Match(const AcTrieImpl& trie, const std::string& text) {
+  std::vector<uint64_t> result;
+  sa::AcProcessor<AcTrieImpl> processor(trie);
+  sa::StateId state = sa::kStartState;
+  for (size_t i = 0; i < text.size(); ++i) {
+    state = processor.Move(state, text[i]);
+    const typename AcTrieImpl::AttributeList& attrs = trie.GetStateAttributes(state);
+    for (size_t j = 0; j < attrs.size(); ++j) {
+      result.push_back(i);
+      result.push_back(attrs[j]);
+    }
+  }
+  return result;
+}
+
+} // namespace.
+
+BOOST_AUTO_TEST_CASE(Automata_Frozen_Trie) {
+  const std::vector<std::string> words = GenerateWords();
+  FlexTrie trie;
+  for (size_t i = 0; i < words.size(); ++i) {
+    trie.AddChain(words[i].begin(), words[i].end(), i);
+  }
+
+  FrozenTrie frozen;
+  sa::Freeze(trie, frozen);
+  CheckTrie(trie, frozen, words);
+
+  // The start state has a lot of moves, they are searched by binary search.
+  BOOST_CHECK(trie.GetMoveTable(sa::kStartState).size() > FrozenTrie::kLinearSearchSize);
+
+  // Back to the modifiable trie.
+  FlexTrie thawed;
+  sa::Thaw(frozen, thawed);
+  CheckTrie(trie, thawed, words);
+  thawed.AddChain(words[0].begin(), words[0].end(), 1000);
+  BOOST_CHECK_EQUAL(thawed.Search(words[0].begin(), words[0].end()).back(), 1000u);
+}
+
+BOOST_AUTO_TEST_CASE(Automata_Frozen_EmptyTrie) {
+  FlexTrie trie;
+  FrozenTrie frozen;
+  sa::Freeze(trie, frozen);
+  BOOST_CHECK_EQUAL(frozen.GetNumOfStates(), 2u);
+  BOOST_CHECK_EQUAL(frozen.Go(sa::kStartState, 'a'), sa::kInvalidState);
+  BOOST_CHECK_EQUAL(frozen.Go(sa::kInvalidState, 'a'), sa::kInvalidState);
+
+  const std::string chain = "abc";
+  BOOST_CHECK(frozen.Search(chain.begin(), chain.end()).empty());
+}
+
+BOOST_AUTO_TEST_CASE(Automata_Frozen_Serialize) {
+  const std::vector<std::string> words = GenerateWords();
+  FlexTrie trie;
+  for (size_t i = 0; i < words.size(); ++i) {
+    trie.AddChain(words[i].begin(), words[i].end(), i);
+  }
+
+  // The flexible trie is read as frozen one.
+  std::stringstream flex_stream;
+  sa::AttrFsmSerializer<FlexTrie>::Serialize(trie, flex_stream);
+  FrozenTrie frozen;
+  sa::AttrFsmSerializer<FrozenTrie>::Deserialize(frozen, flex_stream);
+  CheckTrie(trie, frozen, words);
+
+  // The frozen trie is written in the same format.
+  std::stringstream frozen_stream;
+  sa::AttrFsmSerializer<FrozenTrie>::Serialize(frozen, frozen_stream);
+  BOOST_CHECK(frozen_stream.str() == flex_stream.str());
+  FlexTrie flex;
+  sa::AttrFsmSerializer<FlexTrie>::Deserialize(flex, frozen_stream);
+  CheckTrie(trie, flex, words);
+}
+
+BOOST_AUTO_TEST_CASE(Automata_Frozen_BadStream) {
+  typedef sa::FiniteStateMachine<FrozenTrans> FrozenFsm;
+  typedef sa::FsmSerializer<FrozenTrans>      Serializer;
+
+  // Two states: the start state moves to the second one by 'a' and 'b'.
+  const char moves[] = {'a', 2, 0, 0, 0, 'b', 2, 0, 0, 0};
+  const char head[] = {2, 0, 0, 0, 0, 2, 0, 0, 0};
+  const char tail[] = {1, 0, 0, 0, 0};
+  const std::string good = std::string(head, sizeof(head)) + std::string(moves, sizeof(moves))
+                           + std::string(tail, sizeof(tail));
+  std::stringstream good_ss(good);
+  FrozenFsm fsm;
+  Serializer::Deserialize(fsm, good_ss);
+  BOOST_CHECK_EQUAL(fsm.Go(sa::kStartState, 'b'), 2u);
+  BOOST_CHECK(fsm.IsAcceptable(2));
+
+  // Truncated moves, target out of range, unsorted symbols, too many moves.
+  std::stringstream truncated_ss(good.substr(0, sizeof(head) + 7));
+  BOOST_CHECK_THROW(Serializer::Deserialize(fsm, truncated_ss), std::runtime_error);
+  std::string bad = good;
+  bad[sizeof(head) + 6] = 3;
+  std::stringstream bad_target_ss(bad);
+  BOOST_CHECK_THROW(Serializer::Deserialize(fsm, bad_target_ss), std::runtime_error);
+  bad = good;
+  std::swap(bad[sizeof(head)], bad[sizeof(head) + 5]);
+  std::stringstream unsorted_ss(bad);
+  BOOST_CHECK_THROW(Serializer::Deserialize(fsm, unsorted_ss), std::runtime_error);
+  bad = good;
+  bad[8] = 1;
+  std::stringstream many_ss(bad);
+  BOOST_CHECK_THROW(Serializer::Deserialize(fsm, many_ss), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(Automata_Frozen_AcTrie) {
+  const std::vector<std::string> words = GenerateWords();
+  AcTrie trie;
+  for (size_t i = 0; i < words.size(); ++i) {
+    trie.AddChain(words[i].begin(), words[i].end(), i);
+  }
+  sa::FailMoveGenerator<AcTrie>::Generate(trie);
+
+  FrozenAcTrie frozen;
+  sa::Freeze(trie, frozen);
+
+  std::string text;
+  for (size_t i = 0; i < words.size(); i += 3) {
+    text += words[i];
+  }
+  const std::vector<uint64_t> expected = Match(trie, text);
+  BOOST_CHECK(not expected.empty());
+  BOOST_CHECK(Match(frozen, text) == expected);
+
+  // Serialization.
+  std::stringstream ss;
+  sa::AcSerializer<FrozenAcTrie>::Serialize(frozen, ss);
+  FrozenAcTrie frozen1;
+  sa::AcSerializer<FrozenAcTrie>::Deserialize(frozen1, ss);
+  BOOST_CHECK(Match(frozen1, text) == expected);
+}
@@ -0,0 +1,205 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Bit-parallel matcher unit test.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/make_shared.hpp>
+
+#include "nfa.h"
+#include "nfa_operations.h"
+#include "lazy_dfa.h"
+#include "glushkov_matcher.h"
+#include "test_random.h"
+#include "test_nfa.h"
+
+namespace {
+
+namespace sa = strutext::automata;
+namespace so = strutext::automata::operations;
+namespace se = strutext::encode;
+
+// Type definitions.
+typedef sa::Nfa<char, uint32_t>             NfaImpl;
+typedef NfaImpl::State                      State;
+typedef NfaImpl::Ptr                        NfaPtr;
+typedef sa::LazyDfa<char, uint32_t>         LazyDfa;
+typedef sa::GlushkovMatcher<char, uint32_t> Matcher;
+typedef std::pair<size_t, uint32_t>         FoundRule;
+typedef std::vector<FoundRule>              FoundRuleList;
+
+// Shared NFA builders.
+using strutext::test::NewState;
+
+/// The chain of moves by the word symbols.
+NfaPtr Word(const std::string& word) {
+  NfaPtr nfa = boost::make_shared<NfaImpl>();
+  State* state = NewState(*nfa);
+  nfa->SetStartState(state);
+  for (size_t i = 0; i < word.size(); ++i) {
+    State* next = NewState(*nfa);
+    nfa->AddTransition(state, next, word[i]);
+    state = next;
+  }
+  nfa->AddToAcceptedSet(state);
+  return nfa;
+}
+
+/// One move by any of the symbols.
+NfaPtr AnyOf(const std::string& symbols) {
+  NfaPtr nfa = boost::make_shared<NfaImpl>();
+  State* start = NewState(*nfa);
+  State* accepted = NewState(*nfa);
+  nfa->SetStartState(start);
+  for (size_t i = 0; i < symbols.size(); ++i) {
+    nfa->AddTransition(start, accepted, symbols[i]);
+  }
+  nfa->AddToAcceptedSet(accepted);
+  return nfa;
+}
+
+/// Alternative of the automata.
+NfaPtr Alt(NfaPtr left, NfaPtr right) {
+  std::list<NfaPtr> auto_list;
+  auto_list.push_back(left);
+  auto_list.push_back(right);
+  return so::Union<char, uint32_t>(auto_list);
+}
+
+/// Concatenation of the automata.
+NfaPtr Cat(NfaPtr left, NfaPtr right) {
+  return so::Concat<char, uint32_t>(left, right);
+}
+
+/// Iteration of the automaton.
+NfaPtr Star(NfaPtr operand) {
+  return so::Iteration<char, uint32_t>(operand);
+}
+
+/// Find the rule matches by matching each substring.
+FoundRuleList FindRules(const std::vector<NfaPtr>& rules, const std::string& text) {
+  FoundRuleList found;
+  LazyDfa::AttributeList attrs;
+  for (size_t i = 0; i < rules.size(); ++i) {
+    LazyDfa dfa(*rules[i]);
+    for (size_t end = 0; end <= text.size(); ++end) {
+      for (size_t begin = 0; begin <= end; ++begin) {
+        if (dfa.Match(text.begin() + begin, text.begin() + end, attrs)) {
+          found.push_back(FoundRule(end, i));
+          break;
+        }
+      }
+    }
+  }
+  std::sort(found.begin(), found.end());
+  return found;
+}
+
+/// Scan the text by the matcher.
+FoundRuleList ScanRules(const Matcher& matcher, const std::string& text) {
+  Matcher::MatchList matches;
+  matcher.Scan(text.begin(), text.end(), matches);
+  FoundRuleList found;
+  for (size_t i = 0; i < matches.size(); ++i) {
+    found.push_back(FoundRule(matches[i].end_, matches[i].id_));
+  }
+  std::sort(found.begin(), found.end());
+  return found;
+}
+
+} // namespace.
+
+// Matches are the same as found by deterministic automata of the rules.
+BOOST_AUTO_TEST_CASE(Automata_Glushkov_Matches) {
+  std::vector<NfaPtr> rules;
+  rules.push_back(Word("abc"));
+  rules.push_back(Alt(Word("ab"), Word("bd")));
+  rules.push_back(Cat(Word("a"), Cat(Star(AnyOf("ab")), Word("c"))));
+  rules.push_back(Cat(AnyOf("ab"), Cat(AnyOf("abcd"), AnyOf("ab"))));
+  rules.push_back(Star(Word("cd")));
+  rules.push_back(Cat(Star(Star(Alt(Word("a"), Star(Word("b"))))), Word("d")));
+  rules.push_back(Cat(Word("d"), Star(Alt(Word("ba"), Word("c")))));
+  rules.push_back(Cat(Cat(Word("b"), Star(Word("a"))), Cat(Word("a"), Alt(Word("c"), Word("")))));
+  for (size_t i = 0; i < 12; ++i) {
+    strutext::test::Random random(i);
+    rules.push_back(Word(random.GenerateText(3 + i % 4, "abcd")));
+  }
+
+  Matcher matcher;
+  for (size_t i = 0; i < rules.size(); ++i) {
+    matcher.AddRule(*rules[i], i);
+  }
+  BOOST_CHECK(not matcher.IsCompiled());
+  matcher.Compile();
+  BOOST_CHECK(matcher.IsCompiled());
+  BOOST_CHECK_EQUAL(matcher.GetNumOfRules(), rules.size());
+  BOOST_CHECK(matcher.GetNumOfWords() >= 2);
+  BOOST_CHECK_EQUAL(matcher.GetSymbolClass('z'), 0u);
+
+  const se::SimdLevel levels[] = {
+    se::SCALAR_SIMD_LEVEL, se::SSE2_SIMD_LEVEL, se::AVX2_SIMD_LEVEL
+  };
+  strutext::test::Random random;
+  for (size_t i = 0; i < 50; ++i) {
+    const std::string text = random.GenerateText(i % 25, "abcdz");
+    const FoundRuleList expected = FindRules(rules, text);
+    for (size_t j = 0; j < sizeof(levels) / sizeof(levels[0]); ++j) {
+      matcher.SetSimdLevel(levels[j]);
+      BOOST_CHECK(ScanRules(matcher, text) == expected);
+    }
+  }
+}
+
+// Packing of the rules to the words, errors.
+BOOST_AUTO_TEST_CASE(Automata_Glushkov_Packing) {
+  Matcher matcher;
+  Matcher::MatchList matches;
+  const std::string text = "abcdefghijk";
+  BOOST_CHECK_THROW(matcher.Scan(text.begin(), text.end(), matches), std::runtime_error);
+  BOOST_CHECK_THROW(matcher.AddRule(NfaImpl(), 0), std::invalid_argument);
+  BOOST_CHECK_THROW(matcher.AddRule(*Word(std::string(Matcher::kMaxPositions + 1, 'a')), 0), std::invalid_argument);
+  matcher.AddRule(*Word(std::string(Matcher::kMaxPositions, 'a')), 0);
+
+  // The long rule takes one word, six rules of ten positions fit the next one.
+  for (size_t i = 1; i <= 10; ++i) {
+    matcher.AddRule(*Word(text.substr(0, 10)), i);
+  }
+  matcher.Compile();
+  BOOST_CHECK_EQUAL(matcher.GetNumOfWords(), 3u);
+  BOOST_CHECK_EQUAL(matcher.GetNumOfClasses(), 11u);
+
+  // The rules are reported once at the end of the first ten symbols.
+  BOOST_CHECK_EQUAL(matcher.Scan(text.begin(), text.end(), matches), 10u);
+  for (size_t i = 0; i < matches.size(); ++i) {
+    BOOST_CHECK_EQUAL(matches[i].end_, 10u);
+    BOOST_CHECK_EQUAL(matches[i].id_, i + 1);
+  }
+
+  // The rule matching the empty text is reported at each offset, the adding resets compilation.
+  matcher.AddRule(*Star(Word("a")), 11);
+  BOOST_CHECK(not matcher.IsCompiled());
+  matcher.Compile();
+  BOOST_CHECK_EQUAL(matcher.Scan(text.begin(), text.begin() + 2, matches), 3u);
+}
@@ -0,0 +1,139 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Lazy deterministic automaton unit test.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "nfa.h"
+#include "lazy_dfa.h"
+#include "test_random.h"
+#include "test_nfa.h"
+
+namespace {
+
+namespace sa = strutext::automata;
+
+// Type definitions.
+typedef sa::Nfa<char, uint32_t>     NfaImpl;
+typedef NfaImpl::State              State;
+typedef sa::LazyDfa<char, uint32_t> LazyDfa;
+typedef LazyDfa::AttributeList      AttributeList;
+
+// Shared NFA builders.
+using strutext::test::NewState;
+using strutext::test::AddWord;
+
+/// Build (a|b)*a(a|b){n}, its deterministic automaton has 2^(n+1) states.
+void BuildNthFromEndNfa(size_t n, NfaImpl& nfa) {
+  State* start = NewState(nfa);
+  nfa.SetStartState(start);
+  nfa.AddTransition(start, start, 'a');
+  nfa.AddTransition(start, start, 'b');
+  State* state = NewState(nfa);
+  nfa.AddTransition(start, state, 'a');
+  for (size_t i = 0; i < n; ++i) {
+    State* next = NewState(nfa);
+    nfa.AddTransition(state, next, 'a');
+    nfa.AddTransition(state, next, 'b');
+    state = next;
+  }
+  nfa.AddToAcceptedSet(state);
+  state->attr_list_.insert(1);
+}
+
+/// Match the string.
+bool Match(LazyDfa& dfa, const std::string& text, AttributeList& attrs) {
+  return dfa.Match(text.begin(), text.end(), attrs);
+}
+
+} // namespace.
+
+// Matching of words and their attributes.
+BOOST_AUTO_TEST_CASE(Automata_LazyDfa_Words) {
+  NfaImpl nfa;
+  nfa.SetStartState(NewState(nfa));
+  AddWord(nfa, "ab", 1);
+  AddWord(nfa, "abc", 2);
+  AddWord(nfa, "abc", 3);
+  AddWord(nfa, "bd", 4);
+
+  LazyDfa dfa(nfa);
+  BOOST_CHECK_EQUAL(dfa.GetNumOfStates(), 1u);
+  BOOST_CHECK_EQUAL(dfa.GetNumOfClasses(), 5u);
+  BOOST_CHECK_EQUAL(dfa.GetSymbolClass('z'), 0u);
+
+  AttributeList attrs;
+  BOOST_CHECK(Match(dfa, "abc", attrs));
+  BOOST_REQUIRE_EQUAL(attrs.size(), 2u);
+  BOOST_CHECK_EQUAL(attrs[0], 2u);
+  BOOST_CHECK_EQUAL(attrs[1], 3u);
+  BOOST_CHECK(Match(dfa, "ab", attrs));
+  BOOST_REQUIRE_EQUAL(attrs.size(), 1u);
+  BOOST_CHECK_EQUAL(attrs[0], 1u);
+  BOOST_CHECK(Match(dfa, "bd", attrs));
+  BOOST_CHECK(not Match(dfa, "", attrs));
+  BOOST_CHECK(attrs.empty());
+  BOOST_CHECK(not Match(dfa, "abcd", attrs));
+  BOOST_CHECK(not Match(dfa, "azc", attrs));
+
+  // The states are built once: "", "a", "ab", "abc", "b", "bd" and the dead one.
+  const size_t num_of_states = dfa.GetNumOfStates();
+  BOOST_CHECK_EQUAL(num_of_states, 7u);
+  BOOST_CHECK(Match(dfa, "abc", attrs));
+  BOOST_CHECK(not Match(dfa, "abcd", attrs));
+  BOOST_CHECK_EQUAL(dfa.GetNumOfStates(), num_of_states);
+  BOOST_CHECK_EQUAL(dfa.GetNumOfFlushes(), 0u);
+}
+
+// The bounded cache gives the same results as the unbounded one.
+BOOST_AUTO_TEST_CASE(Automata_LazyDfa_Cache) {
+  const size_t n = 8;
+  NfaImpl nfa;
+  BuildNthFromEndNfa(n, nfa);
+  BOOST_CHECK_THROW(LazyDfa(nfa, LazyDfa::kMinStates - 1), std::invalid_argument);
+
+  LazyDfa full(nfa, 1 << 12);
+  LazyDfa small(nfa, 16);
+  LazyDfa tiny(nfa, LazyDfa::kMinStates);
+  strutext::test::Random random;
+  AttributeList attrs;
+  for (size_t i = 0; i < 300; ++i) {
+    const std::string text = random.GenerateText(random.Next(400), "ba");
+    const bool expected = text.size() > n and text[text.size() - n - 1] == 'a';
+    BOOST_CHECK_EQUAL(Match(full, text, attrs), expected);
+    BOOST_CHECK_EQUAL(attrs.size(), expected ? 1u : 0u);
+    BOOST_CHECK_EQUAL(Match(small, text, attrs), expected);
+    BOOST_CHECK_EQUAL(attrs.size(), expected ? 1u : 0u);
+    BOOST_CHECK_EQUAL(Match(tiny, text, attrs), expected);
+    BOOST_CHECK_EQUAL(attrs.size(), expected ? 1u : 0u);
+  }
+
+  // All the states fit the large cache, the small caches are flushed or thrash.
+  BOOST_CHECK_EQUAL(full.GetNumOfStates(), 1u << (n + 1));
+  BOOST_CHECK_EQUAL(full.GetNumOfFlushes(), 0u);
+  BOOST_CHECK_EQUAL(full.GetNumOfFallbacks(), 0u);
+  BOOST_CHECK(small.GetNumOfStates() <= 16);
+  BOOST_CHECK(small.GetNumOfFlushes() + small.GetNumOfFallbacks() > 0);
+  BOOST_CHECK(tiny.GetNumOfStates() <= LazyDfa::kMinStates);
+  BOOST_CHECK(tiny.GetNumOfFallbacks() > 0);
+}
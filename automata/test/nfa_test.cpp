@@ -0,0 +1,217 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  NFA determinization and DFA minimization unit test.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+#include <boost/make_shared.hpp>
+
+#include "nfa.h"
+#include "nfa_operations.h"
+#include "trie.h"
+#include "flex_transitions.h"
+#include "frozen_transitions.h"
+#include "dfa_minimizer.h"
+#include "dawg.h"
+#include "test_random.h"
+#include "test_nfa.h"
+
+namespace {
+
+namespace sa = strutext::automata;
+namespace so = strutext::automata::operations;
+
+// Type definitions.
+typedef sa::Nfa<char, uint32_t>                                 NfaImpl;
+typedef NfaImpl::State                                          State;
+typedef sa::AttributeFsm<sa::FrozenTransitions<char>, uint32_t> FrozenDfa;
+typedef sa::Trie<sa::FlexTransitions<char>, uint32_t>           FlexTrie;
+
+// Shared NFA builders.
+using strutext::test::NewState;
+using strutext::test::AddWord;
+
+/// Build (a|b)*abb as Thompson construction does.
+NfaImpl::Ptr BuildAbbNfa() {
+  NfaImpl::Ptr nfa = boost::make_shared<NfaImpl>();
+  std::vector<State*> states;
+  for (size_t i = 0; i < 11; ++i) {
+    states.push_back(NewState(*nfa));
+  }
+  nfa->SetStartState(states[0]);
+  nfa->AddEpsilonTransition(states[0], states[1]);
+  nfa->AddEpsilonTransition(states[0], states[7]);
+  nfa->AddEpsilonTransition(states[1], states[2]);
+  nfa->AddEpsilonTransition(states[1], states[4]);
+  nfa->AddTransition(states[2], states[3], 'a');
+  nfa->AddTransition(states[4], states[5], 'b');
+  nfa->AddEpsilonTransition(states[3], states[6]);
+  nfa->AddEpsilonTransition(states[5], states[6]);
+  nfa->AddEpsilonTransition(states[6], states[1]);
+  nfa->AddEpsilonTransition(states[6], states[7]);
+  nfa->AddTransition(states[7], states[8], 'a');
+  nfa->AddTransition(states[8], states[9], 'b');
+  nfa->AddTransition(states[9], states[10], 'b');
+  nfa->AddToAcceptedSet(states[10]);
+  nfa->AddAttrToAcceptedStates(7);
+  return nfa;
+}
+
+/// Attributes of the text found by the NFA simulation, empty if the text is not accepted.
+std::set<uint32_t> SimulateNfa(const NfaImpl& nfa, const std::string& text, bool& accepted) {
+  std::set<State*> states;
+  so::utils::EpsilonClosure<char, uint32_t>(nfa.GetStartState(), states);
+  for (size_t i = 0; i < text.size(); ++i) {
+    std::set<State*> next;
+    so::utils::Move<char, uint32_t>(states, NfaImpl::Symbol(text[i]), next);
+    states.swap(next);
+  }
+  accepted = false;
+  std::set<uint32_t> attrs;
+  for (std::set<State*>::const_iterator st_it = states.begin(); st_it != states.end(); ++st_it) {
+    if (nfa.GetAcceptedStates().count(*st_it)) {
+      accepted = true;
+      attrs.insert((*st_it)->attr_list_.begin(), (*st_it)->attr_list_.end());
+    }
+  }
+  return accepted ? attrs : std::set<uint32_t>();
+}
+
+/// Attributes of the text found by the DFA.
+std::set<uint32_t> SimulateDfa(const FrozenDfa& dfa, const std::string& text, bool& accepted) {
+  sa::StateId state = sa::kStartState;
+  for (size_t i = 0; i < text.size() and state != sa::kInvalidState; ++i) {
+    state = dfa.Go(state, text[i]);
+  }
+  accepted = state != sa::kInvalidState and dfa.IsAcceptable(state);
+  if (not accepted) {
+    return std::set<uint32_t>();
+  }
+  const FrozenDfa::AttributeList attrs = dfa.GetStateAttributes(state);
+  return std::set<uint32_t>(attrs.begin(), attrs.end());
+}
+
+/// Check the automata on all the texts over the alphabet up to the passed length.
+void CheckEquivalent(const NfaImpl& nfa, const FrozenDfa& dfa, const std::string& alphabet, size_t max_len) {
+  std::vector<std::string> texts(1, std::string());
+  for (size_t i = 0; i < texts.size(); ++i) {
+    bool nfa_accepted = false, dfa_accepted = false;
+    const std::set<uint32_t> nfa_attrs = SimulateNfa(nfa, texts[i], nfa_accepted);
+    const std::set<uint32_t> dfa_attrs = SimulateDfa(dfa, texts[i], dfa_accepted);
+    BOOST_CHECK_EQUAL(nfa_accepted, dfa_accepted);
+    BOOST_CHECK(nfa_attrs == dfa_attrs);
+    if (texts[i].size() < max_len) {
+      for (size_t j = 0; j < alphabet.size(); ++j) {
+        texts.push_back(texts[i] + alphabet[j]);
+      }
+    }
+  }
+}
+
+} // namespace.
+
+// The classical example: (a|b)*abb.
+BOOST_AUTO_TEST_CASE(Automata_Nfa_Minimal) {
+  const NfaImpl::Ptr nfa = BuildAbbNfa();
+  FrozenDfa dfa;
+  so::BuildDfa<char, uint32_t>(nfa, dfa);
+  // Invalid state and 4 states of the minimal automaton.
+  BOOST_CHECK_EQUAL(dfa.GetNumOfStates(), 5u);
+  CheckEquivalent(*nfa, dfa, "abc", 8);
+
+  // The subset construction gives 5 states.
+  const NfaImpl::Ptr subset_dfa = so::TransformToDfa<char, uint32_t>(nfa);
+  BOOST_CHECK_EQUAL(subset_dfa->GetStates().size(), 5u);
+  for (NfaImpl::StateStorage::const_iterator st_it = subset_dfa->GetStates().begin();
+        st_it != subset_dfa->GetStates().end(); ++st_it) {
+    std::set<NfaImpl::Symbol> symbols;
+    for (State::TransTable::const_iterator it = (*st_it)->trans_table_.begin(); it != (*st_it)->trans_table_.end(); ++it) {
+      BOOST_CHECK(it->first.type_ == NfaImpl::Symbol::SYMBOL_MT);
+      BOOST_CHECK(symbols.insert(it->first).second);
+    }
+  }
+  FrozenDfa minimal;
+  so::BuildDfa<char, uint32_t>(subset_dfa, minimal);
+  BOOST_CHECK_EQUAL(minimal.GetNumOfStates(), 5u);
+  CheckEquivalent(*subset_dfa, minimal, "abc", 8);
+}
+
+// Attributes of different patterns are not merged.
+BOOST_AUTO_TEST_CASE(Automata_Nfa_Attributes) {
+  NfaImpl::Ptr nfa = boost::make_shared<NfaImpl>();
+  nfa->SetStartState(NewState(*nfa));
+  AddWord(*nfa, "ab", 1);
+  AddWord(*nfa, "cb", 2);
+  AddWord(*nfa, "db", 1);
+  AddWord(*nfa, "abc", 3);
+  AddWord(*nfa, "ab", 4);
+  FrozenDfa dfa;
+  so::BuildDfa<char, uint32_t>(nfa, dfa);
+  CheckEquivalent(*nfa, dfa, "abcd", 4);
+  // Invalid, start, "a", "c", "d", "ab", "abc", "cb" and "db" states: "c" and "d" lead to different attributes.
+  BOOST_CHECK_EQUAL(dfa.GetNumOfStates(), 9u);
+
+  // The empty language.
+  NfaImpl::Ptr empty = boost::make_shared<NfaImpl>();
+  State* start = NewState(*empty);
+  empty->SetStartState(start);
+  empty->AddTransition(start, NewState(*empty), 'a');
+  so::BuildDfa<char, uint32_t>(empty, dfa);
+  BOOST_CHECK_EQUAL(dfa.GetNumOfStates(), 2u);
+  BOOST_CHECK_EQUAL(dfa.Go(sa::kStartState, 'a'), sa::kInvalidState);
+  BOOST_CHECK(not dfa.IsAcceptable(sa::kStartState));
+}
+
+// The minimal automaton of a word list is the minimal acyclic automaton.
+BOOST_AUTO_TEST_CASE(Automata_Nfa_Words) {
+  std::vector<std::string> words;
+  strutext::test::Random random;
+  for (size_t i = 0; i < 400; ++i) {
+    words.push_back(random.GenerateText(1 + random.Next(7), "abcde"));
+  }
+  std::sort(words.begin(), words.end());
+  words.erase(std::unique(words.begin(), words.end()), words.end());
+
+  NfaImpl::Ptr nfa = boost::make_shared<NfaImpl>();
+  nfa->SetStartState(NewState(*nfa));
+  FlexTrie trie;
+  sa::DawgBuilder<char, uint32_t> builder;
+  for (size_t i = 0; i < words.size(); ++i) {
+    AddWord(*nfa, words[i], 0);
+    trie.AddAttribute(trie.AddChain(words[i].begin(), words[i].end()), 0);
+    builder.Add(words[i].begin(), words[i].end(), uint32_t(0));
+  }
+  sa::Dawg<char, uint32_t> dawg;
+  builder.Build(dawg);
+
+  FrozenDfa dfa;
+  so::BuildDfa<char, uint32_t>(nfa, dfa);
+  BOOST_CHECK_EQUAL(dfa.GetNumOfStates(), dawg.GetNumOfStates());
+  CheckEquivalent(*nfa, dfa, "abcdef", 5);
+
+  // The trie minimization gives the same automaton.
+  FrozenDfa minimal_trie;
+  sa::MinimizeDfa(trie, minimal_trie);
+  BOOST_CHECK_EQUAL(minimal_trie.GetNumOfStates(), dawg.GetNumOfStates());
+  CheckEquivalent(*nfa, minimal_trie, "abcdef", 5);
+}
@@ -0,0 +1,243 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Regular expression parser and scanner unit test.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/regex.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include "regex_scanner.h"
+#include "test_random.h"
+
+namespace {
+
+namespace sa = strutext::automata;
+
+typedef sa::RegexScanner           Scanner;
+typedef Scanner::MatchList         MatchList;
+typedef std::pair<size_t, uint32_t> MatchPair;
+
+/// Does the pattern match the whole text?
+bool FullMatch(const std::string& pattern, const std::string& text) {
+  Scanner scanner;
+  scanner.AddRule("^(?:" + pattern + ")$", 1);
+  scanner.Compile();
+  MatchList matches;
+  scanner.ScanUtf8(text, matches);
+  return matches.size() == 1 and matches[0].end_ == text.size() and matches[0].id_ == 1;
+}
+
+/// Does the pattern cause syntax error?
+bool IsInvalid(const std::string& pattern) {
+  Scanner scanner;
+  try {
+    scanner.AddRule(pattern, 1);
+  } catch (const std::invalid_argument&) {
+    return true;
+  }
+  return false;
+}
+
+/// Get the matches as pairs of end and rule.
+std::set<MatchPair> GetMatches(const Scanner& scanner, const std::string& text) {
+  MatchList matches;
+  scanner.ScanUtf8(text, matches);
+  std::set<MatchPair> result;
+  for (size_t i = 0; i < matches.size(); ++i) {
+    result.insert(MatchPair(matches[i].end_, matches[i].id_));
+  }
+  return result;
+}
+
+} // namespace.
+
+// Regular expression syntax.
+BOOST_AUTO_TEST_CASE(Automata_Regex_Syntax) {
+  BOOST_CHECK(FullMatch("abc", "abc"));
+  BOOST_CHECK(not FullMatch("abc", "abcd"));
+  BOOST_CHECK(FullMatch("a|bc|", ""));
+  BOOST_CHECK(FullMatch("a|bc", "bc"));
+  BOOST_CHECK(not FullMatch("a|bc", "ab"));
+  BOOST_CHECK(FullMatch("(ab)*c", "ababc"));
+  BOOST_CHECK(FullMatch("(?:ab)+c?", "abab"));
+  BOOST_CHECK(not FullMatch("(ab)+", ""));
+  BOOST_CHECK(FullMatch("a{3}", "aaa"));
+  BOOST_CHECK(not FullMatch("a{3}", "aa"));
+  BOOST_CHECK(FullMatch("a{2,}", "aaaaa"));
+  BOOST_CHECK(not FullMatch("a{2,}", "a"));
+  BOOST_CHECK(FullMatch("(ab){1,2}", "abab"));
+  BOOST_CHECK(not FullMatch("(ab){1,2}", "ababab"));
+  BOOST_CHECK(FullMatch("a{0}b", "b"));
+  BOOST_CHECK(FullMatch("x.y", "x\xD1\x8Fy"));
+  BOOST_CHECK(not FullMatch("x.y", "x\ny"));
+  BOOST_CHECK(FullMatch("[a-c]+[^a-c]", "abcd"));
+  BOOST_CHECK(not FullMatch("[^a-c]", "b"));
+  BOOST_CHECK(FullMatch("[]a]+", "]a]"));
+  BOOST_CHECK(FullMatch("[a-]+", "-a"));
+  BOOST_CHECK(FullMatch("\\d+\\.\\d+", "3.14"));
+  BOOST_CHECK(FullMatch("\\w+\\s\\W", "a_1\t+"));
+  BOOST_CHECK(not FullMatch("\\D", "5"));
+  BOOST_CHECK(FullMatch("[\\d\\s]+", "1 2"));
+  BOOST_CHECK(FullMatch("\\x41\\u0042\\x{430}\\t", "AB\xD0\xB0\t"));
+  BOOST_CHECK(FullMatch("\\*\\(\\)\\[\\{\\|\\\\\\$\\^", "*()[{|\\$^"));
+
+  // Unicode categories.
+  BOOST_CHECK(FullMatch("\\p{Lu}\\p{Ll}+", "\xD0\x9C\xD0\xB8\xD1\x80"));
+  BOOST_CHECK(not FullMatch("\\p{Lu}\\p{Ll}+", "\xD0\xBC\xD0\xB8\xD1\x80"));
+  BOOST_CHECK(FullMatch("\\p{L}+\\p{N}\\p{P}", "Word\xD1\x81\xD0\xBB\xD0\xBE\xD0\xB2\xD0\xBE" "5!"));
+  BOOST_CHECK(FullMatch("\\P{L}+", "12 ,"));
+  BOOST_CHECK(not FullMatch("\\P{L}", "z"));
+  BOOST_CHECK(FullMatch("[\\p{Lu}\\d]+", "A1B2"));
+  BOOST_CHECK(FullMatch("[\xD0\xB0-\xD1\x8F]+", "\xD1\x81\xD0\xBB\xD0\xBE\xD0\xB2\xD0\xBE"));
+}
+
+// Syntax errors.
+BOOST_AUTO_TEST_CASE(Automata_Regex_Errors) {
+  BOOST_CHECK(IsInvalid("(ab"));
+  BOOST_CHECK(IsInvalid("ab)"));
+  BOOST_CHECK(IsInvalid("[ab"));
+  BOOST_CHECK(IsInvalid("*a"));
+  BOOST_CHECK(IsInvalid("a|+"));
+  BOOST_CHECK(IsInvalid("a{3,2}"));
+  BOOST_CHECK(IsInvalid("a{x}"));
+  BOOST_CHECK(IsInvalid("a{1001}"));
+  BOOST_CHECK(IsInvalid("((a{1000}){1000}){1000}"));
+  BOOST_CHECK(IsInvalid("(a{1000}|b{1000}){100}"));
+  BOOST_CHECK(not IsInvalid("(a{100}){1000}"));
+  BOOST_CHECK(IsInvalid("[z-a]"));
+  BOOST_CHECK(IsInvalid("[a-\\d]"));
+  BOOST_CHECK(IsInvalid("\\q"));
+  BOOST_CHECK(IsInvalid("\\p{Xx}"));
+  BOOST_CHECK(IsInvalid("\\x{110000}"));
+  BOOST_CHECK(IsInvalid("\\x4"));
+  BOOST_CHECK(IsInvalid("(?=a)"));
+  BOOST_CHECK(IsInvalid("a\\"));
+  BOOST_CHECK(IsInvalid("\xD0"));
+  BOOST_CHECK(not IsInvalid(""));
+  BOOST_CHECK(not IsInvalid("a{2,3}"));
+}
+
+// Search of several rules.
+BOOST_AUTO_TEST_CASE(Automata_Regex_Scanner) {
+  Scanner scanner;
+  MatchList matches;
+  BOOST_CHECK_THROW(scanner.ScanUtf8("abc", matches), std::runtime_error);
+  scanner.Compile();
+  BOOST_CHECK_EQUAL(scanner.ScanUtf8("abc", matches), 0u);
+
+  scanner.AddRule("[0-9]+", 1);
+  scanner.AddRule("\\p{L}+", 2);
+  scanner.AddRule("^\\p{L}", 3);
+  scanner.AddRule("\\d$", 4);
+  scanner.AddRule("\xD0\xB4\xD0\xB0", 5);
+  scanner.Compile();
+  BOOST_CHECK(scanner.IsCompiled());
+
+  // "да 12": letters end at 1 and 2 bytes... the offsets are in bytes.
+  const std::string text = "\xD0\xB4\xD0\xB0 12";
+  std::set<MatchPair> expected;
+  expected.insert(MatchPair(2, 2));
+  expected.insert(MatchPair(2, 3));
+  expected.insert(MatchPair(4, 2));
+  expected.insert(MatchPair(4, 5));
+  expected.insert(MatchPair(6, 1));
+  expected.insert(MatchPair(7, 1));
+  expected.insert(MatchPair(7, 4));
+  BOOST_CHECK(GetMatches(scanner, text) == expected);
+
+  // The same text as symbols, the offsets are in symbols.
+  std::vector<uint32_t> symbols;
+  symbols.push_back(0x434);
+  symbols.push_back(0x430);
+  symbols.push_back(' ');
+  symbols.push_back('1');
+  symbols.push_back('2');
+  scanner.Scan(symbols.begin(), symbols.end(), matches);
+  BOOST_CHECK_EQUAL(matches.size(), 7u);
+  BOOST_CHECK_EQUAL(matches.front().end_, 1u);
+  BOOST_CHECK_EQUAL(matches.back().end_, 5u);
+
+  // Anchored rules are found at the text bounds only.
+  BOOST_CHECK(GetMatches(scanner, "1a").count(MatchPair(2, 3)) == 0);
+  BOOST_CHECK(GetMatches(scanner, "1a").count(MatchPair(1, 4)) == 0);
+}
+
+// The rules matched at the text end are reported once.
+BOOST_AUTO_TEST_CASE(Automata_Regex_TextEnd) {
+  Scanner star;
+  star.AddRule("x*", 1);
+  star.Compile();
+  MatchList matches;
+  BOOST_REQUIRE_EQUAL(star.ScanUtf8("ab", matches), 3u);
+  for (size_t i = 0; i < matches.size(); ++i) {
+    BOOST_CHECK_EQUAL(matches[i].end_, i);
+    BOOST_CHECK_EQUAL(matches[i].id_, 1u);
+  }
+  const std::vector<uint32_t> symbols(2, 'a');
+  BOOST_CHECK_EQUAL(star.Scan(symbols.begin(), symbols.end(), matches), 3u);
+  BOOST_CHECK_EQUAL(star.ScanUtf8("", matches), 1u);
+
+  Scanner alt;
+  alt.AddRule("a|$", 1);
+  alt.Compile();
+  BOOST_REQUIRE_EQUAL(alt.ScanUtf8("ba", matches), 1u);
+  BOOST_CHECK_EQUAL(matches[0].end_, 2u);
+  BOOST_CHECK_EQUAL(matches[0].id_, 1u);
+  BOOST_REQUIRE_EQUAL(alt.Scan(symbols.begin(), symbols.end(), matches), 2u);
+  BOOST_CHECK_EQUAL(matches[0].end_, 1u);
+  BOOST_CHECK_EQUAL(matches[1].end_, 2u);
+  BOOST_REQUIRE_EQUAL(alt.ScanUtf8("ab", matches), 2u);
+  BOOST_CHECK_EQUAL(matches[0].end_, 1u);
+  BOOST_CHECK_EQUAL(matches[1].end_, 2u);
+}
+
+// The matches are the ends of all the substrings matched by the rules.
+BOOST_AUTO_TEST_CASE(Automata_Regex_Matches) {
+  const char* rules[] = {"ab+c", "[0-9]{2,3}", "a|bc", "(ab)*c", "x.?y", "[^a-c]d", "(a|b)*abb"};
+  const size_t num_of_rules = sizeof(rules) / sizeof(rules[0]);
+  Scanner scanner;
+  std::vector<boost::regex> regexes;
+  for (size_t i = 0; i < num_of_rules; ++i) {
+    scanner.AddRule(rules[i], i);
+    regexes.push_back(boost::regex(rules[i]));
+  }
+  scanner.Compile();
+
+  const std::string alphabet = "abcdxy01 ";
+  strutext::test::Random random;
+  for (size_t n = 0; n < 200; ++n) {
+    const std::string text = random.GenerateText(random.Next(12), alphabet);
+    std::set<MatchPair> expected;
+    for (size_t end = 0; end <= text.size(); ++end) {
+      for (size_t begin = 0; begin <= end; ++begin) {
+        for (size_t i = 0; i < num_of_rules; ++i) {
+          if (boost::regex_match(text.begin() + begin, text.begin() + end, regexes[i])) {
+            expected.insert(MatchPair(end, i));
+          }
+        }
+      }
+    }
+    BOOST_CHECK(GetMatches(scanner, text) == expected);
+  }
+}
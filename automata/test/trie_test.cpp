@@ -104,3 +104,41 @@ BOOST_AUTO_TEST_CASE(Automata_Trie_Serialize) {
   BOOST_CHECK(TrieUtils::CheckCnainInTrie("hello", 1, trie1));
   BOOST_CHECK(TrieUtils::CheckCnainInTrie("bye", 2, trie1));
 }
+
+// Pooled attributes test.
+BOOST_AUTO_TEST_CASE(Automata_Trie_PooledAttributes) {
+  FlexTrie trie;
+  TrieUtils::AddChainToTrie("hello", 1, trie);
+  TrieUtils::AddChainToTrie("hello", 3, trie);
+  TrieUtils::AddChainToTrie("bye", 2, trie);
+  BOOST_CHECK(not trie.IsAttributesPooled());
+
+  // The attributes are the same in the pool.
+  trie.FreezeAttributes();
+  BOOST_CHECK(trie.IsAttributesPooled());
+  BOOST_CHECK(trie.states_attr_.empty());
+  BOOST_CHECK_EQUAL(trie.attrs_.size(), 3u);
+  BOOST_CHECK(TrieUtils::CheckCnainInTrie("hello", 1, trie));
+  BOOST_CHECK(TrieUtils::CheckCnainInTrie("hello", 3, trie));
+  BOOST_CHECK(TrieUtils::CheckCnainInTrie("bye", 2, trie));
+  BOOST_CHECK(trie.GetStateAttributes(strutext::automata::kStartState).empty());
+
+  // Serialization keeps the format, deserialized attributes are pooled.
+  std::stringstream ss;
+  Serializer::Serialize(trie, ss);
+  FlexTrie trie1;
+  Serializer::Deserialize(trie1, ss);
+  BOOST_CHECK(trie1.IsAttributesPooled());
+  BOOST_CHECK(TrieUtils::CheckCnainInTrie("hello", 3, trie1));
+  BOOST_CHECK(TrieUtils::CheckCnainInTrie("bye", 2, trie1));
+
+  // New states keep pooled form, new attributes return the vector per state form.
+  const std::string chain = "byebye";
+  trie1.AddChain(chain.begin(), chain.end());
+  BOOST_CHECK(trie1.IsAttributesPooled());
+  TrieUtils::AddChainToTrie("hell", 4, trie1);
+  BOOST_CHECK(not trie1.IsAttributesPooled());
+  BOOST_CHECK(TrieUtils::CheckCnainInTrie("hello", 1, trie1));
+  BOOST_CHECK(TrieUtils::CheckCnainInTrie("hell", 4, trie1));
+  BOOST_CHECK(trie1.Search(chain.begin(), chain.end()).empty());
+}
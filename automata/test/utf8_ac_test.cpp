@@ -0,0 +1,107 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  UTF-8 Aho-Corasick scanner unit test.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+#include "utf8_ac.h"
+#include "flex_transitions.h"
+#include "utf8_iterator.h"
+
+namespace {
+
+namespace sa = strutext::automata;
+
+// Type definitions.
+typedef sa::Utf8AcScanner<uint64_t>                                      Scanner;
+typedef sa::Utf8AcScanner<uint64_t, sa::FlexTransitions<uint8_t> >       FlexScanner;
+typedef strutext::encode::Utf8Iterator<std::string::const_iterator>     Utf8Iterator;
+
+// Add UTF-8 chain to the scanner.
+template <class ScannerImpl>
+void AddChain(const std::string& chain, uint64_t id, ScannerImpl& scanner) {
+  std::vector<uint32_t> symbols;
+  for (Utf8Iterator it(chain.begin(), chain.end()); it != Utf8Iterator(); ++it) {
+    symbols.push_back(*it);
+  }
+  scanner.AddChain(symbols.begin(), symbols.end(), id);
+}
+
+}  // namespace.
+
+BOOST_AUTO_TEST_CASE(Automata_Utf8Ac_Search) {
+  Scanner scanner;
+  AddChain("мама", 1, scanner);
+  AddChain("рама", 2, scanner);
+  AddChain("ама", 3, scanner);
+  AddChain("mother", 4, scanner);
+  scanner.Compile();
+
+  // "мама мыла раму mother": Cyrillic letters take 2 bytes.
+  const std::string text = "мама мыла раму mother";
+  Scanner::MatchList matches;
+  BOOST_CHECK_EQUAL(scanner.Scan(text, matches), 3u);
+  BOOST_REQUIRE_EQUAL(matches.size(), 3u);
+  // Matches are ordered by their ends, the longest one first at the same end.
+  BOOST_CHECK_EQUAL(matches[0].id_, 1u);
+  BOOST_CHECK_EQUAL(matches[0].begin_, 0u);
+  BOOST_CHECK_EQUAL(matches[0].end_, 8u);
+  BOOST_CHECK_EQUAL(matches[1].id_, 3u);
+  BOOST_CHECK_EQUAL(matches[1].begin_, 2u);
+  BOOST_CHECK_EQUAL(matches[1].end_, 8u);
+  BOOST_CHECK_EQUAL(matches[2].id_, 4u);
+  BOOST_CHECK_EQUAL(text.substr(matches[2].begin_, matches[2].end_ - matches[2].begin_), "mother");
+
+  // Chains are case sensitive by default.
+  BOOST_CHECK_EQUAL(scanner.Scan(std::string("МАМА"), matches), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(Automata_Utf8Ac_FoldCase) {
+  FlexScanner scanner(true);
+  AddChain("Москва", 1, scanner);
+  AddChain("river", 2, scanner);
+  scanner.Compile();
+
+  const std::string text = "МОСКВА, москва, Москва; River RIVER river rIVER";
+  FlexScanner::MatchList matches;
+  scanner.Scan(text, matches);
+  BOOST_REQUIRE_EQUAL(matches.size(), 6u);
+  for (size_t i = 0; i < 3; ++i) {
+    BOOST_CHECK_EQUAL(matches[i].id_, 1u);
+    BOOST_CHECK_EQUAL(matches[i].end_ - matches[i].begin_, 12u);
+  }
+  for (size_t i = 3; i < 6; ++i) {
+    BOOST_CHECK_EQUAL(matches[i].id_, 2u);
+    BOOST_CHECK_EQUAL(matches[i].end_ - matches[i].begin_, 5u);
+  }
+  BOOST_CHECK_EQUAL(text.substr(matches[1].begin_, 12), "москва");
+}
+
+BOOST_AUTO_TEST_CASE(Automata_Utf8Ac_NotCompiled) {
+  Scanner scanner;
+  AddChain("abc", 1, scanner);
+  Scanner::MatchList matches;
+  BOOST_CHECK_THROW(scanner.Scan(std::string("abc"), matches), std::runtime_error);
+  scanner.Compile();
+  BOOST_CHECK_EQUAL(scanner.Scan(std::string("xabcx"), matches), 1u);
+  BOOST_CHECK_EQUAL(matches[0].begin_, 1u);
+}
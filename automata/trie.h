@@ -96,7 +96,7 @@ struct Trie : public AttributeFsm<Trans, Attribute> {
    * \result      The reference to the list of attributes of the chain if any.
    */
   template <typename SymbolIterator>
-  const typename AttributeFsmImpl::AttributeList& Search(SymbolIterator begin, SymbolIterator end) const {
+  typename AttributeFsmImpl::AttributeList Search(SymbolIterator begin, SymbolIterator end) const {
     StateId state = kStartState;
     for (SymbolIterator it = begin; state !=  kInvalidState and it != end; ++it) {
       state = AttributeFsmImpl::Go(state, *it);
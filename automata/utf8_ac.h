@@ -0,0 +1,214 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Aho-Corasick search over UTF-8 bytes without decoding.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <iterator>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "symbols.h"
+#include "utf8_generator.h"
+
+#include "flat_transitions.h"
+#include "aho_corasick.h"
+#include "ac_dfa.h"
+
+namespace strutext { namespace automata {
+
+/**
+ * \brief Aho-Corasick search of Unicode chains in UTF-8 texts.
+ *
+ * Chains are added as UTF-32 symbol sequences and are put to the trie as their UTF-8 bytes.
+ * The trie is compiled into AcDfa over bytes, so the text is scanned byte by byte and no UTF-8
+ * decoding is done. UTF-8 is self-synchronizing, so a chain is never found from the middle
+ * of a symbol sequence. Found chains are reported by byte offsets in the text.
+ *
+ * If case folding is on, lower case, upper case and capitalized variants of each chain are added
+ * (symbols::ToLower and symbols::ToUpper are used). Mixed case forms like "wOrD" are not found,
+ * the case of such texts must be folded before the scan.
+ *
+ * Template parameters:
+ *   Attribute: the chain identifier type.
+ *   TransImpl: the move table of the byte trie the automaton is built from.
+ */
+template <typename Attribute, class TransImpl = FlatTransitions<uint8_t, 256> >
+class Utf8AcScanner {
+public:
+  /// Chain identifier type.
+  typedef Attribute ChainId;
+
+  /// Chain found in the text.
+  struct Match {
+    /// Initialization.
+    Match(size_t begin, size_t end, const ChainId& id)
+      : begin_(begin)
+      , end_(end)
+      , id_(id) {}
+
+    size_t  begin_; ///< Offset of the first chain byte in the text.
+    size_t  end_;   ///< Offset of the byte after the chain.
+    ChainId id_;    ///< Chain identifier.
+  };
+
+  /// Type of match list.
+  typedef std::vector<Match> MatchList;
+
+  /**
+   * \brief Initialization.
+   *
+   * \param fold_case Add case variants of the chains.
+   */
+  explicit Utf8AcScanner(bool fold_case = false)
+    : fold_case_(fold_case)
+    , compiled_(false) {}
+
+  /**
+   * \brief Add chain of UTF-32 symbols.
+   *
+   * \param begin Iterator of the chain begin.
+   * \param end   Iterator of the chain end.
+   * \param id    Chain identifier.
+   */
+  template <typename Utf32Iterator>
+  void AddChain(Utf32Iterator begin, Utf32Iterator end, const ChainId& id);
+
+  /// Build the automaton, it must be called after the chains are added and before the search.
+  void Compile() {
+    dfa_.Compile(trie_);
+    compiled_ = true;
+  }
+
+  /// Get the compiled automaton, its attributes are the chain variant numbers.
+  const AcDfa<uint8_t, uint32_t>& GetDfa() const { return dfa_; }
+
+  /**
+   * \brief Move by the text byte.
+   *
+   * \param  from State to move from.
+   * \param  byte Byte to move by.
+   * \return      State to move to.
+   */
+  StateId Move(const StateId& from, char byte) const {
+    return dfa_.Move(from, static_cast<uint8_t>(byte));
+  }
+
+  /**
+   * \brief Search all chains in the text.
+   *
+   * \param      begin   Begin of the text in UTF-8.
+   * \param      end     End of the text.
+   * \param[out] matches Found chains, in order of their ends.
+   * \return             Number of found chains.
+   */
+  size_t Scan(const char* begin, const char* end, MatchList& matches) const;
+
+  /// Search all chains in the text.
+  size_t Scan(const std::string& text, MatchList& matches) const {
+    return Scan(text.data(), text.data() + text.size(), matches);
+  }
+
+private:
+  /// Chain variant.
+  struct Variant {
+    /// Initialization.
+    Variant(const ChainId& id, size_t len)
+      : id_(id)
+      , len_(len) {}
+
+    ChainId id_;  ///< Identifier of the chain.
+    size_t  len_; ///< Length of the variant in bytes.
+  };
+
+  /// Add the chain in UTF-8 as variant.
+  void AddVariant(const std::string& chain, const ChainId& id);
+
+  AhoCorasickTrie<TransImpl, uint32_t> trie_;      ///< Trie of the UTF-8 chains, attributes are variant numbers.
+  AcDfa<uint8_t, uint32_t>             dfa_;       ///< Compiled automaton.
+  std::vector<Variant>                 variants_;  ///< Added chain variants.
+  bool                                 fold_case_; ///< Are case variants added?
+  bool                                 compiled_;  ///< Is the automaton compiled?
+};
+
+template <typename Attribute, class TransImpl>
+template <typename Utf32Iterator>
+void Utf8AcScanner<Attribute, TransImpl>::AddChain(Utf32Iterator begin, Utf32Iterator end, const ChainId& id) {
+  const std::vector<symbols::SymbolCode> chain(begin, end);
+  std::set<std::string> chains;
+  std::string utf8;
+  encode::GetUtf8Sequence(chain.begin(), chain.end(), std::back_inserter(utf8));
+  chains.insert(utf8);
+  if (fold_case_ and not chain.empty()) {
+    std::vector<symbols::SymbolCode> lower(chain.size()), upper(chain.size());
+    for (size_t i = 0; i < chain.size(); ++i) {
+      lower[i] = symbols::ToLower(chain[i]);
+      upper[i] = symbols::ToUpper(chain[i]);
+    }
+    utf8.clear();
+    encode::GetUtf8Sequence(lower.begin(), lower.end(), std::back_inserter(utf8));
+    chains.insert(utf8);
+    utf8.clear();
+    encode::GetUtf8Sequence(upper.begin(), upper.end(), std::back_inserter(utf8));
+    chains.insert(utf8);
+    // Capitalized: the first symbol in upper case.
+    lower[0] = upper[0];
+    utf8.clear();
+    encode::GetUtf8Sequence(lower.begin(), lower.end(), std::back_inserter(utf8));
+    chains.insert(utf8);
+  }
+  for (std::set<std::string>::const_iterator it = chains.begin(); it != chains.end(); ++it) {
+    AddVariant(*it, id);
+  }
+  compiled_ = false;
+}
+
+template <typename Attribute, class TransImpl>
+void Utf8AcScanner<Attribute, TransImpl>::AddVariant(const std::string& chain, const ChainId& id) {
+  // Empty chain is found everywhere, so it is not added.
+  if (chain.empty()) {
+    return;
+  }
+  const std::vector<uint8_t> bytes(chain.begin(), chain.end());
+  trie_.AddChain(bytes.begin(), bytes.end(), static_cast<uint32_t>(variants_.size()));
+  variants_.push_back(Variant(id, chain.size()));
+}
+
+template <typename Attribute, class TransImpl>
+size_t Utf8AcScanner<Attribute, TransImpl>::Scan(const char* begin, const char* end, MatchList& matches) const {
+  if (not compiled_) {
+    throw std::runtime_error("Utf8AcScanner: the automaton is not compiled");
+  }
+  matches.clear();
+  StateId state = kStartState;
+  for (const char* pos = begin; pos != end; ++pos) {
+    state = dfa_.Move(state, static_cast<uint8_t>(*pos));
+    const typename AcDfa<uint8_t, uint32_t>::AttributeList attrs = dfa_.GetStateAttributes(state);
+    const size_t match_end = pos - begin + 1;
+    for (size_t i = 0; i < attrs.size(); ++i) {
+      const Variant& variant = variants_[attrs[i]];
+      matches.push_back(Match(match_end - variant.len_, match_end, variant.id_));
+    }
+  }
+  return matches.size();
+}
+
+}} // namespace strutext, automata.
@@ -0,0 +1,118 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Single byte encodings transcoding benchmark.
+ * \author Vladimir Lapshin.
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "char_iterator.h"
+#include "char_unicode32_decoder.h"
+#include "char_transcoder.h"
+#include "utf8_generator.h"
+#include "test_random.h"
+#include "timer.h"
+
+namespace {
+
+namespace enc = strutext::encode;
+namespace bench = strutext::bench;
+
+typedef enc::CharIterator<const char*, enc::Cp1251Decoder> Cp1251Iterator;
+
+/// Generate CP1251 text of Cyrillic words separated by spaces and punctuation.
+std::string GenerateText(size_t size) {
+  std::string text;
+  text.reserve(size);
+  strutext::test::Random random;
+  while (text.size() < size) {
+    const size_t word_len = 2 + random.Next(10);
+    for (size_t i = 0; i < word_len; ++i) {
+      text.push_back(static_cast<char>(0xE0 + random.Next(32)));
+    }
+    text.push_back(random.Next(8) ? ' ' : ',');
+  }
+  text.resize(size);
+  return text;
+}
+
+/// Simple checksum to prevent the compiler from throwing away the results.
+uint32_t Sum(const std::vector<uint32_t>& codes) {
+  uint32_t sum = 0;
+  for (size_t i = 0; i < codes.size(); ++i) {
+    sum += codes[i];
+  }
+  return sum;
+}
+
+} // namespace.
+
+int main(int argc, char* argv[]) {
+  const long size_arg = argc > 1 ? std::atol(argv[1]) : 64 * 1024 * 1024;
+  if (size_arg <= 0) {
+    std::cerr << "Usage: " << argv[0] << " [text size]\n";
+    return 1;
+  }
+  const size_t size = size_arg;
+  const std::string text = GenerateText(size);
+  const char* begin = text.data();
+  const char* end = begin + text.size();
+  std::cout << "SIMD level: " << enc::GetSimdLevel() << ", text size: " << size << " bytes\n";
+
+  std::vector<uint32_t> codes(size);
+  {
+    bench::Timer timer;
+    size_t i = 0;
+    for (Cp1251Iterator it(begin, end); it != Cp1251Iterator(); ++it) {
+      codes[i++] = *it;
+    }
+    bench::Report("CharIterator -> UTF-32", timer.Elapsed(), size, "B");
+  }
+  const uint32_t iterator_sum = Sum(codes);
+  {
+    bench::Timer timer;
+    enc::Transcode<enc::Cp1251Decoder>(begin, size, &codes[0]);
+    bench::Report("Transcode -> UTF-32", timer.Elapsed(), size, "B");
+  }
+  if (Sum(codes) != iterator_sum) {
+    std::cerr << "UTF-32 results differ\n";
+    return 1;
+  }
+
+  std::string iterator_utf8;
+  {
+    bench::Timer timer;
+    for (Cp1251Iterator it(begin, end); it != Cp1251Iterator(); ++it) {
+      enc::GetUtf8Sequence(*it, std::back_inserter(iterator_utf8));
+    }
+    bench::Report("CharIterator + GetUtf8Sequence -> UTF-8", timer.Elapsed(), size, "B");
+  }
+  std::string utf8;
+  {
+    bench::Timer timer;
+    enc::TranscodeToUtf8<enc::Cp1251Decoder>(begin, size, utf8);
+    bench::Report("TranscodeToUtf8 -> UTF-8", timer.Elapsed(), size, "B");
+  }
+  if (utf8 != iterator_utf8) {
+    std::cerr << "UTF-8 results differ\n";
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,188 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Bit-parallel matcher benchmark: against deterministic scanners on words and exploding rules.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+
+#include "nfa.h"
+#include "lazy_dfa.h"
+#include "glushkov_matcher.h"
+#include "regex_scanner.h"
+#include "test_random.h"
+#include "timer.h"
+
+namespace {
+
+namespace sa = strutext::automata;
+namespace se = strutext::encode;
+namespace bench = strutext::bench;
+
+typedef sa::Nfa<char, uint32_t>             NfaImpl;
+typedef NfaImpl::State                      State;
+typedef sa::LazyDfa<char, uint32_t>         LazyDfa;
+typedef sa::GlushkovMatcher<char, uint32_t> Matcher;
+
+/// Add new state to the NFA.
+State* NewState(NfaImpl& nfa) {
+  State::Ptr state = boost::make_shared<State>();
+  nfa.AddState(state);
+  return state.get();
+}
+
+/// Generate the word of Latin letters.
+std::string GenerateWord(strutext::test::Random& random) {
+  return random.GenerateText(4 + random.Next(5), "abcdefghijklmnopqrstuvwxyz");
+}
+
+/// Build the chain of the word symbols.
+void BuildWordNfa(const std::string& word, NfaImpl& nfa) {
+  State* state = NewState(nfa);
+  nfa.SetStartState(state);
+  for (size_t i = 0; i < word.size(); ++i) {
+    State* next = NewState(nfa);
+    nfa.AddTransition(state, next, word[i]);
+    state = next;
+  }
+  nfa.AddToAcceptedSet(state);
+}
+
+/// Build a(a|b){n}, with the search loop (a|b)* if it is requested.
+void BuildNthFromEndNfa(size_t n, bool search, NfaImpl& nfa) {
+  State* start = NewState(nfa);
+  nfa.SetStartState(start);
+  if (search) {
+    nfa.AddTransition(start, start, 'a');
+    nfa.AddTransition(start, start, 'b');
+  }
+  State* state = NewState(nfa);
+  nfa.AddTransition(start, state, 'a');
+  for (size_t i = 0; i < n; ++i) {
+    State* next = NewState(nfa);
+    nfa.AddTransition(state, next, 'a');
+    nfa.AddTransition(state, next, 'b');
+    state = next;
+  }
+  nfa.AddToAcceptedSet(state);
+}
+
+/// Scan the text by the matcher with each instruction set.
+void ScanMatcher(Matcher& matcher, const std::string& text) {
+  const se::SimdLevel levels[] = {se::SCALAR_SIMD_LEVEL, se::SSE2_SIMD_LEVEL, se::AVX2_SIMD_LEVEL};
+  const char* names[] = {"GlushkovMatcher, scalar", "GlushkovMatcher, SSE2", "GlushkovMatcher, AVX2"};
+  Matcher::MatchList matches;
+  for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); ++i) {
+    if (not se::IsSimdLevelSupported(levels[i])) {
+      continue;
+    }
+    matcher.SetSimdLevel(levels[i]);
+    bench::Timer timer;
+    matcher.Scan(text.begin(), text.end(), matches);
+    bench::Report(names[i], timer.Elapsed(), text.size(), "B");
+    std::cout << "  matches: " << matches.size() << "\n";
+  }
+}
+
+/// Search the words by the matcher and by the regular expression scanner.
+void BenchWords(size_t num_of_words, size_t text_size) {
+  strutext::test::Random random;
+  std::vector<std::string> words;
+  for (size_t i = 0; i < num_of_words; ++i) {
+    words.push_back(GenerateWord(random));
+  }
+  std::string text;
+  while (text.size() < text_size) {
+    text += random.Next(10) == 0 ? words[random.Next(words.size())] : GenerateWord(random);
+    text.push_back(' ');
+  }
+  std::cout << "Words: " << num_of_words << ", text: " << text.size() << " bytes\n";
+
+  bench::Timer timer;
+  Matcher matcher;
+  for (size_t i = 0; i < words.size(); ++i) {
+    NfaImpl nfa;
+    BuildWordNfa(words[i], nfa);
+    matcher.AddRule(nfa, i);
+  }
+  matcher.Compile();
+  bench::Report("GlushkovMatcher, compile", timer.Elapsed(), num_of_words, "rules");
+  std::cout << "  words: " << matcher.GetNumOfWords() << ", classes: " << matcher.GetNumOfClasses() << "\n";
+  ScanMatcher(matcher, text);
+
+  bench::Timer scanner_timer;
+  sa::RegexScanner scanner;
+  for (size_t i = 0; i < words.size(); ++i) {
+    scanner.AddRule(words[i], i);
+  }
+  scanner.Compile();
+  bench::Report("RegexScanner, compile", scanner_timer.Elapsed(), num_of_words, "rules");
+  std::cout << "  states: " << scanner.GetNumOfStates() << "\n";
+  sa::RegexScanner::MatchList matches;
+  bench::Timer scan_timer;
+  scanner.ScanUtf8(text, matches);
+  bench::Report("RegexScanner, all matches", scan_timer.Elapsed(), text.size(), "B");
+  std::cout << "  matches: " << matches.size() << "\n";
+}
+
+/// Search a(a|b){n}, its deterministic automaton has 2^(n+1) states.
+void BenchNthFromEnd(size_t n, size_t text_size) {
+  strutext::test::Random random;
+  std::string text;
+  for (size_t i = 0; i < text_size; ++i) {
+    text.push_back(random.Next(2) ? 'a' : 'b');
+  }
+  std::cout << "a(a|b){" << n << "}, 2^" << (n + 1) << " DFA states, text: " << text.size() << " bytes\n";
+
+  NfaImpl rule;
+  BuildNthFromEndNfa(n, false, rule);
+  Matcher matcher;
+  matcher.AddRule(rule, 0);
+  matcher.Compile();
+  ScanMatcher(matcher, text);
+
+  // The lazy automaton of the search loop reads the text once, as the matcher does.
+  NfaImpl search;
+  BuildNthFromEndNfa(n, true, search);
+  LazyDfa lazy(search);
+  LazyDfa::AttributeList attrs;
+  bench::Timer timer;
+  lazy.Match(text.begin(), text.end(), attrs);
+  bench::Report("LazyDfa, default cache", timer.Elapsed(), text.size(), "B");
+  std::cout << "  states: " << lazy.GetNumOfStates() << ", flushes: " << lazy.GetNumOfFlushes()
+            << ", NFA fallbacks: " << lazy.GetNumOfFallbacks() << "\n";
+}
+
+} // namespace.
+
+int main(int argc, char* argv[]) {
+  const size_t num_of_words = argc > 1 ? std::atoi(argv[1]) : 1000;
+  const size_t n = argc > 2 ? std::atoi(argv[2]) : 20;
+  const size_t text_size = argc > 3 ? std::atoi(argv[3]) : 1 << 22;
+  if (num_of_words == 0 or n + 1 > Matcher::kMaxPositions or text_size == 0) {
+    std::cerr << "Usage: " << argv[0] << " [number of words] [n of a(a|b){n}, at most 63] [text size]\n";
+    return 1;
+  }
+  BenchWords(num_of_words, text_size);
+  BenchNthFromEnd(n, text_size);
+  return 0;
+}
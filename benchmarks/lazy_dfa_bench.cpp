@@ -0,0 +1,167 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Lazy DFA benchmark: against full construction on word unions and on exponential automata.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+
+#include "nfa.h"
+#include "nfa_operations.h"
+#include "lazy_dfa.h"
+#include "test_random.h"
+#include "timer.h"
+
+namespace {
+
+namespace sa = strutext::automata;
+namespace bench = strutext::bench;
+
+typedef sa::Nfa<char, uint32_t>                                 NfaImpl;
+typedef NfaImpl::State                                          State;
+typedef sa::LazyDfa<char, uint32_t>                             LazyDfa;
+typedef sa::AttributeFsm<sa::FrozenTransitions<char>, uint32_t> FrozenDfa;
+
+/// Add new state to the NFA.
+State* NewState(NfaImpl& nfa) {
+  State::Ptr state = boost::make_shared<State>();
+  nfa.AddState(state);
+  return state.get();
+}
+
+/// Build the union of random words, each word is the chain from the start state.
+void BuildWordNfa(size_t num_of_words, strutext::test::Random& random, NfaImpl& nfa, std::vector<std::string>& words) {
+  nfa.SetStartState(NewState(nfa));
+  for (size_t i = 0; i < num_of_words; ++i) {
+    const std::string word = random.GenerateText(3 + random.Next(8), "abcdefghijklmnopqrstuvwxyz");
+    words.push_back(word);
+    State* state = NewState(nfa);
+    nfa.AddEpsilonTransition(nfa.GetStartState(), state);
+    for (size_t j = 0; j < word.size(); ++j) {
+      State* next = NewState(nfa);
+      nfa.AddTransition(state, next, word[j]);
+      state = next;
+    }
+    nfa.AddToAcceptedSet(state);
+    state->attr_list_.insert(i);
+  }
+}
+
+/// Build (a|b)*a(a|b){n}, its deterministic automaton has 2^(n+1) states.
+void BuildNthFromEndNfa(size_t n, NfaImpl& nfa) {
+  State* start = NewState(nfa);
+  nfa.SetStartState(start);
+  nfa.AddTransition(start, start, 'a');
+  nfa.AddTransition(start, start, 'b');
+  State* state = NewState(nfa);
+  nfa.AddTransition(start, state, 'a');
+  for (size_t i = 0; i < n; ++i) {
+    State* next = NewState(nfa);
+    nfa.AddTransition(state, next, 'a');
+    nfa.AddTransition(state, next, 'b');
+    state = next;
+  }
+  nfa.AddToAcceptedSet(state);
+}
+
+/// Match the texts by the lazy automaton, report the throughput.
+void MatchLazy(const std::string& name, LazyDfa& dfa, const std::vector<std::string>& texts, size_t volume) {
+  bench::Timer timer;
+  size_t num_of_matches = 0;
+  LazyDfa::AttributeList attrs;
+  for (size_t i = 0; i < texts.size(); ++i) {
+    num_of_matches += dfa.Match(texts[i].begin(), texts[i].end(), attrs) ? 1 : 0;
+  }
+  bench::Report(name, timer.Elapsed(), volume, "B");
+  std::cout << "  matches: " << num_of_matches << ", states: " << dfa.GetNumOfStates() << ", flushes: "
+            << dfa.GetNumOfFlushes() << ", NFA fallbacks: " << dfa.GetNumOfFallbacks() << "\n";
+}
+
+/// Compare full and lazy construction on the union of words.
+void BenchWords(size_t num_of_words) {
+  strutext::test::Random random;
+  NfaImpl::Ptr nfa = boost::make_shared<NfaImpl>();
+  std::vector<std::string> words;
+  BuildWordNfa(num_of_words, random, *nfa, words);
+  std::vector<std::string> texts;
+  size_t volume = 0;
+  for (size_t i = 0; i < 1000000; ++i) {
+    texts.push_back(words[random.Next(words.size())]);
+    if (random.Next(2)) {
+      texts.back()[random.Next(texts.back().size())] = 'a' + random.Next(26);
+    }
+    volume += texts.back().size();
+  }
+  std::cout << "Union of " << num_of_words << " words, " << texts.size() << " texts\n";
+
+  bench::Timer timer;
+  FrozenDfa dfa;
+  sa::operations::BuildDfa<char, uint32_t>(nfa, dfa);
+  bench::Report("Full DFA, construction", timer.Elapsed(), num_of_words, "words");
+  bench::Timer match_timer;
+  size_t num_of_matches = 0;
+  for (size_t i = 0; i < texts.size(); ++i) {
+    sa::StateId state = sa::kStartState;
+    for (size_t j = 0; j < texts[i].size() and state != sa::kInvalidState; ++j) {
+      state = dfa.Go(state, texts[i][j]);
+    }
+    num_of_matches += state != sa::kInvalidState and dfa.IsAcceptable(state) ? 1 : 0;
+  }
+  bench::Report("Full DFA, matching", match_timer.Elapsed(), volume, "B");
+  std::cout << "  matches: " << num_of_matches << ", states: " << dfa.GetNumOfStates() << "\n";
+
+  bench::Timer lazy_timer;
+  LazyDfa lazy(*nfa);
+  bench::Report("LazyDfa, construction", lazy_timer.Elapsed(), num_of_words, "words");
+  MatchLazy("LazyDfa, first matching", lazy, texts, volume);
+  MatchLazy("LazyDfa, second matching", lazy, texts, volume);
+}
+
+/// Lazy construction on the automaton of exponential number of states.
+void BenchNthFromEnd(size_t n) {
+  NfaImpl nfa;
+  BuildNthFromEndNfa(n, nfa);
+  strutext::test::Random random;
+  std::vector<std::string> texts(1, std::string());
+  for (size_t i = 0; i < (1 << 20); ++i) {
+    texts[0].push_back(random.Next(2) ? 'a' : 'b');
+  }
+  std::cout << "(a|b)*a(a|b){" << n << "}, " << (1u << (n + 1)) << " DFA states, text: " << texts[0].size() << " bytes\n";
+  LazyDfa lazy(nfa);
+  MatchLazy("LazyDfa, default cache", lazy, texts, texts[0].size());
+  LazyDfa large(nfa, 1 << 23);
+  MatchLazy("LazyDfa, cache of 8M states", large, texts, texts[0].size());
+}
+
+} // namespace.
+
+int main(int argc, char* argv[]) {
+  const size_t num_of_words = argc > 1 ? std::atoi(argv[1]) : 5000;
+  const size_t n = argc > 2 ? std::atoi(argv[2]) : 20;
+  if (num_of_words == 0) {
+    std::cerr << "Usage: " << argv[0] << " [number of words] [n of (a|b)*a(a|b){n}]\n";
+    return 1;
+  }
+  BenchWords(num_of_words);
+  BenchNthFromEnd(n);
+  return 0;
+}
@@ -0,0 +1,203 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Morphological analysis benchmark: speed and heap allocations per call.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <boost/atomic.hpp>
+#include <boost/thread/thread.hpp>
+
+#include "eng_alphabet.h"
+#include "morpho.h"
+#include "morpho_modifier.h"
+#include "mapped_morpho.h"
+#include "test_random.h"
+#include "timer.h"
+
+namespace {
+
+namespace m = strutext::morpho;
+namespace bench = strutext::bench;
+
+typedef m::Morphologist<m::EnglishAlphabet>       Morpher;
+typedef m::MappedMorphologist<m::EnglishAlphabet> MappedMorpher;
+
+/// Number of heap allocations made, the batch analysis allocates in several threads.
+boost::atomic<size_t> g_allocations(0);
+
+/// Generate random word.
+std::string GenerateWord(strutext::test::Random& random, size_t min_len, size_t max_len) {
+  return random.GenerateText(min_len + random.Next(max_len - min_len + 1), "abcdefghijklmnopqrstuvwxyz");
+}
+
+/// Number of suffix lines in the dictionary.
+const size_t kNumOfLines = 32;
+
+/// Number of suffixes in each line.
+const size_t kNumOfSuffixes = 8;
+
+/// Build synthetic dictionary and the list of words, some of them are unknown.
+void Generate(size_t num_of_bases, size_t num_of_words, Morpher& morpher, std::vector<std::string>& words) {
+  strutext::test::Random random;
+  std::vector<std::vector<std::string> > lines(kNumOfLines);
+  for (size_t line = 0; line < kNumOfLines; ++line) {
+    const uint32_t line_id = m::MorphoModifier::AddSuffixLine(morpher);
+    for (size_t i = 0; i < kNumOfSuffixes; ++i) {
+      const std::string suffix = i == 0 ? std::string() : GenerateWord(random, 1, 3);
+      lines[line].push_back(suffix);
+      m::MorphoModifier::AddSuffix(morpher, line_id, i + 1, suffix.begin(), suffix.end());
+    }
+  }
+  std::vector<std::pair<std::string, uint32_t> > bases;
+  for (size_t i = 0; i < num_of_bases; ++i) {
+    const std::string base = GenerateWord(random, 3, 9);
+    const uint32_t line_id = random.Next(kNumOfLines);
+    m::MorphoModifier::AddBase(morpher, i + 1, line_id, base.begin(), base.end(), base);
+    bases.push_back(std::make_pair(base, line_id));
+  }
+  for (size_t i = 0; i < num_of_words; ++i) {
+    if (random.Next(8) == 0) {
+      words.push_back(GenerateWord(random, 3, 12));
+    } else {
+      const std::pair<std::string, uint32_t>& base = bases[random.Next(bases.size())];
+      words.push_back(base.first + lines[base.second][random.Next(kNumOfSuffixes)]);
+    }
+  }
+}
+
+/// Print number of allocations per call.
+void ReportAllocations(size_t allocations, size_t calls) {
+  std::cout << "  heap allocations per call: " << static_cast<double>(allocations) / calls << "\n";
+}
+
+/// Measure the analysis by lemma buffer.
+template <class MorpherImpl>
+size_t AnalizeByBuffer(const MorpherImpl& morpher, const std::vector<std::string>& words, const std::string& name) {
+  m::MorphologistBase::LemmaBuffer buffer;
+  // Warm up: the buffer grows to the longest word.
+  for (size_t i = 0; i < words.size(); ++i) {
+    morpher.Analize(words[i].data(), words[i].data() + words[i].size(), buffer);
+  }
+  size_t num_of_lemmas = 0;
+  const size_t allocations = g_allocations;
+  bench::Timer timer;
+  for (size_t i = 0; i < words.size(); ++i) {
+    morpher.Analize(words[i].data(), words[i].data() + words[i].size(), buffer);
+    num_of_lemmas += buffer.Size();
+  }
+  bench::Report(name, timer.Elapsed(), words.size(), "words");
+  ReportAllocations(g_allocations - allocations, words.size());
+  return num_of_lemmas;
+}
+
+/// Measure the analysis by lemma list.
+size_t AnalizeByList(const Morpher& morpher, const std::vector<std::string>& words, const std::string& name) {
+  m::MorphologistBase::LemList lem_list;
+  size_t num_of_lemmas = 0;
+  const size_t allocations = g_allocations;
+  bench::Timer timer;
+  for (size_t i = 0; i < words.size(); ++i) {
+    morpher.Analize(words[i], lem_list);
+    num_of_lemmas += lem_list.size();
+  }
+  bench::Report(name, timer.Elapsed(), words.size(), "words");
+  ReportAllocations(g_allocations - allocations, words.size());
+  return num_of_lemmas;
+}
+
+/// Measure the batch analysis.
+size_t AnalizeBatch(const Morpher& morpher, const std::vector<std::string>& words, size_t num_of_threads,
+                    const std::string& name) {
+  m::MorphologistBase::TextRangeList ranges;
+  for (size_t i = 0; i < words.size(); ++i) {
+    ranges.push_back(m::MorphologistBase::TextRange(words[i].data(), words[i].data() + words[i].size()));
+  }
+  m::MorphologistBase::BatchResult result;
+  bench::Timer timer;
+  morpher.AnalizeBatch(ranges, result, num_of_threads);
+  bench::Report(name, timer.Elapsed(), words.size(), "words");
+  std::cout << "  different words: " << result.num_of_unique_ << "\n";
+  return result.lemmas_.size();
+}
+
+} // namespace.
+
+// Count heap allocations.
+void* operator new(size_t size) {
+  g_allocations.fetch_add(1, boost::memory_order_relaxed);
+  if (void* ptr = std::malloc(size ? size : 1)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) throw() {
+  std::free(ptr);
+}
+
+#if __cplusplus >= 201402L
+void operator delete(void* ptr, size_t) throw() {
+  std::free(ptr);
+}
+#endif
+
+int main(int argc, char* argv[]) {
+  const size_t num_of_words = argc > 1 ? std::atoi(argv[1]) : 2000000;
+  const size_t num_of_bases = argc > 2 ? std::atoi(argv[2]) : 100000;
+  Morpher morpher;
+  std::vector<std::string> words;
+  Generate(num_of_bases, num_of_words, morpher, words);
+  std::cout << "Bases: " << num_of_bases << ", words: " << num_of_words << "\n";
+
+  morpher.Freeze();
+  const size_t expected = AnalizeByList(morpher, words, "Analize -> LemList");
+  if (AnalizeByBuffer(morpher, words, "Analize -> LemmaBuffer") != expected) {
+    std::cerr << "LemmaBuffer results differ\n";
+    return 1;
+  }
+
+  const size_t num_of_threads = std::max(1u, boost::thread::hardware_concurrency());
+  if (AnalizeBatch(morpher, words, 1, "AnalizeBatch, 1 thread") != expected) {
+    std::cerr << "AnalizeBatch results differ\n";
+    return 1;
+  }
+  std::stringstream threads_name;
+  threads_name << "AnalizeBatch, " << num_of_threads << " threads";
+  if (AnalizeBatch(morpher, words, num_of_threads, threads_name.str()) != expected) {
+    std::cerr << "AnalizeBatch results differ\n";
+    return 1;
+  }
+
+  std::stringstream image;
+  m::MorphoImage::Write(morpher, image);
+  MappedMorpher mapped;
+  mapped.Deserialize(image);
+  if (AnalizeByBuffer(mapped, words, "MappedMorphologist -> LemmaBuffer") != expected) {
+    std::cerr << "MappedMorphologist results differ\n";
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,139 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Reverse suffix index benchmark: candidate bases examined per token on the Russian dictionary.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "symbols.h"
+#include "utf8_iterator.h"
+#include "utf8_generator.h"
+#include "rus_alphabet.h"
+#include "morpho.h"
+#include "timer.h"
+
+namespace {
+
+namespace m = strutext::morpho;
+namespace bench = strutext::bench;
+
+typedef m::Morphologist<m::RussianAlphabet> Morpher;
+
+/// Load the dictionary built by aot without word form automaton and suffix index.
+bool LoadDictionary(const char* file_name, Morpher& morpher) {
+  std::ifstream file(file_name, std::ios::binary);
+  if (not file.is_open()) {
+    std::cerr << "Cannot open dictionary file: \"" << file_name << "\"\n";
+    return false;
+  }
+  morpher.Deserialize(file);
+  if (morpher.IsFormsCompiled() or morpher.IsSuffixIndexBuilt()) {
+    std::cerr << "Build the dictionary without --forms and --suffix-index options\n";
+    return false;
+  }
+  return true;
+}
+
+/// Split UTF-8 text to words of letters.
+void ReadTokens(const char* file_name, size_t max_tokens, std::vector<std::string>& tokens) {
+  typedef strutext::encode::Utf8Iterator<std::string::const_iterator> Utf8Iterator;
+  std::ifstream file(file_name, std::ios::binary);
+  const std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  std::string token;
+  for (Utf8Iterator sym_it(text.begin(), text.end()); sym_it != Utf8Iterator() and tokens.size() < max_tokens; ++sym_it) {
+    if (strutext::symbols::IsLetter(*sym_it)) {
+      strutext::encode::GetUtf8Sequence(*sym_it, std::back_inserter(token));
+    } else if (not token.empty()) {
+      tokens.push_back(token);
+      token.clear();
+    }
+  }
+  if (not token.empty() and tokens.size() < max_tokens) {
+    tokens.push_back(token);
+  }
+}
+
+/// Take all the forms of the first lemmas as tokens.
+void GenerateTokens(const Morpher& morpher, size_t max_tokens, std::vector<std::string>& tokens) {
+  std::set<std::string> forms;
+  for (uint32_t lem_id = 0; lem_id < max_tokens and tokens.size() < max_tokens; ++lem_id) {
+    morpher.GenAllForms(lem_id, forms);
+    tokens.insert(tokens.end(), forms.begin(), forms.end());
+  }
+  if (tokens.size() > max_tokens) {
+    tokens.resize(max_tokens);
+  }
+}
+
+/// Analyze the tokens, report the time and number of candidate bases per token.
+size_t Analize(const Morpher& morpher, const std::vector<std::string>& tokens, const std::string& name) {
+  m::MorphologistBase::LemmaBuffer buffer;
+  size_t num_of_lemmas = 0;
+  size_t num_of_candidates = 0;
+  bench::Timer timer;
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    morpher.Analize(tokens[i].data(), tokens[i].data() + tokens[i].size(), buffer);
+    num_of_lemmas += buffer.Size();
+    num_of_candidates += buffer.GetNumOfCandidates();
+  }
+  bench::Report(name, timer.Elapsed(), tokens.size(), "tokens");
+  std::cout << "  candidates per token: " << static_cast<double>(num_of_candidates) / tokens.size()
+            << ", lemmas per token: " << static_cast<double>(num_of_lemmas) / tokens.size() << "\n";
+  return num_of_lemmas;
+}
+
+} // namespace.
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    std::cerr << "Usage: " << argv[0] << " <russian binary dictionary> [text file in UTF-8] [max tokens]\n"
+              << "The dictionary is built by aot with -m rus, the text is optional: the forms of the first lemmas are taken\n";
+    return 1;
+  }
+  const size_t max_tokens = argc > 3 ? std::atoi(argv[3]) : 1000000;
+  Morpher morpher, indexed;
+  if (not LoadDictionary(argv[1], morpher) or not LoadDictionary(argv[1], indexed)) {
+    return 1;
+  }
+  indexed.BuildSuffixIndex();
+
+  std::vector<std::string> tokens;
+  if (argc > 2) {
+    ReadTokens(argv[2], max_tokens, tokens);
+  } else {
+    GenerateTokens(morpher, max_tokens, tokens);
+  }
+  if (tokens.empty()) {
+    std::cerr << "No tokens to analyze\n";
+    return 1;
+  }
+  std::cout << "Tokens: " << tokens.size() << "\n";
+
+  const size_t expected = Analize(morpher, tokens, "Analize, bases automaton");
+  if (Analize(indexed, tokens, "Analize, bases and suffix index") != expected) {
+    std::cerr << "Suffix index results differ\n";
+    return 1;
+  }
+  return 0;
+}
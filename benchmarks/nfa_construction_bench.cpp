@@ -0,0 +1,213 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  NFA construction benchmark: time and memory of large rule unions.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <boost/make_shared.hpp>
+
+#include "nfa.h"
+#include "nfa_operations.h"
+#include "arena_nfa.h"
+#include "test_random.h"
+#include "timer.h"
+
+namespace {
+
+/// Number of bytes allocated and not freed yet.
+size_t g_live_bytes = 0;
+
+/// Block header size, keeps the alignment of the block.
+const size_t kHeaderSize = 16;
+
+} // namespace.
+
+void* operator new(size_t size) {
+  char* block = static_cast<char*>(std::malloc(size + kHeaderSize));
+  if (block == NULL) {
+    throw std::bad_alloc();
+  }
+  *reinterpret_cast<size_t*>(block) = size;
+  g_live_bytes += size;
+  return block + kHeaderSize;
+}
+
+void operator delete(void* ptr) throw() {
+  if (ptr != NULL) {
+    char* block = static_cast<char*>(ptr) - kHeaderSize;
+    g_live_bytes -= *reinterpret_cast<size_t*>(block);
+    std::free(block);
+  }
+}
+
+#if __cplusplus >= 201402L
+void operator delete(void* ptr, size_t) throw() {
+  operator delete(ptr);
+}
+#endif
+
+namespace {
+
+namespace sa = strutext::automata;
+namespace bench = strutext::bench;
+
+typedef std::vector<uint32_t>            Word;
+typedef sa::Nfa<uint32_t, uint32_t>      NfaImpl;
+typedef sa::ArenaNfa<uint32_t, uint32_t> ArenaNfa;
+
+/// First and last symbols of [a-я] class.
+const uint32_t kClassFirst = 'a';
+const uint32_t kClassLast = 0x44F;
+
+/// Rule: the word, which may be prefixed by [a-я]+.
+struct Rule {
+  Word word_;      ///< The word.
+  bool has_class_; ///< Is the word prefixed by the class?
+};
+
+/// Generate rules of Cyrillic words, each tenth rule is prefixed by the class.
+void GenerateRules(size_t num_of_rules, std::vector<Rule>& rules) {
+  strutext::test::Random random;
+  rules.resize(num_of_rules);
+  for (size_t i = 0; i < num_of_rules; ++i) {
+    const size_t len = 3 + random.Next(8);
+    for (size_t j = 0; j < len; ++j) {
+      rules[i].word_.push_back(0x430 + random.Next(32));
+    }
+    rules[i].has_class_ = i % 10 == 0;
+  }
+}
+
+/// Return the total length of the rules, the volume reported.
+size_t CountSymbols(const std::vector<Rule>& rules) {
+  size_t num_of_symbols = 0;
+  for (size_t i = 0; i < rules.size(); ++i) {
+    num_of_symbols += rules[i].word_.size();
+  }
+  return num_of_symbols;
+}
+
+/// Add new state to the NFA.
+NfaImpl::State* NewState(NfaImpl& nfa) {
+  NfaImpl::State::Ptr state = boost::make_shared<NfaImpl::State>();
+  nfa.AddState(state);
+  return state.get();
+}
+
+/// Build the rule NFA, the class is a move per symbol.
+NfaImpl::Ptr BuildRule(const Rule& rule, uint32_t id) {
+  NfaImpl::Ptr nfa = boost::make_shared<NfaImpl>();
+  NfaImpl::State* state = NewState(*nfa);
+  nfa->SetStartState(state);
+  if (rule.has_class_) {
+    NfaImpl::State* loop = NewState(*nfa);
+    for (uint32_t symbol = kClassFirst; symbol <= kClassLast; ++symbol) {
+      nfa->AddTransition(state, loop, symbol);
+      nfa->AddTransition(loop, loop, symbol);
+    }
+    state = loop;
+  }
+  for (size_t i = 0; i < rule.word_.size(); ++i) {
+    NfaImpl::State* next = NewState(*nfa);
+    nfa->AddTransition(state, next, rule.word_[i]);
+    state = next;
+  }
+  nfa->AddToAcceptedSet(state);
+  state->attr_list_.insert(id);
+  return nfa;
+}
+
+/// Build the rule fragment, the class is one move.
+ArenaNfa::Fragment BuildRule(const Rule& rule, uint32_t id, ArenaNfa& nfa) {
+  ArenaNfa::Fragment result = nfa.Symbol(rule.word_[0]);
+  for (size_t i = 1; i < rule.word_.size(); ++i) {
+    result = nfa.Concat(result, nfa.Symbol(rule.word_[i]));
+  }
+  if (rule.has_class_) {
+    result = nfa.Concat(nfa.PositiveIteration(nfa.Range(kClassFirst, kClassLast)), result);
+  }
+  nfa.Accept(result, id);
+  return result;
+}
+
+/// Print memory and size of the automaton.
+void PrintSize(size_t bytes, size_t num_of_rules, size_t num_of_states, size_t num_of_moves) {
+  std::cout << "  memory: " << bytes / 1024 << " KB, bytes per rule: " << bytes / num_of_rules
+            << ", states: " << num_of_states << ", moves: " << num_of_moves << "\n";
+}
+
+/// Build the union of rule automata by the pointer based NFA.
+void BuildNfaUnion(const std::vector<Rule>& rules) {
+  const size_t start_bytes = g_live_bytes;
+  bench::Timer timer;
+  std::list<NfaImpl::Ptr> automata;
+  for (size_t i = 0; i < rules.size(); ++i) {
+    automata.push_back(BuildRule(rules[i], i));
+  }
+  const double rules_time = timer.Elapsed();
+  const size_t rules_bytes = g_live_bytes - start_bytes;
+  NfaImpl::Ptr result = sa::operations::Union<uint32_t, uint32_t>(automata);
+  const double union_time = timer.Elapsed();
+
+  size_t num_of_moves = 0;
+  for (NfaImpl::StateStorage::const_iterator st_it = result->GetStates().begin();
+        st_it != result->GetStates().end(); ++st_it) {
+    num_of_moves += (*st_it)->trans_table_.size();
+  }
+  bench::Report("Nfa, rule automata", rules_time, CountSymbols(rules), "symbols");
+  bench::Report("Nfa, rules and union", union_time, CountSymbols(rules), "symbols");
+  PrintSize(g_live_bytes - start_bytes - rules_bytes, rules.size(), result->GetStates().size(), num_of_moves);
+}
+
+/// Build the union of rule fragments by the array NFA.
+void BuildArenaUnion(const std::vector<Rule>& rules) {
+  const size_t start_bytes = g_live_bytes;
+  bench::Timer timer;
+  ArenaNfa nfa;
+  std::vector<ArenaNfa::Fragment> fragments;
+  fragments.reserve(rules.size());
+  for (size_t i = 0; i < rules.size(); ++i) {
+    fragments.push_back(BuildRule(rules[i], i, nfa));
+  }
+  nfa.SetStartState(nfa.Union(fragments).start_);
+  bench::Report("ArenaNfa, rules and union", timer.Elapsed(), CountSymbols(rules), "symbols");
+  std::vector<ArenaNfa::Fragment>().swap(fragments);
+  PrintSize(g_live_bytes - start_bytes, rules.size(), nfa.GetNumOfStates(), nfa.GetNumOfMoves());
+}
+
+} // namespace.
+
+int main(int argc, char* argv[]) {
+  const size_t num_of_rules = argc > 1 ? std::atoi(argv[1]) : 10000;
+  if (num_of_rules == 0) {
+    std::cerr << "Usage: " << argv[0] << " [number of rules]\n";
+    return 1;
+  }
+  std::vector<Rule> rules;
+  GenerateRules(num_of_rules, rules);
+  std::cout << "Rules: " << rules.size() << ", each tenth is prefixed by [a-\xD1\x8F]+\n";
+  BuildArenaUnion(rules);
+  BuildNfaUnion(rules);
+  return 0;
+}
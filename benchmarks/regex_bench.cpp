@@ -0,0 +1,149 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Regular expression scanner benchmark: throughput against boost::regex on the same rules.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdint.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/regex.hpp>
+
+#include "regex_scanner.h"
+#include "test_random.h"
+#include "timer.h"
+
+namespace {
+
+namespace sa = strutext::automata;
+namespace bench = strutext::bench;
+
+/// Generate the word of Latin letters.
+std::string GenerateWord(strutext::test::Random& random) {
+  return random.GenerateText(4 + random.Next(5), "abcdefghijklmnopqrstuvwxyz");
+}
+
+/// Generate the rules: words, words with numbers, optional prefixes and wildcards.
+void GenerateRules(size_t num_of_rules, strutext::test::Random& random, std::vector<std::string>& words,
+                   std::vector<std::string>& rules) {
+  for (size_t i = 0; i < num_of_rules; ++i) {
+    const std::string word = GenerateWord(random);
+    words.push_back(word);
+    switch (i % 4) {
+      case 0:
+        rules.push_back(word);
+        break;
+      case 1:
+        rules.push_back(word + "[0-9]{1,3}");
+        break;
+      case 2:
+        rules.push_back("(?:re|un)?" + word + "s?");
+        break;
+      default:
+        rules.push_back(word.substr(0, 2) + "." + word.substr(3));
+        break;
+    }
+  }
+}
+
+/// Generate the text of random words, each tenth is the rule word.
+std::string GenerateText(size_t size, const std::vector<std::string>& words, strutext::test::Random& random) {
+  std::string text;
+  while (text.size() < size) {
+    if (random.Next(10) == 0) {
+      text += words[random.Next(words.size())];
+      text += random.Next(2) ? "42" : "";
+    } else {
+      text += GenerateWord(random);
+    }
+    text.push_back(' ');
+  }
+  return text;
+}
+
+/// Search the rules by the scanner, return the throughput in bytes per second.
+double ScanRules(const std::vector<std::string>& rules, const std::string& text) {
+  bench::Timer timer;
+  sa::RegexScanner scanner;
+  for (size_t i = 0; i < rules.size(); ++i) {
+    scanner.AddRule(rules[i], i);
+  }
+  scanner.Compile();
+  bench::Report("RegexScanner, compile", timer.Elapsed(), rules.size(), "rules");
+  std::cout << "  states: " << scanner.GetNumOfStates() << ", classes: " << scanner.GetNumOfClasses()
+            << ", dense table: " << (scanner.HasMoveTable() ? "yes" : "no") << "\n";
+
+  sa::RegexScanner::MatchList matches;
+  bench::Timer scan_timer;
+  scanner.ScanUtf8(text, matches);
+  const double seconds = scan_timer.Elapsed();
+  bench::Report("RegexScanner, all matches", seconds, text.size(), "B");
+  std::cout << "  matches: " << matches.size() << "\n";
+  return seconds > 0 ? text.size() / seconds : 0;
+}
+
+/// Search the rules by boost::regex, the rules are alternatives of one expression.
+double SearchRules(const std::vector<std::string>& rules, const std::string& text) {
+  bench::Timer timer;
+  std::string pattern;
+  for (size_t i = 0; i < rules.size(); ++i) {
+    pattern += (i == 0 ? "(?:" : "|(?:") + rules[i] + ")";
+  }
+  const boost::regex regex(pattern, boost::regex::perl | boost::regex::optimize);
+  bench::Report("boost::regex, compile", timer.Elapsed(), rules.size(), "rules");
+
+  bench::Timer search_timer;
+  size_t num_of_matches = 0;
+  for (boost::sregex_iterator it(text.begin(), text.end(), regex), end; it != end; ++it) {
+    ++num_of_matches;
+  }
+  const double seconds = search_timer.Elapsed();
+  bench::Report("boost::regex, leftmost matches", seconds, text.size(), "B");
+  std::cout << "  matches: " << num_of_matches << "\n";
+  return seconds > 0 ? text.size() / seconds : 0;
+}
+
+} // namespace.
+
+int main(int argc, char* argv[]) {
+  const size_t num_of_rules = argc > 1 ? std::atoi(argv[1]) : 1000;
+  const size_t text_size = argc > 2 ? std::atoi(argv[2]) : 1 << 20;
+  const size_t regex_text_size = argc > 3 ? std::atoi(argv[3]) : 1 << 14;
+  if (num_of_rules == 0 or text_size == 0) {
+    std::cerr << "Usage: " << argv[0] << " [number of rules] [text size] [boost::regex text size]\n";
+    return 1;
+  }
+  strutext::test::Random random;
+  std::vector<std::string> words;
+  std::vector<std::string> rules;
+  GenerateRules(num_of_rules, random, words, rules);
+  const std::string text = GenerateText(text_size, words, random);
+  std::cout << "Rules: " << rules.size() << ", text: " << text.size() << " bytes\n";
+  const double scan_speed = ScanRules(rules, text);
+
+  // boost::regex tries the alternatives one by one at each position, it gets the text prefix.
+  // It reports the leftmost non-overlapping matches, the scanner reports all of them.
+  if (regex_text_size > 0) {
+    const double search_speed = SearchRules(rules, text.substr(0, regex_text_size));
+    if (search_speed > 0) {
+      std::cout << "RegexScanner / boost::regex throughput: " << scan_speed / search_speed << "\n";
+    }
+  }
+  return 0;
+}
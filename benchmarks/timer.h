@@ -0,0 +1,59 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Simple timer for benchmarks.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+
+namespace strutext { namespace bench {
+
+/// Wall clock timer, starts on construction.
+class Timer {
+public:
+  Timer()
+    : start_(boost::posix_time::microsec_clock::universal_time()) {}
+
+  /// Elapsed time in seconds.
+  double Elapsed() const {
+    const boost::posix_time::time_duration elapsed = boost::posix_time::microsec_clock::universal_time() - start_;
+    return elapsed.total_microseconds() / 1e6;
+  }
+
+private:
+  boost::posix_time::ptime start_; ///< Start time.
+};
+
+/**
+ * \brief Print benchmark result.
+ *
+ * \param name    The name of measured routine.
+ * \param seconds Elapsed time.
+ * \param volume  Processed volume, in bytes or items.
+ * \param unit    Volume unit name.
+ */
+inline void Report(const std::string& name, double seconds, double volume, const std::string& unit) {
+  std::cout << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << seconds << " s" << std::setw(12) << std::setprecision(1)
+            << (seconds > 0 ? volume / seconds / 1e6 : 0) << " M" << unit << "/s\n";
+}
+
+}} // namespace strutext, bench.
@@ -0,0 +1,246 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Bulk transcoding of single byte encodings implementation.
+ * \author Vladimir Lapshin.
+ */
+
+#include <stdexcept>
+
+#include "char_transcoder.h"
+#include "utf8_generator.h"
+#include "utf8_compact_table.h"
+
+#ifdef STRUTEXT_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace strutext { namespace encode {
+
+CharTable::CharTable(const uint32_t* utf32)
+  : utf32_(utf32)
+  , ascii_(true) {
+  for (unsigned byte = 0; byte < 256; ++byte) {
+    if (utf32[byte] > 0xFFFF) {
+      throw std::invalid_argument("Only basic multilingual plane is supported in single byte encodings");
+    }
+    if (byte < 0x80 and utf32[byte] != byte) {
+      ascii_ = false;
+    }
+    uint8_t sequence[4] = {0};
+    const size_t len = GetUtf8Sequence(utf32[byte], sequence) - sequence;
+    utf8_[byte] = sequence[0] | (sequence[1] << 8) | (sequence[2] << 16);
+    utf8_len_[byte] = static_cast<uint8_t>(len);
+  }
+}
+
+namespace {
+
+/// Plain decoding.
+size_t TranscodeScalar(const CharTable& table, const uint8_t* bytes, size_t n, uint32_t* out) {
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = table.utf32_[bytes[i]];
+  }
+  return n;
+}
+
+/// Plain conversion to UTF-8.
+size_t TranscodeToUtf8Scalar(const CharTable& table, const uint8_t* bytes, size_t n, char* out) {
+  char* const begin = out;
+  size_t i = 0;
+  // Each byte gives at least one byte of output, so three bytes may be always written
+  // except the tail.
+  for (; i + 3 <= n; ++i) {
+    const uint32_t sequence = table.utf8_[bytes[i]];
+    out[0] = static_cast<char>(sequence);
+    out[1] = static_cast<char>(sequence >> 8);
+    out[2] = static_cast<char>(sequence >> 16);
+    out += table.utf8_len_[bytes[i]];
+  }
+  for (; i < n; ++i) {
+    const uint32_t sequence = table.utf8_[bytes[i]];
+    for (unsigned j = 0; j < table.utf8_len_[bytes[i]]; ++j) {
+      *out++ = static_cast<char>(sequence >> (8 * j));
+    }
+  }
+  return out - begin;
+}
+
+#ifdef STRUTEXT_X86_SIMD
+
+/// SSE2 decoding, ASCII blocks are widened if the encoding is ASCII compatible.
+size_t TranscodeSse2(const CharTable& table, const uint8_t* bytes, size_t n, uint32_t* out) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+    if (table.ascii_ and _mm_movemask_epi8(block) == 0) {
+      const __m128i lo = _mm_unpacklo_epi8(block, zero);
+      const __m128i hi = _mm_unpackhi_epi8(block, zero);
+      __m128i* dst = reinterpret_cast<__m128i*>(out + i);
+      _mm_storeu_si128(dst, _mm_unpacklo_epi16(lo, zero));
+      _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(lo, zero));
+      _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(hi, zero));
+      _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(hi, zero));
+    } else {
+      TranscodeScalar(table, bytes + i, 16, out + i);
+    }
+  }
+  return i + TranscodeScalar(table, bytes + i, n - i, out + i);
+}
+
+/// SSE2 conversion to UTF-8, ASCII blocks are copied if the encoding is ASCII compatible.
+size_t TranscodeToUtf8Sse2(const CharTable& table, const uint8_t* bytes, size_t n, char* out) {
+  char* const begin = out;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i));
+    if (table.ascii_ and _mm_movemask_epi8(block) == 0) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), block);
+      out += 16;
+    } else {
+      out += TranscodeToUtf8Scalar(table, bytes + i, 16, out);
+    }
+  }
+  return (out - begin) + TranscodeToUtf8Scalar(table, bytes + i, n - i, out);
+}
+
+/// AVX2 decoding, the codes are gathered from the table.
+__attribute__((target("avx2")))
+size_t TranscodeAvx2(const CharTable& table, const uint8_t* bytes, size_t n, uint32_t* out) {
+  const int* utf32 = reinterpret_cast<const int*>(table.utf32_);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i));
+    __m256i* dst = reinterpret_cast<__m256i*>(out + i);
+    const bool ascii = table.ascii_ and _mm256_movemask_epi8(block) == 0;
+    for (unsigned j = 0; j < 4; ++j) {
+      const __m256i indexes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes + i + 8 * j)));
+      _mm256_storeu_si256(dst + j, ascii ? indexes : _mm256_i32gather_epi32(utf32, indexes, 4));
+    }
+  }
+  for (; i + 8 <= n; i += 8) {
+    const __m256i indexes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes + i)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_i32gather_epi32(utf32, indexes, 4));
+  }
+  return i + TranscodeScalar(table, bytes + i, n - i, out + i);
+}
+
+/**
+ * \brief AVX2 conversion to UTF-8.
+ *
+ * UTF-8 sequences are gathered from the table by eight and compacted by shuffle.
+ */
+__attribute__((target("avx2")))
+size_t TranscodeToUtf8Avx2(const CharTable& table, const uint8_t* bytes, size_t n, char* out) {
+  const details::Utf8CompactTable& compact = details::GetUtf8CompactTable();
+  const int* utf8 = reinterpret_cast<const int*>(table.utf8_);
+  const __m256i one_byte_max = _mm256_set1_epi32(0xFF);
+  const __m256i two_bytes_max = _mm256_set1_epi32(0xFFFF);
+  char* const begin = out;
+  size_t i = 0;
+  // 16 byte stores go beyond the sequences, but at least 16 bytes are left to convert.
+  // So the stored garbage is overwritten later.
+  for (; i + 48 <= n; i += 32) {
+    const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i));
+    if (table.ascii_ and _mm256_movemask_epi8(block) == 0) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), block);
+      out += 32;
+      continue;
+    }
+    for (unsigned j = 0; j < 4; ++j) {
+      const __m256i indexes = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(bytes + i + 8 * j)));
+      const __m256i sequences = _mm256_i32gather_epi32(utf8, indexes, 4);
+      const unsigned two_mask =
+          _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(sequences, one_byte_max)));
+      const unsigned three_mask =
+          _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(sequences, two_bytes_max)));
+      const unsigned low_index = (two_mask & 0xF) | ((three_mask & 0xF) << 4);
+      const unsigned high_index = (two_mask >> 4) | (three_mask & 0xF0);
+      const __m256i shuffle = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(compact.shuffle_[low_index]))),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(compact.shuffle_[high_index])), 1);
+      const __m256i result = _mm256_shuffle_epi8(sequences, shuffle);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(result));
+      out += compact.len_[low_index];
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_extracti128_si256(result, 1));
+      out += compact.len_[high_index];
+    }
+  }
+  return (out - begin) + TranscodeToUtf8Scalar(table, bytes + i, n - i, out);
+}
+
+#endif  // STRUTEXT_X86_SIMD
+
+typedef size_t (*TranscodeFunction)(const CharTable&, const uint8_t*, size_t, uint32_t*);
+typedef size_t (*TranscodeToUtf8Function)(const CharTable&, const uint8_t*, size_t, char*);
+
+/// Get decoding implementation by the instruction set.
+TranscodeFunction GetTranscodeFunction(SimdLevel level) {
+  switch (level) {
+#ifdef STRUTEXT_X86_SIMD
+    case AVX2_SIMD_LEVEL:
+      return TranscodeAvx2;
+    case SSE2_SIMD_LEVEL:
+      return TranscodeSse2;
+#endif
+    default:
+      return TranscodeScalar;
+  }
+}
+
+/// Get UTF-8 conversion implementation by the instruction set.
+TranscodeToUtf8Function GetTranscodeToUtf8Function(SimdLevel level) {
+  switch (level) {
+#ifdef STRUTEXT_X86_SIMD
+    case AVX2_SIMD_LEVEL:
+      return TranscodeToUtf8Avx2;
+    case SSE2_SIMD_LEVEL:
+      return TranscodeToUtf8Sse2;
+#endif
+    default:
+      return TranscodeToUtf8Scalar;
+  }
+}
+
+}  // namespace.
+
+size_t details::Transcode(SimdLevel level, const CharTable& table, const char* bytes, size_t n, uint32_t* out) {
+  return GetTranscodeFunction(level)(table, reinterpret_cast<const uint8_t*>(bytes), n, out);
+}
+
+size_t details::TranscodeToUtf8(SimdLevel level, const CharTable& table, const char* bytes, size_t n, char* out) {
+  return GetTranscodeToUtf8Function(level)(table, reinterpret_cast<const uint8_t*>(bytes), n, out);
+}
+
+size_t Transcode(const CharTable& table, const char* bytes, size_t n, uint32_t* out) {
+  static const TranscodeFunction transcode = GetTranscodeFunction(GetSimdLevel());
+  return transcode(table, reinterpret_cast<const uint8_t*>(bytes), n, out);
+}
+
+size_t GetUtf8Length(const CharTable& table, const char* bytes, size_t n) {
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(bytes);
+  size_t len = 0;
+  for (size_t i = 0; i < n; ++i) {
+    len += table.utf8_len_[data[i]];
+  }
+  return len;
+}
+
+size_t TranscodeToUtf8(const CharTable& table, const char* bytes, size_t n, char* out) {
+  static const TranscodeToUtf8Function transcode = GetTranscodeToUtf8Function(GetSimdLevel());
+  return transcode(table, reinterpret_cast<const uint8_t*>(bytes), n, out);
+}
+
+}} // namespace strutext, encode.
@@ -0,0 +1,156 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Bulk transcoding of single byte encodings.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+
+#include "cpu_features.h"
+
+namespace strutext { namespace encode {
+
+/**
+ * \brief Lookup tables of single byte encoding.
+ *
+ * The tables are built by UNICODE32 table of decoder, see char_unicode32_decoder.h.
+ * Only symbols of basic multilingual plane are supported.
+ */
+struct CharTable {
+  /**
+   * \brief Build tables.
+   *
+   * \param utf32 The decoder table of 256 UNICODE32 codes, must live longer than the object.
+   * \throw       std::invalid_argument if there is a code above 0xFFFF.
+   */
+  explicit CharTable(const uint32_t* utf32);
+
+  const uint32_t* utf32_;         ///< UNICODE32 codes.
+  bool            ascii_;         ///< Are ASCII bytes decoded to themselves?
+  uint32_t        utf8_[256];     ///< UTF-8 sequences, the first byte is in the lowest byte of word.
+  uint8_t         utf8_len_[256]; ///< Lengths of UTF-8 sequences.
+};
+
+/**
+ * \brief Get tables of the decoder.
+ *
+ * Template parameters:
+ *   Decoder The decoder class with static table_ member, see char_unicode32_decoder.h.
+ *
+ * \return The tables, they are built on the first call.
+ */
+template <class Decoder>
+inline const CharTable& GetCharTable() {
+  static const CharTable table(Decoder::table_);
+  return table;
+}
+
+/**
+ * \brief Decode bytes to UNICODE32 codes.
+ *
+ * The decoding is done by gather instruction, if AVX2 is supported.
+ *
+ * \param      table The tables of encoding.
+ * \param      bytes The bytes to decode.
+ * \param      n     Number of bytes.
+ * \param[out] out   Output buffer for n codes.
+ * \return           Number of codes written, it is always n.
+ */
+size_t Transcode(const CharTable& table, const char* bytes, size_t n, uint32_t* out);
+
+/**
+ * \brief Decode bytes to UNICODE32 codes.
+ *
+ * Template parameters:
+ *   Decoder The decoder class, for example Cp1251Decoder.
+ *
+ * \param      bytes The bytes to decode.
+ * \param      n     Number of bytes.
+ * \param[out] out   Output buffer for n codes.
+ * \return           Number of codes written, it is always n.
+ */
+template <class Decoder>
+inline size_t Transcode(const char* bytes, size_t n, uint32_t* out) {
+  return Transcode(GetCharTable<Decoder>(), bytes, n, out);
+}
+
+/**
+ * \brief Calculate length of UTF-8 text for the bytes.
+ *
+ * \param  table The tables of encoding.
+ * \param  bytes The bytes to decode.
+ * \param  n     Number of bytes.
+ * \return       Number of UTF-8 bytes.
+ */
+size_t GetUtf8Length(const CharTable& table, const char* bytes, size_t n);
+
+/**
+ * \brief Convert bytes to UTF-8 text directly.
+ *
+ * \param      table The tables of encoding.
+ * \param      bytes The bytes to decode.
+ * \param      n     Number of bytes.
+ * \param[out] out   Output buffer, must have place for GetUtf8Length(table, bytes, n) bytes.
+ * \return           Number of bytes written.
+ */
+size_t TranscodeToUtf8(const CharTable& table, const char* bytes, size_t n, char* out);
+
+/**
+ * \brief Convert bytes to UTF-8 text and append it to the string.
+ *
+ * Template parameters:
+ *   Decoder The decoder class, for example Cp1251Decoder.
+ *
+ * \param      bytes The bytes to decode.
+ * \param      n     Number of bytes.
+ * \param[out] out   The string to append to.
+ * \return           Number of bytes appended.
+ */
+template <class Decoder>
+inline size_t TranscodeToUtf8(const char* bytes, size_t n, std::string& out) {
+  const CharTable& table = GetCharTable<Decoder>();
+  const size_t len = GetUtf8Length(table, bytes, n);
+  if (len == 0) {
+    return 0;
+  }
+  const size_t prev_size = out.size();
+  out.resize(prev_size + len);
+  return TranscodeToUtf8(table, bytes, n, &out[prev_size]);
+}
+
+namespace details {
+
+/**
+ * \brief Decode by the passed implementation.
+ *
+ * The implementation must be supported by the CPU, see IsSimdLevelSupported().
+ */
+size_t Transcode(SimdLevel level, const CharTable& table, const char* bytes, size_t n, uint32_t* out);
+
+/**
+ * \brief Convert to UTF-8 by the passed implementation.
+ *
+ * The implementation must be supported by the CPU, see IsSimdLevelSupported().
+ */
+size_t TranscodeToUtf8(SimdLevel level, const CharTable& table, const char* bytes, size_t n, char* out);
+
+}  // namespace details.
+
+}} // namespace strutext, encode.
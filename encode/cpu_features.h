@@ -0,0 +1,63 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Runtime detection of CPU vector extensions.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+// SIMD kernels are built for x86-64 by GCC compatible compilers only, SSE2 is always
+// available there. Other kernels are compiled with target attribute and selected in runtime.
+#if defined(__GNUC__) && defined(__x86_64__)
+#define STRUTEXT_X86_SIMD 1
+#endif
+
+namespace strutext { namespace encode {
+
+/// Vector instruction sets used by the encode library.
+enum SimdLevel {
+  SCALAR_SIMD_LEVEL = 0, ///< Plain C++ implementation.
+  SSE2_SIMD_LEVEL   = 1, ///< SSE2 implementation.
+  AVX2_SIMD_LEVEL   = 2  ///< AVX2 implementation.
+};
+
+/**
+ * \brief Get the best instruction set supported by the CPU.
+ *
+ * \return The maximum supported level.
+ */
+inline SimdLevel GetSimdLevel() {
+#ifdef STRUTEXT_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return AVX2_SIMD_LEVEL;
+  }
+  return SSE2_SIMD_LEVEL;
+#else
+  return SCALAR_SIMD_LEVEL;
+#endif
+}
+
+/**
+ * \brief Check the instruction set is supported by the CPU.
+ *
+ * \param  level The instruction set to check.
+ * \return       True if the implementation may be run.
+ */
+inline bool IsSimdLevelSupported(SimdLevel level) {
+  return level <= GetSimdLevel();
+}
+
+}} // namespace strutext, encode.
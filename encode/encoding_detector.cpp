@@ -0,0 +1,375 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Detection of text encoding implementation.
+ * \author Vladimir Lapshin.
+ */
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "encoding_detector.h"
+#include "char_unicode32_decoder.h"
+#include "utf8_decoder.h"
+#include "symbols.h"
+
+namespace strutext { namespace encode {
+
+namespace {
+
+/// Symbol classes used in bigrams.
+enum {
+  CONTROL_CLASS = 0,          ///< Control, unassigned symbol or invalid sequence.
+  PLAIN_CLASS,                ///< ASCII symbol except letters.
+  ASCII_LOWER_CLASS,          ///< ASCII lower case letter.
+  ASCII_UPPER_CLASS,          ///< ASCII upper case letter.
+  OTHER_LOWER_CLASS,          ///< Non ASCII and non Cyrillic lower case letter.
+  OTHER_UPPER_CLASS,          ///< Non ASCII and non Cyrillic upper case letter.
+  SYMBOL_CLASS,               ///< Non ASCII symbol except letters.
+  CYRILLIC_EXTRA_LOWER_CLASS, ///< Cyrillic lower case letter out of Russian alphabet.
+  CYRILLIC_EXTRA_UPPER_CLASS, ///< Cyrillic upper case letter out of Russian alphabet.
+  CYRILLIC_LOWER_CLASS,       ///< The first of Russian lower case letter classes.
+  CYRILLIC_UPPER_CLASS = CYRILLIC_LOWER_CLASS + 33, ///< The first of Russian upper case letter classes.
+  CLASS_NUM = CYRILLIC_UPPER_CLASS + 33
+};
+
+/// Marker of invalid UTF-8 sequence.
+const uint32_t INVALID_CODE = 0xFFFFFFFFu;
+
+/// Penalty for invalid UTF-8 sequence.
+const int32_t INVALID_PENALTY = -20;
+
+/// Scale of scores to get confidence.
+const double SCORE_TEMPERATURE = 8.0;
+
+/// Russian letters frequencies in 1/10000, from "а" to "я" and then "ё".
+const int RUSSIAN_FREQUENCIES[33] = {
+  801, 159, 454, 170, 298, 845, 94, 165, 735, 121, 349, 440, 321, 670, 1097, 281,
+  473, 547, 626, 262, 26, 97, 48, 144, 73, 36, 4, 190, 174, 32, 64, 201, 20
+};
+
+/// The most frequent Russian bigrams.
+const char* const FREQUENT_BIGRAMS[] = {
+  "ст", "но", "то", "на", "ен", "ов", "ни", "ра", "во", "ко", "ал", "ро", "пр", "по", "ре", "ол", "ор", "ет",
+  "ан", "ло", "ли", "ть", "ос", "ак", "ит", "ел", "те", "ва", "ка", "ом", "ер", "ле", "го", "ри", "не", "да",
+  "ес", "ат", "ль", "ой", "ий", "ый", "ая", "ие", "ом", "ег", "ем", "ых", "их", "че", "об", "от", "де", "та"
+};
+
+/// Russian bigrams, which are almost impossible.
+const char* const RARE_BIGRAMS[] = {
+  "аь", "еь", "ёь", "иь", "оь", "уь", "ыь", "эь", "юь", "яь", "аъ", "еъ", "ёъ", "иъ", "оъ", "уъ", "ыъ", "эъ",
+  "юъ", "яъ", "аы", "еы", "ёы", "иы", "оы", "уы", "эы", "юы", "яы", "ьы", "ъы", "ыы", "ьь", "ъъ", "йй", "ьъ",
+  "ъь", "йь", "йъ", "йы", "жы", "шы", "щы", "чы", "цю", "жя", "шя", "щя", "чя", "жю", "шю", "щю", "чю"
+};
+
+/// Get index of Russian letter from "а" to "я" and then "ё".
+int GetRussianIndex(uint32_t code) {
+  if (code >= 0x430 and code <= 0x44F) {
+    return code - 0x430;
+  } else if (code == 0x451) {
+    return 32;
+  }
+  return -1;
+}
+
+/// Get class of the symbol.
+uint8_t GetClass(uint32_t code) {
+  if (code == INVALID_CODE) {
+    return CONTROL_CLASS;
+  } else if (code < 0x80) {
+    if (code >= 'a' and code <= 'z') {
+      return ASCII_LOWER_CLASS;
+    } else if (code >= 'A' and code <= 'Z') {
+      return ASCII_UPPER_CLASS;
+    } else if ((code < 0x20 and code != '\t' and code != '\n' and code != '\r' and code != '\f') or code == 0x7F) {
+      return CONTROL_CLASS;
+    }
+    return PLAIN_CLASS;
+  }
+
+  const int lower_index = GetRussianIndex(code);
+  if (lower_index >= 0) {
+    return CYRILLIC_LOWER_CLASS + lower_index;
+  }
+  const int upper_index = GetRussianIndex(symbols::ToLower(code));
+  if (upper_index >= 0 and symbols::Is<symbols::UPPERCASE_LETTER>(code)) {
+    return CYRILLIC_UPPER_CLASS + upper_index;
+  }
+
+  if (symbols::IsLetter(code)) {
+    const bool upper = symbols::Is<symbols::UPPERCASE_LETTER>(code);
+    if (code >= 0x400 and code < 0x530) {
+      return upper ? CYRILLIC_EXTRA_UPPER_CLASS : CYRILLIC_EXTRA_LOWER_CLASS;
+    }
+    return upper ? OTHER_UPPER_CLASS : OTHER_LOWER_CLASS;
+  } else if (symbols::Is<symbols::CONTROL>(code) or symbols::Is<symbols::UNASSIGNED>(code)
+             or symbols::Is<symbols::PRIVATE_USE>(code) or symbols::Is<symbols::SURROGATE>(code)) {
+    return CONTROL_CLASS;
+  }
+  return SYMBOL_CLASS;
+}
+
+/// Get Russian letter index by UTF-8 text of one letter.
+int GetRussianIndex(const char* utf8) {
+  uint32_t code = 0;
+  DecodeUtf8Symbol(reinterpret_cast<const uint8_t*>(utf8), reinterpret_cast<const uint8_t*>(utf8) + 2, code);
+  return GetRussianIndex(code);
+}
+
+/// Is the class a letter class?
+bool IsLetterClass(unsigned cls) {
+  return cls >= ASCII_LOWER_CLASS and cls != SYMBOL_CLASS;
+}
+
+/// Is the class a Cyrillic letter class?
+bool IsCyrillicClass(unsigned cls) {
+  return cls >= CYRILLIC_EXTRA_LOWER_CLASS;
+}
+
+/// Is the class an upper case letter class?
+bool IsUpperClass(unsigned cls) {
+  return cls == ASCII_UPPER_CLASS or cls == OTHER_UPPER_CLASS or cls == CYRILLIC_EXTRA_UPPER_CLASS
+         or cls >= CYRILLIC_UPPER_CLASS;
+}
+
+/// Get Russian letter index by class or -1.
+int GetClassRussianIndex(unsigned cls) {
+  if (cls >= CYRILLIC_UPPER_CLASS) {
+    return cls - CYRILLIC_UPPER_CLASS;
+  } else if (cls >= CYRILLIC_LOWER_CLASS) {
+    return cls - CYRILLIC_LOWER_CLASS;
+  }
+  return -1;
+}
+
+/// Detector tables, built once.
+struct DetectorTables {
+  DetectorTables() {
+    // Scores of Russian letter pairs.
+    int russian[33][33];
+    for (unsigned i = 0; i < 33; ++i) {
+      for (unsigned j = 0; j < 33; ++j) {
+        const double average = 10000.0 / 33;
+        const double ratio = RUSSIAN_FREQUENCIES[i] * RUSSIAN_FREQUENCIES[j] / (average * average);
+        russian[i][j] = static_cast<int>(std::floor(std::log(ratio) + 0.5));
+      }
+    }
+    for (size_t i = 0; i < sizeof(FREQUENT_BIGRAMS) / sizeof(FREQUENT_BIGRAMS[0]); ++i) {
+      russian[GetRussianIndex(FREQUENT_BIGRAMS[i])][GetRussianIndex(FREQUENT_BIGRAMS[i] + 2)] += 3;
+    }
+    for (size_t i = 0; i < sizeof(RARE_BIGRAMS) / sizeof(RARE_BIGRAMS[0]); ++i) {
+      russian[GetRussianIndex(RARE_BIGRAMS[i])][GetRussianIndex(RARE_BIGRAMS[i] + 2)] = -6;
+    }
+
+    for (unsigned prev = 0; prev < CLASS_NUM; ++prev) {
+      for (unsigned next = 0; next < CLASS_NUM; ++next) {
+        int score = 0;
+        if (prev == CONTROL_CLASS or next == CONTROL_CLASS) {
+          score = -10;
+        } else if (IsLetterClass(prev) and IsLetterClass(next)) {
+          const int prev_index = GetClassRussianIndex(prev);
+          const int next_index = GetClassRussianIndex(next);
+          if (not IsUpperClass(prev) and IsUpperClass(next)) {
+            // Lower case letter is not followed by upper case one.
+            score = -8;
+          } else if (IsCyrillicClass(prev) != IsCyrillicClass(next)) {
+            // Cyrillic and Latin letters are not mixed in words.
+            score = -6;
+          } else if (prev_index >= 0 and next_index >= 0) {
+            score = russian[prev_index][next_index];
+            if (IsUpperClass(prev) and IsUpperClass(next)) {
+              score /= 2;
+            }
+          } else if ((prev == OTHER_LOWER_CLASS or prev == OTHER_UPPER_CLASS) and next == OTHER_LOWER_CLASS) {
+            // Accented letters seldom go in a row.
+            score = -1;
+          }
+        } else if (prev == SYMBOL_CLASS or next == SYMBOL_CLASS) {
+          score = -1;
+        } else if (prev == PLAIN_CLASS and next >= CYRILLIC_LOWER_CLASS) {
+          // Words do not start with "ь", "ъ" and "ы".
+          const int index = GetClassRussianIndex(next);
+          if (index == 26 or index == 27 or index == 28) {
+            score = -6;
+          }
+        }
+        bigrams_[prev][next] = static_cast<int8_t>(std::max(-10, std::min(10, score)));
+      }
+    }
+
+    for (unsigned id = UTF8_ENCODING + 1; id < ENCODING_NUM; ++id) {
+      const CharTable* table = GetEncodingTable(static_cast<EncodingId>(id));
+      for (unsigned byte = 0; byte < 256; ++byte) {
+        classes_[id][byte] = GetClass(table->utf32_[byte]);
+      }
+    }
+  }
+
+  int8_t  bigrams_[CLASS_NUM][CLASS_NUM]; ///< Scores of class pairs.
+  uint8_t classes_[ENCODING_NUM][256];    ///< Classes of bytes in single byte encodings.
+};
+
+/// Get the tables.
+const DetectorTables& GetDetectorTables() {
+  static const DetectorTables tables;
+  return tables;
+}
+
+/// Has the word non ASCII bytes?
+inline bool HasNonAscii(const uint8_t* pos) {
+  uint64_t word;
+  std::memcpy(&word, pos, sizeof(word));
+  return (word & 0x8080808080808080ULL) != 0;
+}
+
+}  // namespace.
+
+const char* GetEncodingName(EncodingId id) {
+  static const char* const NAMES[ENCODING_NUM] = {
+    "utf-8", "cp1251", "koi8-r", "cp866", "mac-cyrillic", "koi8-u", "koi8-ru", "mac-ukraine", "cp1252", "iso-8859-1",
+    "cp1253"
+  };
+  return id < ENCODING_NUM ? NAMES[id] : "";
+}
+
+const CharTable* GetEncodingTable(EncodingId id) {
+  switch (id) {
+    case CP1251_ENCODING:       return &GetCharTable<Cp1251Decoder>();
+    case KOI8R_ENCODING:        return &GetCharTable<Koi8rDecoder>();
+    case CP866_ENCODING:        return &GetCharTable<Cp866Decoder>();
+    case MAC_CYRILLIC_ENCODING: return &GetCharTable<MacCyrillicDecoder>();
+    case KOI8U_ENCODING:        return &GetCharTable<Koi8uDecoder>();
+    case KOI8RU_ENCODING:       return &GetCharTable<Koi8ruDecoder>();
+    case MAC_UKRAINE_ENCODING:  return &GetCharTable<MacUkraineDecoder>();
+    case CP1252_ENCODING:       return &GetCharTable<Cp1252Decoder>();
+    case ISO88591_ENCODING:     return &GetCharTable<Iso88591Decoder>();
+    case CP1253_ENCODING:       return &GetCharTable<Cp1253Decoder>();
+    default:                    return NULL;
+  }
+}
+
+EncodingDetector::EncodingDetector() {
+  Reset();
+}
+
+void EncodingDetector::Reset() {
+  std::fill(scores_, scores_ + ENCODING_NUM, 0);
+  prev_byte_ = ' ';
+  prev_utf8_code_ = ' ';
+  pending_len_ = 0;
+  processed_ = 0;
+}
+
+void EncodingDetector::Update(const char* begin, const char* end) {
+  const DetectorTables& tables = GetDetectorTables();
+  const uint8_t* pos = reinterpret_cast<const uint8_t*>(begin);
+  const uint8_t* last = reinterpret_cast<const uint8_t*>(end);
+  processed_ += last - pos;
+  UpdateUtf8(pos, last);
+
+  // ASCII pairs are scored equally by all the encodings, so they are skipped.
+  uint8_t prev = prev_byte_;
+  while (pos != last) {
+    if (prev < 0x80 and last - pos >= 8 and not HasNonAscii(pos)) {
+      prev = pos[7];
+      pos += 8;
+      continue;
+    }
+    const uint8_t byte = *pos++;
+    if ((prev | byte) & 0x80) {
+      for (unsigned id = UTF8_ENCODING + 1; id < ENCODING_NUM; ++id) {
+        scores_[id] += tables.bigrams_[tables.classes_[id][prev]][tables.classes_[id][byte]];
+      }
+    }
+    prev = byte;
+  }
+  prev_byte_ = prev;
+}
+
+void EncodingDetector::UpdateUtf8(const uint8_t* pos, const uint8_t* end) {
+  // Complete the sequence split by the parts, a sequence is never longer than the pending buffer.
+  while (pending_len_ > 0 and pending_len_ < sizeof pending_ and pos != end) {
+    pending_[pending_len_++] = *pos++;
+    uint32_t code;
+    if (DecodeUtf8Symbol(pending_, pending_ + pending_len_, code) != 0) {
+      AddUtf8Symbol(code, code != 0);
+      pending_len_ = 0;
+    }
+  }
+
+  while (pos != end) {
+    if (*pos < 0x80) {
+      if (prev_utf8_code_ < 0x80 and end - pos >= 8 and not HasNonAscii(pos)) {
+        prev_utf8_code_ = pos[7];
+        pos += 8;
+      } else {
+        AddUtf8Symbol(*pos++, true);
+      }
+      continue;
+    }
+    uint32_t code;
+    const size_t len = DecodeUtf8Symbol(pos, end, code);
+    if (len == 0) {
+      pending_len_ = end - pos;
+      std::memcpy(pending_, pos, pending_len_);
+      break;
+    }
+    AddUtf8Symbol(code, code != 0);
+    pos += len;
+  }
+}
+
+void EncodingDetector::AddUtf8Symbol(uint32_t code, bool legal) {
+  if (not legal) {
+    scores_[UTF8_ENCODING] += INVALID_PENALTY;
+    code = INVALID_CODE;
+  }
+  if (code >= 0x80 or prev_utf8_code_ >= 0x80) {
+    scores_[UTF8_ENCODING] += GetDetectorTables().bigrams_[GetClass(prev_utf8_code_)][GetClass(code)];
+  }
+  prev_utf8_code_ = code;
+}
+
+void EncodingDetector::GetCandidates(CandidateList& candidates) const {
+  candidates.clear();
+  const int32_t max_score = *std::max_element(scores_, scores_ + ENCODING_NUM);
+  double sum = 0;
+  for (unsigned id = 0; id < ENCODING_NUM; ++id) {
+    const double weight = std::exp((scores_[id] - max_score) / SCORE_TEMPERATURE);
+    candidates.push_back(Candidate(static_cast<EncodingId>(id), weight));
+    sum += weight;
+  }
+  // Sort by confidence, equal confidences keep the order of identifiers.
+  for (size_t i = 1; i < candidates.size(); ++i) {
+    for (size_t j = i; j > 0 and candidates[j].confidence_ > candidates[j - 1].confidence_; --j) {
+      std::swap(candidates[j], candidates[j - 1]);
+    }
+  }
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    candidates[i].confidence_ /= sum;
+  }
+}
+
+EncodingId EncodingDetector::GetBest() const {
+  return static_cast<EncodingId>(std::max_element(scores_, scores_ + ENCODING_NUM) - scores_);
+}
+
+EncodingId DetectEncoding(const char* begin, const char* end) {
+  EncodingDetector detector;
+  detector.Update(begin, end);
+  return detector.GetBest();
+}
+
+}} // namespace strutext, encode.
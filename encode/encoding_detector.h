@@ -0,0 +1,145 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Detection of text encoding.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include "char_transcoder.h"
+
+namespace strutext { namespace encode {
+
+/// Encodings to detect. The order is used to choose between equally scored encodings.
+enum EncodingId {
+  UTF8_ENCODING = 0,
+  CP1251_ENCODING,
+  KOI8R_ENCODING,
+  CP866_ENCODING,
+  MAC_CYRILLIC_ENCODING,
+  KOI8U_ENCODING,
+  KOI8RU_ENCODING,
+  MAC_UKRAINE_ENCODING,
+  CP1252_ENCODING,
+  ISO88591_ENCODING,
+  CP1253_ENCODING,
+  ENCODING_NUM
+};
+
+/**
+ * \brief Get encoding name.
+ *
+ * \param  id The encoding identifier.
+ * \return    The name, for example "cp1251".
+ */
+const char* GetEncodingName(EncodingId id);
+
+/**
+ * \brief Get tables of single byte encoding.
+ *
+ * \param  id The encoding identifier.
+ * \return    The tables or NULL for UTF-8.
+ */
+const CharTable* GetEncodingTable(EncodingId id);
+
+/**
+ * \brief Streaming encoding detector.
+ *
+ * The detector decodes the byte stream by all the encodings at once. Each decoded symbol is
+ * mapped to symbol class: Cyrillic letter (each letter has its own class), other letter
+ * (defined by symbols::IsLetter), ASCII symbol, other symbol or control symbol. Then the
+ * pairs of adjacent classes are scored by bigram table built by Russian letters statistics
+ * and rules of letter case: lower case letter is not followed by upper case letter in a word,
+ * Cyrillic letters are not mixed with Latin ones, control symbols do not appear in text and
+ * so on. Invalid UTF-8 sequences are penalized.
+ *
+ * Only pairs with non ASCII bytes are scored, so ASCII text is skipped quickly. Pure ASCII
+ * text gets equal scores for all encodings, then UTF-8 is the first.
+ */
+class EncodingDetector {
+public:
+  /// Detection result.
+  struct Candidate {
+    /// Initialization of all fields.
+    Candidate(EncodingId id, double confidence)
+      : id_(id)
+      , confidence_(confidence) {}
+
+    EncodingId id_;         ///< Encoding identifier.
+    double     confidence_; ///< Confidence from 0 to 1, confidences of all candidates give 1 in sum.
+  };
+
+  /// Candidate list type.
+  typedef std::vector<Candidate> CandidateList;
+
+  /// Initialization.
+  EncodingDetector();
+
+  /// Prepare to process new stream.
+  void Reset();
+
+  /**
+   * \brief Process next part of stream.
+   *
+   * \param begin Begin of the bytes.
+   * \param end   End of the bytes.
+   */
+  void Update(const char* begin, const char* end);
+
+  /**
+   * \brief Get encodings ranked by confidence.
+   *
+   * \param[out] candidates All the encodings, the most probable is the first.
+   */
+  void GetCandidates(CandidateList& candidates) const;
+
+  /// Get the most probable encoding.
+  EncodingId GetBest() const;
+
+  /// Get number of processed bytes.
+  size_t GetProcessedBytes() const {
+    return processed_;
+  }
+
+private:
+  /// Process UTF-8 hypothesis.
+  void UpdateUtf8(const uint8_t* begin, const uint8_t* end);
+
+  /// Score the decoded UTF-8 symbol.
+  void AddUtf8Symbol(uint32_t code, bool legal);
+
+  int32_t  scores_[ENCODING_NUM]; ///< Scores of encodings.
+  uint8_t  prev_byte_;            ///< The last byte for single byte encodings.
+  uint32_t prev_utf8_code_;       ///< The last UTF-8 symbol.
+  uint8_t  pending_[6];           ///< Beginning of UTF-8 sequence, which is split by parts of stream.
+  size_t   pending_len_;          ///< Length of the pending sequence.
+  size_t   processed_;            ///< Number of processed bytes.
+};
+
+/**
+ * \brief Detect encoding of the text.
+ *
+ * \param  begin Begin of the text. 4 KB prefix of text is usually enough.
+ * \param  end   End of the text.
+ * \return       The most probable encoding.
+ */
+EncodingId DetectEncoding(const char* begin, const char* end);
+
+}} // namespace strutext, encode.
@@ -0,0 +1,113 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Single byte encodings bulk transcoding unit test.
+ * \author Vladimir Lapshin.
+ */
+
+#include <string>
+#include <vector>
+#include <iterator>
+
+#include <boost/test/unit_test.hpp>
+
+#include "char_iterator.h"
+#include "char_unicode32_decoder.h"
+#include "char_transcoder.h"
+#include "utf8_generator.h"
+#include "test_random.h"
+
+namespace {
+
+namespace enc = strutext::encode;
+
+/// Check all the implementations get the same result as the character iterator.
+template <class Decoder>
+void CheckBytes(const std::string& bytes) {
+  typedef enc::CharIterator<const char*, Decoder> CharIterator;
+  const char* begin = bytes.data();
+  const std::vector<uint32_t> expected_codes(
+      CharIterator(begin, begin + bytes.size()), CharIterator());
+  std::string expected_text;
+  enc::GetUtf8Sequence(expected_codes.begin(), expected_codes.end(), std::back_inserter(expected_text));
+
+  const enc::CharTable& table = enc::GetCharTable<Decoder>();
+  const enc::SimdLevel levels[] = {enc::SCALAR_SIMD_LEVEL, enc::SSE2_SIMD_LEVEL, enc::AVX2_SIMD_LEVEL};
+  for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); ++i) {
+    if (enc::IsSimdLevelSupported(levels[i])) {
+      std::vector<uint32_t> codes(bytes.size() + 1);
+      codes.resize(enc::details::Transcode(levels[i], table, begin, bytes.size(), &codes[0]));
+      BOOST_CHECK_MESSAGE(codes == expected_codes, "SIMD level: " << levels[i]);
+
+      BOOST_CHECK_EQUAL(enc::GetUtf8Length(table, begin, bytes.size()), expected_text.size());
+      std::string text(expected_text.size() + 1, '\0');
+      text.resize(enc::details::TranscodeToUtf8(levels[i], table, begin, bytes.size(), &text[0]));
+      BOOST_CHECK_MESSAGE(text == expected_text, "SIMD level: " << levels[i]);
+    }
+  }
+
+  std::string appended("prefix");
+  BOOST_CHECK_EQUAL(enc::TranscodeToUtf8<Decoder>(begin, bytes.size(), appended), expected_text.size());
+  BOOST_CHECK_EQUAL(appended, "prefix" + expected_text);
+}
+
+/// Check the decoder on all the bytes and random texts.
+template <class Decoder>
+void CheckDecoder() {
+  std::string all_bytes;
+  for (unsigned byte = 0; byte < 256; ++byte) {
+    all_bytes.push_back(static_cast<char>(byte));
+  }
+  CheckBytes<Decoder>(all_bytes);
+
+  strutext::test::Random random;
+  for (size_t iter = 0; iter < 200; ++iter) {
+    std::string bytes;
+    const size_t len = random.Next(200);
+    for (size_t i = 0; i < len; ++i) {
+      // Mostly ASCII texts and mostly national texts.
+      bytes.push_back(static_cast<char>(random.Next(iter % 2 ? 0x80 : 0x100)));
+    }
+    CheckBytes<Decoder>(bytes);
+  }
+}
+
+} // namespace.
+
+BOOST_AUTO_TEST_CASE(Encode_CharTranscoder_Decoders) {
+  CheckDecoder<enc::Cp1251Decoder>();
+  CheckDecoder<enc::Cp1252Decoder>();
+  CheckDecoder<enc::Cp1253Decoder>();
+  CheckDecoder<enc::Cp866Decoder>();
+  CheckDecoder<enc::Iso88591Decoder>();
+  CheckDecoder<enc::Koi8rDecoder>();
+  CheckDecoder<enc::Koi8ruDecoder>();
+  CheckDecoder<enc::Koi8uDecoder>();
+  CheckDecoder<enc::MacCyrillicDecoder>();
+  CheckDecoder<enc::MacUkraineDecoder>();
+}
+
+BOOST_AUTO_TEST_CASE(Encode_CharTranscoder_Text) {
+  // "Мир" in CP1251.
+  const std::string text("\xcc\xe8\xf0");
+  std::string result;
+  enc::TranscodeToUtf8<enc::Cp1251Decoder>(text.data(), text.size(), result);
+  BOOST_CHECK_EQUAL(result, "Мир");
+
+  uint32_t codes[3];
+  BOOST_CHECK_EQUAL(enc::Transcode<enc::Cp1251Decoder>(text.data(), text.size(), codes), 3);
+  BOOST_CHECK_EQUAL(codes[0], 0x41c);
+  BOOST_CHECK_EQUAL(codes[1], 0x438);
+  BOOST_CHECK_EQUAL(codes[2], 0x440);
+}
@@ -0,0 +1,147 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Encoding detector unit test.
+ * \author Vladimir Lapshin.
+ */
+
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+#include "utf8_decoder.h"
+#include "char_transcoder.h"
+#include "encoding_detector.h"
+
+namespace {
+
+namespace enc = strutext::encode;
+
+const char* const RUSSIAN_TEXT =
+  "Мороз и солнце; день чудесный! Еще ты дремлешь, друг прелестный, пора, красавица, проснись: "
+  "открой сомкнуты негой взоры навстречу северной Авроры, звездою севера явись! "
+  "Вечор, ты помнишь, вьюга злилась, на мутном небе мгла носилась; луна, как бледное пятно, "
+  "сквозь тучи мрачные желтела, и ты печальная сидела, а нынче погляди в окно.";
+
+const char* const FRENCH_TEXT =
+  "Le cœur a ses raisons que la raison ne connaît point. Où est la bibliothèque? "
+  "Il était une fois une fée très âgée qui habitait près de la forêt, à côté du château.";
+
+/// Encode UTF-8 text to the single byte encoding.
+std::string EncodeText(const std::string& text, enc::EncodingId id) {
+  std::vector<uint32_t> codes;
+  enc::DecodeUtf8(text.data(), text.data() + text.size(), codes);
+  const enc::CharTable* table = enc::GetEncodingTable(id);
+  std::string bytes;
+  for (size_t i = 0; i < codes.size(); ++i) {
+    for (unsigned byte = 0; byte < 256; ++byte) {
+      if (table->utf32_[byte] == codes[i]) {
+        bytes.push_back(static_cast<char>(byte));
+        break;
+      }
+    }
+  }
+  return bytes;
+}
+
+/// Decode the bytes to UTF-8 by the encoding.
+std::string DecodeText(const std::string& bytes, enc::EncodingId id) {
+  if (id == enc::UTF8_ENCODING) {
+    return bytes;
+  }
+  const enc::CharTable& table = *enc::GetEncodingTable(id);
+  std::string text(enc::GetUtf8Length(table, bytes.data(), bytes.size()) + 1, '\0');
+  text.resize(enc::TranscodeToUtf8(table, bytes.data(), bytes.size(), &text[0]));
+  return text;
+}
+
+/// Check the detected encoding gives the same text.
+void CheckDetection(const std::string& text, enc::EncodingId id) {
+  const std::string bytes = id == enc::UTF8_ENCODING ? text : EncodeText(text, id);
+  const enc::EncodingId detected = enc::DetectEncoding(bytes.data(), bytes.data() + bytes.size());
+  BOOST_CHECK_MESSAGE(DecodeText(bytes, detected) == text,
+                      "Encoding: " << enc::GetEncodingName(id) << ", detected: " << enc::GetEncodingName(detected));
+}
+
+} // namespace.
+
+BOOST_AUTO_TEST_CASE(Encode_EncodingDetector_Cyrillic) {
+  const enc::EncodingId ids[] = {
+    enc::UTF8_ENCODING, enc::CP1251_ENCODING, enc::KOI8R_ENCODING, enc::CP866_ENCODING, enc::MAC_CYRILLIC_ENCODING
+  };
+  for (size_t i = 0; i < sizeof(ids) / sizeof(ids[0]); ++i) {
+    CheckDetection(RUSSIAN_TEXT, ids[i]);
+    // Short texts.
+    CheckDetection("Привет, мир!", ids[i]);
+    CheckDetection("МОСКВА", ids[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Encode_EncodingDetector_Western) {
+  CheckDetection(FRENCH_TEXT, enc::UTF8_ENCODING);
+  CheckDetection(FRENCH_TEXT, enc::CP1252_ENCODING);
+}
+
+BOOST_AUTO_TEST_CASE(Encode_EncodingDetector_Ascii) {
+  const std::string text = "Just a plain ASCII text.\n";
+  BOOST_CHECK_EQUAL(enc::DetectEncoding(text.data(), text.data() + text.size()), enc::UTF8_ENCODING);
+  BOOST_CHECK_EQUAL(enc::DetectEncoding(text.data(), text.data()), enc::UTF8_ENCODING);
+
+  enc::EncodingDetector detector;
+  detector.Update(text.data(), text.data() + text.size());
+  enc::EncodingDetector::CandidateList candidates;
+  detector.GetCandidates(candidates);
+  BOOST_REQUIRE_EQUAL(candidates.size(), size_t(enc::ENCODING_NUM));
+  BOOST_CHECK_EQUAL(candidates[0].id_, enc::UTF8_ENCODING);
+  BOOST_CHECK_CLOSE(candidates[0].confidence_, 1.0 / enc::ENCODING_NUM, 1e-6);
+}
+
+BOOST_AUTO_TEST_CASE(Encode_EncodingDetector_Streaming) {
+  const enc::EncodingId ids[] = {enc::UTF8_ENCODING, enc::CP1251_ENCODING, enc::KOI8R_ENCODING};
+  for (size_t i = 0; i < sizeof(ids) / sizeof(ids[0]); ++i) {
+    const std::string bytes = ids[i] == enc::UTF8_ENCODING ? RUSSIAN_TEXT : EncodeText(RUSSIAN_TEXT, ids[i]);
+    enc::EncodingDetector whole;
+    whole.Update(bytes.data(), bytes.data() + bytes.size());
+    enc::EncodingDetector::CandidateList expected;
+    whole.GetCandidates(expected);
+
+    for (size_t part = 1; part < 10; ++part) {
+      enc::EncodingDetector detector;
+      for (size_t pos = 0; pos < bytes.size(); pos += part) {
+        const size_t len = std::min(part, bytes.size() - pos);
+        detector.Update(bytes.data() + pos, bytes.data() + pos + len);
+      }
+      BOOST_CHECK_EQUAL(detector.GetProcessedBytes(), bytes.size());
+      enc::EncodingDetector::CandidateList candidates;
+      detector.GetCandidates(candidates);
+      BOOST_REQUIRE_EQUAL(candidates.size(), expected.size());
+      for (size_t j = 0; j < candidates.size(); ++j) {
+        BOOST_CHECK_EQUAL(candidates[j].id_, expected[j].id_);
+        BOOST_CHECK_CLOSE(candidates[j].confidence_, expected[j].confidence_, 1e-6);
+      }
+    }
+
+    whole.Reset();
+    BOOST_CHECK_EQUAL(whole.GetProcessedBytes(), 0u);
+    BOOST_CHECK_EQUAL(whole.GetBest(), enc::UTF8_ENCODING);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Encode_EncodingDetector_InvalidUtf8) {
+  // Truncated and broken sequences make UTF-8 less probable than single byte encodings.
+  const std::string bytes = "\xD0\xD0\xD0 \xC0\xE0\xE1\xF0 \xD0";
+  BOOST_CHECK_NE(enc::DetectEncoding(bytes.data(), bytes.data() + bytes.size()), enc::UTF8_ENCODING);
+}
@@ -0,0 +1,132 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Bulk UTF-8 decoder unit test.
+ * \author Vladimir Lapshin.
+ */
+
+#include <string>
+#include <vector>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "utf8_decoder.h"
+#include "utf8_iterator.h"
+#include "test_random.h"
+
+namespace {
+
+namespace enc = strutext::encode;
+
+/// Decode by the byte by byte iterator.
+std::vector<uint32_t> DecodeByIterator(const std::string& text) {
+  typedef enc::Utf8Iterator<std::string::const_iterator> Utf8Iterator;
+  std::vector<uint32_t> result;
+  for (Utf8Iterator it(text.begin(), text.end()); it != Utf8Iterator(); ++it) {
+    result.push_back(*it);
+  }
+  return result;
+}
+
+/// Decode by the pointer iterator.
+std::vector<uint32_t> DecodeByPointerIterator(const std::string& text) {
+  typedef enc::Utf8Iterator<const char*> Utf8Iterator;
+  std::vector<uint32_t> result;
+  const char* begin = text.data();
+  for (Utf8Iterator it(begin, begin + text.size()); it != Utf8Iterator(); ++it) {
+    result.push_back(*it);
+  }
+  return result;
+}
+
+/// Decode by the passed implementation.
+std::vector<uint32_t> DecodeByLevel(enc::SimdLevel level, const std::string& text) {
+  std::vector<uint32_t> result(text.size() + 1);
+  const char* begin = text.data();
+  result.resize(enc::details::DecodeUtf8(level, begin, begin + text.size(), &result[0]));
+  return result;
+}
+
+/// Check all the implementations get the same result as the iterator.
+void CheckText(const std::string& text) {
+  const std::vector<uint32_t> expected = DecodeByIterator(text);
+  BOOST_CHECK(DecodeByPointerIterator(text) == expected);
+  const enc::SimdLevel levels[] = {enc::SCALAR_SIMD_LEVEL, enc::SSE2_SIMD_LEVEL, enc::AVX2_SIMD_LEVEL};
+  for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); ++i) {
+    if (enc::IsSimdLevelSupported(levels[i])) {
+      BOOST_CHECK_MESSAGE(DecodeByLevel(levels[i], text) == expected, "SIMD level: " << levels[i]);
+    }
+  }
+  std::vector<uint32_t> buffer;
+  enc::DecodeUtf8(text.data(), text.data() + text.size(), buffer);
+  BOOST_CHECK(buffer == expected);
+}
+
+} // namespace.
+
+BOOST_AUTO_TEST_CASE(Encode_Utf8Decoder_Text) {
+  CheckText("");
+  CheckText("a");
+  CheckText("Hello world! This is long enough ASCII string to fill vector registers.");
+  CheckText("Мир Труд Май! Съешь же ещё этих мягких французских булок, да выпей чаю.");
+  CheckText("мама cleans раму, папа reads газету, and everybody is happy. Ελληνικά κείμενα.");
+  CheckText("中文文本和 English text 和 русский текст вместе 𝄞𝄞𝄞 и ещё немного текста.");
+
+  std::vector<uint32_t> codes;
+  const std::string text("\x66\xd0\xae\xe0\xa8\x89\xf0\x9d\x84\x9e");
+  BOOST_CHECK_EQUAL(enc::DecodeUtf8(text.data(), text.data() + text.size(), codes), 4);
+  BOOST_CHECK_EQUAL(codes[0], 0x66);
+  BOOST_CHECK_EQUAL(codes[1], 0x42e);
+  BOOST_CHECK_EQUAL(codes[2], 0xa09);
+  BOOST_CHECK_EQUAL(codes[3], 0x1d11e);
+}
+
+BOOST_AUTO_TEST_CASE(Encode_Utf8Decoder_IllegalSequences) {
+  const std::string cyrillic("Съешь же ещё этих мягких булок");
+  const char* illegal[] = {
+    "\x80", "\xbf", "\xc0\xaf", "\xc1\xbf", "\xc2\x41", "\xe0\x80\xaf", "\xed\xa0\x80", "\xf0\x80\x80\xaf",
+    "\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "\xf8\x88\x80\x80\x80", "\xfc\x84\x80\x80\x80\x80", "\xd0", "\xe0\xa8", "\xff"
+  };
+  for (size_t i = 0; i < sizeof(illegal) / sizeof(illegal[0]); ++i) {
+    CheckText(illegal[i]);
+    // Put the sequence to every position of vector block.
+    for (size_t pos = 0; pos <= 32; ++pos) {
+      std::string text = cyrillic;
+      text.insert(std::min(pos * 2, text.size()), illegal[i]);
+      CheckText(text);
+      CheckText(text.substr(0, pos + 16));
+      CheckText(std::string(pos, 'a') + illegal[i] + std::string(40, 'b'));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Encode_Utf8Decoder_Random) {
+  // Pieces of legal and illegal UTF-8 text.
+  const char* pieces[] = {
+    "a", "z", " ", "0", "\x7f", "\xd0\xb0", "\xd1\x8f", "\xc2\xa0", "\xdf\xbf", "\xe2\x82\xac", "\xef\xbf\xbf",
+    "\xf0\x9f\x98\x80", "\xf4\x8f\xbf\xbf", "\x80", "\xc1", "\xe0", "\xf0\x9f", "\xed\xbf\xbf", "\xfe"
+  };
+  const size_t pieces_num = sizeof(pieces) / sizeof(pieces[0]);
+  strutext::test::Random random;
+  for (size_t iter = 0; iter < 2000; ++iter) {
+    std::string text;
+    const size_t len = random.Next(100);
+    // Prefer ASCII and two byte symbols to walk through vector paths.
+    const size_t used_pieces = iter % 2 ? pieces_num : 9;
+    for (size_t i = 0; i < len; ++i) {
+      text += pieces[random.Next(used_pieces)];
+    }
+    CheckText(text);
+  }
+}
@@ -0,0 +1,105 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Bulk UTF-8 encoder unit test.
+ * \author Vladimir Lapshin.
+ */
+
+#include <string>
+#include <vector>
+#include <iterator>
+
+#include <boost/test/auto_unit_test.hpp>
+
+#include "utf8_encoder.h"
+#include "utf8_generator.h"
+#include "utf8_decoder.h"
+#include "test_random.h"
+
+namespace {
+
+namespace enc = strutext::encode;
+
+/// Check all the implementations get the same result as the per symbol generator.
+void CheckCodes(const std::vector<uint32_t>& codes) {
+  std::string expected;
+  enc::GetUtf8Sequence(codes.begin(), codes.end(), std::back_inserter(expected));
+
+  const uint32_t* begin = codes.empty() ? NULL : &codes[0];
+  const uint32_t* end = begin + codes.size();
+  const enc::SimdLevel levels[] = {enc::SCALAR_SIMD_LEVEL, enc::SSE2_SIMD_LEVEL, enc::AVX2_SIMD_LEVEL};
+  for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); ++i) {
+    if (enc::IsSimdLevelSupported(levels[i])) {
+      BOOST_CHECK_EQUAL(enc::details::GetUtf8Length(levels[i], begin, end), expected.size());
+      std::string result(expected.size(), '\0');
+      const size_t len = expected.empty() ? 0 : enc::details::EncodeUtf8(levels[i], begin, end, &result[0]);
+      BOOST_CHECK_EQUAL(len, expected.size());
+      BOOST_CHECK_MESSAGE(result == expected, "SIMD level: " << levels[i]);
+    }
+  }
+
+  std::string appended("prefix");
+  BOOST_CHECK_EQUAL(enc::EncodeUtf8(begin, end, appended), expected.size());
+  BOOST_CHECK_EQUAL(appended, "prefix" + expected);
+}
+
+} // namespace.
+
+BOOST_AUTO_TEST_CASE(Encode_Utf8Encoder_Text) {
+  const std::string texts[] = {
+    "",
+    "Hello world! This is long enough ASCII string to fill vector registers.",
+    "Мир Труд Май! Съешь же ещё этих мягких французских булок, да выпей чаю.",
+    "中文文本和 English text 和 русский текст вместе 𝄞𝄞𝄞 и ещё немного текста."
+  };
+  for (size_t i = 0; i < sizeof(texts) / sizeof(texts[0]); ++i) {
+    std::vector<uint32_t> codes;
+    enc::DecodeUtf8(texts[i].data(), texts[i].data() + texts[i].size(), codes);
+    CheckCodes(codes);
+    std::string result;
+    const uint32_t* begin = codes.empty() ? NULL : &codes[0];
+    enc::EncodeUtf8(begin, begin + codes.size(), result);
+    BOOST_CHECK_EQUAL(result, texts[i]);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(Encode_Utf8Encoder_Random) {
+  // Boundaries of sequence length classes and illegal codes.
+  const uint32_t edges[] = {
+    0, 0x41, 0x7f, 0x80, 0x430, 0x7ff, 0x800, 0x4e2d, 0xd800, 0xfffd, 0xffff, 0x10000, 0x1d11e, 0x10ffff, 0x110000,
+    0x7fffffff, 0x80000000, 0xffffffff
+  };
+  const size_t edges_num = sizeof(edges) / sizeof(edges[0]);
+  strutext::test::Random random;
+  for (size_t iter = 0; iter < 2000; ++iter) {
+    std::vector<uint32_t> codes;
+    const size_t len = random.Next(100);
+    for (size_t i = 0; i < len; ++i) {
+      switch (iter % 4) {
+        case 0:
+          codes.push_back(edges[random.Next(edges_num)]);
+          break;
+        case 1:
+          codes.push_back(random.Next(0x80));
+          break;
+        case 2:
+          codes.push_back(random.Next(0x800));
+          break;
+        default:
+          codes.push_back(random.Next(0x10000));
+      }
+    }
+    CheckCodes(codes);
+  }
+}
@@ -0,0 +1,57 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Shuffle table for vector generation of UTF-8 sequences.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+namespace strutext { namespace encode { namespace details {
+
+/**
+ * \brief Shuffle masks to compact UTF-8 sequences of four symbols.
+ *
+ * Each 32-bit lane of vector register keeps UTF-8 sequence of one to three bytes in its
+ * first bytes. The table is indexed by masks of lanes with two and more bytes (low 4 bits)
+ * and with three bytes (high 4 bits), the row moves the sequence bytes to the beginning
+ * of the register.
+ */
+struct Utf8CompactTable {
+  Utf8CompactTable() {
+    for (unsigned mask = 0; mask < 256; ++mask) {
+      unsigned pos = 0;
+      for (unsigned lane = 0; lane < 4; ++lane) {
+        const unsigned lane_len = 1 + ((mask >> lane) & 1) + ((mask >> (lane + 4)) & 1);
+        for (unsigned i = 0; i < lane_len; ++i) {
+          shuffle_[mask][pos++] = static_cast<uint8_t>(4 * lane + i);
+        }
+      }
+      len_[mask] = static_cast<uint8_t>(pos);
+      while (pos < 16) {
+        shuffle_[mask][pos++] = 0x80;
+      }
+    }
+  }
+
+  uint8_t shuffle_[256][16]; ///< Shuffle masks.
+  uint8_t len_[256];         ///< Number of bytes after compaction.
+};
+
+/// Get the table, it is built on the first call.
+const Utf8CompactTable& GetUtf8CompactTable();
+
+}}} // namespace strutext, encode, details.
@@ -0,0 +1,274 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Bulk UTF-8 to UTF-32 decoding implementation.
+ * \author Vladimir Lapshin.
+ */
+
+#include <cstring>
+
+#include "utf8_decoder.h"
+
+#ifdef STRUTEXT_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace strutext { namespace encode {
+
+namespace {
+
+/// Decode the tail of the sequence symbol by symbol.
+size_t DecodeTail(const uint8_t* pos, const uint8_t* end, uint32_t* out, size_t count) {
+  while (pos < end) {
+    uint32_t code;
+    const size_t len = DecodeUtf8Symbol(pos, end, code);
+    if (len == 0) {
+      break;
+    }
+    out[count++] = code;
+    pos += len;
+  }
+  return count;
+}
+
+/// Plain implementation, ASCII is checked by 8 byte words.
+size_t DecodeScalar(const uint8_t* pos, const uint8_t* end, uint32_t* out) {
+  static const uint64_t HIGH_BITS = 0x8080808080808080ULL;
+  size_t count = 0;
+  while (end - pos >= 8) {
+    uint64_t word;
+    std::memcpy(&word, pos, sizeof(word));
+    if ((word & HIGH_BITS) == 0) {
+      for (unsigned i = 0; i < 8; ++i) {
+        out[count++] = pos[i];
+      }
+      pos += 8;
+      continue;
+    }
+    uint32_t code;
+    const size_t len = DecodeUtf8Symbol(pos, end, code);
+    if (len == 0) {
+      return count;
+    }
+    out[count++] = code;
+    pos += len;
+  }
+  return DecodeTail(pos, end, out, count);
+}
+
+#ifdef STRUTEXT_X86_SIMD
+
+/// SSE2 implementation, ASCII is processed by 16 byte blocks.
+size_t DecodeSse2(const uint8_t* pos, const uint8_t* end, uint32_t* out) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t count = 0;
+  while (end - pos >= 16) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+    const unsigned non_ascii = static_cast<unsigned>(_mm_movemask_epi8(bytes));
+
+    // The whole block is widened, the output has enough place for it. If there are non ASCII
+    // bytes, only the ASCII prefix is accepted.
+    const __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    const __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    __m128i* dst = reinterpret_cast<__m128i*>(out + count);
+    _mm_storeu_si128(dst, _mm_unpacklo_epi16(lo, zero));
+    _mm_storeu_si128(dst + 1, _mm_unpackhi_epi16(lo, zero));
+    _mm_storeu_si128(dst + 2, _mm_unpacklo_epi16(hi, zero));
+    _mm_storeu_si128(dst + 3, _mm_unpackhi_epi16(hi, zero));
+    if (non_ascii == 0) {
+      count += 16;
+      pos += 16;
+      continue;
+    }
+
+    const unsigned prefix = __builtin_ctz(non_ascii);
+    count += prefix;
+    pos += prefix;
+    uint32_t code;
+    const size_t len = DecodeUtf8Symbol(pos, end, code);
+    if (len == 0) {
+      return count;
+    }
+    out[count++] = code;
+    pos += len;
+  }
+  return DecodeTail(pos, end, out, count);
+}
+
+/**
+ * \brief Shuffle masks to compact 16-bit lanes.
+ *
+ * The table is indexed by 8-bit mask of lanes to keep, the row moves the kept lanes
+ * to the beginning of the register.
+ */
+struct CompactTable {
+  CompactTable() {
+    for (unsigned mask = 0; mask < 256; ++mask) {
+      unsigned pos = 0;
+      for (unsigned lane = 0; lane < 8; ++lane) {
+        if (mask & (1u << lane)) {
+          shuffle_[mask][pos++] = static_cast<uint8_t>(2 * lane);
+          shuffle_[mask][pos++] = static_cast<uint8_t>(2 * lane + 1);
+        }
+      }
+      while (pos < 16) {
+        shuffle_[mask][pos++] = 0x80;
+      }
+    }
+  }
+
+  uint8_t shuffle_[256][16];
+};
+
+/// Get the table, it is built on the first call.
+const CompactTable& GetCompactTable() {
+  static const CompactTable table;
+  return table;
+}
+
+/// Store kept 16-bit lanes as 32-bit codes, return number of stored codes.
+__attribute__((target("avx2")))
+inline unsigned StoreCompacted(const CompactTable& table, __m128i values, unsigned keep, uint32_t* out) {
+  const __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(table.shuffle_[keep]));
+  const __m128i packed = _mm_shuffle_epi8(values, shuffle);
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_cvtepu16_epi32(packed));
+  return __builtin_popcount(keep);
+}
+
+/**
+ * \brief AVX2 implementation.
+ *
+ * ASCII is processed by 32 byte blocks. The blocks of one and two bytes sequences
+ * (Latin, Cyrillic, Greek etc.) are decoded in 16-bit lanes and compacted by shuffle.
+ */
+__attribute__((target("avx2")))
+size_t DecodeAvx2(const uint8_t* pos, const uint8_t* end, uint32_t* out) {
+  size_t count = 0;
+  while (end - pos >= 32) {
+    const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+    if (_mm256_movemask_epi8(bytes) != 0) {
+      break;
+    }
+    __m256i* dst = reinterpret_cast<__m256i*>(out + count);
+    _mm256_storeu_si256(dst, _mm256_cvtepu8_epi32(_mm256_castsi256_si128(bytes)));
+    _mm256_storeu_si256(dst + 1, _mm256_cvtepu8_epi32(_mm_srli_si128(_mm256_castsi256_si128(bytes), 8)));
+    _mm256_storeu_si256(dst + 2, _mm256_cvtepu8_epi32(_mm256_extracti128_si256(bytes, 1)));
+    _mm256_storeu_si256(dst + 3, _mm256_cvtepu8_epi32(_mm_srli_si128(_mm256_extracti128_si256(bytes, 1), 8)));
+    count += 32;
+    pos += 32;
+  }
+
+  const CompactTable& table = GetCompactTable();
+  const __m128i max_two_bytes_lead = _mm_set1_epi8(static_cast<char>(0xDF));
+  const __m128i lead_bits = _mm_set1_epi8(static_cast<char>(0xC0));
+  const __m128i overlong_bits = _mm_set1_epi8(static_cast<char>(0xFE));
+  const __m128i lead_payload = _mm_set1_epi16(0x1F);
+  const __m128i continuation_payload = _mm_set1_epi16(0x3F);
+  const __m128i max_ascii = _mm_set1_epi16(0x7F);
+  while (end - pos >= 16) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+    const unsigned non_ascii = static_cast<unsigned>(_mm_movemask_epi8(bytes));
+    if (non_ascii == 0) {
+      __m256i* dst = reinterpret_cast<__m256i*>(out + count);
+      _mm256_storeu_si256(dst, _mm256_cvtepu8_epi32(bytes));
+      _mm256_storeu_si256(dst + 1, _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+      count += 16;
+      pos += 16;
+      continue;
+    }
+
+    // Only ASCII and two bytes sequences are accepted, overlong leads C0 and C1 are excluded.
+    const __m128i short_bytes = _mm_cmpeq_epi8(_mm_max_epu8(bytes, max_two_bytes_lead), max_two_bytes_lead);
+    const bool has_long = _mm_movemask_epi8(short_bytes) != 0xFFFF;
+    const bool has_overlong = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(bytes, overlong_bits), lead_bits)) != 0;
+    const unsigned leads =
+        static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(bytes, lead_bits), lead_bits)));
+    const unsigned continuations = non_ascii & ~leads;
+    if (has_long or has_overlong or continuations != ((leads << 1) & 0xFFFF)) {
+      // Decode the ASCII prefix and the first non ASCII symbol in ordinal way.
+      __m256i* dst = reinterpret_cast<__m256i*>(out + count);
+      _mm256_storeu_si256(dst, _mm256_cvtepu8_epi32(bytes));
+      _mm256_storeu_si256(dst + 1, _mm256_cvtepu8_epi32(_mm_srli_si128(bytes, 8)));
+      const unsigned prefix = __builtin_ctz(non_ascii);
+      count += prefix;
+      pos += prefix;
+      uint32_t code;
+      const size_t len = DecodeUtf8Symbol(pos, end, code);
+      if (len == 0) {
+        return count;
+      }
+      out[count++] = code;
+      pos += len;
+      continue;
+    }
+
+    // The lead byte in the last position is decoded in the next block.
+    const unsigned block_len = (leads & 0x8000) ? 15 : 16;
+    const unsigned keep = ~continuations & ((1u << block_len) - 1);
+
+    const __m128i next = _mm_srli_si128(bytes, 1);
+    const __m128i first[2] = {_mm_cvtepu8_epi16(bytes), _mm_cvtepu8_epi16(_mm_srli_si128(bytes, 8))};
+    const __m128i second[2] = {_mm_cvtepu8_epi16(next), _mm_cvtepu8_epi16(_mm_srli_si128(next, 8))};
+    for (unsigned half = 0; half < 2; ++half) {
+      const __m128i two_bytes = _mm_or_si128(
+          _mm_slli_epi16(_mm_and_si128(first[half], lead_payload), 6), _mm_and_si128(second[half], continuation_payload));
+      const __m128i values = _mm_blendv_epi8(first[half], two_bytes, _mm_cmpgt_epi16(first[half], max_ascii));
+      count += StoreCompacted(table, values, (keep >> (8 * half)) & 0xFF, out + count);
+    }
+    pos += block_len;
+  }
+  return DecodeTail(pos, end, out, count);
+}
+
+#endif  // STRUTEXT_X86_SIMD
+
+typedef size_t (*DecodeFunction)(const uint8_t*, const uint8_t*, uint32_t*);
+
+/// Get implementation by the instruction set.
+DecodeFunction GetDecodeFunction(SimdLevel level) {
+  switch (level) {
+#ifdef STRUTEXT_X86_SIMD
+    case AVX2_SIMD_LEVEL:
+      return DecodeAvx2;
+    case SSE2_SIMD_LEVEL:
+      return DecodeSse2;
+#endif
+    default:
+      return DecodeScalar;
+  }
+}
+
+}  // namespace.
+
+size_t details::DecodeUtf8(SimdLevel level, const char* begin, const char* end, uint32_t* out) {
+  return GetDecodeFunction(level)(
+      reinterpret_cast<const uint8_t*>(begin), reinterpret_cast<const uint8_t*>(end), out);
+}
+
+size_t DecodeUtf8(const char* begin, const char* end, uint32_t* out) {
+  static const DecodeFunction decode = GetDecodeFunction(GetSimdLevel());
+  return decode(reinterpret_cast<const uint8_t*>(begin), reinterpret_cast<const uint8_t*>(end), out);
+}
+
+size_t DecodeUtf8(const char* begin, const char* end, std::vector<uint32_t>& out) {
+  out.resize(end - begin);
+  if (out.empty()) {
+    return 0;
+  }
+  const size_t count = DecodeUtf8(begin, end, &out[0]);
+  out.resize(count);
+  return count;
+}
+
+}} // namespace strutext, encode.
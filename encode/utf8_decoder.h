@@ -0,0 +1,141 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Bulk UTF-8 to UTF-32 decoding.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+
+#include "cpu_features.h"
+
+namespace strutext { namespace encode {
+
+/**
+ * \brief Get length of UTF-8 sequence by its first byte.
+ *
+ * \param  lead The first byte of the sequence.
+ * \return      The sequence length from 1 to 6.
+ */
+inline size_t GetUtf8SequenceLength(uint8_t lead) {
+  static const uint8_t SEQUENCE_LENGTH[256] = {
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // NOLINT
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // NOLINT
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // NOLINT
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // NOLINT
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // NOLINT
+    1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, 1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // NOLINT
+    2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, 2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2, // NOLINT
+    3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3, 4,4,4,4,4,4,4,4,5,5,5,5,6,6,6,6  // NOLINT
+  };
+  return SEQUENCE_LENGTH[lead];
+}
+
+/**
+ * \brief Decode one UTF-8 symbol from contiguous byte sequence.
+ *
+ * The sequence length is defined by the first byte. Illegal sequence (overlong form,
+ * surrogate, code above 0x10FFFF, bad continuation byte) is consumed entirely and decoded
+ * as 0, the same way Utf8Iterator does.
+ *
+ * \param      begin Pointer to the first byte of the symbol.
+ * \param      end   End of the byte sequence, must be greater than begin.
+ * \param[out] code  Decoded UTF-32 code or 0 for illegal sequence.
+ * \return           Number of bytes consumed or 0 if the sequence is truncated by the end.
+ */
+inline size_t DecodeUtf8Symbol(const uint8_t* begin, const uint8_t* end, uint32_t& code) {
+  const uint8_t lead = begin[0];
+  if (lead < 0x80) {
+    code = lead;
+    return 1;
+  }
+
+  const size_t len = GetUtf8SequenceLength(lead);
+  if (static_cast<size_t>(end - begin) < len) {
+    code = 0;
+    return 0;
+  }
+
+  code = 0;
+  switch (len) {
+    case 2:
+      if (lead >= 0xC2 and (begin[1] & 0xC0) == 0x80) {
+        code = ((lead & 0x1Fu) << 6) | (begin[1] & 0x3Fu);
+      }
+      break;
+    case 3: {
+      const uint8_t min = lead == 0xE0 ? 0xA0 : 0x80;
+      const uint8_t max = lead == 0xED ? 0x9F : 0xBF;
+      if (begin[1] >= min and begin[1] <= max and (begin[2] & 0xC0) == 0x80) {
+        code = ((lead & 0x0Fu) << 12) | ((begin[1] & 0x3Fu) << 6) | (begin[2] & 0x3Fu);
+      }
+      break;
+    }
+    case 4: {
+      const uint8_t min = lead == 0xF0 ? 0x90 : 0x80;
+      const uint8_t max = lead == 0xF4 ? 0x8F : 0xBF;
+      if (lead <= 0xF4 and begin[1] >= min and begin[1] <= max
+          and (begin[2] & 0xC0) == 0x80 and (begin[3] & 0xC0) == 0x80) {
+        code = ((lead & 0x07u) << 18) | ((begin[1] & 0x3Fu) << 12) | ((begin[2] & 0x3Fu) << 6) | (begin[3] & 0x3Fu);
+      }
+      break;
+    }
+    default: // Stray continuation byte or obsolete 5 and 6 byte forms.
+      break;
+  }
+  return len;
+}
+
+/**
+ * \brief Decode contiguous UTF-8 byte sequence to UTF-32 codes.
+ *
+ * An each UTF-8 sequence produces one code, illegal sequence produces 0. Truncated
+ * sequence at the end of input is dropped. So the output is the same as the one of
+ * Utf8Iterator. ASCII and Cyrillic texts are decoded by vector instructions, the
+ * implementation is selected in runtime by CPU features.
+ *
+ * \param      begin Begin of UTF-8 bytes.
+ * \param      end   End of UTF-8 bytes.
+ * \param[out] out   Output buffer, must have place for (end - begin) codes.
+ * \return           Number of codes written.
+ */
+size_t DecodeUtf8(const char* begin, const char* end, uint32_t* out);
+
+/**
+ * \brief Decode contiguous UTF-8 byte sequence to UTF-32 codes.
+ *
+ * \param      begin Begin of UTF-8 bytes.
+ * \param      end   End of UTF-8 bytes.
+ * \param[out] out   Output buffer, it is resized to number of decoded codes.
+ * \return           Number of codes written.
+ */
+size_t DecodeUtf8(const char* begin, const char* end, std::vector<uint32_t>& out);
+
+namespace details {
+
+/**
+ * \brief Decode by the passed implementation.
+ *
+ * The implementation must be supported by the CPU, see IsSimdLevelSupported().
+ */
+size_t DecodeUtf8(SimdLevel level, const char* begin, const char* end, uint32_t* out);
+
+}  // namespace details.
+
+}} // namespace strutext, encode.
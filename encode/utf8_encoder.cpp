@@ -0,0 +1,279 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Bulk UTF-32 to UTF-8 encoding implementation.
+ * \author Vladimir Lapshin.
+ */
+
+#include "utf8_encoder.h"
+#include "utf8_generator.h"
+#include "utf8_compact_table.h"
+
+#ifdef STRUTEXT_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace strutext { namespace encode {
+
+namespace {
+
+/// Length of UTF-8 sequence for the code.
+inline size_t GetSequenceLength(uint32_t code) {
+  if (code < 0x80u) {
+    return 1;
+  } else if (code < 0x800u) {
+    return 2;
+  } else if (code < 0x10000u) {
+    return 3;
+  } else if (code <= strutext::symbols::MAX_LEGAL_UTF32) {
+    return 4;
+  }
+  // Replacement symbol.
+  return 3;
+}
+
+/// Plain length calculation.
+size_t GetLengthScalar(const uint32_t* pos, const uint32_t* end) {
+  size_t len = 0;
+  for (; pos != end; ++pos) {
+    len += GetSequenceLength(*pos);
+  }
+  return len;
+}
+
+/// Plain encoding.
+size_t EncodeScalar(const uint32_t* pos, const uint32_t* end, char* out) {
+  char* const begin = out;
+  for (; pos != end; ++pos) {
+    out = GetUtf8Sequence(*pos, out);
+  }
+  return out - begin;
+}
+
+#ifdef STRUTEXT_X86_SIMD
+
+// The vector length counters are flushed after this number of blocks to avoid overflow.
+const size_t MAX_COUNTER_BLOCKS = 1 << 16;
+
+/// Sum of 32-bit lanes.
+inline size_t SumLanes(__m128i counters) {
+  uint32_t lanes[4];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), counters);
+  return static_cast<size_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+}
+
+/**
+ * \brief SSE2 length calculation.
+ *
+ * Each code gives 1 byte plus 1 for each exceeded threshold 0x7F, 0x7FF, 0xFFFF minus 1
+ * for illegal code, which is replaced by three bytes symbol. Codes are compared as
+ * signed numbers, so the sign bit is inverted.
+ */
+size_t GetLengthSse2(const uint32_t* pos, const uint32_t* end) {
+  const __m128i sign = _mm_set1_epi32(static_cast<int>(0x80000000u));
+  const __m128i one_byte_max = _mm_set1_epi32(static_cast<int>(0x7Fu ^ 0x80000000u));
+  const __m128i two_bytes_max = _mm_set1_epi32(static_cast<int>(0x7FFu ^ 0x80000000u));
+  const __m128i three_bytes_max = _mm_set1_epi32(static_cast<int>(0xFFFFu ^ 0x80000000u));
+  const __m128i legal_max = _mm_set1_epi32(static_cast<int>(strutext::symbols::MAX_LEGAL_UTF32 ^ 0x80000000u));
+  size_t len = 0;
+  while (end - pos >= 4) {
+    __m128i counters = _mm_setzero_si128();
+    for (size_t blocks = 0; blocks < MAX_COUNTER_BLOCKS and end - pos >= 4; ++blocks, pos += 4) {
+      const __m128i codes = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)), sign);
+      counters = _mm_sub_epi32(counters, _mm_cmpgt_epi32(codes, one_byte_max));
+      counters = _mm_sub_epi32(counters, _mm_cmpgt_epi32(codes, two_bytes_max));
+      counters = _mm_sub_epi32(counters, _mm_cmpgt_epi32(codes, three_bytes_max));
+      counters = _mm_add_epi32(counters, _mm_cmpgt_epi32(codes, legal_max));
+      len += 4;
+    }
+    len += SumLanes(counters);
+  }
+  return len + GetLengthScalar(pos, end);
+}
+
+/// SSE2 encoding, ASCII is processed by 16 code blocks.
+size_t EncodeSse2(const uint32_t* pos, const uint32_t* end, char* out) {
+  char* const begin = out;
+  const __m128i non_ascii_bits = _mm_set1_epi32(~0x7F);
+  while (end - pos >= 16) {
+    const __m128i* src = reinterpret_cast<const __m128i*>(pos);
+    const __m128i a = _mm_loadu_si128(src);
+    const __m128i b = _mm_loadu_si128(src + 1);
+    const __m128i c = _mm_loadu_si128(src + 2);
+    const __m128i d = _mm_loadu_si128(src + 3);
+    const __m128i all = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(all, non_ascii_bits), _mm_setzero_si128())) == 0xFFFF) {
+      const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), bytes);
+      out += 16;
+    } else {
+      out += EncodeScalar(pos, pos + 16, out);
+    }
+    pos += 16;
+  }
+  return (out - begin) + EncodeScalar(pos, end, out);
+}
+
+/// AVX2 length calculation, see GetLengthSse2().
+__attribute__((target("avx2")))
+size_t GetLengthAvx2(const uint32_t* pos, const uint32_t* end) {
+  const __m256i sign = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+  const __m256i one_byte_max = _mm256_set1_epi32(static_cast<int>(0x7Fu ^ 0x80000000u));
+  const __m256i two_bytes_max = _mm256_set1_epi32(static_cast<int>(0x7FFu ^ 0x80000000u));
+  const __m256i three_bytes_max = _mm256_set1_epi32(static_cast<int>(0xFFFFu ^ 0x80000000u));
+  const __m256i legal_max = _mm256_set1_epi32(static_cast<int>(strutext::symbols::MAX_LEGAL_UTF32 ^ 0x80000000u));
+  size_t len = 0;
+  while (end - pos >= 8) {
+    __m256i counters = _mm256_setzero_si256();
+    for (size_t blocks = 0; blocks < MAX_COUNTER_BLOCKS and end - pos >= 8; ++blocks, pos += 8) {
+      const __m256i codes = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos)), sign);
+      counters = _mm256_sub_epi32(counters, _mm256_cmpgt_epi32(codes, one_byte_max));
+      counters = _mm256_sub_epi32(counters, _mm256_cmpgt_epi32(codes, two_bytes_max));
+      counters = _mm256_sub_epi32(counters, _mm256_cmpgt_epi32(codes, three_bytes_max));
+      counters = _mm256_add_epi32(counters, _mm256_cmpgt_epi32(codes, legal_max));
+      len += 8;
+    }
+    len += SumLanes(_mm256_castsi256_si128(counters)) + SumLanes(_mm256_extracti128_si256(counters, 1));
+  }
+  return len + GetLengthScalar(pos, end);
+}
+
+/**
+ * \brief AVX2 encoding.
+ *
+ * ASCII blocks are packed. Blocks of codes below 0x10000 are converted to UTF-8 sequences
+ * in 32-bit lanes and compacted by shuffle.
+ */
+__attribute__((target("avx2")))
+size_t EncodeAvx2(const uint32_t* pos, const uint32_t* end, char* out) {
+  const details::Utf8CompactTable& table = details::GetUtf8CompactTable();
+  char* const begin = out;
+  const __m256i non_ascii_bits = _mm256_set1_epi32(~0x7F);
+  const __m256i non_bmp_bits = _mm256_set1_epi32(~0xFFFF);
+  const __m256i one_byte_max = _mm256_set1_epi32(0x7F);
+  const __m256i two_bytes_max = _mm256_set1_epi32(0x7FF);
+  const __m256i payload = _mm256_set1_epi32(0x3F);
+  const __m256i continuation = _mm256_set1_epi32(0x80);
+  const __m256i two_bytes_lead = _mm256_set1_epi32(0xC0);
+  const __m256i three_bytes_lead = _mm256_set1_epi32(0xE0);
+  while (end - pos >= 8) {
+    const __m256i codes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+    if (_mm256_testz_si256(codes, non_ascii_bits)) {
+      const __m128i words = _mm_packs_epi32(_mm256_castsi256_si128(codes), _mm256_extracti128_si256(codes, 1));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(words, words));
+      out += 8;
+    } else if (end - pos >= 24 and _mm256_testz_si256(codes, non_bmp_bits)) {
+      // 16 byte stores go beyond the block sequences, but at least 16 codes are left to encode.
+      // So the stored garbage is overwritten later.
+      const __m256i low = _mm256_or_si256(_mm256_and_si256(codes, payload), continuation);
+      const __m256i middle = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi32(codes, 6), payload), continuation);
+      const __m256i two_bytes = _mm256_or_si256(
+          _mm256_or_si256(_mm256_srli_epi32(codes, 6), two_bytes_lead), _mm256_slli_epi32(low, 8));
+      const __m256i three_bytes = _mm256_or_si256(
+          _mm256_or_si256(_mm256_srli_epi32(codes, 12), three_bytes_lead),
+          _mm256_or_si256(_mm256_slli_epi32(middle, 8), _mm256_slli_epi32(low, 16)));
+      const __m256i is_two = _mm256_cmpgt_epi32(codes, one_byte_max);
+      const __m256i is_three = _mm256_cmpgt_epi32(codes, two_bytes_max);
+      const __m256i sequences =
+          _mm256_blendv_epi8(_mm256_blendv_epi8(codes, two_bytes, is_two), three_bytes, is_three);
+
+      const unsigned two_mask = _mm256_movemask_ps(_mm256_castsi256_ps(is_two));
+      const unsigned three_mask = _mm256_movemask_ps(_mm256_castsi256_ps(is_three));
+      const unsigned low_index = (two_mask & 0xF) | ((three_mask & 0xF) << 4);
+      const unsigned high_index = (two_mask >> 4) | (three_mask & 0xF0);
+      const __m256i shuffle = _mm256_inserti128_si256(
+          _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(table.shuffle_[low_index]))),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(table.shuffle_[high_index])), 1);
+      const __m256i bytes = _mm256_shuffle_epi8(sequences, shuffle);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(bytes));
+      out += table.len_[low_index];
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_extracti128_si256(bytes, 1));
+      out += table.len_[high_index];
+    } else {
+      out += EncodeScalar(pos, pos + 8, out);
+    }
+    pos += 8;
+  }
+  return (out - begin) + EncodeScalar(pos, end, out);
+}
+
+#endif  // STRUTEXT_X86_SIMD
+
+typedef size_t (*LengthFunction)(const uint32_t*, const uint32_t*);
+typedef size_t (*EncodeFunction)(const uint32_t*, const uint32_t*, char*);
+
+/// Get length implementation by the instruction set.
+LengthFunction GetLengthFunction(SimdLevel level) {
+  switch (level) {
+#ifdef STRUTEXT_X86_SIMD
+    case AVX2_SIMD_LEVEL:
+      return GetLengthAvx2;
+    case SSE2_SIMD_LEVEL:
+      return GetLengthSse2;
+#endif
+    default:
+      return GetLengthScalar;
+  }
+}
+
+/// Get encoding implementation by the instruction set.
+EncodeFunction GetEncodeFunction(SimdLevel level) {
+  switch (level) {
+#ifdef STRUTEXT_X86_SIMD
+    case AVX2_SIMD_LEVEL:
+      return EncodeAvx2;
+    case SSE2_SIMD_LEVEL:
+      return EncodeSse2;
+#endif
+    default:
+      return EncodeScalar;
+  }
+}
+
+}  // namespace.
+
+const details::Utf8CompactTable& details::GetUtf8CompactTable() {
+  static const Utf8CompactTable table;
+  return table;
+}
+
+size_t details::GetUtf8Length(SimdLevel level, const uint32_t* begin, const uint32_t* end) {
+  return GetLengthFunction(level)(begin, end);
+}
+
+size_t details::EncodeUtf8(SimdLevel level, const uint32_t* begin, const uint32_t* end, char* out) {
+  return GetEncodeFunction(level)(begin, end, out);
+}
+
+size_t GetUtf8Length(const uint32_t* begin, const uint32_t* end) {
+  static const LengthFunction get_length = GetLengthFunction(GetSimdLevel());
+  return get_length(begin, end);
+}
+
+size_t EncodeUtf8(const uint32_t* begin, const uint32_t* end, char* out) {
+  static const EncodeFunction encode = GetEncodeFunction(GetSimdLevel());
+  return encode(begin, end, out);
+}
+
+size_t EncodeUtf8(const uint32_t* begin, const uint32_t* end, std::string& out) {
+  const size_t len = GetUtf8Length(begin, end);
+  if (len == 0) {
+    return 0;
+  }
+  const size_t prev_size = out.size();
+  out.resize(prev_size + len);
+  return EncodeUtf8(begin, end, &out[prev_size]);
+}
+
+}} // namespace strutext, encode.
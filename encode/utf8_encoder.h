@@ -0,0 +1,85 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Bulk UTF-32 to UTF-8 encoding.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+
+#include "cpu_features.h"
+
+namespace strutext { namespace encode {
+
+/**
+ * \brief Calculate length of UTF-8 text for UTF-32 codes.
+ *
+ * Illegal codes (above 0x10FFFF) are counted as replacement symbol 0xFFFD.
+ *
+ * \param  begin Begin of UTF-32 codes.
+ * \param  end   End of UTF-32 codes.
+ * \return       Number of UTF-8 bytes.
+ */
+size_t GetUtf8Length(const uint32_t* begin, const uint32_t* end);
+
+/**
+ * \brief Encode UTF-32 codes to contiguous UTF-8 buffer.
+ *
+ * The output is the same as the one of GetUtf8Sequence(): illegal codes are replaced by
+ * 0xFFFD. Blocks of one, two and three bytes sequences are encoded by vector instructions,
+ * the implementation is selected in runtime by CPU features.
+ *
+ * \param      begin Begin of UTF-32 codes.
+ * \param      end   End of UTF-32 codes.
+ * \param[out] out   Output buffer, must have place for GetUtf8Length(begin, end) bytes.
+ * \return           Number of bytes written.
+ */
+size_t EncodeUtf8(const uint32_t* begin, const uint32_t* end, char* out);
+
+/**
+ * \brief Append UTF-8 encoded UTF-32 codes to the string.
+ *
+ * The string memory is reserved once by the precalculated length.
+ *
+ * \param      begin Begin of UTF-32 codes.
+ * \param      end   End of UTF-32 codes.
+ * \param[out] out   The string to append to.
+ * \return           Number of bytes appended.
+ */
+size_t EncodeUtf8(const uint32_t* begin, const uint32_t* end, std::string& out);
+
+namespace details {
+
+/**
+ * \brief Calculate UTF-8 length by the passed implementation.
+ *
+ * The implementation must be supported by the CPU, see IsSimdLevelSupported().
+ */
+size_t GetUtf8Length(SimdLevel level, const uint32_t* begin, const uint32_t* end);
+
+/**
+ * \brief Encode by the passed implementation.
+ *
+ * The implementation must be supported by the CPU, see IsSimdLevelSupported().
+ */
+size_t EncodeUtf8(SimdLevel level, const uint32_t* begin, const uint32_t* end, char* out);
+
+}  // namespace details.
+
+}} // namespace strutext, encode.
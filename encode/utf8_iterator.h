@@ -25,6 +25,8 @@
 
 #include <boost/iterator/iterator_facade.hpp>
 
+#include "utf8_decoder.h"
+
 namespace strutext { namespace encode {
 
 /**
@@ -74,7 +76,9 @@ struct Utf8Symbol {
  *
  * The class performs decoding of UTF-8 symbols to UNICODE32 codes. The class is implemented
  * by basing on Boost iterator library. The end iterator is initialized by default constructor.
- * All end iterators are equal.
+ * All end iterators are equal. For const char* streams the symbols are read by the same decoder
+ * as DecodeUtf8() uses, for other iterators the sequences are read byte by byte. For bulk
+ * decoding of contiguous memory DecodeUtf8() is much faster.
  *
  * Template parameters:
  *   ByteIterator Forward итератор of byte stream.
@@ -133,7 +137,33 @@ class Utf8Iterator : public  boost::iterator_facade<
     return true;
   }
 
-  void RealIncrement() {
+  /// Read UTF-8 sequence from contiguous memory.
+  void ReadSequence(const char* pos) {
+    const uint8_t* begin = reinterpret_cast<const uint8_t*>(pos);
+    const uint8_t* end = reinterpret_cast<const uint8_t*>(end_);
+    uint32_t code;
+    const size_t len = DecodeUtf8Symbol(begin, end, code);
+    if (len == 0) {
+      // Truncated sequence, go to the end.
+      symbol_.utf32_ = 0;
+      symbol_.len_ = 0;
+      byte_pos_ += (end - begin) - 1;
+      iter_ = end_;
+      return;
+    }
+    std::memcpy(symbol_.chain_, begin, len);
+    symbol_.len_ = len;
+    symbol_.utf32_ = code;
+    iter_ += len - 1;
+    byte_pos_ += len - 1;
+    if (code != 0) {
+      ++sym_pos_;
+    }
+  }
+
+  /// Read UTF-8 sequence from generic byte stream.
+  template <typename Iterator>
+  void ReadSequence(const Iterator&) {
     // How many bytes in UTF-8 sequence?
     static const unsigned TRAILING_BYTES[256] = {
       0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0, // NOLINT
@@ -209,6 +239,24 @@ class Utf8Iterator : public  boost::iterator_facade<
     }
   }
 
+  void RealIncrement() {
+    if (iter_ == end_) {
+      return;
+    }
+
+    // ASCII is the most frequent case.
+    const uint8_t first = static_cast<uint8_t>(*iter_);
+    if (first < 0x80) {
+      symbol_.chain_[0] = first;
+      symbol_.len_ = 1;
+      symbol_.utf32_ = first;
+      ++sym_pos_;
+      return;
+    }
+
+    ReadSequence(iter_);
+  }
+
   /// Next symbol getting.
   inline void increment() {
     if (not Next()) {
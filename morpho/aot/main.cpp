@@ -36,6 +36,7 @@
 #include "symbols.h"
 #include "morpho_modifier.h"
 #include "morpho.h"
+#include "morpho_image.h"
 #include "aot_parser.h"
 #include "eng_aot_parser.h"
 #include "rus_aot_parser.h"
@@ -250,7 +251,8 @@ void ReadDictionarySection(std::ifstream& mfile, strutext::morpho::Morphologist<
 }
 
 template<class Alphabet>
-void ReadDictFile(strutext::morpho::AotParser::Ptr parser, const std::string& dname, const std::string& bname, const Tabs& tabs) {
+void ReadDictFile(strutext::morpho::AotParser::Ptr parser, const std::string& dname, const std::string& bname,
+                  const std::string& iname, bool compile_forms, bool index_suffixes, const Tabs& tabs) {
   std::cerr << "Starting parse dictionary file...\n";
   strutext::morpho::Morphologist<Alphabet> morpher;
 
@@ -265,6 +267,20 @@ void ReadDictFile(strutext::morpho::AotParser::Ptr parser, const std::string& dn
   DropSection(dic_file);
   ReadDictionarySection(dic_file, morpher);
 
+  // Build the word form automaton if needed.
+  if (compile_forms) {
+    std::cerr << "Start word forms compilation...\n";
+    morpher.CompileForms();
+    std::cerr << "Word forms compilation completed\n";
+  }
+
+  // Build the reverse suffix index if needed.
+  if (index_suffixes) {
+    std::cerr << "Start suffix index building...\n";
+    morpher.BuildSuffixIndex();
+    std::cerr << "Suffix index building completed\n";
+  }
+
   // Serialize morphologist object.
   std::cerr << "Start serialization...\n";
   std::ofstream bfile(bname.c_str());
@@ -274,6 +290,16 @@ void ReadDictFile(strutext::morpho::AotParser::Ptr parser, const std::string& dn
   morpher.Serialize(bfile);
   std::cerr << "Serialization completed\n";
 
+  // Write memory mapped image if needed.
+  if (not iname.empty()) {
+    std::ofstream ifile(iname.c_str(), std::ios::binary);
+    if (not ifile.is_open()) {
+      throw std::invalid_argument(("cannot open dictionary image file: \"" + iname + "\"").c_str());
+    }
+    strutext::morpho::MorphoImage::Write(morpher, ifile);
+    std::cerr << "Image writing completed\n";
+  }
+
   std::cerr << "End of reading dictionary file\n";
 }
 
@@ -288,6 +314,9 @@ int main(int argc, char* argv[]) {
       ("tab,t", po::value<std::string>(), "tab file name")
       ("dict,d", po::value<std::string>(), "dictionary file name")
       ("bin,b", po::value<std::string>(), "binary dictionary file name")
+      ("image,i", po::value<std::string>(), "memory mapped dictionary image file name (optional)")
+      ("forms,f", "compile word form automaton for faster analysis (optional)")
+      ("suffix-index,x", "build reverse suffix index to prune candidate bases (optional)")
       ("model,m", po::value<std::string>(), "language model: eng, rus")
       ("verbose,v", "produce process info to stderr");
 
@@ -324,6 +353,14 @@ int main(int argc, char* argv[]) {
       return 1;
     }
 
+    std::string image_file_name;
+    if (vm.count("image")) {
+      image_file_name = vm["image"].as<std::string>();
+    }
+
+    const bool compile_forms = vm.count("forms") > 0;
+    const bool index_suffixes = vm.count("suffix-index") > 0;
+
     std::string model;
     if (vm.count("model")) {
       model = vm["model"].as<std::string>();
@@ -349,9 +386,11 @@ int main(int argc, char* argv[]) {
     std::cerr << "Parsing tab file completed, " << tabs.size() << " tabs extracted\n";
 
     if (model == "rus") {
-      ReadDictFile<strutext::morpho::RussianAlphabet>(parser, dict_file_name, bin_file_name, tabs);
+      ReadDictFile<strutext::morpho::RussianAlphabet>(parser, dict_file_name, bin_file_name, image_file_name, compile_forms,
+                                                      index_suffixes, tabs);
     } else if (model == "eng") {
-      ReadDictFile<strutext::morpho::EnglishAlphabet>(parser, dict_file_name, bin_file_name, tabs);
+      ReadDictFile<strutext::morpho::EnglishAlphabet>(parser, dict_file_name, bin_file_name, image_file_name, compile_forms,
+                                                      index_suffixes, tabs);
     }
   } catch (const std::exception& err) {
     std::cerr << err.what() << "\n";
@@ -16,15 +16,50 @@
  * \author Vladimir Lapshin.
  */
 
+#include <stdexcept>
+
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 #include <boost/serialization/string.hpp>
-#include <boost/serialization/map.hpp>
+#include <boost/serialization/vector.hpp>
 
 #include "base_storage.h"
 
 namespace strutext { namespace morpho {
 
+void BaseStorage::Add(uint32_t lem_id, uint32_t line_id, const std::string& base, const std::string& main_form) {
+  if (lem_id > kMaxLemmaId) {
+    throw std::invalid_argument("invalid lemma id passed");
+  }
+  if (lem_id < storage_.size() and storage_[lem_id].line_id_ != kNoLine) {
+    return;
+  }
+  LemmaInfo info;
+  info.line_id_ = line_id;
+  info.base_ = AddText(base);
+  info.main_form_ = AddText(main_form);
+  if (lem_id >= storage_.size()) {
+    storage_.resize(static_cast<size_t>(lem_id) + 1);
+  }
+  storage_[lem_id] = info;
+}
+
+StringRef BaseStorage::AddText(const std::string& text) {
+  // The text is put to the pool end to be found in the index, it is removed if it is found.
+  const size_t pool_size = pool_.size();
+  StringRef ref;
+  ref.offset_ = pool_size;
+  ref.len_ = text.size();
+  pool_.append(text);
+  TextIndex::const_iterator it = index_.find(ref);
+  if (it != index_.end()) {
+    pool_.resize(pool_size);
+    return *it;
+  }
+  index_.insert(ref);
+  return ref;
+}
+
 /// Serialization implementation.
 void BaseStorage::Serialize(std::ostream& os) const {
   boost::archive::text_oarchive oa(os);
@@ -35,6 +70,7 @@ void BaseStorage::Serialize(std::ostream& os) const {
 void BaseStorage::Deserialize(std::istream& is) {
   boost::archive::text_iarchive ia(is);
   ia >> *this;
+  ReleaseIndex();
 }
 
 }} // namespace strutext, morpho.
@@ -19,21 +19,37 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 
 #include <string>
-#include <map>
+#include <vector>
 #include <iostream>
 #include <memory>
 
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/unordered_set.hpp>
+#include <boost/serialization/access.hpp>
+
+#include "suffix_storage.h"
 
 namespace strutext { namespace morpho {
 
 // Forward declaration of MorphoModifier class.
 class MorphoModifier;
 
-/// Simple storage for word bases.
+// Forward declaration of MorphoImage class.
+struct MorphoImage;
+
+/**
+ * \brief Storage for word bases.
+ *
+ * Lemma identifiers are dense, so the lemmas are kept in the array indexed by identifier. The
+ * base and main form texts are kept in one pool, equal texts are put to the pool once. The base
+ * is coded by the alphabet and the main form is UTF-8 text, so they are not shared. Texts are
+ * returned as pointer and length without copy, and no memory is allocated per lemma.
+ */
 class BaseStorage : boost::noncopyable {
   // Using boost::serialization.
   friend class boost::serialization::access;
@@ -42,45 +58,96 @@ public:
   /// Class object pointer type.
   typedef boost::shared_ptr<BaseStorage> Ptr;
 
-private:
-  /// Lemma info.
+  /// Line identifier of absent lemma.
+  static const uint32_t kNoLine = 0xFFFFFFFF;
+
+  /// The maximal lemma identifier, the storage size is one greater.
+  static const uint32_t kMaxLemmaId = 0xFFFFFFFE;
+
+  /// Lemma info, the texts are in the pool.
   struct LemmaInfo {
     // Using boost::serialization.
     friend class boost::serialization::access;
 
+    /// Default initialization: absent lemma.
+    LemmaInfo()
+      : line_id_(kNoLine) {
+      base_.offset_ = base_.len_ = 0;
+      main_form_.offset_ = main_form_.len_ = 0;
+    }
+
     /// Boost serialization implementation.
     template<class Archive>
     void serialize(Archive& ar, const unsigned version) {
-      ar & base_;
-      ar & main_form_;
       ar & line_id_;
+      ar & base_.offset_;
+      ar & base_.len_;
+      ar & main_form_.offset_;
+      ar & main_form_.len_;
+    }
+
+    uint32_t  line_id_;   ///< Line id for this base.
+    StringRef base_;      ///< The base text.
+    StringRef main_form_; ///< The main form text.
+  };
+
+private:
+  /// Type of lemma list, lemma identifier is the index.
+  typedef std::vector<LemmaInfo> LemInfoList;
+
+  /// Hash of the pool text.
+  struct TextHash {
+    explicit TextHash(const std::string& pool) : pool_(&pool) {}
+
+    size_t operator()(const StringRef& ref) const {
+      return boost::hash_range(pool_->begin() + ref.offset_, pool_->begin() + ref.offset_ + ref.len_);
+    }
+
+    const std::string* pool_; ///< The pool.
+  };
+
+  /// Equality of the pool texts.
+  struct TextEqual {
+    explicit TextEqual(const std::string& pool) : pool_(&pool) {}
+
+    bool operator()(const StringRef& left, const StringRef& right) const {
+      return left.len_ == right.len_ and pool_->compare(left.offset_, left.len_, *pool_, right.offset_, right.len_) == 0;
     }
 
-    std::string base_;      ///< The base text.
-    std::string main_form_; ///< The main form text.
-    uint32_t    line_id_;   ///< Line id for this base.
+    const std::string* pool_; ///< The pool.
   };
 
-  /// Type of lem id to base and line id mapping.
-  typedef std::map<uint32_t, LemmaInfo> LemInfoList;
+  /// Type of index of the pool texts.
+  typedef boost::unordered_set<StringRef, TextHash, TextEqual> TextIndex;
 
   /// Friend declaration of modifier class.
   friend class MorphoModifier;
 
+  /// Friend declaration of image writer class.
+  friend struct MorphoImage;
+
 public:
+  /// Default initialization.
+  BaseStorage()
+    : index_(0, TextHash(pool_), TextEqual(pool_)) {}
+
+  /// Get number of lemma identifiers, the maximal identifier plus one.
+  size_t GetNumOfLemmas() const { return storage_.size(); }
+
   /**
-   * \brief Get suffix attributes.
+   * \brief Get lemma base and line.
    *
    * \param      lem_id  Identifier of a lemma.
    * \param[out] line_id Line id found if any.
    * \param[out] base    Base found if any.
+   * \param[out] len     Length of the base.
    * \return             True if the base having the passed id is found.
    */
-  bool Search(uint32_t lem_id, uint32_t& line_id, std::string& base) const {
-    LemInfoList::const_iterator info_it = storage_.find(lem_id);
-    if (info_it != storage_.end()) {
-      line_id = info_it->second.line_id_;
-      base = info_it->second.base_;
+  bool Search(uint32_t lem_id, uint32_t& line_id, const char*& base, size_t& len) const {
+    if (const LemmaInfo* info = GetLemma(lem_id)) {
+      line_id = info->line_id_;
+      base = GetText(info->base_);
+      len = info->base_.len_;
       return true;
     }
     return false;
@@ -89,20 +156,36 @@ public:
   /**
    * \brief Get main form text.
    *
-   * \param      lem_id  Identifier of a lemma.
-   * \param[out] line_id Line id found if any.
-   * \param[out] base    Base found if any.
-   * \return             True if the base having the passed id is found.
+   * \param      lem_id    Identifier of a lemma.
+   * \param[out] main_form Main form found if any.
+   * \param[out] len       Length of the main form.
+   * \return               True if the base having the passed id is found.
    */
-  bool SearchMainForm(uint32_t lem_id, std::string& main_form) const {
-    LemInfoList::const_iterator info_it = storage_.find(lem_id);
-    if (info_it != storage_.end()) {
-      main_form = info_it->second.main_form_;
+  bool SearchMainForm(uint32_t lem_id, const char*& main_form, size_t& len) const {
+    if (const LemmaInfo* info = GetLemma(lem_id)) {
+      main_form = GetText(info->main_form_);
+      len = info->main_form_.len_;
       return true;
     }
     return false;
   }
 
+  /**
+   * \brief Add lemma, the lemma already added is not changed.
+   *
+   * \param lem_id    Identifier of the lemma, at most kMaxLemmaId.
+   * \param line_id   Line id of the base.
+   * \param base      The base text.
+   * \param main_form The main form text.
+   */
+  void Add(uint32_t lem_id, uint32_t line_id, const std::string& base, const std::string& main_form);
+
+  /// Drop the index of texts, the texts added later are not shared with the added ones.
+  void ReleaseIndex() {
+    TextIndex empty(0, TextHash(pool_), TextEqual(pool_));
+    index_.swap(empty);
+  }
+
   /// Serialization implementation.
   void Serialize(std::ostream&) const;
 
@@ -110,13 +193,35 @@ public:
   void Deserialize(std::istream&);
 
 private:
+  /// Get the lemma or NULL.
+  const LemmaInfo* GetLemma(uint32_t lem_id) const {
+    if (lem_id < storage_.size() and storage_[lem_id].line_id_ != kNoLine) {
+      return &storage_[lem_id];
+    }
+    return NULL;
+  }
+
+  /// Get text from the pool.
+  const char* GetText(const StringRef& ref) const { return pool_.data() + ref.offset_; }
+
+  /**
+   * \brief Put the text to the pool if it is absent.
+   *
+   * \param  text The text.
+   * \return      Reference to the text in the pool.
+   */
+  StringRef AddText(const std::string& text);
+
   /// Boost serialization implementation.
   template<class Archive>
   void serialize(Archive& ar, const unsigned version) {
     ar & storage_;
+    ar & pool_;
   }
 
   LemInfoList storage_; ///< List of lemma informations.
+  std::string pool_;    ///< Texts of the lemmas.
+  TextIndex   index_;   ///< Index of the pool texts, used in adding.
 };
 
 }} // namespace strutext, morpho.
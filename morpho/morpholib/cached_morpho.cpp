@@ -0,0 +1,185 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Morphologist with cache of analysis results implementation.
+ * \author Vladimir Lapshin.
+ */
+
+#include <cstring>
+#include <stdexcept>
+
+#include <boost/thread/locks.hpp>
+
+#include "cached_morpho.h"
+
+namespace strutext { namespace morpho {
+
+namespace {
+
+/// Hash of the text, FNV-1a.
+inline size_t GetTextHash(const char* begin, const char* end) {
+  uint32_t hash = 2166136261u;
+  for (; begin != end; ++begin) {
+    hash = (hash ^ static_cast<uint8_t>(*begin)) * 16777619u;
+  }
+  return hash;
+}
+
+/// Memory used by an index node, estimation.
+const size_t kIndexNodeSize = 4 * sizeof(void*);
+
+}  // namespace.
+
+size_t CachedMorphologist::TextHash::operator()(const std::string& text) const {
+  return GetTextHash(text.data(), text.data() + text.size());
+}
+
+size_t CachedMorphologist::TextHash::operator()(const TextRange& text) const {
+  return GetTextHash(text.first, text.second);
+}
+
+bool CachedMorphologist::TextEqual::operator()(const TextRange& left, const std::string& right) const {
+  const size_t len = left.second - left.first;
+  return len == right.size() and std::memcmp(left.first, right.data(), len) == 0;
+}
+
+CachedMorphologist::CachedMorphologist(MorphologistBase::Ptr morph, size_t memory_budget, size_t num_of_shards)
+  : morph_(morph) {
+  if (not morph_) {
+    throw std::invalid_argument("morphologist to cache is not passed");
+  }
+  size_t shards = 1;
+  while (shards < num_of_shards) {
+    shards *= 2;
+  }
+  shard_budget_ = memory_budget / shards;
+  for (size_t i = 0; i < shards; ++i) {
+    shards_.push_back(ShardPtr(new Shard()));
+  }
+}
+
+void CachedMorphologist::Analize(const std::string& text, LemList& lem_list) const {
+  LemmaBuffer buffer;
+  Analize(text.data(), text.data() + text.size(), buffer);
+  lem_list.assign(buffer.begin(), buffer.end());
+}
+
+void CachedMorphologist::Analize(const char* begin, const char* end, LemmaBuffer& buffer) const {
+  const TextRange text(begin, end);
+  // Shard is chosen by the upper bits, the lower ones are used by the index.
+  Shard& shard = *shards_[(TextHash()(text) >> 16) & (shards_.size() - 1)];
+  {
+    boost::lock_guard<boost::mutex> lock(shard.mutex_);
+    WordIndex::const_iterator it = shard.index_.find(text, TextHash(), TextEqual());
+    if (it != shard.index_.end()) {
+      Entry& entry = shard.entries_[it->second];
+      entry.referenced_ = true;
+      buffer.Clear();
+      buffer.lemmas_.assign(entry.lemmas_.begin(), entry.lemmas_.end());
+      ++shard.hits_;
+      return;
+    }
+    ++shard.misses_;
+  }
+
+  // The analysis is performed without the lock.
+  morph_->Analize(begin, end, buffer);
+  Insert(shard, text, buffer);
+}
+
+size_t CachedMorphologist::GetEntrySize(size_t text_len, size_t num_of_lemmas) {
+  return sizeof(Entry) + kIndexNodeSize + 2 * (text_len + 1) + num_of_lemmas * sizeof(Lemma);
+}
+
+void CachedMorphologist::Insert(Shard& shard, const TextRange& text, const LemmaBuffer& buffer) const {
+  const size_t entry_size = GetEntrySize(text.second - text.first, buffer.Size());
+  if (entry_size > shard_budget_) {
+    return;
+  }
+
+  boost::lock_guard<boost::mutex> lock(shard.mutex_);
+  // Other thread may put the word meanwhile.
+  if (shard.index_.find(text, TextHash(), TextEqual()) != shard.index_.end()) {
+    return;
+  }
+  while (shard.memory_ + entry_size > shard_budget_) {
+    Evict(shard);
+  }
+  uint32_t entry_id = shard.entries_.size();
+  if (shard.free_.empty()) {
+    shard.entries_.push_back(Entry());
+  } else {
+    entry_id = shard.free_.back();
+    shard.free_.pop_back();
+  }
+  Entry& entry = shard.entries_[entry_id];
+  entry.text_.assign(text.first, text.second);
+  entry.lemmas_.assign(buffer.begin(), buffer.end());
+  entry.referenced_ = false;
+  entry.used_ = true;
+  shard.index_.insert(std::make_pair(entry.text_, entry_id));
+  shard.memory_ += entry_size;
+}
+
+void CachedMorphologist::Evict(Shard& shard) {
+  // Look for unused entry and give a second chance to referenced ones.
+  for (;;) {
+    if (shard.hand_ >= shard.entries_.size()) {
+      shard.hand_ = 0;
+    }
+    Entry& entry = shard.entries_[shard.hand_++];
+    if (not entry.used_) {
+      continue;
+    } else if (entry.referenced_) {
+      entry.referenced_ = false;
+      continue;
+    }
+    shard.memory_ -= GetEntrySize(entry.text_.size(), entry.lemmas_.size());
+    shard.index_.erase(entry.text_);
+    shard.free_.push_back(shard.hand_ - 1);
+    entry.used_ = false;
+    // Release the entry memory.
+    std::string().swap(entry.text_);
+    std::vector<Lemma>().swap(entry.lemmas_);
+    return;
+  }
+}
+
+CachedMorphologist::Statistics CachedMorphologist::GetStatistics() const {
+  Statistics stat;
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    boost::lock_guard<boost::mutex> lock(shards_[i]->mutex_);
+    stat.hits_ += shards_[i]->hits_;
+    stat.misses_ += shards_[i]->misses_;
+    stat.num_of_words_ += shards_[i]->index_.size();
+    stat.memory_ += shards_[i]->memory_;
+  }
+  return stat;
+}
+
+void CachedMorphologist::Clear() {
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    Shard& shard = *shards_[i];
+    boost::lock_guard<boost::mutex> lock(shard.mutex_);
+    WordIndex().swap(shard.index_);
+    std::vector<Entry>().swap(shard.entries_);
+    std::vector<uint32_t>().swap(shard.free_);
+    shard.hand_ = 0;
+    shard.memory_ = 0;
+    shard.hits_ = 0;
+    shard.misses_ = 0;
+  }
+}
+
+}} // namespace strutext, morpho.
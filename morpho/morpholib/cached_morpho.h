@@ -0,0 +1,211 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Morphologist with cache of analysis results.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include "morpho.h"
+
+namespace strutext { namespace morpho {
+
+/**
+ * \brief Morphologist with cache of analysis results.
+ *
+ * The class wraps any morphologist and keeps results of analysis of recently used words. Word
+ * frequencies of texts are close to Zipf's law, so a small cache serves most of the calls.
+ * The cache is split in shards by word hash, each shard has its own lock, so the object may be
+ * used by several threads. Shards evict words by CLOCK algorithm when the memory budget is
+ * exceeded. Generation calls are passed to the wrapped morphologist as is.
+ */
+class CachedMorphologist : public MorphologistBase {
+public:
+  /// Cache statistics.
+  struct Statistics {
+    /// Default initilization.
+    Statistics()
+      : hits_(0)
+      , misses_(0)
+      , num_of_words_(0)
+      , memory_(0) {}
+
+    uint64_t hits_;         ///< Number of analysis calls served by the cache.
+    uint64_t misses_;       ///< Number of analysis calls passed to the morphologist.
+    size_t   num_of_words_; ///< Number of words in the cache.
+    size_t   memory_;       ///< Memory used by the cache, estimation in bytes.
+  };
+
+  /// Default memory budget, enough for about 100K words.
+  static const size_t kDefaultMemoryBudget = 16 * 1024 * 1024;
+
+  /// Default number of shards.
+  static const size_t kDefaultNumOfShards = 16;
+
+  /**
+   * \brief Initialization.
+   *
+   * \param morph          The morphologist to wrap.
+   * \param memory_budget  Maximal memory used by the cache, in bytes.
+   * \param num_of_shards  Number of shards, rounded up to the power of two.
+   */
+  explicit CachedMorphologist(MorphologistBase::Ptr morph, size_t memory_budget = kDefaultMemoryBudget,
+                              size_t num_of_shards = kDefaultNumOfShards);
+
+  /// Get the wrapped morphologist.
+  const MorphologistBase::Ptr& GetMorphologist() const { return morph_; }
+
+  /**
+   * \brief Implementation of morphological analysis of passed form.
+   *
+   * \param      text     Input text in UTF-8 encoding.
+   * \param[out] lem_list List of lemmas within morphological attributes.
+   */
+  void Analize(const std::string& text, LemList& lem_list) const;
+
+  /**
+   * \brief Implementation of morphological analysis, no memory is allocated if the word is cached.
+   *
+   * \param      begin  Begin of input text in UTF-8 encoding.
+   * \param      end    End of the text.
+   * \param[out] buffer Buffer for lemmas within morphological attributes, its content is replaced.
+   */
+  void Analize(const char* begin, const char* end, LemmaBuffer& buffer) const;
+
+  /**
+   * \brief Generate form.
+   *
+   * \param lem_id The lemma identifier.
+   * \param attrs  The attributes of the form.
+   * \return       Generated text in UTF-8 encoding.
+   */
+  std::string Generate(uint32_t lem_id, uint32_t attrs) const {
+    return morph_->Generate(lem_id, attrs);
+  }
+
+  /**
+   * \brief Generate all lemma's forms.
+   *
+   * \param      lem_id   The lemma identifier.
+   * \param[out] form_set Set of forms generated as UTF-8 texts.
+   * \return              Number of generated forms.
+   */
+  size_t GenAllForms(uint32_t lem_id, std::set<std::string>& form_set) const {
+    return morph_->GenAllForms(lem_id, form_set);
+  }
+
+  /**
+   * \brief Get main form.
+   *
+   * \param      lem_id    The lemma identifier.
+   * \param[out] main_form The main form's text (UTF-8).
+   * \return               True if frm is found.
+   */
+  bool GenMainForm(uint32_t lem_id, std::string& main_form) const {
+    return morph_->GenMainForm(lem_id, main_form);
+  }
+
+  /// Serialization implementation.
+  void Serialize(std::ostream& os) const {
+    morph_->Serialize(os);
+  }
+
+  /// Deserialization implementation, the cache is cleared.
+  void Deserialize(std::istream& is) {
+    morph_->Deserialize(is);
+    Clear();
+  }
+
+  /// Get statistics summed over the shards.
+  Statistics GetStatistics() const;
+
+  /// Drop all the cached words and reset counters.
+  void Clear();
+
+private:
+  /// Cached word.
+  struct Entry {
+    /// Default initilization.
+    Entry()
+      : referenced_(false)
+      , used_(false) {}
+
+    std::string        text_;       ///< Word text.
+    std::vector<Lemma> lemmas_;     ///< Analysis result.
+    bool               referenced_; ///< The word was used since the last clock sweep.
+    bool               used_;       ///< The entry keeps a word.
+  };
+
+  /// Hash of texts, the same for strings and text ranges.
+  struct TextHash {
+    size_t operator()(const std::string& text) const;
+    size_t operator()(const TextRange& text) const;
+  };
+
+  /// Equality of texts.
+  struct TextEqual {
+    bool operator()(const std::string& left, const std::string& right) const { return left == right; }
+    bool operator()(const TextRange& left, const std::string& right) const;
+  };
+
+  /// Type of word index in a shard.
+  typedef boost::unordered_map<std::string, uint32_t, TextHash, TextEqual> WordIndex;
+
+  /// Cache shard.
+  struct Shard {
+    /// Default initilization.
+    Shard()
+      : hand_(0)
+      , memory_(0)
+      , hits_(0)
+      , misses_(0) {}
+
+    boost::mutex          mutex_;   ///< Lock of the shard.
+    WordIndex             index_;   ///< Entry numbers of words.
+    std::vector<Entry>    entries_; ///< Entries, some of them may be free.
+    std::vector<uint32_t> free_;    ///< Free entry numbers.
+    size_t                hand_;    ///< Clock hand.
+    size_t                memory_;  ///< Memory used by entries.
+    uint64_t              hits_;    ///< Number of hits.
+    uint64_t              misses_;  ///< Number of misses.
+  };
+
+  /// Type of shard pointer.
+  typedef boost::shared_ptr<Shard> ShardPtr;
+
+  /// Memory used by the word entry.
+  static size_t GetEntrySize(size_t text_len, size_t num_of_lemmas);
+
+  /// Put the word analysis to the shard.
+  void Insert(Shard& shard, const TextRange& text, const LemmaBuffer& buffer) const;
+
+  /// Evict a word from the shard by clock algorithm.
+  static void Evict(Shard& shard);
+
+  MorphologistBase::Ptr morph_;        ///< The wrapped morphologist.
+  size_t                shard_budget_; ///< Memory budget of each shard.
+  std::vector<ShardPtr> shards_;       ///< The shards.
+};
+
+}} // namespace strutext, morpho.
@@ -0,0 +1,178 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Read only morphologist over memory mapped dictionary image.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "alphabet.h"
+#include "morpho.h"
+#include "morpho_image.h"
+
+namespace strutext { namespace morpho {
+
+/**
+ * \brief Read only morphology library implementation.
+ *
+ * The dictionary is the image written by MorphoImage. Opened by file, the image is mapped to
+ * memory and used as is, so opening takes constant time and all the processes using the same
+ * file share its pages. Template parameter is Alphabet interface implementation, it must be
+ * the same as the image was written with.
+ */
+template <class T>
+class MappedMorphologist : public MorphologistBase {
+  /// Alphabet type definition.
+  typedef Alphabet<T> AlphabetImpl;
+
+public:
+  /// Initialization by empty dictionary.
+  MappedMorphologist() {}
+
+  /**
+   * \brief Initialization by the image file.
+   *
+   * \param path The image file path.
+   */
+  explicit MappedMorphologist(const std::string& path) {
+    view_.Open(path);
+  }
+
+  /**
+   * \brief Map the image file to memory.
+   *
+   * \param path The image file path.
+   */
+  void Open(const std::string& path) {
+    view_.Open(path);
+  }
+
+  /**
+   * \brief Implementation of morphological analysis of passed form.
+   *
+   * \param      text     Input text in UTF-8 encoding.
+   * \param[out] lem_list List of lemmas within morphological attributes.
+   */
+  void Analize(const std::string& text, LemList& lem_list) const {
+    LemmaBuffer buffer;
+    Analize(text.data(), text.data() + text.size(), buffer);
+    lem_list.assign(buffer.begin(), buffer.end());
+  }
+
+  /**
+   * \brief Implementation of morphological analysis without memory allocation.
+   *
+   * \param      begin  Begin of input text in UTF-8 encoding.
+   * \param      end    End of the text.
+   * \param[out] buffer Buffer for lemmas within morphological attributes, its content is replaced.
+   */
+  void Analize(const char* begin, const char* end, LemmaBuffer& buffer) const {
+    // The same phases as Morphologist has, the suffixes are searched in the image.
+    FindBases(alphabet_, view_, begin, end, buffer);
+    for (size_t base = 0; base < buffer.bases_.size(); ++base) {
+      SearchLemmas(view_, base, buffer);
+    }
+  }
+
+  /**
+   * \brief Generate form.
+   *
+   * \param lem_id The lemma identifier.
+   * \param attrs  The attributes of the form.
+   * \return       Generated text in UTF-8 encoding.
+   */
+  std::string Generate(uint32_t lem_id, uint32_t attrs) const {
+    std::string result;
+    if (const MorphoImage::LemmaEntry* lemma = view_.SearchLemma(lem_id)) {
+      const char* suffix = NULL;
+      size_t len = 0;
+      if (view_.SearchSuffix(lemma->line_id_, attrs, suffix, len)) {
+        AppendUtf8(alphabet_, view_.GetText(lemma->base_), lemma->base_.len_, result);
+        if (not IsNullSuffix(suffix, len)) {
+          AppendUtf8(alphabet_, suffix, len, result);
+        }
+      }
+    }
+    return result;
+  }
+
+  /**
+   * \brief Generate all lemma's forms.
+   *
+   * \param      lem_id   The lemma identifier.
+   * \param[out] form_set Set of forms generated as UTF-8 texts.
+   * \return              Number of generated forms.
+   */
+  size_t GenAllForms(uint32_t lem_id, std::set<std::string>& form_set) const {
+    form_set.clear();
+    if (const MorphoImage::LemmaEntry* lemma = view_.SearchLemma(lem_id)) {
+      std::string base_text_utf8;
+      AppendUtf8(alphabet_, view_.GetText(lemma->base_), lemma->base_.len_, base_text_utf8);
+      std::set<std::string> suf_set;
+      view_.GetSuffixSet(lemma->line_id_, suf_set);
+      std::string form;
+      for (std::set<std::string>::iterator suf_it = suf_set.begin(); suf_it != suf_set.end(); ++suf_it) {
+        form = base_text_utf8;
+        if (*suf_it != kNullSuffix) {
+          AppendUtf8(alphabet_, suf_it->data(), suf_it->size(), form);
+        }
+        form_set.insert(form);
+      }
+    }
+    return form_set.size();
+  }
+
+  /**
+   * \brief Get main form.
+   *
+   * \param      lem_id    The lemma identifier.
+   * \param[out] main_form The main form's text (UTF-8).
+   * \return               True if frm is found.
+   */
+  bool GenMainForm(uint32_t lem_id, std::string& main_form) const {
+    if (const MorphoImage::LemmaEntry* lemma = view_.SearchLemma(lem_id)) {
+      main_form.assign(view_.GetText(lemma->main_form_), lemma->main_form_.len_);
+      return true;
+    }
+    return false;
+  }
+
+  /// Serialization implementation, the image is written as is.
+  void Serialize(std::ostream& os) const {
+    os.write(view_.GetData(), view_.GetSize());
+  }
+
+  /// Deserialization implementation, the image is read to memory.
+  void Deserialize(std::istream& is) {
+    view_.Read(is);
+  }
+
+private:
+  /// Is the suffix the empty one?
+  static bool IsNullSuffix(const char* suffix, size_t len) {
+    return len == kNullSuffix.size() and std::memcmp(suffix, kNullSuffix.data(), len) == 0;
+  }
+
+  MorphoImageView view_;     ///< The dictionary image.
+  AlphabetImpl    alphabet_; ///< Alphabet.
+};
+
+}} // namespace strutext, morpho.
@@ -17,3 +17,170 @@
  */
 
 #include "morpho.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <boost/thread/thread.hpp>
+
+namespace strutext { namespace morpho {
+
+namespace {
+
+/// Hash of the text, FNV-1a.
+inline uint32_t GetTextHash(const MorphologistBase::TextRange& text) {
+  uint32_t hash = 2166136261u;
+  for (const char* pos = text.first; pos != text.second; ++pos) {
+    hash = (hash ^ static_cast<uint8_t>(*pos)) * 16777619u;
+  }
+  return hash;
+}
+
+/// Are texts equal?
+inline bool IsEqual(const MorphologistBase::TextRange& left, const MorphologistBase::TextRange& right) {
+  const size_t len = left.second - left.first;
+  return static_cast<size_t>(right.second - right.first) == len and std::memcmp(left.first, right.first, len) == 0;
+}
+
+/**
+ * \brief Find different words of the list.
+ *
+ * \param      words       The word list.
+ * \param[out] unique      Index of the first occurrence of each different word.
+ * \param[out] word_unique Index in unique list for each word.
+ */
+void FindUniqueWords(const MorphologistBase::TextRangeList& words, std::vector<uint32_t>& unique,
+                     std::vector<uint32_t>& word_unique) {
+  // Open addressing hash table of unique list indexes, the size is a power of two.
+  const uint32_t kEmptySlot = UINT32_MAX;
+  size_t table_size = 16;
+  while (table_size < words.size() * 2) {
+    table_size *= 2;
+  }
+  std::vector<uint32_t> table(table_size, kEmptySlot);
+  unique.clear();
+  word_unique.resize(words.size());
+  for (size_t i = 0; i < words.size(); ++i) {
+    size_t slot = GetTextHash(words[i]) & (table_size - 1);
+    while (table[slot] != kEmptySlot and not IsEqual(words[unique[table[slot]]], words[i])) {
+      slot = (slot + 1) & (table_size - 1);
+    }
+    if (table[slot] == kEmptySlot) {
+      table[slot] = unique.size();
+      unique.push_back(i);
+    }
+    word_unique[i] = table[slot];
+  }
+}
+
+/// Analysis of a part of different words.
+struct BatchPart {
+  /// Initialization.
+  BatchPart(const MorphologistBase& morph, const MorphologistBase::TextRangeList& words,
+            const std::vector<uint32_t>& unique, size_t begin, size_t end)
+    : morph_(&morph)
+    , words_(&words)
+    , unique_(&unique)
+    , begin_(begin)
+    , end_(end) {}
+
+  /// Analize the words, the errors are remembered to be passed to the caller thread.
+  void operator()() {
+    try {
+      MorphologistBase::LemmaBuffer buffer;
+      counts_.reserve(end_ - begin_);
+      for (size_t i = begin_; i < end_; ++i) {
+        const MorphologistBase::TextRange& word = (*words_)[(*unique_)[i]];
+        morph_->Analize(word.first, word.second, buffer);
+        lemmas_.insert(lemmas_.end(), buffer.begin(), buffer.end());
+        counts_.push_back(buffer.Size());
+      }
+    } catch (const std::exception& err) {
+      error_ = err.what();
+      if (error_.empty()) {
+        error_ = "batch analysis failed";
+      }
+    } catch (...) {
+      error_ = "batch analysis failed";
+    }
+  }
+
+  const MorphologistBase*                morph_;  ///< The morphologist.
+  const MorphologistBase::TextRangeList* words_;  ///< All the words.
+  const std::vector<uint32_t>*           unique_; ///< Indexes of different words.
+  size_t                                 begin_;  ///< Begin of the part in the unique list.
+  size_t                                 end_;    ///< End of the part in the unique list.
+  std::vector<MorphologistBase::Lemma>   lemmas_; ///< Lemmas found.
+  std::vector<uint32_t>                  counts_; ///< Number of lemmas of each word.
+  std::string                            error_;  ///< Analysis error.
+};
+
+}  // namespace.
+
+void MorphologistBase::AnalizeBatch(const TextRangeList& words, BatchResult& result, size_t num_of_threads) const {
+  std::vector<uint32_t> unique, word_unique;
+  FindUniqueWords(words, unique, word_unique);
+
+  // Split the different words in parts, the first part is analyzed by the caller thread.
+  const size_t num_of_parts = std::max<size_t>(1, std::min(num_of_threads, unique.size() / kMinBatchPerThread));
+  std::vector<BatchPart> parts;
+  parts.reserve(num_of_parts);
+  for (size_t i = 0; i < num_of_parts; ++i) {
+    parts.push_back(BatchPart(*this, words, unique, unique.size() * i / num_of_parts,
+                              unique.size() * (i + 1) / num_of_parts));
+  }
+  // The started threads refer to the parts, they are joined even if a thread cannot be created.
+  boost::thread_group threads;
+  try {
+    for (size_t i = 1; i < parts.size(); ++i) {
+      threads.create_thread(boost::ref(parts[i]));
+    }
+    parts[0]();
+  } catch (...) {
+    threads.join_all();
+    throw;
+  }
+  threads.join_all();
+
+  // Lemmas of different words.
+  std::vector<Lemma> unique_lemmas;
+  std::vector<uint32_t> unique_offsets(1, 0);
+  unique_offsets.reserve(unique.size() + 1);
+  for (size_t i = 0; i < parts.size(); ++i) {
+    if (not parts[i].error_.empty()) {
+      throw std::runtime_error(parts[i].error_);
+    }
+    if (parts.size() == 1) {
+      unique_lemmas.swap(parts[i].lemmas_);
+    } else {
+      unique_lemmas.insert(unique_lemmas.end(), parts[i].lemmas_.begin(), parts[i].lemmas_.end());
+    }
+    for (size_t j = 0; j < parts[i].counts_.size(); ++j) {
+      unique_offsets.push_back(unique_offsets.back() + parts[i].counts_[j]);
+    }
+  }
+
+  // Spread them over all the words.
+  result.lemmas_.clear();
+  result.offsets_.assign(1, 0);
+  result.offsets_.reserve(words.size() + 1);
+  for (size_t i = 0; i < words.size(); ++i) {
+    const uint32_t id = word_unique[i];
+    result.lemmas_.insert(result.lemmas_.end(), unique_lemmas.begin() + unique_offsets[id],
+                          unique_lemmas.begin() + unique_offsets[id + 1]);
+    result.offsets_.push_back(result.lemmas_.size());
+  }
+  result.num_of_unique_ = unique.size();
+}
+
+void MorphologistBase::AnalizeBatch(const std::vector<std::string>& words, BatchResult& result,
+                                    size_t num_of_threads) const {
+  TextRangeList ranges;
+  ranges.reserve(words.size());
+  for (size_t i = 0; i < words.size(); ++i) {
+    ranges.push_back(TextRange(words[i].data(), words[i].data() + words[i].size()));
+  }
+  AnalizeBatch(ranges, result, num_of_threads);
+}
+
+}} // namespace strutext, morpho.
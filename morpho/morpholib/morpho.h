@@ -21,21 +21,29 @@
 #include <stdint.h>
 
 #include <memory>
+#include <algorithm>
+#include <cstring>
 #include <list>
+#include <stdexcept>
 #include <utility>
 #include <iterator>
+#include <string>
+#include <vector>
 
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
 
 #include "utf8_iterator.h"
 #include "utf8_generator.h"
+#include "utf8_encoder.h"
 #include "flex_transitions.h"
+#include "dawg.h"
 #include "serializer.h"
 #include "trie.h"
 #include "fsm_defs.h"
 #include "alphabet.h"
 #include "suffix_storage.h"
+#include "suffix_index.h"
 #include "base_storage.h"
 
 namespace strutext { namespace morpho {
@@ -45,6 +53,14 @@ const std::string kNullSuffix = std::string(1, '\0'); ///< Empty suffix
 // forward declaration of MorphoModifier class.
 class MorphoModifier;
 
+// forward declaration of MorphoImage class.
+struct MorphoImage;
+
+// forward declaration of morphologist classes.
+template <class T> class Morphologist;
+template <class T> class MappedMorphologist;
+class CachedMorphologist;
+
 /// Base morphologist class.
 struct MorphologistBase : private boost::noncopyable {
   /// Smart pointer type.
@@ -69,6 +85,105 @@ struct MorphologistBase : private boost::noncopyable {
   /// Lemma list type definition.
   typedef std::list<Lemma> LemList;
 
+  /**
+   * \brief Reusable output of morphological analysis.
+   *
+   * The buffer keeps found lemmas and working memory of analysis. Memory is not released
+   * between calls, so analysis by the same buffer does not allocate memory after the buffer
+   * has grown to the size of the longest word analyzed. The buffer may not be shared by threads.
+   */
+  class LemmaBuffer {
+    friend struct MorphologistBase;
+    template <class T> friend class Morphologist;
+    template <class T> friend class MappedMorphologist;
+    friend class CachedMorphologist;
+
+  public:
+    /// Lemma list iterator.
+    typedef std::vector<Lemma>::const_iterator const_iterator;
+
+    /// Default number of lemmas and word symbols reserved.
+    static const size_t kDefaultCapacity = 64;
+
+    /**
+     * \brief Initialization.
+     *
+     * \param capacity Number of lemmas and word symbols to reserve memory for.
+     */
+    explicit LemmaBuffer(size_t capacity = kDefaultCapacity)
+      : num_of_candidates_(0) {
+      lemmas_.reserve(capacity);
+      bases_.reserve(capacity);
+      codes_.reserve(capacity);
+      suffixes_.reserve(capacity + 1);
+    }
+
+    /// Number of lemmas found.
+    size_t Size() const { return lemmas_.size(); }
+
+    /// Are lemmas absent?
+    bool Empty() const { return lemmas_.empty(); }
+
+    /// Get the lemma.
+    const Lemma& operator[](size_t i) const { return lemmas_[i]; }
+
+    /// Begin of the lemma list.
+    const_iterator begin() const { return lemmas_.begin(); }
+
+    /// End of the lemma list.
+    const_iterator end() const { return lemmas_.end(); }
+
+    /// Number of the bases, whose suffixes were searched in the suffix storage by the last analysis.
+    size_t GetNumOfCandidates() const { return num_of_candidates_; }
+
+    /// Drop the content, the memory is kept.
+    void Clear() {
+      lemmas_.clear();
+      bases_.clear();
+      codes_.clear();
+      suffixes_.clear();
+      num_of_candidates_ = 0;
+    }
+
+  private:
+    std::vector<Lemma>                          lemmas_;            ///< Found lemmas.
+    std::vector<std::pair<uint64_t, uint32_t> > bases_;             ///< Found bases: trie attribute and base length.
+    std::string                                 codes_;             ///< Alphabet codes of the word.
+    std::vector<uint32_t>                       suffixes_;          ///< Numbers of the word suffixes in the suffix index.
+    size_t                                      num_of_candidates_; ///< Number of suffix storage searches.
+  };
+
+  /// Text range: begin and end of UTF-8 text.
+  typedef std::pair<const char*, const char*> TextRange;
+
+  /// Type of text range list.
+  typedef std::vector<TextRange> TextRangeList;
+
+  /**
+   * \brief Result of batch analysis.
+   *
+   * Lemmas of all the words are kept in one array, lemmas of i-th word are placed in
+   * [offsets_[i], offsets_[i + 1]) range. Memory is not released between batches.
+   */
+  struct BatchResult {
+    /// Default initilization.
+    BatchResult()
+      : num_of_unique_(0) {}
+
+    /// Number of words in the batch.
+    size_t GetNumOfWords() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+
+    /// Number of lemmas of the word.
+    size_t GetNumOfLemmas(size_t word) const { return offsets_[word + 1] - offsets_[word]; }
+
+    std::vector<Lemma>    lemmas_;        ///< Lemmas of all the words.
+    std::vector<uint32_t> offsets_;       ///< Begin of lemmas of each word, plus the end of the last word lemmas.
+    size_t                num_of_unique_; ///< Number of different words in the batch.
+  };
+
+  /// Minimal number of different words analyzed by a thread in batch analysis.
+  static const size_t kMinBatchPerThread = 512;
+
   /// Virtual destruction: the class is inheritable.
   virtual ~MorphologistBase() {}
 
@@ -80,6 +195,36 @@ struct MorphologistBase : private boost::noncopyable {
    */
   virtual void Analize(const std::string& text, LemList& lem_list) const = 0;
 
+  /**
+   * \brief Implementation of morphological analysis without memory allocation.
+   *
+   * \param      begin  Begin of input text in UTF-8 encoding.
+   * \param      end    End of the text.
+   * \param[out] buffer Buffer for lemmas within morphological attributes, its content is replaced.
+   */
+  virtual void Analize(const char* begin, const char* end, LemmaBuffer& buffer) const = 0;
+
+  /**
+   * \brief Morphological analysis of batch of words.
+   *
+   * Repeated words are analyzed once. If threads are allowed and the batch is large, different
+   * words are spread over the threads, the dictionary must not be modified meanwhile.
+   *
+   * \param      words          Words in UTF-8 encoding.
+   * \param[out] result         Lemmas of the words.
+   * \param      num_of_threads Maximal number of threads to use.
+   */
+  void AnalizeBatch(const TextRangeList& words, BatchResult& result, size_t num_of_threads = 1) const;
+
+  /**
+   * \brief Morphological analysis of batch of words.
+   *
+   * \param      words          Words in UTF-8 encoding.
+   * \param[out] result         Lemmas of the words.
+   * \param      num_of_threads Maximal number of threads to use.
+   */
+  void AnalizeBatch(const std::vector<std::string>& words, BatchResult& result, size_t num_of_threads = 1) const;
+
   /**
    * \brief Generate form.
    *
@@ -112,6 +257,137 @@ struct MorphologistBase : private boost::noncopyable {
 
   /// Deserialization implementation.
   virtual void Deserialize(std::istream& is) = 0;
+
+protected:
+  /// Map of automata 64bit attribute for morphology.
+  struct AttrMap {
+    union {
+      struct {
+        uint32_t lem_id_;     ///< Lemma identifier.
+        uint32_t line_id_;    ///< Line id.
+      };
+      uint64_t   auto_attr_;  ///< Whole automaton attribute.
+    };
+  };
+
+  /// Size of buffer to decode alphabet codes.
+  static const size_t kDecodeBufferSize = 64;
+
+  /// Move in the automaton of bases, the base number is accumulated.
+  template <class Bases, typename Code>
+  static strutext::automata::StateId Go(const Bases& bases, strutext::automata::StateId state, Code c, uint32_t& number) {
+    return bases.Go(state, c, number);
+  }
+
+  /// Move in the bases trie, it has no base numbers.
+  template <class Trans, typename Attribute, typename Code>
+  static strutext::automata::StateId Go(const strutext::automata::Trie<Trans, Attribute>& trie,
+                                        strutext::automata::StateId state, Code c, uint32_t&) {
+    return trie.Go(state, c);
+  }
+
+  /// Get attributes of the base found in the automaton of bases.
+  template <class Bases>
+  static typename Bases::AttributeList GetAttributes(const Bases& bases, strutext::automata::StateId, uint32_t number) {
+    return bases.GetWordAttributes(number);
+  }
+
+  /// Get attributes of the acceptable trie state.
+  template <class Trans, typename Attribute>
+  static typename strutext::automata::Trie<Trans, Attribute>::AttributeList GetAttributes(
+      const strutext::automata::Trie<Trans, Attribute>& trie, strutext::automata::StateId state, uint32_t) {
+    return trie.GetStateAttributes(state);
+  }
+
+  /**
+   * \brief The first phase of analysis: encode the word and collect the bases found in the automaton.
+   *
+   * \param      alphabet The alphabet.
+   * \param      bases    The bases trie or automaton.
+   * \param      begin    Begin of input text in UTF-8 encoding.
+   * \param      end      End of the text.
+   * \param[out] buffer   Buffer for the word codes and the bases, its content is replaced.
+   */
+  template <class AlphabetImpl, class Bases>
+  static void FindBases(const AlphabetImpl& alphabet, const Bases& bases, const char* begin, const char* end,
+                        LemmaBuffer& buffer) {
+    buffer.Clear();
+
+    // Try starts with empty bases.
+    strutext::automata::StateId state = strutext::automata::kStartState;
+    uint32_t number = 0;
+    if (bases.IsAcceptable(state)) {
+      const typename Bases::AttributeList attrs = GetAttributes(bases, state, number);
+      for (size_t i = 0; i < attrs.size(); ++i) {
+        buffer.bases_.push_back(std::make_pair(attrs[i], 0));
+      }
+    }
+
+    // Encode the symbols, remember attribute and base length of each base found.
+    typedef strutext::encode::Utf8Iterator<const char*> Utf8Iterator;
+    for (Utf8Iterator sym_it(begin, end); sym_it != Utf8Iterator(); ++sym_it) {
+      const typename AlphabetImpl::Code c = alphabet.Encode(*sym_it);
+      buffer.codes_.push_back(c);
+      if (state != strutext::automata::kInvalidState) {
+        state = Go(bases, state, c, number);
+        if (state != strutext::automata::kInvalidState and bases.IsAcceptable(state)) {
+          const typename Bases::AttributeList attrs = GetAttributes(bases, state, number);
+          for (size_t i = 0; i < attrs.size(); ++i) {
+            buffer.bases_.push_back(std::make_pair(attrs[i], buffer.codes_.size()));
+          }
+        }
+      }
+    }
+  }
+
+  /**
+   * \brief The second phase of analysis: add lemmas of the base, whose suffix is found.
+   *
+   * \param         suffixes Suffix lines: suffix storage or dictionary image.
+   * \param         base     Number of the base in the buffer.
+   * \param[in,out] buffer   Buffer of the analysis.
+   */
+  template <class Suffixes>
+  static void SearchLemmas(const Suffixes& suffixes, size_t base, LemmaBuffer& buffer) {
+    AttrMap attr;
+    attr.auto_attr_ = buffer.bases_[base].first;
+    ++buffer.num_of_candidates_;
+    // The suffix is searched by the code range, no memory is allocated.
+    const char* suffix = buffer.codes_.data() + buffer.bases_[base].second;
+    size_t len = buffer.codes_.size() - buffer.bases_[base].second;
+    // If suffix is empty (empty suffix passed), search the zero symbol.
+    if (len == 0) {
+      suffix = kNullSuffix.data();
+      len = kNullSuffix.size();
+    }
+    const uint32_t* attrs_begin = NULL;
+    const uint32_t* attrs_end = NULL;
+    if (suffixes.SearchAttrs(attr.line_id_, suffix, len, attrs_begin, attrs_end)) {
+      for (; attrs_begin != attrs_end; ++attrs_begin) {
+        buffer.lemmas_.push_back(Lemma(attr.lem_id_, *attrs_begin));
+      }
+    }
+  }
+
+  /**
+   * \brief Decode alphabet codes and append them to UTF-8 text.
+   *
+   * \param      alphabet The alphabet.
+   * \param      codes    The alphabet codes.
+   * \param      size     Number of the codes.
+   * \param[out] text     The text to append to.
+   */
+  template <class AlphabetImpl>
+  static void AppendUtf8(const AlphabetImpl& alphabet, const char* codes, size_t size, std::string& text) {
+    uint32_t buffer[kDecodeBufferSize];
+    for (size_t pos = 0; pos < size; pos += kDecodeBufferSize) {
+      const size_t len = std::min(size - pos, static_cast<size_t>(kDecodeBufferSize));
+      for (size_t i = 0; i < len; ++i) {
+        buffer[i] = alphabet.Decode(codes[pos + i]);
+      }
+      strutext::encode::EncodeUtf8(buffer, buffer + len, text);
+    }
+  }
 };
 
 /**
@@ -141,21 +417,49 @@ class Morphologist : public MorphologistBase {
   /// Trie serializer type definition.
   typedef strutext::automata::AttrFsmSerializer<Trie> TrieSerializer;
 
-  /// Map of automata 64bit attribute for morphology.
-  struct AttrMap {
+  /// Minimal automaton of the bases, used in analysis.
+  typedef strutext::automata::Dawg<Code, Attribute> Dawg;
+
+  /// Minimal automaton serializer type definition.
+  typedef strutext::automata::DawgSerializer<Dawg> DawgSerializer;
+
+  /// Size of stream format signature.
+  static const size_t kMagicSize = 8;
+
+  /// Map of 64bit attribute of the word form automaton.
+  struct FormAttrMap {
     union {
       struct {
         uint32_t lem_id_;     ///< Lemma identifier.
-        uint32_t line_id_;    ///< Line id.
+        uint32_t attr_;       ///< Form attributes.
       };
       uint64_t   auto_attr_;  ///< Whole automaton attribute.
     };
   };
 
+  /// Word form and its attribute, used in the form automaton building.
+  typedef std::pair<std::string, Attribute> FormEntry;
+
   /// Friend MorphoModifier class.
   friend class strutext::morpho::MorphoModifier;
 
+  /// Friend MorphoImage class, it writes the dictionary image.
+  friend struct strutext::morpho::MorphoImage;
+
 public:
+  /// Current stream format version, 2 has the minimal automaton of bases and the word form automaton,
+  /// 3 has the reverse suffix index.
+  static const uint32_t kVersion = 3;
+
+  /// Get stream format signature, the stream of version 1 has no signature and is not read.
+  static const char* GetMagic() { return "STRMDICT"; }
+
+  /// Default initialization.
+  Morphologist()
+    : frozen_(false)
+    , forms_compiled_(false)
+    , suffix_indexed_(false) {}
+
   /**
    * \brief Implementation of morphological analysis of passed form.
    *
@@ -163,56 +467,25 @@ public:
    * \param[out] lem_list List of lemmas within morphological attributes.
    */
   void Analize(const std::string& text, LemList& lem_list) const {
-    // The first phase. Go throw the passed word text, encode symbol
-    // and remember symbol codes in the string. If found word base on
-    // some position, remember attribute and position for an each
-    // attribute.
-
-    // Try starts with empty bases
-    typedef std::list<std::pair<Attribute, size_t> > BaseList;
-    BaseList base_list;
-    strutext::automata::StateId state = strutext::automata::kStartState;
-    if (bases_trie_.IsAcceptable(state))  {
-      const typename Trie::AttributeList& attrs = bases_trie_.GetStateAttributes(state);
-      for (size_t i = 0; i < attrs.size(); ++i) {
-        base_list.push_back(std::make_pair(attrs[i], 0));
-      }
-    }
-
-    // Permorm the first phase.
-    std::string code_str;
-    typedef strutext::encode::Utf8Iterator<std::string::const_iterator> Utf8Iterator;
-    for (Utf8Iterator sym_it(text.begin(), text.end()); sym_it != Utf8Iterator(); ++sym_it) {
-      Code c = alphabet_.Encode(*sym_it);
-      code_str += c;
-      if (state != strutext::automata::kInvalidState) {
-        state = bases_trie_.Go(state, c);
-        if (bases_trie_.IsAcceptable(state))  {
-          const typename Trie::AttributeList& attrs = bases_trie_.GetStateAttributes(state);
-          for (size_t i = 0; i < attrs.size(); ++i) {
-            base_list.push_back(std::make_pair(attrs[i], code_str.size()));
-          }
-        }
-      }
-    }
+    LemmaBuffer buffer;
+    Analize(text.data(), text.data() + text.size(), buffer);
+    lem_list.assign(buffer.begin(), buffer.end());
+  }
 
-    // The second phase. Go throuth the found base list and find suffixes for them.
-    // If suffixes have been found then add them to the lemma list.
-    lem_list.clear();
-    for (BaseList::iterator base_it = base_list.begin(); base_it != base_list.end(); ++base_it) {
-      AttrMap attr;
-      attr.auto_attr_ = base_it->first;
-      SuffixStorage::AttrList att_list;
-      std::string suffix = code_str.substr(base_it->second);
-      // If suffix is empty (empty suffix passed), add zero symbol to it.
-      if (suffix.empty()) {
-        suffix.push_back('\0');
-      }
-      if (const SuffixStorage::AttrList* att_list = suff_store_.SearchAttrs(attr.line_id_, suffix)) {
-        for (size_t i = 0; i < att_list->size(); ++i) {
-          lem_list.push_back(Lemma(attr.lem_id_, (*att_list)[i]));
-        }
-      }
+  /**
+   * \brief Implementation of morphological analysis without memory allocation.
+   *
+   * \param      begin  Begin of input text in UTF-8 encoding.
+   * \param      end    End of the text.
+   * \param[out] buffer Buffer for lemmas within morphological attributes, its content is replaced.
+   */
+  void Analize(const char* begin, const char* end, LemmaBuffer& buffer) const {
+    if (forms_compiled_) {
+      AnalizeForm(begin, end, buffer);
+    } else if (frozen_) {
+      Analize(dawg_, begin, end, buffer);
+    } else {
+      Analize(bases_trie_, begin, end, buffer);
     }
   }
 
@@ -225,21 +498,19 @@ public:
    */
   std::string Generate(uint32_t lem_id, uint32_t attrs) const {
     // Firstly, find the lemma's base and line.
-    std::string base_text;
+    const char* base_text = NULL;
+    size_t base_len = 0;
     uint32_t line_id = 0;
     std::string result;
-    if (base_store_.Search(lem_id, line_id, base_text)) {
+    if (base_store_.Search(lem_id, line_id, base_text, base_len)) {
       // Then search suffix for the attribute.
-      if (const std::string* suffix = suff_store_.SearchSuffix(line_id, attrs)) {
-        // Write base text.
-        for (std::string::iterator sym_it = base_text.begin(); sym_it != base_text.end(); ++sym_it) {
-          strutext::encode::GetUtf8Sequence(alphabet_.Decode(*sym_it), std::back_inserter(result));
-        }
-        // Write suffix.
-        if (*suffix != kNullSuffix) {
-          for (std::string::const_iterator sym_it = (*suffix).begin(); sym_it != (*suffix).end(); ++sym_it) {
-            strutext::encode::GetUtf8Sequence(alphabet_.Decode(*sym_it), std::back_inserter(result));
-          }
+      const char* suffix = NULL;
+      size_t len = 0;
+      if (suff_store_.SearchSuffix(line_id, attrs, suffix, len)) {
+        // Write base text and suffix.
+        AppendUtf8(alphabet_, base_text, base_len, result);
+        if (kNullSuffix.compare(0, std::string::npos, suffix, len) != 0) {
+          AppendUtf8(alphabet_, suffix, len, result);
         }
       }
     }
@@ -257,28 +528,25 @@ public:
     form_set.clear();
 
     // Firstly, find the lemma's base and line.
-    std::string base_text;
+    const char* base_text = NULL;
+    size_t base_len = 0;
     uint32_t line_id = 0;
-    if (base_store_.Search(lem_id, line_id, base_text)) {
+    if (base_store_.Search(lem_id, line_id, base_text, base_len)) {
       // Decode base text.
       std::string base_text_utf8;
-      for (std::string::iterator sym_it = base_text.begin(); sym_it != base_text.end(); ++sym_it) {
-        strutext::encode::GetUtf8Sequence(alphabet_.Decode(*sym_it), std::back_inserter(base_text_utf8));
-      }
+      AppendUtf8(alphabet_, base_text, base_len, base_text_utf8);
 
       // Then get suffix set.
       std::set<std::string> suf_set;
       suff_store_.GetSuffixSet(line_id, suf_set);
+      std::string form;
       for (std::set<std::string>::iterator suf_it = suf_set.begin(); suf_it != suf_set.end(); ++suf_it) {
-        // Decode suffix.
-        std::string suffix_utf8;
+        // Concatenate base and decoded suffix.
+        form = base_text_utf8;
         if (*suf_it != kNullSuffix) {
-          for (std::string::const_iterator sym_it = (*suf_it).begin(); sym_it != (*suf_it).end(); ++sym_it) {
-            strutext::encode::GetUtf8Sequence(alphabet_.Decode(*sym_it), std::back_inserter(suffix_utf8));
-          }
+          AppendUtf8(alphabet_, suf_it->data(), suf_it->size(), form);
         }
-        // Concatenate base and suffix.
-        form_set.insert(base_text_utf8 + suffix_utf8);
+        form_set.insert(form);
       }
     }
     return form_set.size();
@@ -293,28 +561,296 @@ public:
    */
   bool GenMainForm(uint32_t lem_id, std::string& main_form) const {
     // Find the form.
-    return base_store_.SearchMainForm(lem_id, main_form);
+    const char* text = NULL;
+    size_t len = 0;
+    if (base_store_.SearchMainForm(lem_id, text, len)) {
+      main_form.assign(text, len);
+      return true;
+    }
+    return false;
   }
 
+  /**
+   * \brief Make the dictionary immutable.
+   *
+   * The trie is replaced by the minimal automaton, which shares the base suffixes too and keeps
+   * moves in contiguous arrays, so it is much smaller and faster in analysis. The suffix storage
+   * maps are replaced by sorted arrays. Deserialized dictionary is frozen already. Adding bases
+   * or suffixes by MorphoModifier unfreezes the dictionary.
+   */
+  void Freeze() {
+    if (not frozen_) {
+      strutext::automata::BuildDawg(bases_trie_, dawg_);
+      ClearTrie(bases_trie_);
+      frozen_ = true;
+    }
+    suff_store_.Freeze();
+    base_store_.ReleaseIndex();
+  }
+
+  /**
+   * \brief Build the automaton of all the word forms.
+   *
+   * Each form of each base is put to the minimal automaton, the form attributes are pairs of
+   * lemma identifier and form attribute. So analysis is a single pass through the automaton,
+   * without suffix extraction and suffix storage search, the lemmas are ordered by identifier
+   * and attribute. The automaton is several times bigger than the bases one and takes time to
+   * build, so the mode is optional. The dictionary is frozen first, the bases and suffixes are
+   * kept for generation. Adding bases or suffixes by MorphoModifier drops the automaton.
+   */
+  void CompileForms() {
+    Freeze();
+
+    // Collect the forms, the automaton builder requires them sorted.
+    std::vector<FormEntry> forms;
+    FormCollector collector(suff_store_.GetView(), forms);
+    strutext::automata::VisitWords(dawg_, collector);
+    std::sort(forms.begin(), forms.end(), FormLess());
+    forms.erase(std::unique(forms.begin(), forms.end()), forms.end());
+
+    strutext::automata::DawgBuilder<Code, Attribute> builder;
+    for (size_t i = 0; i < forms.size(); ++i) {
+      builder.Add(forms[i].first.begin(), forms[i].first.end(), forms[i].second);
+    }
+    builder.Build(forms_);
+    forms_compiled_ = true;
+  }
+
+  /// Is the word form automaton used in analysis?
+  bool IsFormsCompiled() const { return forms_compiled_; }
+
+  /**
+   * \brief Build the reverse index of suffixes.
+   *
+   * The index gives the lines having the word end as suffix, so the bases found by the bases
+   * automaton are filtered by their lines before the suffix storage search. It pays off for the
+   * dictionaries with short bases, which are found in many words. The dictionary is frozen first.
+   * Adding suffixes by MorphoModifier drops the index.
+   */
+  void BuildSuffixIndex() {
+    Freeze();
+    suff_index_.Build(suff_store_.GetView());
+    suffix_indexed_ = true;
+  }
+
+  /// Is the reverse index of suffixes used in analysis?
+  bool IsSuffixIndexBuilt() const { return suffix_indexed_; }
+
   /// Serialization implementation.
   void Serialize(std::ostream& os) const {
-    TrieSerializer::Serialize(bases_trie_, os);
+    // The signature and the version go first, so the stream of other format is not misread.
+    os.write(GetMagic(), kMagicSize);
+    const uint32_t version = kVersion;
+    os.write(reinterpret_cast<const char*>(&version), sizeof version);
+    // The bases are always written as the minimal automaton.
+    if (frozen_) {
+      DawgSerializer::Serialize(dawg_, os);
+    } else {
+      Dawg dawg;
+      strutext::automata::BuildDawg(bases_trie_, dawg);
+      DawgSerializer::Serialize(dawg, os);
+    }
+    // The word form automaton is written if it is compiled.
+    const char compiled = forms_compiled_ ? 1 : 0;
+    os.write(&compiled, sizeof compiled);
+    if (forms_compiled_) {
+      DawgSerializer::Serialize(forms_, os);
+    }
+    // The same for the suffix index, since version 3.
+    const char indexed = suffix_indexed_ ? 1 : 0;
+    os.write(&indexed, sizeof indexed);
+    if (suffix_indexed_) {
+      suff_index_.Serialize(os);
+    }
     suff_store_.Serialize(os);
     base_store_.Serialize(os);
   }
 
   /// Deserialization implementation.
   void Deserialize(std::istream& is) {
-    TrieSerializer::Deserialize(bases_trie_, is);
+    char magic[kMagicSize];
+    uint32_t version = 0;
+    if (not is.read(magic, kMagicSize) or not is.read(reinterpret_cast<char*>(&version), sizeof version)) {
+      throw std::runtime_error("Cannot read morphologist from stream");
+    } else if (std::memcmp(magic, GetMagic(), kMagicSize) != 0) {
+      throw std::runtime_error("Invalid morphologist signature in stream");
+    } else if (version != kVersion) {
+      throw std::runtime_error("Unsupported morphologist version in stream");
+    }
+    DawgSerializer::Deserialize(dawg_, is);
+    ClearTrie(bases_trie_);
+    frozen_ = true;
+    char compiled = 0;
+    if (not is.read(&compiled, sizeof compiled)) {
+      throw std::runtime_error("Cannot read morphologist from stream");
+    }
+    DropForms();
+    if (compiled) {
+      DawgSerializer::Deserialize(forms_, is);
+      forms_compiled_ = true;
+    }
+    char indexed = 0;
+    if (not is.read(&indexed, sizeof indexed)) {
+      throw std::runtime_error("Cannot read morphologist from stream");
+    }
+    DropSuffixIndex();
+    if (indexed) {
+      suff_index_.Deserialize(is);
+      suffix_indexed_ = true;
+    }
     suff_store_.Deserialize(is);
     base_store_.Deserialize(is);
   }
 
 private:
-  Trie          bases_trie_; ///< Vocabulary bases trie, used in analysis.
-  BaseStorage   base_store_; ///< Base texts storage.
-  SuffixStorage suff_store_; ///< Suffix storage.
-  AlphabetImpl  alphabet_;   ///< Alphabet implementation.
+  /**
+   * \brief Implementation of morphological analysis by the bases trie.
+   *
+   * \param      trie   The bases trie.
+   * \param      begin  Begin of input text in UTF-8 encoding.
+   * \param      end    End of the text.
+   * \param[out] buffer Buffer for lemmas within morphological attributes.
+   */
+  template <class TrieImpl>
+  void Analize(const TrieImpl& trie, const char* begin, const char* end, LemmaBuffer& buffer) const {
+    FindBases(alphabet_, trie, begin, end, buffer);
+
+    // The word end is passed through the suffix index, so the bases with the lines having no such
+    // suffix are dropped without the suffix storage search.
+    if (suffix_indexed_ and not buffer.bases_.empty()) {
+      suff_index_.FindSuffixes(buffer.codes_.data(), buffer.codes_.size(), buffer.suffixes_);
+    }
+
+    // The second phase. Go throuth the found base list and find suffixes for them.
+    // If suffixes have been found then add them to the lemma list.
+    for (size_t base = 0; base < buffer.bases_.size(); ++base) {
+      if (suffix_indexed_) {
+        AttrMap attr;
+        attr.auto_attr_ = buffer.bases_[base].first;
+        const uint32_t suffix_len = buffer.codes_.size() - buffer.bases_[base].second;
+        if (not suff_index_.HasLine(buffer.suffixes_[suffix_len], attr.line_id_)) {
+          continue;
+        }
+      }
+      SearchLemmas(suff_store_, base, buffer);
+    }
+  }
+
+  /**
+   * \brief Implementation of morphological analysis by the word form automaton.
+   *
+   * \param      begin  Begin of input text in UTF-8 encoding.
+   * \param      end    End of the text.
+   * \param[out] buffer Buffer for lemmas within morphological attributes.
+   */
+  void AnalizeForm(const char* begin, const char* end, LemmaBuffer& buffer) const {
+    buffer.Clear();
+    strutext::automata::StateId state = strutext::automata::kStartState;
+    uint32_t number = 0;
+    typedef strutext::encode::Utf8Iterator<const char*> Utf8Iterator;
+    for (Utf8Iterator sym_it(begin, end); sym_it != Utf8Iterator(); ++sym_it) {
+      state = forms_.Go(state, alphabet_.Encode(*sym_it), number);
+      if (state == strutext::automata::kInvalidState) {
+        return;
+      }
+    }
+    if (forms_.IsAcceptable(state)) {
+      const typename Dawg::AttributeList attrs = forms_.GetWordAttributes(number);
+      for (size_t i = 0; i < attrs.size(); ++i) {
+        FormAttrMap attr;
+        attr.auto_attr_ = attrs[i];
+        buffer.lemmas_.push_back(Lemma(attr.lem_id_, attr.attr_));
+      }
+    }
+  }
+
+  /// Visitor of the bases, which collects their forms.
+  struct FormCollector {
+    /// Initialization.
+    FormCollector(const SuffixLinesView& suffixes, std::vector<FormEntry>& forms)
+      : suffixes_(&suffixes)
+      , forms_(&forms) {}
+
+    /// Add the forms of the base.
+    template <class AttributeList>
+    void operator()(const std::vector<Code>& base, const AttributeList& attrs) {
+      const std::string base_text(base.begin(), base.end());
+      for (size_t i = 0; i < attrs.size(); ++i) {
+        AttrMap base_attr;
+        base_attr.auto_attr_ = attrs[i];
+        suffixes_->CheckLine(base_attr.line_id_);
+        const uint32_t line_begin = suffixes_->suffix_lines_[base_attr.line_id_];
+        const uint32_t line_end = suffixes_->suffix_lines_[base_attr.line_id_ + 1];
+        for (uint32_t j = line_begin; j < line_end; ++j) {
+          const SuffixEntry& entry = suffixes_->suffix_entries_[j];
+          const std::string suffix(suffixes_->GetText(entry.suffix_), entry.suffix_.len_);
+          const std::string form = suffix == kNullSuffix ? base_text : base_text + suffix;
+          for (uint32_t k = entry.attrs_begin_; k < entry.attrs_end_; ++k) {
+            FormAttrMap form_attr;
+            form_attr.lem_id_ = base_attr.lem_id_;
+            form_attr.attr_ = suffixes_->suffix_attrs_[k];
+            forms_->push_back(FormEntry(form, form_attr.auto_attr_));
+          }
+        }
+      }
+    }
+
+    const SuffixLinesView*  suffixes_; ///< Frozen suffix lines.
+    std::vector<FormEntry>* forms_;    ///< Collected forms.
+  };
+
+  /// Order of the forms, the symbols are compared as the automaton compares them.
+  struct FormLess {
+    bool operator()(const FormEntry& left, const FormEntry& right) const {
+      if (left.first == right.first) {
+        return left.second < right.second;
+      }
+      return std::lexicographical_compare(left.first.begin(), left.first.end(), right.first.begin(), right.first.end());
+    }
+  };
+
+  /// Drop the word form automaton, used by MorphoModifier.
+  void DropForms() {
+    if (forms_compiled_) {
+      forms_ = Dawg();
+      forms_compiled_ = false;
+    }
+  }
+
+  /// Drop the suffix index, used by MorphoModifier.
+  void DropSuffixIndex() {
+    if (suffix_indexed_) {
+      suff_index_ = SuffixIndex();
+      suffix_indexed_ = false;
+    }
+  }
+
+  /// Make the bases trie modifiable, used by MorphoModifier.
+  void Thaw() {
+    if (frozen_) {
+      strutext::automata::Thaw(dawg_, bases_trie_);
+      dawg_ = Dawg();
+      frozen_ = false;
+    }
+  }
+
+  /// Drop the trie content and release its memory.
+  static void ClearTrie(Trie& trie) {
+    Trie empty(0);
+    trie.states_.swap(empty.states_);
+    trie.ClearAttributes();
+  }
+
+  Trie          bases_trie_;     ///< Vocabulary bases trie, used in analysis until it is frozen.
+  Dawg          dawg_;           ///< Minimal automaton of the vocabulary bases.
+  bool          frozen_;         ///< Is the minimal automaton used in analysis?
+  Dawg          forms_;          ///< Minimal automaton of the word forms.
+  bool          forms_compiled_; ///< Is the word form automaton used in analysis?
+  BaseStorage   base_store_;     ///< Base texts storage.
+  SuffixStorage suff_store_;     ///< Suffix storage.
+  SuffixIndex   suff_index_;     ///< Reverse index of suffixes.
+  bool          suffix_indexed_; ///< Is the suffix index used in analysis?
+  AlphabetImpl  alphabet_;       ///< Alphabet implementation.
 };
 
 }} // namespace strutext, morpho.
@@ -0,0 +1,344 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Memory mapped image of morphological dictionary implementation.
+ * \author Vladimir Lapshin.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "morpho_image.h"
+
+namespace strutext { namespace morpho {
+
+namespace {
+
+/// Size of block the image is read by from the stream of unknown length.
+const size_t kReadBlockSize = 1 << 20;
+
+/**
+ * \brief Number of bytes left in the stream.
+ *
+ * \param  is Stream to check, the read position is kept.
+ * \return    The number of bytes or -1 if the stream cannot be positioned.
+ */
+std::streamoff GetStreamRest(std::istream& is) {
+  const std::streampos pos = is.tellg();
+  if (pos == std::streampos(-1)) {
+    is.clear();
+    return -1;
+  }
+  is.seekg(0, std::ios::end);
+  const std::streampos end = is.tellg();
+  is.seekg(pos);
+  if (not is or end == std::streampos(-1)) {
+    is.clear();
+    is.seekg(pos);
+    return -1;
+  }
+  return end - pos;
+}
+
+/// Builder of image sections.
+class ImageBuilder {
+public:
+  /// Initialization, the header place is reserved.
+  ImageBuilder()
+    : image_(sizeof(MorphoImage::Header), '\0') {
+    std::memset(&header_, 0, sizeof(header_));
+    std::memcpy(header_.magic_, MorphoImage::GetMagic(), sizeof(header_.magic_));
+    header_.version_ = MorphoImage::kVersion;
+    header_.byte_order_ = MorphoImage::kByteOrderMark;
+  }
+
+  /// Add the section.
+  void AddSection(MorphoImage::SectionId id, const void* data, size_t size) {
+    image_.resize((image_.size() + MorphoImage::kAlignment - 1) / MorphoImage::kAlignment * MorphoImage::kAlignment, '\0');
+    header_.sections_[id].offset_ = image_.size();
+    header_.sections_[id].size_ = size;
+    image_.append(static_cast<const char*>(data), size);
+  }
+
+  /// Add the array section.
+  template <typename T>
+  void AddSection(MorphoImage::SectionId id, const std::vector<T>& data) {
+    AddSection(id, data.empty() ? NULL : &data[0], data.size() * sizeof(T));
+  }
+
+  /// Write the image.
+  void Write(std::ostream& os) {
+    header_.size_ = image_.size();
+    std::memcpy(&image_[0], &header_, sizeof(header_));
+    os.write(image_.data(), image_.size());
+    if (os.bad()) {
+      throw std::runtime_error("Cannot write dictionary image to stream");
+    }
+  }
+
+private:
+  MorphoImage::Header header_; ///< Image header.
+  std::string         image_;  ///< Image content.
+};
+
+}  // namespace.
+
+void MorphoImage::Write(const Dawg& dawg, const SuffixStorage& suff_store, const BaseStorage& base_store,
+                        std::ostream& os) {
+  ImageBuilder builder;
+
+  // Bases automaton, its arrays are written as is.
+  builder.AddSection(TRIE_OFFSETS_SECTION, dawg.offsets_);
+  builder.AddSection(TRIE_SYMBOLS_SECTION, dawg.symbols_);
+  builder.AddSection(TRIE_TARGETS_SECTION, dawg.targets_);
+  builder.AddSection(TRIE_OUTPUTS_SECTION, dawg.outputs_);
+  builder.AddSection(TRIE_ACCEPTED_SECTION, dawg.accepted_);
+  builder.AddSection(TRIE_ATTR_OFFSETS_SECTION, dawg.attr_offsets_);
+  builder.AddSection(TRIE_ATTRS_SECTION, dawg.attrs_);
+
+  // Suffix and attribute lines are the arrays of frozen storage, its pool begins the image pool.
+  SuffixStorage::FrozenLines lines;
+  suff_store.GetFrozenLines(lines);
+  builder.AddSection(SUFFIX_LINES_SECTION, lines.suffix_lines_);
+  builder.AddSection(SUFFIX_ENTRIES_SECTION, lines.suffix_entries_);
+  builder.AddSection(SUFFIX_ATTRS_SECTION, lines.suffix_attrs_);
+  builder.AddSection(ATTR_LINES_SECTION, lines.attr_lines_);
+  builder.AddSection(ATTR_ENTRIES_SECTION, lines.attr_entries_);
+
+  // Lemmas, the base pool follows the suffix pool.
+  const uint32_t base_offset = lines.pool_.size();
+  std::vector<LemmaEntry> lemmas;
+  for (size_t lem_id = 0; lem_id < base_store.storage_.size(); ++lem_id) {
+    const BaseStorage::LemmaInfo& info = base_store.storage_[lem_id];
+    if (info.line_id_ == BaseStorage::kNoLine) {
+      continue;
+    }
+    LemmaEntry entry;
+    entry.lem_id_ = lem_id;
+    entry.line_id_ = info.line_id_;
+    entry.base_.offset_ = info.base_.offset_ + base_offset;
+    entry.base_.len_ = info.base_.len_;
+    entry.main_form_.offset_ = info.main_form_.offset_ + base_offset;
+    entry.main_form_.len_ = info.main_form_.len_;
+    lemmas.push_back(entry);
+  }
+  builder.AddSection(LEMMAS_SECTION, lemmas);
+
+  std::string pool = lines.pool_;
+  pool.append(base_store.pool_);
+  builder.AddSection(STRING_POOL_SECTION, pool.data(), pool.size());
+  builder.Write(os);
+}
+
+MorphoImageView::MorphoImageView()
+  : data_(NULL)
+  , size_(0)
+  , num_of_lemmas_(0) {
+  // Empty dictionary: invalid and start states without moves.
+  static const uint32_t kEmptyOffsets[3] = {0, 0, 0};
+  static const uint8_t kEmptyAccepted[2] = {0, 0};
+  static const uint32_t kEmptyLines[1] = {0};
+  trie_offsets_ = kEmptyOffsets;
+  trie_symbols_ = NULL;
+  trie_targets_ = NULL;
+  trie_outputs_ = NULL;
+  trie_accepted_ = kEmptyAccepted;
+  trie_attr_offsets_ = kEmptyLines;
+  trie_attrs_ = NULL;
+  lemmas_ = NULL;
+  pool_ = NULL;
+}
+
+void MorphoImageView::Open(const std::string& path) {
+  boost::iostreams::mapped_file_source file;
+  try {
+    file.open(path);
+  } catch (const std::exception& err) {
+    throw std::runtime_error("Cannot map dictionary image \"" + path + "\": " + err.what());
+  }
+  Attach(file.data(), file.size());
+
+  // The new image is valid, the previous one is released.
+  file_ = file;
+  std::vector<uint64_t>().swap(buffer_);
+}
+
+void MorphoImageView::Read(std::istream& is) {
+  // Read the header to know the image size.
+  MorphoImage::Header header;
+  is.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (not is or header.size_ < sizeof(header)) {
+    throw std::runtime_error("Cannot read dictionary image header");
+  }
+
+  // The header size is not trusted before the memory is allocated: it is compared with the stream
+  // length, or the memory grows by blocks as the data are read if the length is unknown.
+  const uint64_t rest = header.size_ - sizeof(header);
+  const std::streamoff stream_rest = GetStreamRest(is);
+  if (rest > std::numeric_limits<size_t>::max() - sizeof(uint64_t)
+      or (stream_rest >= 0 and static_cast<uint64_t>(stream_rest) < rest)) {
+    throw std::runtime_error("Dictionary image size exceeds the stream length");
+  }
+
+  // The buffer of 64 bit numbers is aligned properly.
+  const size_t size = static_cast<size_t>(header.size_);
+  std::vector<uint64_t> buffer;
+  size_t read_size = sizeof(header);
+  do {
+    const size_t next_size = stream_rest >= 0 ? size : std::min(size, read_size + kReadBlockSize);
+    buffer.resize((next_size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    is.read(reinterpret_cast<char*>(&buffer[0]) + read_size, next_size - read_size);
+    if (not is) {
+      throw std::runtime_error("Cannot read dictionary image");
+    }
+    read_size = next_size;
+  } while (read_size < size);
+  char* data = reinterpret_cast<char*>(&buffer[0]);
+  std::memcpy(data, &header, sizeof(header));
+  Attach(data, size);
+
+  // The buffer memory is kept by swap, the previous image is released.
+  buffer_.swap(buffer);
+  if (file_.is_open()) {
+    file_.close();
+  }
+}
+
+void MorphoImageView::Init(const char* data, size_t size) {
+  const bool same_image = data == data_;
+  Attach(data, size);
+
+  // The image memory is owned by the caller, the previous image is released.
+  if (not same_image) {
+    if (file_.is_open()) {
+      file_.close();
+    }
+    std::vector<uint64_t>().swap(buffer_);
+  }
+}
+
+template <typename T>
+const T* MorphoImageView::GetSection(const char* data, size_t size, MorphoImage::SectionId id, size_t& count) {
+  const MorphoImage::Section& section = reinterpret_cast<const MorphoImage::Header*>(data)->sections_[id];
+  if (section.offset_ % MorphoImage::kAlignment != 0 or section.offset_ > size
+      or section.size_ > size - section.offset_ or section.size_ % sizeof(T) != 0) {
+    throw std::runtime_error("Invalid section of dictionary image");
+  }
+  count = section.size_ / sizeof(T);
+  return reinterpret_cast<const T*>(data + section.offset_);
+}
+
+void MorphoImageView::Attach(const char* data, size_t size) {
+  if (size < sizeof(MorphoImage::Header) or reinterpret_cast<uintptr_t>(data) % MorphoImage::kAlignment != 0) {
+    throw std::runtime_error("Invalid dictionary image");
+  }
+  const MorphoImage::Header& header = *reinterpret_cast<const MorphoImage::Header*>(data);
+  if (std::memcmp(header.magic_, MorphoImage::GetMagic(), sizeof(header.magic_)) != 0) {
+    throw std::runtime_error("Invalid dictionary image signature");
+  } else if (header.byte_order_ != MorphoImage::kByteOrderMark) {
+    throw std::runtime_error("Invalid dictionary image byte order");
+  } else if (header.version_ != MorphoImage::kVersion) {
+    throw std::runtime_error("Unsupported dictionary image version");
+  } else if (header.size_ > size) {
+    throw std::runtime_error("Dictionary image is truncated");
+  }
+  size = header.size_;
+
+  // Get sections and check their sizes are consistent, the view is not changed until all is checked.
+  size_t num_of_offsets = 0, num_of_symbols = 0, num_of_targets = 0, num_of_outputs = 0, num_of_states = 0;
+  size_t num_of_attr_offsets = 0, num_of_attrs = 0;
+  const uint32_t* trie_offsets = GetSection<uint32_t>(data, size, MorphoImage::TRIE_OFFSETS_SECTION, num_of_offsets);
+  const char* trie_symbols = GetSection<char>(data, size, MorphoImage::TRIE_SYMBOLS_SECTION, num_of_symbols);
+  const automata::StateId* trie_targets = GetSection<automata::StateId>(
+      data, size, MorphoImage::TRIE_TARGETS_SECTION, num_of_targets);
+  const uint32_t* trie_outputs = GetSection<uint32_t>(data, size, MorphoImage::TRIE_OUTPUTS_SECTION, num_of_outputs);
+  const uint8_t* trie_accepted = GetSection<uint8_t>(data, size, MorphoImage::TRIE_ACCEPTED_SECTION, num_of_states);
+  const uint32_t* trie_attr_offsets = GetSection<uint32_t>(
+      data, size, MorphoImage::TRIE_ATTR_OFFSETS_SECTION, num_of_attr_offsets);
+  const uint64_t* trie_attrs = GetSection<uint64_t>(data, size, MorphoImage::TRIE_ATTRS_SECTION, num_of_attrs);
+  if (num_of_states < 2 or num_of_offsets != num_of_states + 1 or num_of_attr_offsets == 0
+      or num_of_symbols != num_of_targets or num_of_outputs != num_of_targets
+      or trie_offsets[num_of_states] != num_of_symbols or trie_attr_offsets[num_of_attr_offsets - 1] != num_of_attrs
+      or not automata::CheckDawgArrays(trie_offsets, trie_targets, trie_outputs, trie_accepted, trie_attr_offsets,
+                                       num_of_states, num_of_attr_offsets - 1)) {
+    throw std::runtime_error("Invalid bases automaton of dictionary image");
+  }
+
+  size_t num_of_suffix_lines = 0, num_of_suffix_entries = 0, num_of_suffix_attrs = 0;
+  size_t num_of_attr_lines = 0, num_of_attr_entries = 0, num_of_lemmas = 0, pool_size = 0;
+  SuffixLinesView suffixes;
+  suffixes.suffix_lines_ = GetSection<uint32_t>(data, size, MorphoImage::SUFFIX_LINES_SECTION, num_of_suffix_lines);
+  suffixes.suffix_entries_ = GetSection<MorphoImage::SuffixEntry>(
+      data, size, MorphoImage::SUFFIX_ENTRIES_SECTION, num_of_suffix_entries);
+  suffixes.suffix_attrs_ = GetSection<uint32_t>(data, size, MorphoImage::SUFFIX_ATTRS_SECTION, num_of_suffix_attrs);
+  suffixes.attr_lines_ = GetSection<uint32_t>(data, size, MorphoImage::ATTR_LINES_SECTION, num_of_attr_lines);
+  suffixes.attr_entries_ = GetSection<MorphoImage::AttrEntry>(
+      data, size, MorphoImage::ATTR_ENTRIES_SECTION, num_of_attr_entries);
+  const MorphoImage::LemmaEntry* lemmas = GetSection<MorphoImage::LemmaEntry>(
+      data, size, MorphoImage::LEMMAS_SECTION, num_of_lemmas);
+  const char* pool = GetSection<char>(data, size, MorphoImage::STRING_POOL_SECTION, pool_size);
+  if (num_of_suffix_lines == 0 or num_of_attr_lines != num_of_suffix_lines) {
+    throw std::runtime_error("Invalid suffix storage of dictionary image");
+  }
+  suffixes.num_of_lines_ = num_of_suffix_lines - 1;
+  suffixes.pool_ = pool;
+  if (not suffixes.IsValid(num_of_suffix_entries, num_of_suffix_attrs, num_of_attr_entries, pool_size)) {
+    throw std::runtime_error("Invalid suffix storage of dictionary image");
+  }
+
+  // Lemmas are sorted by identifier, their lines and texts are in range.
+  for (size_t i = 0; i < num_of_lemmas; ++i) {
+    const MorphoImage::LemmaEntry& lemma = lemmas[i];
+    if ((i > 0 and lemmas[i - 1].lem_id_ >= lemma.lem_id_) or lemma.line_id_ >= suffixes.num_of_lines_
+        or not IsInPool(lemma.base_, pool_size) or not IsInPool(lemma.main_form_, pool_size)) {
+      throw std::runtime_error("Invalid lemmas of dictionary image");
+    }
+  }
+
+  // The image is valid.
+  data_ = data;
+  size_ = size;
+  trie_offsets_ = trie_offsets;
+  trie_symbols_ = trie_symbols;
+  trie_targets_ = trie_targets;
+  trie_outputs_ = trie_outputs;
+  trie_accepted_ = trie_accepted;
+  trie_attr_offsets_ = trie_attr_offsets;
+  trie_attrs_ = trie_attrs;
+  suffixes_ = suffixes;
+  num_of_lemmas_ = num_of_lemmas;
+  lemmas_ = lemmas;
+  pool_ = pool;
+}
+
+const MorphoImage::LemmaEntry* MorphoImageView::SearchLemma(uint32_t lem_id) const {
+  const MorphoImage::LemmaEntry* first = lemmas_;
+  const MorphoImage::LemmaEntry* last = lemmas_ + num_of_lemmas_;
+  while (first < last) {
+    const MorphoImage::LemmaEntry* middle = first + (last - first) / 2;
+    if (middle->lem_id_ < lem_id) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  if (first != lemmas_ + num_of_lemmas_ and first->lem_id_ == lem_id) {
+    return first;
+  }
+  return NULL;
+}
+
+}} // namespace strutext, morpho.
@@ -0,0 +1,316 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Memory mapped image of morphological dictionary.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <algorithm>
+#include <string>
+#include <set>
+#include <vector>
+#include <iostream>
+
+#include <boost/noncopyable.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "fsm_defs.h"
+#include "dawg.h"
+#include "suffix_storage.h"
+#include "base_storage.h"
+
+namespace strutext { namespace morpho {
+
+// Forward declaration of Morphologist class.
+template <class T> class Morphologist;
+
+/**
+ * \brief Binary image of morphological dictionary.
+ *
+ * The image is a header and a set of sections. Each section is a plain array of numbers or
+ * structures, its offset is counted from the image begin and aligned by 8 bytes, so the image
+ * is position independent and may be used just after it is mapped to memory. Numbers are
+ * stored in the native byte order, which is checked by the header.
+ *
+ * The sections are: the minimal automaton of bases (move offsets, symbols, targets and outputs,
+ * acceptable state marks, attribute offsets of each base and attributes), suffix lines sorted
+ * by suffix text, attribute lines sorted by attribute, lemmas sorted by identifier, and the pool
+ * of texts.
+ */
+struct MorphoImage {
+  /// Minimal automaton type, the same as Morphologist uses.
+  typedef automata::Dawg<char, uint64_t> Dawg;
+
+  /// Current format version, 2 has the minimal automaton of bases instead of the trie.
+  static const uint32_t kVersion = 2;
+
+  /// Byte order mark.
+  static const uint32_t kByteOrderMark = 0x01020304;
+
+  /// Alignment of sections.
+  static const size_t kAlignment = 8;
+
+  /// Image sections.
+  enum SectionId {
+    TRIE_OFFSETS_SECTION = 0,  ///< Move offsets of each state, uint32_t.
+    TRIE_SYMBOLS_SECTION,      ///< Move symbols, char.
+    TRIE_TARGETS_SECTION,      ///< Move targets, StateId.
+    TRIE_OUTPUTS_SECTION,      ///< Move outputs, uint32_t.
+    TRIE_ACCEPTED_SECTION,     ///< Acceptable state marks, uint8_t.
+    TRIE_ATTR_OFFSETS_SECTION, ///< Attribute offsets of each base, uint32_t.
+    TRIE_ATTRS_SECTION,        ///< Base attributes, uint64_t.
+    SUFFIX_LINES_SECTION,      ///< Suffix entry offsets of each line, uint32_t.
+    SUFFIX_ENTRIES_SECTION,    ///< Suffix entries, SuffixEntry.
+    SUFFIX_ATTRS_SECTION,      ///< Attributes of suffixes, uint32_t.
+    ATTR_LINES_SECTION,        ///< Attribute entry offsets of each line, uint32_t.
+    ATTR_ENTRIES_SECTION,      ///< Attribute entries, AttrEntry.
+    LEMMAS_SECTION,            ///< Lemma entries, LemmaEntry.
+    STRING_POOL_SECTION,       ///< Texts, char.
+    SECTION_NUM
+  };
+
+  /// Section position.
+  struct Section {
+    uint64_t offset_; ///< Offset from the image begin.
+    uint64_t size_;   ///< Size in bytes.
+  };
+
+  /// Image header.
+  struct Header {
+    char     magic_[8];              ///< Format signature.
+    uint32_t version_;               ///< Format version.
+    uint32_t byte_order_;            ///< Byte order mark.
+    uint64_t size_;                  ///< Size of the whole image.
+    Section  sections_[SECTION_NUM]; ///< Section positions.
+  };
+
+  /// Text in the string pool.
+  typedef morpho::StringRef StringRef;
+
+  /// Suffix of suffix line, the same as frozen suffix storage keeps.
+  typedef morpho::SuffixEntry SuffixEntry;
+
+  /// Attribute of attribute line, the same as frozen suffix storage keeps.
+  typedef morpho::AttrEntry AttrEntry;
+
+  /// Lemma information.
+  struct LemmaEntry {
+    uint32_t  lem_id_;    ///< Lemma identifier.
+    uint32_t  line_id_;   ///< Suffix line identifier.
+    StringRef base_;      ///< Base text.
+    StringRef main_form_; ///< Main form text.
+  };
+
+  /// Get format signature.
+  static const char* GetMagic() { return "STRMORPH"; }
+
+  /**
+   * \brief Write image of the morphologist dictionary.
+   *
+   * \param morph The morphologist.
+   * \param os    Stream to write to.
+   */
+  template <class Alphabet>
+  static void Write(const Morphologist<Alphabet>& morph, std::ostream& os) {
+    if (morph.frozen_) {
+      Write(morph.dawg_, morph.suff_store_, morph.base_store_, os);
+    } else {
+      Dawg dawg;
+      automata::BuildDawg(morph.bases_trie_, dawg);
+      Write(dawg, morph.suff_store_, morph.base_store_, os);
+    }
+  }
+
+  /**
+   * \brief Write image of the dictionary.
+   *
+   * \param dawg       Minimal automaton of bases.
+   * \param suff_store Suffix storage.
+   * \param base_store Base storage.
+   * \param os         Stream to write to.
+   */
+  static void Write(const Dawg& dawg, const SuffixStorage& suff_store, const BaseStorage& base_store,
+                    std::ostream& os);
+};
+
+/**
+ * \brief Read only view of the dictionary image.
+ *
+ * The image may be mapped from file, read from stream or passed as memory block. The data
+ * are not parsed, only the header is checked.
+ */
+class MorphoImageView : private boost::noncopyable {
+public:
+  /// Type of base attribute list.
+  typedef automata::AttributeRange<uint64_t> AttributeList;
+
+  /// Initialization by empty image.
+  MorphoImageView();
+
+  /**
+   * \brief Map the image file to memory.
+   *
+   * \param path The file path.
+   */
+  void Open(const std::string& path);
+
+  /**
+   * \brief Read the image from stream.
+   *
+   * The image size of the header must not exceed the stream length.
+   *
+   * \param is Stream to read from.
+   */
+  void Read(std::istream& is);
+
+  /**
+   * \brief Use the image in memory, the memory should live while the view is used.
+   *
+   * The view is not changed if the image is invalid, as by Open and Read.
+   *
+   * \param data The image begin, aligned by 8 bytes.
+   * \param size The image size.
+   */
+  void Init(const char* data, size_t size);
+
+  /// Get the image begin.
+  const char* GetData() const { return data_; }
+
+  /// Get the image size.
+  size_t GetSize() const { return size_; }
+
+  /**
+   * \brief Transiotion by symbol in the bases automaton.
+   *
+   * \param         state  The state to move from.
+   * \param         symbol The move symbol.
+   * \param[in,out] number Base number, the move output is added to it.
+   * \return               Move state number or kInvalidState if move is absent.
+   */
+  automata::StateId Go(automata::StateId state, char symbol, uint32_t& number) const {
+    uint32_t begin = trie_offsets_[state];
+    uint32_t end = trie_offsets_[state + 1];
+    if (end - begin <= kLinearSearchSize) {
+      for (; begin != end; ++begin) {
+        if (trie_symbols_[begin] == symbol) {
+          number += trie_outputs_[begin];
+          return trie_targets_[begin];
+        }
+      }
+      return automata::kInvalidState;
+    }
+    const char* pos = std::lower_bound(trie_symbols_ + begin, trie_symbols_ + end, symbol);
+    if (pos != trie_symbols_ + end and *pos == symbol) {
+      number += trie_outputs_[pos - trie_symbols_];
+      return trie_targets_[pos - trie_symbols_];
+    }
+    return automata::kInvalidState;
+  }
+
+  /// Is the bases automaton state acceptable?
+  bool IsAcceptable(automata::StateId state) const { return trie_accepted_[state] != 0; }
+
+  /**
+   * \brief Get attributes of the base, as the bases automaton does.
+   *
+   * \param  number The base number, got in the acceptable state.
+   * \return        The base attributes.
+   */
+  AttributeList GetWordAttributes(uint32_t number) const {
+    return AttributeList(trie_attrs_ + trie_attr_offsets_[number], trie_attrs_ + trie_attr_offsets_[number + 1]);
+  }
+
+  /**
+   * \brief Get suffix attributes.
+   *
+   * \param      line_id Identifier of line where suffix must be find.
+   * \param      suffix  Suffix text.
+   * \param      len     Suffix length.
+   * \param[out] begin   Begin of the attributes.
+   * \param[out] end     End of the attributes.
+   * \return             True if the suffix is found.
+   */
+  bool SearchAttrs(size_t line_id, const char* suffix, size_t len, const uint32_t*& begin, const uint32_t*& end) const {
+    return suffixes_.SearchAttrs(line_id, suffix, len, begin, end);
+  }
+
+  /**
+   * \brief Get attribute's suffix.
+   *
+   * \param      line_id Identifier of line where suffix must be find.
+   * \param      attr    The attribute.
+   * \param[out] suffix  Suffix text.
+   * \param[out] len     Suffix length.
+   * \return             True if the suffix is found.
+   */
+  bool SearchSuffix(size_t line_id, uint32_t attr, const char*& suffix, size_t& len) const {
+    return suffixes_.SearchSuffix(line_id, attr, suffix, len);
+  }
+
+  /**
+   * \brief Get all line suffixes.
+   *
+   * \param      line_id Identifier of line where suffix must be find.
+   * \param[out] suf_set Suffixes found.
+   */
+  void GetSuffixSet(size_t line_id, std::set<std::string>& suf_set) const {
+    suffixes_.GetSuffixSet(line_id, suf_set);
+  }
+
+  /**
+   * \brief Get lemma information.
+   *
+   * \param  lem_id Identifier of a lemma.
+   * \return        The lemma entry or NULL.
+   */
+  const MorphoImage::LemmaEntry* SearchLemma(uint32_t lem_id) const;
+
+  /// Get text from the string pool.
+  const char* GetText(const MorphoImage::StringRef& ref) const { return pool_ + ref.offset_; }
+
+private:
+  /// Number of state moves, which are looked through linearly.
+  static const uint32_t kLinearSearchSize = 8u;
+
+  /// Get section array of the image and check its size.
+  template <typename T>
+  static const T* GetSection(const char* data, size_t size, MorphoImage::SectionId id, size_t& count);
+
+  /// Check the image and use it, the view is not changed if the image is invalid.
+  void Attach(const char* data, size_t size);
+
+  boost::iostreams::mapped_file_source file_;   ///< Mapped image file.
+  std::vector<uint64_t>                buffer_; ///< Image read from stream.
+  const char*                          data_;   ///< Image begin.
+  size_t                               size_;   ///< Image size.
+
+  const uint32_t*                 trie_offsets_;      ///< Move offsets of each state.
+  const char*                     trie_symbols_;      ///< Move symbols.
+  const automata::StateId*        trie_targets_;      ///< Move targets.
+  const uint32_t*                 trie_outputs_;      ///< Move outputs.
+  const uint8_t*                  trie_accepted_;     ///< Acceptable state marks.
+  const uint32_t*                 trie_attr_offsets_; ///< Attribute offsets of each base.
+  const uint64_t*                 trie_attrs_;        ///< Base attributes.
+  SuffixLinesView                 suffixes_;          ///< Suffix lines.
+  size_t                          num_of_lemmas_;     ///< Number of lemmas.
+  const MorphoImage::LemmaEntry*  lemmas_;            ///< Lemma entries.
+  const char*                     pool_;              ///< String pool.
+};
+
+}} // namespace strutext, morpho.
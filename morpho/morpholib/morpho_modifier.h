@@ -41,6 +41,11 @@ struct MorphoModifier {
   template <class Alphabet, class Iterator>
   static void AddBase(Morphologist<Alphabet>& morph, uint32_t lem_id, uint32_t line_id, Iterator begin, Iterator end,
                         const std::string& main_form) {
+    // The vocabulary is not changed for the lemma which cannot be stored.
+    if (lem_id > BaseStorage::kMaxLemmaId) {
+      throw std::invalid_argument("invalid lemma id passed");
+    }
+
     // At first encode the passed string.
     std::string code_base;
     for (Iterator sym_it = begin; sym_it != end; ++sym_it) {
@@ -48,18 +53,16 @@ struct MorphoModifier {
       code_base += c;
     }
 
-    // Then add the encoded base to morpho trie.
+    // Then add the encoded base to morpho trie, the frozen trie cannot be modified.
+    morph.Thaw();
+    morph.DropForms();
     typename Morphologist<Alphabet>::AttrMap attr_map;
     attr_map.lem_id_ = lem_id;
     attr_map.line_id_ = line_id;
     morph.bases_trie_.AddChain(code_base.begin(), code_base.end(), attr_map.auto_attr_);
 
     // Add lem id to base map and line id to base storage.
-    BaseStorage::LemmaInfo lem_info;
-    lem_info.base_ = code_base;
-    lem_info.main_form_ = main_form;
-    lem_info.line_id_ = line_id;
-    morph.base_store_.storage_.insert(std::make_pair(lem_id, lem_info));
+    morph.base_store_.Add(lem_id, line_id, code_base, main_form);
   }
 
   /**
@@ -70,6 +73,8 @@ struct MorphoModifier {
    */
   template <class Alphabet>
   static uint32_t AddSuffixLine(Morphologist<Alphabet>& morph) {
+    morph.suff_store_.Thaw();
+    morph.DropSuffixIndex();
     morph.suff_store_.suff_storage_.push_back(SuffixStorage::SuffixLine());
     morph.suff_store_.attr_storage_.push_back(SuffixStorage::AttrLine());
     return morph.suff_store_.suff_storage_.size() - 1;
@@ -86,9 +91,13 @@ struct MorphoModifier {
    */
   template <class Alphabet, class Iterator>
   static void AddSuffix(Morphologist<Alphabet>& morph, uint32_t line_id, uint32_t attrs, Iterator begin, Iterator end) {
+    // The frozen storage cannot be modified, the word form automaton and the suffix index are not valid after the change.
+    morph.suff_store_.Thaw();
     if (morph.suff_store_.suff_storage_.size() <= line_id) {
       throw std::invalid_argument("invalid line id passed");
     }
+    morph.DropForms();
+    morph.DropSuffixIndex();
 
     // At first encode the passed string.
     std::string code_suffix;
@@ -0,0 +1,118 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Reverse index of suffixes implementation.
+ * \author Vladimir Lapshin.
+ */
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "serializer.h"
+#include "suffix_index.h"
+
+namespace strutext { namespace morpho {
+
+namespace {
+
+/// Reversed suffix and its line.
+typedef std::pair<std::string, uint32_t> SuffixLine;
+
+/// Order of the suffixes, the symbols are compared as the automaton compares them.
+struct SuffixLineLess {
+  bool operator()(const SuffixLine& left, const SuffixLine& right) const {
+    if (left.first == right.first) {
+      return left.second < right.second;
+    }
+    return std::lexicographical_compare(left.first.begin(), left.first.end(), right.first.begin(), right.first.end());
+  }
+};
+
+}  // namespace.
+
+const uint32_t SuffixIndex::kNoSuffix;
+
+void SuffixIndex::Build(const SuffixLinesView& lines) {
+  // Collect the reversed suffixes, the automaton builder requires them sorted.
+  std::vector<SuffixLine> suffixes;
+  for (size_t line_id = 0; line_id < lines.num_of_lines_; ++line_id) {
+    for (uint32_t i = lines.suffix_lines_[line_id]; i < lines.suffix_lines_[line_id + 1]; ++i) {
+      const StringRef& ref = lines.suffix_entries_[i].suffix_;
+      const char* text = lines.GetText(ref);
+      suffixes.push_back(SuffixLine(std::string(text, text + ref.len_), line_id));
+      std::reverse(suffixes.back().first.begin(), suffixes.back().first.end());
+    }
+  }
+  std::sort(suffixes.begin(), suffixes.end(), SuffixLineLess());
+
+  // The suffix number is its index in the sorted list of different suffixes.
+  num_of_lines_ = lines.num_of_lines_;
+  set_size_ = (num_of_lines_ + 63) / 64;
+  line_sets_.clear();
+  strutext::automata::DawgBuilder<char, uint32_t> builder;
+  const uint32_t* no_attrs = NULL;
+  for (size_t i = 0; i < suffixes.size(); ++i) {
+    if (i == 0 or suffixes[i].first != suffixes[i - 1].first) {
+      builder.Add(suffixes[i].first.begin(), suffixes[i].first.end(), no_attrs, no_attrs);
+      line_sets_.resize(line_sets_.size() + set_size_, 0);
+    }
+    const uint32_t line_id = suffixes[i].second;
+    line_sets_[line_sets_.size() - set_size_ + line_id / 64] |= uint64_t(1) << (line_id % 64);
+  }
+  builder.Build(suffixes_);
+}
+
+void SuffixIndex::Serialize(std::ostream& os) const {
+  strutext::automata::DawgSerializer<SuffixDawg>::Serialize(suffixes_, os);
+  const uint32_t size = line_sets_.size();
+  os.write(reinterpret_cast<const char*>(&num_of_lines_), sizeof num_of_lines_);
+  os.write(reinterpret_cast<const char*>(&size), sizeof size);
+  if (size) {
+    os.write(reinterpret_cast<const char*>(&line_sets_[0]), size * sizeof(uint64_t));
+  }
+  if (os.bad()) {
+    throw std::runtime_error("Cannot write suffix index to stream");
+  }
+}
+
+void SuffixIndex::Deserialize(std::istream& is) {
+  SuffixDawg suffixes;
+  strutext::automata::DawgSerializer<SuffixDawg>::Deserialize(suffixes, is);
+  uint32_t num_of_lines = 0;
+  uint32_t size = 0;
+  is.read(reinterpret_cast<char*>(&num_of_lines), sizeof num_of_lines);
+  is.read(reinterpret_cast<char*>(&size), sizeof size);
+  if (not is) {
+    throw std::runtime_error("Cannot read suffix index from stream");
+  }
+  const uint32_t set_size = (num_of_lines + 63) / 64;
+  if (size != suffixes.GetNumOfWords() * set_size) {
+    throw std::runtime_error("Invalid suffix index in stream");
+  }
+  std::vector<uint64_t> line_sets(size);
+  if (size) {
+    is.read(reinterpret_cast<char*>(&line_sets[0]), size * sizeof(uint64_t));
+    if (not is) {
+      throw std::runtime_error("Cannot read suffix index from stream");
+    }
+  }
+  suffixes_ = suffixes;
+  num_of_lines_ = num_of_lines;
+  set_size_ = set_size;
+  line_sets_.swap(line_sets);
+}
+
+}} // namespace strutext, morpho.
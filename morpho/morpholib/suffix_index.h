@@ -0,0 +1,126 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Reverse index of suffixes: suffix lines by the word end.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+
+#include "fsm_defs.h"
+#include "dawg.h"
+#include "suffix_storage.h"
+
+namespace strutext { namespace morpho {
+
+/**
+ * \brief Reverse index of suffixes.
+ *
+ * Suffix texts of all the lines are put reversed to the minimal automaton, so the word is passed
+ * from its end and each acceptable state gives the number of the suffix of this length. Each suffix
+ * has a bitset of the lines it is in. So a base found by the bases automaton is a candidate only if
+ * its line has the rest of the word as suffix, and the candidate test is a bit test instead of the
+ * suffix storage search. The null suffix is kept as the storage keeps it, as the zero symbol.
+ */
+class SuffixIndex {
+public:
+  /// Number of absent suffix.
+  static const uint32_t kNoSuffix = 0xFFFFFFFF;
+
+  /// Default initialization: empty index.
+  SuffixIndex()
+    : num_of_lines_(0)
+    , set_size_(0) {}
+
+  /**
+   * \brief Build the index of frozen suffix lines.
+   *
+   * \param lines The suffix lines.
+   */
+  void Build(const SuffixLinesView& lines);
+
+  /// Return number of different suffixes.
+  size_t GetNumOfSuffixes() const { return suffixes_.GetNumOfWords(); }
+
+  /// Return number of indexed lines.
+  size_t GetNumOfLines() const { return num_of_lines_; }
+
+  /**
+   * \brief Find the suffixes of the word.
+   *
+   * \param      codes   Alphabet codes of the word.
+   * \param      len     Number of the codes.
+   * \param[out] numbers Number of the suffix of each length from 0 to len, or kNoSuffix.
+   */
+  void FindSuffixes(const char* codes, size_t len, std::vector<uint32_t>& numbers) const {
+    numbers.assign(len + 1, kNoSuffix);
+    uint32_t number = 0;
+    strutext::automata::StateId state = suffixes_.Go(strutext::automata::kStartState, '\0', number);
+    if (state != strutext::automata::kInvalidState and suffixes_.IsAcceptable(state)) {
+      numbers[0] = number;
+    }
+    number = 0;
+    state = strutext::automata::kStartState;
+    for (size_t i = 1; i <= len; ++i) {
+      state = suffixes_.Go(state, codes[len - i], number);
+      if (state == strutext::automata::kInvalidState) {
+        break;
+      }
+      if (suffixes_.IsAcceptable(state)) {
+        numbers[i] = number;
+      }
+    }
+  }
+
+  /**
+   * \brief Is the suffix in the line?
+   *
+   * \param  number  The suffix number, kNoSuffix is in no line.
+   * \param  line_id The line identifier, std::invalid_argument is thrown if the line is not indexed.
+   * \return         True if the line has the suffix.
+   */
+  bool HasLine(uint32_t number, uint32_t line_id) const {
+    if (line_id >= num_of_lines_) {
+      throw std::invalid_argument("incorrect line id passed");
+    }
+    if (number == kNoSuffix) {
+      return false;
+    }
+    return (line_sets_[number * set_size_ + line_id / 64] >> (line_id % 64)) & 1;
+  }
+
+  /// Serialization implementation.
+  void Serialize(std::ostream& os) const;
+
+  /// Deserialization implementation.
+  void Deserialize(std::istream& is);
+
+private:
+  /// Reversed suffixes automaton, the suffixes have no attributes.
+  typedef strutext::automata::Dawg<char, uint32_t> SuffixDawg;
+
+  SuffixDawg            suffixes_;     ///< Automaton of reversed suffixes.
+  uint32_t              num_of_lines_; ///< Number of indexed lines.
+  uint32_t              set_size_;     ///< Number of 64 bit words of line set.
+  std::vector<uint64_t> line_sets_;    ///< Line sets of the suffixes.
+};
+
+}} // namespace strutext, morpho.
@@ -16,24 +16,297 @@
  * \author Vladimir Lapshin.
  */
 
-#include <boost/archive/text_oarchive.hpp>
-#include <boost/archive/text_iarchive.hpp>
-#include <boost/serialization/string.hpp>
-#include <boost/serialization/map.hpp>
-#include <boost/serialization/vector.hpp>
+#include <algorithm>
+#include <cstring>
 
+#include "serializer.h"
 #include "suffix_storage.h"
 
 namespace strutext { namespace morpho {
 
+namespace {
+
+/// Compare texts in the same order as std::string does.
+inline bool TextLess(const char* left, size_t left_len, const char* right, size_t right_len) {
+  const int result = std::memcmp(left, right, std::min(left_len, right_len));
+  return result < 0 or (result == 0 and left_len < right_len);
+}
+
+}  // namespace.
+
+SuffixLinesView::SuffixLinesView()
+  : num_of_lines_(0)
+  , suffix_entries_(NULL)
+  , suffix_attrs_(NULL)
+  , attr_entries_(NULL)
+  , pool_(NULL) {
+  static const uint32_t kEmptyLines[1] = {0};
+  suffix_lines_ = kEmptyLines;
+  attr_lines_ = kEmptyLines;
+}
+
+void SuffixLinesView::CheckLine(size_t line_id) const {
+  if (line_id >= num_of_lines_) {
+    throw std::invalid_argument("incorrect line id passed");
+  }
+}
+
+bool SuffixLinesView::IsValid(size_t num_of_suffix_entries, size_t num_of_suffix_attrs, size_t num_of_attr_entries,
+                              size_t pool_size) const {
+  if (suffix_lines_[num_of_lines_] != num_of_suffix_entries or attr_lines_[num_of_lines_] != num_of_attr_entries) {
+    return false;
+  }
+  for (size_t i = 0; i < num_of_lines_; ++i) {
+    if (suffix_lines_[i] > suffix_lines_[i + 1] or attr_lines_[i] > attr_lines_[i + 1]) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < num_of_suffix_entries; ++i) {
+    const SuffixEntry& entry = suffix_entries_[i];
+    if (entry.attrs_begin_ > entry.attrs_end_ or entry.attrs_end_ > num_of_suffix_attrs
+        or not IsInPool(entry.suffix_, pool_size)) {
+      return false;
+    }
+  }
+  for (size_t i = 0; i < num_of_attr_entries; ++i) {
+    if (not IsInPool(attr_entries_[i].suffix_, pool_size)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool SuffixLinesView::SearchAttrs(size_t line_id, const char* suffix, size_t len,
+                                  const uint32_t*& begin, const uint32_t*& end) const {
+  CheckLine(line_id);
+  const SuffixEntry* first = suffix_entries_ + suffix_lines_[line_id];
+  const SuffixEntry* last = suffix_entries_ + suffix_lines_[line_id + 1];
+  while (first < last) {
+    const SuffixEntry* middle = first + (last - first) / 2;
+    if (TextLess(GetText(middle->suffix_), middle->suffix_.len_, suffix, len)) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  if (first != suffix_entries_ + suffix_lines_[line_id + 1] and first->suffix_.len_ == len
+      and std::memcmp(GetText(first->suffix_), suffix, len) == 0) {
+    begin = suffix_attrs_ + first->attrs_begin_;
+    end = suffix_attrs_ + first->attrs_end_;
+    return true;
+  }
+  return false;
+}
+
+bool SuffixLinesView::SearchSuffix(size_t line_id, uint32_t attr, const char*& suffix, size_t& len) const {
+  CheckLine(line_id);
+  const AttrEntry* first = attr_entries_ + attr_lines_[line_id];
+  const AttrEntry* last = attr_entries_ + attr_lines_[line_id + 1];
+  while (first < last) {
+    const AttrEntry* middle = first + (last - first) / 2;
+    if (middle->attr_ < attr) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  if (first != attr_entries_ + attr_lines_[line_id + 1] and first->attr_ == attr) {
+    suffix = GetText(first->suffix_);
+    len = first->suffix_.len_;
+    return true;
+  }
+  return false;
+}
+
+void SuffixLinesView::GetSuffixSet(size_t line_id, std::set<std::string>& suf_set) const {
+  suf_set.clear();
+  CheckLine(line_id);
+  for (uint32_t i = attr_lines_[line_id]; i < attr_lines_[line_id + 1]; ++i) {
+    suf_set.insert(std::string(GetText(attr_entries_[i].suffix_), attr_entries_[i].suffix_.len_));
+  }
+}
+
+SuffixLinesView SuffixStorage::FrozenLines::GetView() const {
+  SuffixLinesView view;
+  if (not suffix_lines_.empty()) {
+    view.num_of_lines_ = suffix_lines_.size() - 1;
+    view.suffix_lines_ = &suffix_lines_[0];
+    view.attr_lines_ = &attr_lines_[0];
+  }
+  view.suffix_entries_ = suffix_entries_.empty() ? NULL : &suffix_entries_[0];
+  view.suffix_attrs_ = suffix_attrs_.empty() ? NULL : &suffix_attrs_[0];
+  view.attr_entries_ = attr_entries_.empty() ? NULL : &attr_entries_[0];
+  view.pool_ = pool_.data();
+  return view;
+}
+
+bool SuffixStorage::SearchAttrs(size_t line_id, const char* suffix, size_t len,
+                                const uint32_t*& begin, const uint32_t*& end) const {
+  if (frozen_) {
+    return view_.SearchAttrs(line_id, suffix, len, begin, end);
+  } else if (line_id >= suff_storage_.size()) {
+    throw std::invalid_argument("incorrect line id passed");
+  }
+  SuffixLine::const_iterator it = suff_storage_[line_id].find(std::string(suffix, len));
+  if (it == suff_storage_[line_id].end() or it->second.empty()) {
+    return false;
+  }
+  begin = &it->second[0];
+  end = begin + it->second.size();
+  return true;
+}
+
+bool SuffixStorage::SearchSuffix(size_t line_id, uint32_t attr, const char*& suffix, size_t& len) const {
+  if (frozen_) {
+    return view_.SearchSuffix(line_id, attr, suffix, len);
+  } else if (line_id >= attr_storage_.size()) {
+    throw std::invalid_argument("incorrect line id passed");
+  }
+  AttrLine::const_iterator it = attr_storage_[line_id].find(attr);
+  if (it == attr_storage_[line_id].end()) {
+    return false;
+  }
+  suffix = it->second.data();
+  len = it->second.size();
+  return true;
+}
+
+void SuffixStorage::GetSuffixSet(size_t line_id, std::set<std::string>& suf_set) const {
+  if (frozen_) {
+    view_.GetSuffixSet(line_id, suf_set);
+    return;
+  } else if (line_id >= attr_storage_.size()) {
+    throw std::invalid_argument("incorrect line id passed");
+  }
+  suf_set.clear();
+  for (AttrLine::const_iterator it = attr_storage_[line_id].begin(); it != attr_storage_[line_id].end(); ++it) {
+    suf_set.insert(it->second);
+  }
+}
+
+void SuffixStorage::GetFrozenLines(FrozenLines& lines) const {
+  if (frozen_) {
+    lines = lines_;
+    return;
+  }
+
+  // Each suffix text is put to the pool once.
+  std::map<std::string, uint32_t> offsets;
+  lines = FrozenLines();
+  lines.suffix_lines_.push_back(0);
+  lines.attr_lines_.push_back(0);
+  for (size_t i = 0; i < suff_storage_.size(); ++i) {
+    // std::map keeps suffixes and attributes sorted.
+    for (SuffixLine::const_iterator it = suff_storage_[i].begin(); it != suff_storage_[i].end(); ++it) {
+      SuffixEntry entry;
+      std::map<std::string, uint32_t>::const_iterator offset_it = offsets.insert(
+          std::make_pair(it->first, static_cast<uint32_t>(lines.pool_.size()))).first;
+      if (offset_it->second == lines.pool_.size()) {
+        lines.pool_.append(it->first);
+      }
+      entry.suffix_.offset_ = offset_it->second;
+      entry.suffix_.len_ = it->first.size();
+      entry.attrs_begin_ = lines.suffix_attrs_.size();
+      lines.suffix_attrs_.insert(lines.suffix_attrs_.end(), it->second.begin(), it->second.end());
+      entry.attrs_end_ = lines.suffix_attrs_.size();
+      lines.suffix_entries_.push_back(entry);
+    }
+    lines.suffix_lines_.push_back(lines.suffix_entries_.size());
+
+    for (AttrLine::const_iterator it = attr_storage_[i].begin(); it != attr_storage_[i].end(); ++it) {
+      AttrEntry entry;
+      std::map<std::string, uint32_t>::const_iterator offset_it = offsets.insert(
+          std::make_pair(it->second, static_cast<uint32_t>(lines.pool_.size()))).first;
+      if (offset_it->second == lines.pool_.size()) {
+        lines.pool_.append(it->second);
+      }
+      entry.attr_ = it->first;
+      entry.suffix_.offset_ = offset_it->second;
+      entry.suffix_.len_ = it->second.size();
+      lines.attr_entries_.push_back(entry);
+    }
+    lines.attr_lines_.push_back(lines.attr_entries_.size());
+  }
+}
+
+void SuffixStorage::Freeze() {
+  if (not frozen_) {
+    GetFrozenLines(lines_);
+    view_ = lines_.GetView();
+    SuffAttrStorage().swap(suff_storage_);
+    AttrSuffStorage().swap(attr_storage_);
+    frozen_ = true;
+  }
+}
+
+void SuffixStorage::Thaw() {
+  if (frozen_) {
+    suff_storage_.assign(view_.num_of_lines_, SuffixLine());
+    attr_storage_.assign(view_.num_of_lines_, AttrLine());
+    for (size_t i = 0; i < view_.num_of_lines_; ++i) {
+      for (uint32_t j = lines_.suffix_lines_[i]; j < lines_.suffix_lines_[i + 1]; ++j) {
+        const SuffixEntry& entry = lines_.suffix_entries_[j];
+        suff_storage_[i][std::string(view_.GetText(entry.suffix_), entry.suffix_.len_)].assign(
+            lines_.suffix_attrs_.begin() + entry.attrs_begin_, lines_.suffix_attrs_.begin() + entry.attrs_end_);
+      }
+      for (uint32_t j = lines_.attr_lines_[i]; j < lines_.attr_lines_[i + 1]; ++j) {
+        const AttrEntry& entry = lines_.attr_entries_[j];
+        attr_storage_[i][entry.attr_] = std::string(view_.GetText(entry.suffix_), entry.suffix_.len_);
+      }
+    }
+    lines_ = FrozenLines();
+    view_ = SuffixLinesView();
+    frozen_ = false;
+  }
+}
+
 void SuffixStorage::Serialize(std::ostream& os) const {
-  boost::archive::text_oarchive oa(os);
-  oa << *this;
+  FrozenLines lines;
+  const FrozenLines* frozen_lines = &lines_;
+  if (not frozen_) {
+    GetFrozenLines(lines);
+    frozen_lines = &lines;
+  }
+  automata::WriteList(frozen_lines->suffix_lines_, os);
+  automata::WriteList(frozen_lines->suffix_entries_, os);
+  automata::WriteList(frozen_lines->suffix_attrs_, os);
+  automata::WriteList(frozen_lines->attr_lines_, os);
+  automata::WriteList(frozen_lines->attr_entries_, os);
+  const std::vector<char> pool(frozen_lines->pool_.begin(), frozen_lines->pool_.end());
+  automata::WriteList(pool, os);
+  if (os.bad()) {
+    throw std::runtime_error("Cannot write suffix storage to stream");
+  }
 }
 
 void SuffixStorage::Deserialize(std::istream& is) {
-  boost::archive::text_iarchive ia(is);
-  ia >> *this;
+  FrozenLines lines;
+  automata::ReadList(lines.suffix_lines_, is);
+  automata::ReadList(lines.suffix_entries_, is);
+  automata::ReadList(lines.suffix_attrs_, is);
+  automata::ReadList(lines.attr_lines_, is);
+  automata::ReadList(lines.attr_entries_, is);
+  std::vector<char> pool;
+  automata::ReadList(pool, is);
+  lines.pool_.assign(pool.begin(), pool.end());
+
+  // Check the arrays are consistent.
+  if (lines.suffix_lines_.empty() or lines.attr_lines_.size() != lines.suffix_lines_.size()
+      or not lines.GetView().IsValid(lines.suffix_entries_.size(), lines.suffix_attrs_.size(),
+                                     lines.attr_entries_.size(), lines.pool_.size())) {
+    throw std::runtime_error("Invalid suffix storage in stream");
+  }
+
+  SuffAttrStorage().swap(suff_storage_);
+  AttrSuffStorage().swap(attr_storage_);
+  std::swap(lines_.suffix_lines_, lines.suffix_lines_);
+  std::swap(lines_.suffix_entries_, lines.suffix_entries_);
+  std::swap(lines_.suffix_attrs_, lines.suffix_attrs_);
+  std::swap(lines_.attr_lines_, lines.attr_lines_);
+  std::swap(lines_.attr_entries_, lines.attr_entries_);
+  std::swap(lines_.pool_, lines.pool_);
+  view_ = lines_.GetView();
+  frozen_ = true;
 }
 
 }} // namespace strutext, morpho.
@@ -31,13 +31,107 @@
 
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
-#include <boost/serialization/access.hpp>
 
 namespace strutext { namespace morpho {
 
 // Forward declaration of MorphoModifier class.
 class MorphoModifier;
 
+/// Text in a string pool.
+struct StringRef {
+  uint32_t offset_; ///< Offset in the pool.
+  uint32_t len_;    ///< Text length.
+};
+
+/// Is the text in the pool of the passed size?
+inline bool IsInPool(const StringRef& ref, size_t pool_size) {
+  return ref.offset_ <= pool_size and ref.len_ <= pool_size - ref.offset_;
+}
+
+/// Suffix of frozen suffix line.
+struct SuffixEntry {
+  StringRef suffix_;      ///< Suffix text.
+  uint32_t  attrs_begin_; ///< Begin of the suffix attributes.
+  uint32_t  attrs_end_;   ///< End of the suffix attributes.
+};
+
+/// Attribute of frozen attribute line.
+struct AttrEntry {
+  uint32_t  attr_;   ///< Attribute.
+  StringRef suffix_; ///< Suffix text.
+};
+
+/**
+ * \brief Read only view of frozen suffix lines.
+ *
+ * Suffixes of line i are placed in [suffix_lines_[i], suffix_lines_[i + 1]) range of suffix
+ * entries, sorted by suffix text, their attributes are ranges of one attribute array. Attributes
+ * of line i are placed in [attr_lines_[i], attr_lines_[i + 1]) range of attribute entries, sorted
+ * by attribute. Texts are kept in the pool. So a search is a binary search in a line and no memory
+ * is allocated. The arrays are owned by SuffixStorage or are the sections of dictionary image.
+ */
+struct SuffixLinesView {
+  /// Initialization by empty line list.
+  SuffixLinesView();
+
+  /**
+   * \brief Get suffix attributes.
+   *
+   * \param      line_id Identifier of line where suffix must be find.
+   * \param      suffix  Suffix text.
+   * \param      len     Suffix length.
+   * \param[out] begin   Begin of the attributes.
+   * \param[out] end     End of the attributes.
+   * \return             True if the suffix is found.
+   */
+  bool SearchAttrs(size_t line_id, const char* suffix, size_t len, const uint32_t*& begin, const uint32_t*& end) const;
+
+  /**
+   * \brief Get attribute's suffix.
+   *
+   * \param      line_id Identifier of line where suffix must be find.
+   * \param      attr    The attribute.
+   * \param[out] suffix  Suffix text.
+   * \param[out] len     Suffix length.
+   * \return             True if the suffix is found.
+   */
+  bool SearchSuffix(size_t line_id, uint32_t attr, const char*& suffix, size_t& len) const;
+
+  /**
+   * \brief Get all line suffixes.
+   *
+   * \param      line_id Identifier of line where suffix must be find.
+   * \param[out] suf_set Suffixes found.
+   */
+  void GetSuffixSet(size_t line_id, std::set<std::string>& suf_set) const;
+
+  /// Get text from the string pool.
+  const char* GetText(const StringRef& ref) const { return pool_ + ref.offset_; }
+
+  /// Check line identifier.
+  void CheckLine(size_t line_id) const;
+
+  /**
+   * \brief Check the arrays read from stream or memory image.
+   *
+   * \param num_of_suffix_entries Number of suffix entries.
+   * \param num_of_suffix_attrs   Number of suffix attributes.
+   * \param num_of_attr_entries   Number of attribute entries.
+   * \param pool_size             Size of the string pool.
+   * \return                      True if line offsets do not decrease and all ranges are in the arrays.
+   */
+  bool IsValid(size_t num_of_suffix_entries, size_t num_of_suffix_attrs, size_t num_of_attr_entries,
+               size_t pool_size) const;
+
+  size_t             num_of_lines_;   ///< Number of lines.
+  const uint32_t*    suffix_lines_;   ///< Suffix entry offsets of each line.
+  const SuffixEntry* suffix_entries_; ///< Suffix entries.
+  const uint32_t*    suffix_attrs_;   ///< Attributes of suffixes.
+  const uint32_t*    attr_lines_;     ///< Attribute entry offsets of each line.
+  const AttrEntry*   attr_entries_;   ///< Attribute entries.
+  const char*        pool_;           ///< String pool.
+};
+
 /**
  * \brief Suffix storage implementation.
  *
@@ -45,11 +139,12 @@ class MorphoModifier;
  * An each line is a map, where key is a string, representing a suffix, and value is
  * a list of 32bit attributes. To find attribute list one must pass line id and suffix
  * value to the seach procedure.
+ *
+ * The lines are not changed after the dictionary is built, so the storage may be frozen: the
+ * maps are replaced by sorted arrays of SuffixLinesView layout. Deserialized storage is frozen.
+ * MorphoModifier unfreezes the storage to add suffixes.
  */
 class SuffixStorage : boost::noncopyable {
-  // Using boost::serialization.
-  friend class boost::serialization::access;
-
 public:
   /// Class object pointer type.
   typedef boost::shared_ptr<SuffixStorage> Ptr;
@@ -57,6 +152,19 @@ public:
   /// Type of attribute array.
   typedef std::vector<uint32_t> AttrList;
 
+  /// Arrays of frozen suffix lines.
+  struct FrozenLines {
+    /// Get view of the arrays, it is valid while the arrays are not changed.
+    SuffixLinesView GetView() const;
+
+    std::vector<uint32_t>    suffix_lines_;   ///< Suffix entry offsets of each line.
+    std::vector<SuffixEntry> suffix_entries_; ///< Suffix entries.
+    std::vector<uint32_t>    suffix_attrs_;   ///< Attributes of suffixes.
+    std::vector<uint32_t>    attr_lines_;     ///< Attribute entry offsets of each line.
+    std::vector<AttrEntry>   attr_entries_;   ///< Attribute entries.
+    std::string              pool_;           ///< String pool.
+  };
+
 private:
   /// Type of suffix list element.
   typedef std::map<std::string, AttrList> SuffixLine;
@@ -74,43 +182,35 @@ private:
   friend class MorphoModifier;
 
 public:
+  /// Default initialization: empty modifiable storage.
+  SuffixStorage()
+    : frozen_(false) {}
+
+  /// Get number of lines.
+  size_t GetNumOfLines() const { return frozen_ ? view_.num_of_lines_ : suff_storage_.size(); }
+
   /**
    * \brief Get suffix attributes.
    *
-   * \param  line_id Identifier of line where suffix must be find.
-   * \param  suffix  Suffix value.
-   * \return         Found attributes pointer or NULL.
+   * \param      line_id Identifier of line where suffix must be find.
+   * \param      suffix  Suffix text.
+   * \param      len     Suffix length.
+   * \param[out] begin   Begin of the attributes.
+   * \param[out] end     End of the attributes.
+   * \return             True if the suffix is found.
    */
-  const AttrList* SearchAttrs(size_t line_id, const std::string& suffix) const {
-    if (line_id < suff_storage_.size()) {
-      SuffixLine::const_iterator it = suff_storage_[line_id].find(suffix);
-      if (it != suff_storage_[line_id].end()) {
-        return &(it->second);
-      }
-    } else {
-      throw std::invalid_argument("incorrect line id passed");
-    }
-    return NULL;
-  }
+  bool SearchAttrs(size_t line_id, const char* suffix, size_t len, const uint32_t*& begin, const uint32_t*& end) const;
 
   /**
    * \brief Get attribute's suffix.
    *
-   * \param  line_id Identifier of line where suffix must be find.
-   * \param  suffix  Suffix value.
-   * \return         Found attributes pointer or NULL.
+   * \param      line_id Identifier of line where suffix must be find.
+   * \param      attr    The attribute.
+   * \param[out] suffix  Suffix text.
+   * \param[out] len     Suffix length.
+   * \return             True if the suffix is found.
    */
-  const std::string* SearchSuffix(size_t line_id, uint32_t attr) const {
-    if (line_id < attr_storage_.size()) {
-      AttrLine::const_iterator it = attr_storage_[line_id].find(attr);
-      if (it != attr_storage_[line_id].end()) {
-        return &(it->second);
-      }
-    } else {
-      throw std::invalid_argument("incorrect line id passed");
-    }
-    return NULL;
-  }
+  bool SearchSuffix(size_t line_id, uint32_t attr, const char*& suffix, size_t& len) const;
 
   /**
    * \brief Get all line suffixes.
@@ -118,33 +218,39 @@ public:
    * \param      line_id Identifier of line where suffix must be find.
    * \param[out] suf_set Suffixes found.
    */
-  void GetSuffixSet(size_t line_id, std::set<std::string>& suf_set) const {
-    suf_set.clear();
-    if (line_id < attr_storage_.size()) {
-      for (AttrLine::const_iterator it = attr_storage_[line_id].begin(); it != attr_storage_[line_id].end(); ++it) {
-        suf_set.insert(it->second);
-      }
-    } else {
-      throw std::invalid_argument("incorrect line id passed");
-    }
-  }
-
-  /// Serialization implementation.
+  void GetSuffixSet(size_t line_id, std::set<std::string>& suf_set) const;
+
+  /// Is the storage frozen?
+  bool IsFrozen() const { return frozen_; }
+
+  /// Replace the maps by the sorted arrays.
+  void Freeze();
+
+  /// Replace the sorted arrays by the maps, used by MorphoModifier.
+  void Thaw();
+
+  /**
+   * \brief Build the sorted arrays, the storage is not changed.
+   *
+   * \param[out] lines The arrays to fill.
+   */
+  void GetFrozenLines(FrozenLines& lines) const;
+
+  /// Get view of the sorted arrays, the storage must be frozen.
+  const SuffixLinesView& GetView() const { return view_; }
+
+  /// Serialization implementation, the sorted arrays are written.
   void Serialize(std::ostream&) const;
 
-  /// Deserialization implementation.
+  /// Deserialization implementation, the storage is frozen.
   void Deserialize(std::istream& is);
 
 private:
-  /// Boost serialization implementation.
-  template<class Archive>
-  void serialize(Archive& ar, const unsigned version) {
-    ar & suff_storage_;
-    ar & attr_storage_;
-  }
-
   SuffAttrStorage suff_storage_; ///< Storage of suffixes and attributes.
   AttrSuffStorage attr_storage_; ///< Storage of attributes and suffixes.
+  FrozenLines     lines_;        ///< Sorted arrays of the frozen storage.
+  SuffixLinesView view_;         ///< View of the sorted arrays.
+  bool            frozen_;       ///< Are the sorted arrays used?
 };
 
 }} // namespace strutext, morpho.
@@ -16,19 +16,30 @@
  * \author Vladimir Lapshin.
  */
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <sstream>
+#include <stdexcept>
 
 #include <boost/test/unit_test.hpp>
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <boost/thread/thread.hpp>
 
 #include "utf8_iterator.h"
 #include "rus_alphabet.h"
 #include "eng_alphabet.h"
 #include "morpho_modifier.h"
 #include "morpho.h"
+#include "mapped_morpho.h"
+#include "cached_morpho.h"
 #include "rus_model.h"
 #include "eng_model.h"
 #include "rus_model_description.h"
 #include "eng_model_description.h"
+#include "test_random.h"
 
 namespace {
 
@@ -37,6 +48,53 @@ namespace rm = strutext::morpho::russian;
 
 typedef strutext::encode::Utf8Iterator<std::string::iterator> Utf8Iterator;
 
+/// Are lemmas equal?
+bool LemmaEqual(const m::MorphologistBase::Lemma& left, const m::MorphologistBase::Lemma& right) {
+  return left.id_ == right.id_ and left.attr_ == right.attr_;
+}
+
+/// Order of lemmas.
+bool LemmaLess(const m::MorphologistBase::Lemma& left, const m::MorphologistBase::Lemma& right) {
+  return left.id_ < right.id_ or (left.id_ == right.id_ and left.attr_ < right.attr_);
+}
+
+/// Analyze the form, the lemmas are sorted.
+template <class MorpherImpl>
+std::vector<m::MorphologistBase::Lemma> AnalizeSorted(const MorpherImpl& morpher, const std::string& form) {
+  m::MorphologistBase::LemList lem_list;
+  morpher.Analize(form, lem_list);
+  std::vector<m::MorphologistBase::Lemma> lemmas(lem_list.begin(), lem_list.end());
+  std::sort(lemmas.begin(), lemmas.end(), LemmaLess);
+  return lemmas;
+}
+
+/// Are lemma lists equal?
+bool LemmasEqual(const std::vector<m::MorphologistBase::Lemma>& left, const std::vector<m::MorphologistBase::Lemma>& right) {
+  return left.size() == right.size() and std::equal(left.begin(), left.end(), right.begin(), LemmaEqual);
+}
+
+/// Replace the element of the image section.
+template <typename T>
+std::string PatchImage(const std::string& image, m::MorphoImage::SectionId id, size_t index, const T& value) {
+  m::MorphoImage::Header header;
+  std::memcpy(&header, image.data(), sizeof(header));
+  std::string patched = image;
+  std::memcpy(&patched[header.sections_[id].offset_ + index * sizeof(T)], &value, sizeof(T));
+  return patched;
+}
+
+/// Stream buffer of the text which cannot be positioned, like a pipe.
+class PipeBuffer : public std::streambuf {
+public:
+  explicit PipeBuffer(const std::string& text) : text_(text) {
+    char* begin = const_cast<char*>(text_.data());
+    setg(begin, begin, begin + text_.size());
+  }
+
+private:
+  std::string text_;
+};
+
 } // namespace.
 
 // English analysis test.
@@ -107,6 +165,660 @@ BOOST_AUTO_TEST_CASE(MorphoLib_Analysis_Russian) {
   BOOST_CHECK(three_done);
 }
 
+// Analysis by frozen and deserialized dictionary.
+BOOST_AUTO_TEST_CASE(MorphoLib_Analysis_Frozen) {
+  typedef m::Morphologist<m::EnglishAlphabet> Morpher;
+  Morpher morpher;
+
+  uint32_t line_id = m::MorphoModifier::AddSuffixLine(morpher);
+  std::string suffix = "s";
+  m::MorphoModifier::AddSuffix(morpher, line_id, 1, suffix.begin(), suffix.end());
+  suffix = "";
+  m::MorphoModifier::AddSuffix(morpher, line_id, 2, suffix.begin(), suffix.end());
+  std::string base = "cat";
+  m::MorphoModifier::AddBase(morpher, 1, line_id, base.begin(), base.end(), "cat");
+  base = "dog";
+  m::MorphoModifier::AddBase(morpher, 2, line_id, base.begin(), base.end(), "dog");
+
+  Morpher::LemList lem_list;
+  morpher.Freeze();
+  morpher.Analize("cats", lem_list);
+  BOOST_REQUIRE_EQUAL(lem_list.size(), 1);
+  BOOST_CHECK_EQUAL(lem_list.front().id_, 1);
+  BOOST_CHECK_EQUAL(lem_list.front().attr_, 1);
+
+  // The deserialized dictionary is frozen.
+  std::stringstream ss;
+  morpher.Serialize(ss);
+  Morpher morpher1;
+  morpher1.Deserialize(ss);
+  morpher1.Analize("dog", lem_list);
+  BOOST_REQUIRE_EQUAL(lem_list.size(), 1);
+  BOOST_CHECK_EQUAL(lem_list.front().id_, 2);
+  BOOST_CHECK_EQUAL(lem_list.front().attr_, 2);
+
+  // Adding to frozen dictionary.
+  base = "cow";
+  m::MorphoModifier::AddBase(morpher1, 3, line_id, base.begin(), base.end(), "cow");
+  morpher1.Analize("cows", lem_list);
+  BOOST_REQUIRE_EQUAL(lem_list.size(), 1);
+  BOOST_CHECK_EQUAL(lem_list.front().id_, 3);
+  morpher1.Analize("cats", lem_list);
+  BOOST_REQUIRE_EQUAL(lem_list.size(), 1);
+  BOOST_CHECK_EQUAL(lem_list.front().id_, 1);
+}
+
+// Analysis by reusable lemma buffer.
+BOOST_AUTO_TEST_CASE(MorphoLib_Analysis_Buffer) {
+  typedef m::Morphologist<m::RussianAlphabet> Morpher;
+  Morpher morpher;
+
+  uint32_t line_id = m::MorphoModifier::AddSuffixLine(morpher);
+  const char* suffixes[] = {"а", "ы", "ой", ""};
+  for (uint32_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); ++i) {
+    std::string suffix = suffixes[i];
+    m::MorphoModifier::AddSuffix(morpher, line_id, i + 1, Utf8Iterator(suffix.begin(), suffix.end()), Utf8Iterator());
+  }
+  const char* bases[] = {"рыб", "рыбак", ""};
+  for (uint32_t i = 0; i < sizeof(bases) / sizeof(bases[0]); ++i) {
+    std::string base = bases[i];
+    m::MorphoModifier::AddBase(morpher, i + 1, line_id, Utf8Iterator(base.begin(), base.end()), Utf8Iterator(), base);
+  }
+  std::stringstream ss;
+  m::MorphoImage::Write(morpher, ss);
+  m::MappedMorphologist<m::RussianAlphabet> mapped;
+  mapped.Deserialize(ss);
+
+  // The same buffer is used for all the words, its content is replaced.
+  const char* forms[] = {"рыбакой", "рыба", "а", "", "кот", "рыбак"};
+  Morpher::LemmaBuffer buffer(1), mapped_buffer;
+  for (size_t i = 0; i < sizeof(forms) / sizeof(forms[0]); ++i) {
+    Morpher::LemList lem_list;
+    morpher.Analize(forms[i], lem_list);
+    const std::string form = forms[i];
+    morpher.Analize(form.data(), form.data() + form.size(), buffer);
+    mapped.Analize(form.data(), form.data() + form.size(), mapped_buffer);
+    BOOST_REQUIRE_EQUAL(buffer.Size(), lem_list.size());
+    BOOST_REQUIRE_EQUAL(mapped_buffer.Size(), lem_list.size());
+    BOOST_CHECK_EQUAL(buffer.Empty(), lem_list.empty());
+    size_t j = 0;
+    for (Morpher::LemList::iterator it = lem_list.begin(); it != lem_list.end(); ++it, ++j) {
+      BOOST_CHECK_EQUAL(buffer[j].id_, it->id_);
+      BOOST_CHECK_EQUAL(buffer[j].attr_, it->attr_);
+      BOOST_CHECK_EQUAL(mapped_buffer[j].id_, it->id_);
+      BOOST_CHECK_EQUAL(mapped_buffer[j].attr_, it->attr_);
+    }
+  }
+
+  // The word of two bases.
+  const std::string form = "рыбакой";
+  morpher.Analize(form.data(), form.data() + form.size(), buffer);
+  BOOST_REQUIRE_EQUAL(buffer.Size(), 1);
+  BOOST_CHECK_EQUAL(buffer.begin()->id_, 2);
+  BOOST_CHECK_EQUAL(buffer.begin()->attr_, 3);
+  buffer.Clear();
+  BOOST_CHECK(buffer.Empty());
+}
+
+// Frozen suffix storage.
+BOOST_AUTO_TEST_CASE(MorphoLib_SuffixStorage_Frozen) {
+  typedef m::Morphologist<m::EnglishAlphabet> Morpher;
+  Morpher morpher;
+
+  uint32_t line_id = m::MorphoModifier::AddSuffixLine(morpher);
+  const char* suffixes[] = {"", "s", "ed", "ing", "s"};
+  for (uint32_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); ++i) {
+    std::string suffix = suffixes[i];
+    m::MorphoModifier::AddSuffix(morpher, line_id, i + 1, suffix.begin(), suffix.end());
+  }
+  uint32_t line_id2 = m::MorphoModifier::AddSuffixLine(morpher);
+  std::string suffix = "ing";
+  m::MorphoModifier::AddSuffix(morpher, line_id2, 7, suffix.begin(), suffix.end());
+  std::string base = "walk";
+  m::MorphoModifier::AddBase(morpher, 1, line_id, base.begin(), base.end(), "walk");
+  base = "sing";
+  m::MorphoModifier::AddBase(morpher, 2, line_id2, base.begin(), base.end(), "sing");
+
+  const char* forms[] = {"walk", "walks", "walked", "walking", "walkes", "singing", "sing", "run"};
+  std::vector<std::vector<Morpher::Lemma> > expected;
+  for (size_t i = 0; i < sizeof(forms) / sizeof(forms[0]); ++i) {
+    expected.push_back(AnalizeSorted(morpher, forms[i]));
+  }
+  std::set<std::string> expected_forms;
+  morpher.GenAllForms(1, expected_forms);
+  BOOST_CHECK_EQUAL(expected_forms.size(), 4);
+
+  // Frozen and deserialized storages give the same results.
+  morpher.Freeze();
+  std::stringstream ss;
+  morpher.Serialize(ss);
+  Morpher restored;
+  restored.Deserialize(ss);
+  Morpher* morphers[] = {&morpher, &restored};
+  for (size_t k = 0; k < 2; ++k) {
+    for (size_t i = 0; i < sizeof(forms) / sizeof(forms[0]); ++i) {
+      BOOST_CHECK(LemmasEqual(AnalizeSorted(*morphers[k], forms[i]), expected[i]));
+    }
+    std::set<std::string> form_set;
+    morphers[k]->GenAllForms(1, form_set);
+    BOOST_CHECK(form_set == expected_forms);
+    BOOST_CHECK_EQUAL(morphers[k]->Generate(1, 3), "walked");
+    BOOST_CHECK_EQUAL(morphers[k]->Generate(1, 1), "walk");
+    BOOST_CHECK_EQUAL(morphers[k]->Generate(2, 7), "singing");
+    BOOST_CHECK_EQUAL(morphers[k]->Generate(2, 1), "");
+    BOOST_CHECK_EQUAL(morphers[k]->Generate(3, 1), "");
+  }
+
+  // Adding suffix to the frozen storage.
+  suffix = "er";
+  m::MorphoModifier::AddSuffix(restored, line_id2, 8, suffix.begin(), suffix.end());
+  BOOST_CHECK_EQUAL(restored.Generate(2, 8), "singer");
+  BOOST_CHECK_EQUAL(AnalizeSorted(restored, "walked").size(), 1);
+
+  // Truncated storage.
+  std::stringstream full_ss;
+  morpher.Serialize(full_ss);
+  std::string data = full_ss.str();
+  data.resize(data.size() / 2);
+  std::stringstream truncated_ss(data);
+  BOOST_CHECK_THROW(restored.Deserialize(truncated_ss), std::exception);
+
+  // Stream without signature, as version 1 wrote, and stream of unknown version.
+  std::stringstream old_ss(full_ss.str().substr(std::strlen(Morpher::GetMagic()) + sizeof(uint32_t)));
+  BOOST_CHECK_THROW(restored.Deserialize(old_ss), std::runtime_error);
+  std::string unknown = full_ss.str();
+  const uint32_t unknown_version = Morpher::kVersion + 1;
+  std::memcpy(&unknown[std::strlen(Morpher::GetMagic())], &unknown_version, sizeof(unknown_version));
+  std::stringstream unknown_ss(unknown);
+  BOOST_CHECK_THROW(restored.Deserialize(unknown_ss), std::runtime_error);
+}
+
+// Analysis by the word form automaton.
+BOOST_AUTO_TEST_CASE(MorphoLib_BaseStorage_Dense) {
+  m::BaseStorage store;
+  store.Add(1, 0, "walk", "walk");
+  store.Add(2, 0, "talk", "talking");
+  store.Add(5, 1, "walk", "walked");
+  store.Add(3, 2, "go", "went");
+  // The lemma already added is not changed.
+  store.Add(1, 7, "run", "run");
+  BOOST_CHECK_EQUAL(store.GetNumOfLemmas(), 6);
+  // The storage size is not representable for the greatest identifier.
+  BOOST_CHECK_THROW(store.Add(0xFFFFFFFF, 0, "run", "run"), std::invalid_argument);
+  BOOST_CHECK_EQUAL(store.GetNumOfLemmas(), 6);
+
+  uint32_t line_id = 0;
+  const char* text = NULL;
+  size_t len = 0;
+  BOOST_REQUIRE(store.Search(1, line_id, text, len));
+  BOOST_CHECK_EQUAL(line_id, 0);
+  BOOST_CHECK_EQUAL(std::string(text, len), "walk");
+  const char* walk = text;
+  BOOST_REQUIRE(store.SearchMainForm(1, text, len));
+  BOOST_CHECK(text == walk);
+  BOOST_REQUIRE(store.SearchMainForm(2, text, len));
+  BOOST_CHECK_EQUAL(std::string(text, len), "talking");
+  // Equal bases are shared.
+  BOOST_REQUIRE(store.Search(5, line_id, text, len));
+  BOOST_CHECK_EQUAL(line_id, 1);
+  BOOST_CHECK(text == walk);
+  BOOST_REQUIRE(store.SearchMainForm(5, text, len));
+  BOOST_CHECK_EQUAL(std::string(text, len), "walked");
+  BOOST_REQUIRE(store.SearchMainForm(3, text, len));
+  BOOST_CHECK_EQUAL(std::string(text, len), "went");
+  // Absent lemmas.
+  BOOST_CHECK(not store.Search(0, line_id, text, len));
+  BOOST_CHECK(not store.Search(4, line_id, text, len));
+  BOOST_CHECK(not store.SearchMainForm(6, text, len));
+
+  std::stringstream ss;
+  store.Serialize(ss);
+  m::BaseStorage restored;
+  restored.Deserialize(ss);
+  BOOST_CHECK_EQUAL(restored.GetNumOfLemmas(), 6);
+  for (uint32_t lem_id = 0; lem_id < 7; ++lem_id) {
+    uint32_t restored_line_id = 0;
+    const char* restored_text = NULL;
+    size_t restored_len = 0;
+    const bool found = store.Search(lem_id, line_id, text, len);
+    BOOST_REQUIRE_EQUAL(restored.Search(lem_id, restored_line_id, restored_text, restored_len), found);
+    if (found) {
+      BOOST_CHECK_EQUAL(restored_line_id, line_id);
+      BOOST_CHECK_EQUAL(std::string(restored_text, restored_len), std::string(text, len));
+      store.SearchMainForm(lem_id, text, len);
+      restored.SearchMainForm(lem_id, restored_text, restored_len);
+      BOOST_CHECK_EQUAL(std::string(restored_text, restored_len), std::string(text, len));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(MorphoLib_Analysis_CompiledForms) {
+  typedef m::Morphologist<m::RussianAlphabet> Morpher;
+  Morpher morpher, compiled;
+
+  const char* suffixes[] = {"а", "ы", "ой", "", "ы"};
+  const char* bases[] = {"рыб", "рыбак", "", "кот"};
+  Morpher* morphers[] = {&morpher, &compiled};
+  for (size_t k = 0; k < 2; ++k) {
+    uint32_t line_id = m::MorphoModifier::AddSuffixLine(*morphers[k]);
+    for (uint32_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); ++i) {
+      std::string suffix = suffixes[i];
+      m::MorphoModifier::AddSuffix(*morphers[k], line_id, i + 1, Utf8Iterator(suffix.begin(), suffix.end()), Utf8Iterator());
+    }
+    for (uint32_t i = 0; i < sizeof(bases) / sizeof(bases[0]); ++i) {
+      std::string base = bases[i];
+      m::MorphoModifier::AddBase(*morphers[k], i + 1, line_id, Utf8Iterator(base.begin(), base.end()), Utf8Iterator(), base);
+    }
+  }
+  compiled.CompileForms();
+  BOOST_CHECK(compiled.IsFormsCompiled());
+  BOOST_CHECK(not morpher.IsFormsCompiled());
+
+  const char* forms[] = {"рыбакой", "рыба", "рыбы", "а", "", "кот", "коты", "котой", "рыбак", "собака"};
+  for (size_t i = 0; i < sizeof(forms) / sizeof(forms[0]); ++i) {
+    BOOST_CHECK(LemmasEqual(AnalizeSorted(compiled, forms[i]), AnalizeSorted(morpher, forms[i])));
+  }
+  // Two suffixes of the line have the same text.
+  BOOST_CHECK_EQUAL(AnalizeSorted(compiled, "коты").size(), 2);
+
+  // The automaton is serialized.
+  std::stringstream ss;
+  compiled.Serialize(ss);
+  Morpher restored;
+  restored.Deserialize(ss);
+  BOOST_CHECK(restored.IsFormsCompiled());
+  for (size_t i = 0; i < sizeof(forms) / sizeof(forms[0]); ++i) {
+    BOOST_CHECK(LemmasEqual(AnalizeSorted(restored, forms[i]), AnalizeSorted(morpher, forms[i])));
+  }
+  BOOST_CHECK_EQUAL(restored.Generate(4, 2), "коты");
+
+  // Adding base drops the automaton.
+  std::string base = "мыш";
+  m::MorphoModifier::AddBase(restored, 5, 0, Utf8Iterator(base.begin(), base.end()), Utf8Iterator(), base);
+  BOOST_CHECK(not restored.IsFormsCompiled());
+  BOOST_CHECK_EQUAL(AnalizeSorted(restored, "мыши").size(), 0);
+  BOOST_REQUIRE_EQUAL(AnalizeSorted(restored, "мышой").size(), 1);
+  BOOST_CHECK_EQUAL(AnalizeSorted(restored, "мышой")[0].id_, 5);
+}
+
+// Reverse index of suffixes.
+BOOST_AUTO_TEST_CASE(MorphoLib_Analysis_SuffixIndex) {
+  typedef m::Morphologist<m::RussianAlphabet> Morpher;
+  Morpher morpher, indexed;
+
+  const char* lines[][4] = {{"а", "ы", "ой", ""}, {"", "и", "ом", "ами"}, {"ь", "я", "ю", "ем"}};
+  const char* bases[] = {"р", "ры", "рыб", "кот", "ко", "", "кон"};
+  const uint32_t base_lines[] = {0, 1, 0, 1, 2, 2, 2};
+  Morpher* morphers[] = {&morpher, &indexed};
+  for (size_t k = 0; k < 2; ++k) {
+    for (uint32_t line = 0; line < 3; ++line) {
+      const uint32_t line_id = m::MorphoModifier::AddSuffixLine(*morphers[k]);
+      for (uint32_t i = 0; i < 4; ++i) {
+        std::string suffix = lines[line][i];
+        m::MorphoModifier::AddSuffix(*morphers[k], line_id, line * 10 + i + 1, Utf8Iterator(suffix.begin(), suffix.end()),
+                                     Utf8Iterator());
+      }
+    }
+    for (uint32_t i = 0; i < sizeof(bases) / sizeof(bases[0]); ++i) {
+      std::string base = bases[i];
+      m::MorphoModifier::AddBase(*morphers[k], i + 1, base_lines[i], Utf8Iterator(base.begin(), base.end()), Utf8Iterator(),
+                                 base);
+    }
+  }
+  morpher.Freeze();
+  indexed.BuildSuffixIndex();
+  BOOST_CHECK(indexed.IsSuffixIndexBuilt());
+  BOOST_CHECK(not morpher.IsSuffixIndexBuilt());
+
+  const char* forms[] = {"рыба", "рыбой", "ры", "рыми", "р", "кот", "котами", "коня", "конь", "ь", "", "ко", "кошка"};
+  m::MorphologistBase::LemmaBuffer buffer, indexed_buffer;
+  size_t num_of_candidates = 0, num_of_indexed_candidates = 0;
+  for (size_t i = 0; i < sizeof(forms) / sizeof(forms[0]); ++i) {
+    BOOST_CHECK(LemmasEqual(AnalizeSorted(indexed, forms[i]), AnalizeSorted(morpher, forms[i])));
+    const std::string form = forms[i];
+    morpher.Analize(form.data(), form.data() + form.size(), buffer);
+    indexed.Analize(form.data(), form.data() + form.size(), indexed_buffer);
+    BOOST_CHECK_LE(indexed_buffer.GetNumOfCandidates(), buffer.GetNumOfCandidates());
+    // Only the bases whose suffixes are found are searched.
+    BOOST_CHECK_LE(indexed_buffer.GetNumOfCandidates(), indexed_buffer.Size());
+    num_of_candidates += buffer.GetNumOfCandidates();
+    num_of_indexed_candidates += indexed_buffer.GetNumOfCandidates();
+  }
+  BOOST_CHECK_LT(num_of_indexed_candidates, num_of_candidates);
+  BOOST_CHECK_EQUAL(AnalizeSorted(indexed, "котами").size(), 1);
+
+  // Unknown line is an error, as the suffix storage reports it.
+  m::SuffixIndex index;
+  BOOST_CHECK_THROW(index.HasLine(m::SuffixIndex::kNoSuffix, 0), std::invalid_argument);
+
+  // The index is serialized.
+  std::stringstream ss;
+  indexed.Serialize(ss);
+  Morpher restored;
+  restored.Deserialize(ss);
+  BOOST_CHECK(restored.IsSuffixIndexBuilt());
+  for (size_t i = 0; i < sizeof(forms) / sizeof(forms[0]); ++i) {
+    BOOST_CHECK(LemmasEqual(AnalizeSorted(restored, forms[i]), AnalizeSorted(morpher, forms[i])));
+  }
+
+  // The stream of version 2 has no index flag, it is not read.
+  std::string old_version = ss.str();
+  const uint32_t version = 2;
+  std::memcpy(&old_version[std::strlen(Morpher::GetMagic())], &version, sizeof(version));
+  std::stringstream old_ss(old_version);
+  BOOST_CHECK_THROW(restored.Deserialize(old_ss), std::runtime_error);
+
+  // Adding suffix drops the index.
+  std::string suffix = "ах";
+  m::MorphoModifier::AddSuffix(restored, 0, 5, Utf8Iterator(suffix.begin(), suffix.end()), Utf8Iterator());
+  BOOST_CHECK(not restored.IsSuffixIndexBuilt());
+  BOOST_REQUIRE_EQUAL(AnalizeSorted(restored, "рыбах").size(), 1);
+  BOOST_CHECK_EQUAL(AnalizeSorted(restored, "рыбах")[0].id_, 3);
+}
+
+// Batch analysis.
+BOOST_AUTO_TEST_CASE(MorphoLib_Analysis_Batch) {
+  typedef m::Morphologist<m::EnglishAlphabet> Morpher;
+  Morpher morpher;
+
+  uint32_t line_id = m::MorphoModifier::AddSuffixLine(morpher);
+  const char* suffixes[] = {"", "s", "ed", "ing"};
+  for (uint32_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); ++i) {
+    std::string suffix = suffixes[i];
+    m::MorphoModifier::AddSuffix(morpher, line_id, i + 1, suffix.begin(), suffix.end());
+  }
+  std::vector<std::string> words;
+  strutext::test::Random random;
+  for (uint32_t lem_id = 1; lem_id <= 2000; ++lem_id) {
+    const std::string base = random.GenerateText(2 + lem_id % 5, "abcdefghijklmnopqrstuvwxyz");
+    m::MorphoModifier::AddBase(morpher, lem_id, line_id, base.begin(), base.end(), base);
+    words.push_back(base + suffixes[lem_id % 4]);
+    words.push_back(base + "xyz");
+  }
+  morpher.Freeze();
+
+  // Repeated words.
+  std::vector<std::string> batch(words.begin(), words.begin() + 10);
+  batch.insert(batch.end(), words.begin(), words.begin() + 10);
+  batch.push_back("");
+  for (size_t num_of_threads = 1; num_of_threads <= 4; num_of_threads *= 2) {
+    Morpher::BatchResult result;
+    morpher.AnalizeBatch(batch, result, num_of_threads);
+    BOOST_CHECK_EQUAL(result.num_of_unique_, 11);
+    BOOST_REQUIRE_EQUAL(result.GetNumOfWords(), batch.size());
+    for (size_t i = 0; i < batch.size(); ++i) {
+      Morpher::LemList lem_list;
+      morpher.Analize(batch[i], lem_list);
+      BOOST_REQUIRE_EQUAL(result.GetNumOfLemmas(i), lem_list.size());
+      const Morpher::Lemma* lemma = &result.lemmas_[result.offsets_[i]];
+      for (Morpher::LemList::iterator it = lem_list.begin(); it != lem_list.end(); ++it, ++lemma) {
+        BOOST_CHECK_EQUAL(lemma->id_, it->id_);
+        BOOST_CHECK_EQUAL(lemma->attr_, it->attr_);
+      }
+    }
+  }
+
+  // Large batch is spread over threads.
+  Morpher::BatchResult single, multi;
+  morpher.AnalizeBatch(words, single);
+  morpher.AnalizeBatch(words, multi, 4);
+  BOOST_CHECK(single.offsets_ == multi.offsets_);
+  BOOST_REQUIRE_EQUAL(single.lemmas_.size(), multi.lemmas_.size());
+  BOOST_CHECK(single.lemmas_.size() >= 2000);
+  for (size_t i = 0; i < single.lemmas_.size(); ++i) {
+    BOOST_CHECK_EQUAL(single.lemmas_[i].id_, multi.lemmas_[i].id_);
+    BOOST_CHECK_EQUAL(single.lemmas_[i].attr_, multi.lemmas_[i].attr_);
+  }
+
+  // Empty batch.
+  morpher.AnalizeBatch(std::vector<std::string>(), multi, 4);
+  BOOST_CHECK_EQUAL(multi.GetNumOfWords(), 0);
+  BOOST_CHECK(multi.lemmas_.empty());
+}
+
+namespace {
+
+// Morphologist which fails by an exception not derived from std::exception.
+struct FailingMorpher : public m::Morphologist<m::EnglishAlphabet> {
+  void Analize(const char*, const char*, LemmaBuffer&) const {
+    throw 1;
+  }
+};
+
+}  // namespace.
+
+BOOST_AUTO_TEST_CASE(MorphoLib_Analysis_BatchFailure) {
+  FailingMorpher morpher;
+  std::vector<std::string> words;
+  for (size_t i = 0; i < 4 * m::MorphologistBase::kMinBatchPerThread; ++i) {
+    words.push_back(std::string(1 + i % 7, 'a') + std::string(1 + i / 7, 'b'));
+  }
+  m::MorphologistBase::BatchResult result;
+  BOOST_CHECK_THROW(morpher.AnalizeBatch(words, result), std::runtime_error);
+  BOOST_CHECK_THROW(morpher.AnalizeBatch(words, result, 4), std::runtime_error);
+}
+
+namespace {
+
+/// Analize the words by the cached morphologist and compare with the original one.
+void CheckCachedAnalysis(const m::CachedMorphologist& cached, const std::vector<std::string>& words, size_t& errors) {
+  m::MorphologistBase::LemmaBuffer buffer;
+  for (size_t pass = 0; pass < 3; ++pass) {
+    for (size_t i = 0; i < words.size(); ++i) {
+      m::MorphologistBase::LemList lem_list;
+      cached.GetMorphologist()->Analize(words[i], lem_list);
+      cached.Analize(words[i].data(), words[i].data() + words[i].size(), buffer);
+      if (buffer.Size() != lem_list.size() or not std::equal(lem_list.begin(), lem_list.end(), buffer.begin(), LemmaEqual)) {
+        ++errors;
+      }
+    }
+  }
+}
+
+} // namespace.
+
+// Analysis by cached morphologist.
+BOOST_AUTO_TEST_CASE(MorphoLib_Analysis_Cache) {
+  typedef m::Morphologist<m::EnglishAlphabet> Morpher;
+  boost::shared_ptr<Morpher> morpher = boost::make_shared<Morpher>();
+
+  uint32_t line_id = m::MorphoModifier::AddSuffixLine(*morpher);
+  const char* suffixes[] = {"", "s", "ed"};
+  for (uint32_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); ++i) {
+    std::string suffix = suffixes[i];
+    m::MorphoModifier::AddSuffix(*morpher, line_id, i + 1, suffix.begin(), suffix.end());
+  }
+  std::vector<std::string> words;
+  strutext::test::Random random;
+  for (uint32_t lem_id = 1; lem_id <= 1000; ++lem_id) {
+    const std::string base = random.GenerateText(3 + lem_id % 4, "abcdefghijklmnopqrstuvwxyz");
+    m::MorphoModifier::AddBase(*morpher, lem_id, line_id, base.begin(), base.end(), base);
+    words.push_back(base + suffixes[lem_id % 3]);
+  }
+  words.push_back("unknown");
+
+  // Large cache keeps all the words.
+  m::CachedMorphologist cached(morpher);
+  size_t errors = 0;
+  CheckCachedAnalysis(cached, words, errors);
+  BOOST_CHECK_EQUAL(errors, 0);
+  m::CachedMorphologist::Statistics stat = cached.GetStatistics();
+  BOOST_CHECK_EQUAL(stat.misses_, words.size());
+  BOOST_CHECK_EQUAL(stat.hits_, 2 * words.size());
+  BOOST_CHECK_EQUAL(stat.num_of_words_, words.size());
+  m::MorphologistBase::LemList lem_list;
+  cached.Analize(words[0], lem_list);
+  BOOST_CHECK_EQUAL(lem_list.size(), 1);
+  BOOST_CHECK_EQUAL(cached.Generate(3, 1), morpher->Generate(3, 1));
+
+  // Small cache evicts words and keeps the memory budget.
+  const size_t kBudget = 4096;
+  m::CachedMorphologist small(morpher, kBudget, 4);
+  CheckCachedAnalysis(small, words, errors);
+  BOOST_CHECK_EQUAL(errors, 0);
+  stat = small.GetStatistics();
+  BOOST_CHECK(stat.memory_ <= kBudget);
+  BOOST_CHECK(stat.num_of_words_ > 0 and stat.num_of_words_ < words.size());
+  BOOST_CHECK_EQUAL(stat.hits_ + stat.misses_, 3 * words.size());
+  small.Clear();
+  stat = small.GetStatistics();
+  BOOST_CHECK_EQUAL(stat.num_of_words_, 0);
+  BOOST_CHECK_EQUAL(stat.hits_, 0);
+
+  // Concurrent analysis.
+  m::CachedMorphologist shared(morpher, 16384);
+  std::vector<size_t> thread_errors(4, 0);
+  boost::thread_group threads;
+  for (size_t i = 0; i < thread_errors.size(); ++i) {
+    threads.create_thread(boost::bind(CheckCachedAnalysis, boost::cref(shared), boost::cref(words),
+                                      boost::ref(thread_errors[i])));
+  }
+  threads.join_all();
+  for (size_t i = 0; i < thread_errors.size(); ++i) {
+    BOOST_CHECK_EQUAL(thread_errors[i], 0);
+  }
+  stat = shared.GetStatistics();
+  BOOST_CHECK_EQUAL(stat.hits_ + stat.misses_, 3 * 4 * words.size());
+}
+
+// Analysis by the dictionary image.
+BOOST_AUTO_TEST_CASE(MorphoLib_Analysis_Image) {
+  typedef m::Morphologist<m::RussianAlphabet> Morpher;
+  typedef m::MappedMorphologist<m::RussianAlphabet> MappedMorpher;
+  Morpher morpher;
+
+  uint32_t line_id = m::MorphoModifier::AddSuffixLine(morpher);
+  const char* suffixes[] = {"а", "ы", "е", "у", "ой", ""};
+  for (uint32_t i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); ++i) {
+    std::string suffix = suffixes[i];
+    m::MorphoModifier::AddSuffix(morpher, line_id, i + 1, Utf8Iterator(suffix.begin(), suffix.end()), Utf8Iterator());
+  }
+  const char* bases[] = {"мам", "рыб", "рыбак", "вод"};
+  for (uint32_t i = 0; i < sizeof(bases) / sizeof(bases[0]); ++i) {
+    std::string base = bases[i];
+    m::MorphoModifier::AddBase(morpher, i + 1, line_id, Utf8Iterator(base.begin(), base.end()), Utf8Iterator(),
+                               base + "а");
+  }
+
+  std::stringstream ss;
+  m::MorphoImage::Write(morpher, ss);
+  const std::string image = ss.str();
+  MappedMorpher mapped;
+  mapped.Deserialize(ss);
+
+  // Analysis and generation are the same.
+  const char* forms[] = {"мама", "рыбы", "рыбак", "рыбакой", "воду", "вод", "кот", ""};
+  Morpher::LemList expected, lem_list;
+  for (size_t i = 0; i < sizeof(forms) / sizeof(forms[0]); ++i) {
+    morpher.Analize(forms[i], expected);
+    mapped.Analize(forms[i], lem_list);
+    BOOST_REQUIRE_EQUAL(lem_list.size(), expected.size());
+    Morpher::LemList::iterator exp_it = expected.begin();
+    for (Morpher::LemList::iterator it = lem_list.begin(); it != lem_list.end(); ++it, ++exp_it) {
+      BOOST_CHECK_EQUAL(it->id_, exp_it->id_);
+      BOOST_CHECK_EQUAL(it->attr_, exp_it->attr_);
+    }
+  }
+  for (uint32_t lem_id = 0; lem_id <= 5; ++lem_id) {
+    for (uint32_t attr = 0; attr <= 7; ++attr) {
+      BOOST_CHECK_EQUAL(mapped.Generate(lem_id, attr), morpher.Generate(lem_id, attr));
+    }
+    std::set<std::string> expected_forms, form_set;
+    BOOST_CHECK_EQUAL(mapped.GenAllForms(lem_id, form_set), morpher.GenAllForms(lem_id, expected_forms));
+    BOOST_CHECK(form_set == expected_forms);
+    std::string expected_main, main_form;
+    BOOST_CHECK_EQUAL(mapped.GenMainForm(lem_id, main_form), morpher.GenMainForm(lem_id, expected_main));
+    BOOST_CHECK_EQUAL(main_form, expected_main);
+  }
+  BOOST_CHECK_EQUAL(mapped.Generate(4, 4), "воду");
+
+  // The frozen dictionary gives the same image, the mapped one writes it as is.
+  morpher.Freeze();
+  std::stringstream frozen_ss;
+  m::MorphoImage::Write(morpher, frozen_ss);
+  BOOST_CHECK(frozen_ss.str() == image);
+  std::stringstream mapped_ss;
+  mapped.Serialize(mapped_ss);
+  BOOST_CHECK(mapped_ss.str() == image);
+
+  // Mapping of the image file.
+  const std::string path = "morpholib-unit-test.img";
+  {
+    std::ofstream file(path.c_str(), std::ios::binary);
+    file.write(image.data(), image.size());
+  }
+  MappedMorpher file_mapped(path);
+  file_mapped.Analize("рыбой", lem_list);
+  BOOST_REQUIRE_EQUAL(lem_list.size(), 1);
+  BOOST_CHECK_EQUAL(lem_list.front().id_, 2);
+  BOOST_CHECK_EQUAL(lem_list.front().attr_, 5);
+  file_mapped.Open(path);
+  file_mapped.Analize("рыбой", lem_list);
+  BOOST_CHECK_EQUAL(lem_list.size(), 1);
+  std::remove(path.c_str());
+  BOOST_CHECK_THROW(file_mapped.Open(path), std::runtime_error);
+  file_mapped.Analize("рыбой", lem_list);
+  BOOST_CHECK_EQUAL(lem_list.size(), 1);
+
+  // Broken images.
+  std::string broken = image;
+  broken[0] = 'X';
+  std::stringstream broken_ss(broken);
+  BOOST_CHECK_THROW(mapped.Deserialize(broken_ss), std::runtime_error);
+  std::stringstream truncated_ss(image.substr(0, image.size() / 2));
+  BOOST_CHECK_THROW(mapped.Deserialize(truncated_ss), std::runtime_error);
+
+  // The image size of the header is checked with the stream length before allocation.
+  m::MorphoImage::Header huge_header;
+  std::memcpy(&huge_header, image.data(), sizeof(huge_header));
+  huge_header.size_ = uint64_t(1) << 60;
+  std::string huge = image;
+  std::memcpy(&huge[0], &huge_header, sizeof(huge_header));
+  std::stringstream huge_ss(huge);
+  BOOST_CHECK_THROW(mapped.Deserialize(huge_ss), std::runtime_error);
+  PipeBuffer huge_pipe(huge);
+  std::istream huge_pipe_is(&huge_pipe);
+  BOOST_CHECK_THROW(mapped.Deserialize(huge_pipe_is), std::runtime_error);
+  PipeBuffer pipe(image);
+  std::istream pipe_is(&pipe);
+  mapped.Deserialize(pipe_is);
+
+  // Section data are checked: move targets, line offsets and lemma lines must be in range, the
+  // invalid state must not be acceptable.
+  m::MorphoImage::Header header;
+  std::memcpy(&header, image.data(), sizeof(header));
+  const uint32_t num_of_states = header.sections_[m::MorphoImage::TRIE_ACCEPTED_SECTION].size_;
+  std::stringstream bad_target_ss(PatchImage(image, m::MorphoImage::TRIE_TARGETS_SECTION, 0, num_of_states));
+  BOOST_CHECK_THROW(mapped.Deserialize(bad_target_ss), std::runtime_error);
+  std::stringstream bad_offset_ss(PatchImage(image, m::MorphoImage::TRIE_OFFSETS_SECTION, 1, uint32_t(1000)));
+  BOOST_CHECK_THROW(mapped.Deserialize(bad_offset_ss), std::runtime_error);
+  std::stringstream bad_accepted_ss(PatchImage(image, m::MorphoImage::TRIE_ACCEPTED_SECTION, 0, uint8_t(1)));
+  BOOST_CHECK_THROW(mapped.Deserialize(bad_accepted_ss), std::runtime_error);
+  std::stringstream bad_line_ss(PatchImage(image, m::MorphoImage::SUFFIX_LINES_SECTION, 0, uint32_t(1000)));
+  BOOST_CHECK_THROW(mapped.Deserialize(bad_line_ss), std::runtime_error);
+  m::MorphoImage::LemmaEntry lemma;
+  std::memcpy(&lemma, image.data() + header.sections_[m::MorphoImage::LEMMAS_SECTION].offset_, sizeof(lemma));
+  lemma.line_id_ = 1000;
+  std::stringstream bad_lemma_ss(PatchImage(image, m::MorphoImage::LEMMAS_SECTION, 0, lemma));
+  BOOST_CHECK_THROW(mapped.Deserialize(bad_lemma_ss), std::runtime_error);
+
+  // The section table is checked after the header, the failed image does not change the view.
+  header.sections_[m::MorphoImage::LEMMAS_SECTION].offset_ = image.size() + m::MorphoImage::kAlignment;
+  std::string bad_section = image;
+  std::memcpy(&bad_section[0], &header, sizeof(header));
+  std::stringstream bad_section_ss(bad_section);
+  BOOST_CHECK_THROW(mapped.Deserialize(bad_section_ss), std::runtime_error);
+  mapped.Analize("рыбой", lem_list);
+  BOOST_CHECK_EQUAL(lem_list.size(), 1);
+  BOOST_CHECK_EQUAL(mapped.Generate(4, 4), "воду");
+
+  // Empty dictionary.
+  MappedMorpher empty;
+  empty.Analize("мама", lem_list);
+  BOOST_CHECK(lem_list.empty());
+  BOOST_CHECK(empty.Generate(1, 1).empty());
+}
+
 // English alphabet test.
 BOOST_AUTO_TEST_CASE(MorphoLib_Alphabet_English) {
   m::EnglishAlphabet alphabet;
@@ -17,6 +17,12 @@
 
 import getopt, sys
 
+# Number of symbol codes covered by the tables, must be equal to SYMBOL_TABLE_SIZE in symbols.h.
+SYMBOL_TABLE_SIZE = 0x110000
+
+# Block size power of two, must be equal to SYMBOL_BLOCK_SHIFT in symbols.h.
+BLOCK_SHIFT = 8
+
 # Generate prolog in binary symbol table.
 def generateFileProlog(f):
   f.write("/** Copyright &copy; 2013, Vladimir Lapshin.\n")
@@ -40,7 +46,7 @@ def generateFileProlog(f):
   f.write("namespace strutext { namespace symbols { namespace details {\n\n")
 
 def generateTableProlog(f, t, n):
-    f.write("{0} {1}[] = {{\n".format(t,n))
+    f.write("const {0} {1}[] = {{\n".format(t,n))
 
 # Generate epilog.
 def generateFileEpilog(f):
@@ -49,6 +55,15 @@ def generateFileEpilog(f):
 def generateTableEpilog(f, t, n):
     f.write("}}; // {0} {1}\n\n".format(t,n))
 
+# Write list of integers as table rows, 16 values per row.
+def generateTableRows(f, values, isLast = True):
+  for i in range(0, values.__len__(), 16):
+    f.write("  ")
+    f.write(", ".join(str(v) for v in values[i:i + 16]))
+    if i + 16 < values.__len__() or not isLast:
+      f.write(",")
+    f.write("\n")
+
 def generateClassMapping(m):
   m["Lu"] = "UPPERCASE_LETTER"
   m["Ll"] = "LOWERCASE_LETTER"
@@ -84,7 +99,6 @@ def generateClassMapping(m):
 def generate(textTablePath, binTablePath):
   symbols = {}
   classes = {}
-  maxCode = 0
   symbol = {}
   try:
     # Open UNICODE data file and read symbol informations from it.
@@ -98,57 +112,64 @@ def generate(textTablePath, binTablePath):
         # Remember symbol properties.
         symCode = int(lineParams[0], 16)
         symbols[symCode] = lineParams
-        if maxCode < symCode:
-          maxCode = symCode
     f.close()
 
+    # Every code gets the property record (class, upper delta, lower delta).
+    # The record 0 is reserved for unassigned code with identity case mappings.
+    generateClassMapping(classes)
+    records = [("Cn", 0, 0)]
+    recordIds = {records[0]: 0}
+    codeRecords = []
+    for code in range(0, SYMBOL_TABLE_SIZE):
+      record = records[0]
+      if code in symbols:
+        symbol = symbols[code]
+        if not symbol[2] in classes:
+          print "Incorrect symbol class {0} for symbol {1}".format(symbol[2], symbol[0])
+          sys.exit(5)
+        upper = int(symbol[12], 16) if symbol[12].__len__() > 0 else code
+        lower = int(symbol[13], 16) if symbol[13].__len__() > 0 else code
+        record = (symbol[2], upper - code, lower - code)
+      if not record in recordIds:
+        recordIds[record] = records.__len__()
+        records.append(record)
+      codeRecords.append(recordIds[record])
+    if records.__len__() > 256:
+      print "Too many symbol property records: {0}".format(records.__len__())
+      sys.exit(6)
+
+    # Split the record ids to blocks and store an each distinct block once.
+    blockSize = 1 << BLOCK_SHIFT
+    blocks = []
+    blockIds = {}
+    blockIndex = []
+    for start in range(0, SYMBOL_TABLE_SIZE, blockSize):
+      block = tuple(codeRecords[start:start + blockSize])
+      if not block in blockIds:
+        blockIds[block] = blocks.__len__()
+        blocks.append(block)
+      blockIndex.append(blockIds[block])
+
     # Trying to generate output.
     f = open(binTablePath, 'wb')
     generateFileProlog(f)
 
-    # Generate symbol classes from 0 to 2^21 - 1.
-    generateClassMapping(classes)
-    generateTableProlog(f, "uint32_t", "SYM_CLASS_TABLE")
-    for code in range(0, maxCode + 1):
-      f.write("  ")
-      if code > 0:
-        f.write(",")
-      if code in symbols:
-        symbol = symbols[code]
-        if symbol[2] in classes:
-          f.write("static_cast<uint32_t>({0}) // {1}.\n".format(classes[symbol[2]], symbol[1]))
-        else:
-            print "Incorrect symbol class {0} for symbol {1}".format(symbol[2], symbol[0])
-            sys.exit(5)
-      else:
-        f.write("static_cast<uint32_t>(UNASSIGNED)\n")
-    generateTableEpilog(f, "uint32_t", "SYM_CLASS_TABLE")
-
-    # Generate symbol upper counterparts from 0 to 2^21 - 1.
-    generateTableProlog(f, "SymbolCode", "SYM_UPPER_TABLE")
-    for code in range(0, maxCode + 1):
-        f.write("  ")
-        if code > 0:
-            f.write(",")
-        if code in symbols:
-            symbol = symbols[code]
-            f.write("0x{0} // {1}.\n".format(symbol[12] if symbol[12].__len__() > 0 else symbol[0], symbol[1]))
-        else:
-            f.write("0x{0:04X}\n".format(code))
-    generateTableEpilog(f, "SymbolCode", "SYM_UPPER_TABLE")
-
-    # Generate symbol upper counterparts from 0 to 2^21 - 1.
-    generateTableProlog(f, "SymbolCode", "SYM_LOWER_TABLE")
-    for code in range(0, maxCode + 1):
-        f.write("  ")
-        if code > 0:
-            f.write(",")
-        if code in symbols:
-            symbol = symbols[code]
-            f.write("0x{0} // {1}.\n".format(symbol[13] if symbol[13].__len__() > 0 else symbol[0], symbol[1]))
-        else:
-            f.write("0x{0:04X}\n".format(code))
-    generateTableEpilog(f, "SymbolCode", "SYM_LOWER_TABLE")
+    generateTableProlog(f, "SymbolProps", "SYM_PROPS")
+    for i in range(0, records.__len__()):
+      record = records[i]
+      f.write("  {0}{{static_cast<uint32_t>({1}), {2}, {3}}}\n".format(
+          "," if i > 0 else "", classes[record[0]], record[1], record[2]))
+    generateTableEpilog(f, "SymbolProps", "SYM_PROPS")
+
+    generateTableProlog(f, "uint16_t", "SYM_BLOCK_INDEX")
+    generateTableRows(f, blockIndex)
+    generateTableEpilog(f, "uint16_t", "SYM_BLOCK_INDEX")
+
+    generateTableProlog(f, "uint8_t", "SYM_BLOCKS")
+    for i in range(0, blocks.__len__()):
+      f.write("  // Block {0}.\n".format(i))
+      generateTableRows(f, blocks[i], i + 1 == blocks.__len__())
+    generateTableEpilog(f, "uint8_t", "SYM_BLOCKS")
 
     generateFileEpilog(f)
     f.close()
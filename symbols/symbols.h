@@ -86,17 +86,46 @@ enum SymbolClass {
 
 namespace details {
 
-// The maximum symbol code.
-static const uint32_t SYMBOL_TABLE_SIZE = 0x200000;
+// The number of symbol codes covered by the tables, codes above have no properties.
+static const uint32_t SYMBOL_TABLE_SIZE = 0x110000;
 
-// The symbol tables declarations.
-extern uint32_t    SYM_CLASS_TABLE[];
-extern SymbolCode  SYM_UPPER_TABLE[];
-extern SymbolCode  SYM_LOWER_TABLE[];
+// The tables are split to blocks of 2^SYMBOL_BLOCK_SHIFT codes.
+static const unsigned SYMBOL_BLOCK_SHIFT = 8;
+
+// The mask to get code offset in its block.
+static const uint32_t SYMBOL_BLOCK_MASK = (1u << SYMBOL_BLOCK_SHIFT) - 1;
+
+/**
+ * \brief Symbol properties record.
+ *
+ * Case mappings are stored as deltas, so all the symbols of some alphabet share
+ * the same record. The record with index 0 describes unassigned symbol.
+ */
+struct SymbolProps {
+  uint32_t class_;       ///< Symbol class.
+  int32_t  upper_delta_; ///< Upper case counterpart minus symbol code.
+  int32_t  lower_delta_; ///< Lower case counterpart minus symbol code.
+};
+
+// The symbol tables declarations. Symbol code is mapped to the properties record
+// in two stages: the block index gives the block of record indexes, the code offset
+// in the block gives the record index. Equal blocks are stored once.
+extern const SymbolProps SYM_PROPS[];
+extern const uint16_t    SYM_BLOCK_INDEX[];
+extern const uint8_t     SYM_BLOCKS[];
 
 extern bool UNIHAN_TABLE[];
 extern unsigned UNIHAN_TABLE_SIZE;
 
+/// Get properties record of the symbol.
+inline const SymbolProps& GetSymbolProps(const SymbolCode& code) {
+  if (code < SYMBOL_TABLE_SIZE) {
+    uint32_t block = SYM_BLOCK_INDEX[code >> SYMBOL_BLOCK_SHIFT];
+    return SYM_PROPS[SYM_BLOCKS[(block << SYMBOL_BLOCK_SHIFT) | (code & SYMBOL_BLOCK_MASK)]];
+  }
+  return SYM_PROPS[0];
+}
+
 }  // namespace details.
 
 inline bool IsHierogliph(const SymbolCode& code) {
@@ -107,15 +136,15 @@ inline bool IsHierogliph(const SymbolCode& code) {
 }
 
 inline const uint32_t& GetSymbolClass(const SymbolCode& code) {
-  return details::SYM_CLASS_TABLE[code];
+  return details::GetSymbolProps(code).class_;
 }
 
 inline SymbolCode ToLower(const SymbolCode& code) {
-  return details::SYM_LOWER_TABLE[code];
+  return code + details::GetSymbolProps(code).lower_delta_;
 }
 
 inline SymbolCode ToUpper(const SymbolCode& code) {
-  return details::SYM_UPPER_TABLE[code];
+  return code + details::GetSymbolProps(code).upper_delta_;
 }
 
 template<SymbolClass class_name>
@@ -150,6 +150,26 @@ BOOST_AUTO_TEST_CASE(Symbols_SymbolCases_RussianToLower) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(Symbols_SymbolTable_Bounds) {
+  // Symbols out of UNICODE range are unassigned and have no case variants.
+  const sym::SymbolCode codes[] = {0x110000, 0x1fffff, 0x200000, sym::MAX_UTF32};
+  BOOST_FOREACH(sym::SymbolCode c, codes) {
+    BOOST_CHECK_EQUAL(sym::GetSymbolClass(c), static_cast<uint32_t>(sym::UNASSIGNED));
+    BOOST_CHECK_EQUAL(sym::ToLower(c), c);
+    BOOST_CHECK_EQUAL(sym::ToUpper(c), c);
+  }
+
+  // The last symbols of the table.
+  BOOST_CHECK_EQUAL(sym::GetSymbolClass(0x10fffd), static_cast<uint32_t>(sym::PRIVATE_USE));
+  BOOST_CHECK_EQUAL(sym::GetSymbolClass(0x10ffff), static_cast<uint32_t>(sym::UNASSIGNED));
+
+  // Case mappings far from the symbol code.
+  BOOST_CHECK_EQUAL(sym::ToUpper(0xff), 0x178u);      // LATIN SMALL LETTER Y WITH DIAERESIS.
+  BOOST_CHECK_EQUAL(sym::ToLower(0x130), 0x69u);      // LATIN CAPITAL LETTER I WITH DOT ABOVE.
+  BOOST_CHECK_EQUAL(sym::ToLower(0x10400), 0x10428u); // DESERET CAPITAL LETTER LONG I.
+  BOOST_CHECK_EQUAL(sym::ToUpper('5'), static_cast<sym::SymbolCode>('5'));
+}
+
 BOOST_AUTO_TEST_CASE(Symbols_Unihan_General) {
   BOOST_CHECK_EQUAL(sym::IsHierogliph(0x3400), true);
   BOOST_CHECK_EQUAL(sym::IsHierogliph(0x340A), true);
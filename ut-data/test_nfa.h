@@ -0,0 +1,56 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  NFA builders for unit tests.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#include <string>
+
+#include <boost/make_shared.hpp>
+
+#include "nfa.h"
+
+namespace strutext { namespace test {
+
+/// Add new state to the NFA.
+template <typename SymbolCode, typename Attribute>
+typename automata::Nfa<SymbolCode, Attribute>::State* NewState(automata::Nfa<SymbolCode, Attribute>& nfa) {
+  typedef typename automata::Nfa<SymbolCode, Attribute>::State State;
+  typename State::Ptr state = boost::make_shared<State>();
+  nfa.AddState(state);
+  return state.get();
+}
+
+/// Add the word to the NFA as the chain from the start state, the end gets the attribute.
+template <typename SymbolCode, typename Attribute>
+void AddWord(automata::Nfa<SymbolCode, Attribute>& nfa, const std::string& word,
+             const typename automata::Nfa<SymbolCode, Attribute>::State::AttrList::value_type& attr) {
+  typedef typename automata::Nfa<SymbolCode, Attribute>::State State;
+  State* state = NewState(nfa);
+  nfa.AddEpsilonTransition(nfa.GetStartState(), state);
+  for (size_t i = 0; i < word.size(); ++i) {
+    State* next = NewState(nfa);
+    nfa.AddTransition(state, next, word[i]);
+    state = next;
+  }
+  nfa.AddToAcceptedSet(state);
+  state->attr_list_.insert(attr);
+}
+
+}} // namespace strutext, test.
@@ -0,0 +1,53 @@
+/** Copyright &copy; 2013, Vladimir Lapshin.
+ *
+ *   Licensed under the Apache License, Version 2.0 (the "License");
+ *   you may not use this file except in compliance with the License.
+ *   You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *   Unless required by applicable law or agreed to in writing, software
+ *   distributed under the License is distributed on an "AS IS" BASIS,
+ *   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *   See the License for the specific language governing permissions and
+ *   limitations under the License.
+ *
+ * \brief  Reproducible random data for unit tests and benchmarks.
+ * \author Vladimir Lapshin.
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+
+namespace strutext { namespace test {
+
+/// Pseudo random generator, the same sequence for each run.
+class Random {
+public:
+  explicit Random(uint32_t seed = 2013)
+    : state_(seed) {}
+
+  /// Return the next number less than the limit.
+  uint32_t Next(uint32_t limit) {
+    state_ = state_ * 1103515245u + 12345u;
+    return (state_ >> 16) % limit;
+  }
+
+  /// Generate the text of the given length from the symbols.
+  std::string GenerateText(size_t len, const std::string& symbols) {
+    std::string text;
+    for (size_t i = 0; i < len; ++i) {
+      text.push_back(symbols[Next(symbols.size())]);
+    }
+    return text;
+  }
+
+private:
+  uint32_t state_; ///< Generator state.
+};
+
+}} // namespace strutext, test.